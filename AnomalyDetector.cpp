@@ -0,0 +1,161 @@
+#include "AnomalyDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Skok: odchylenie od mediany okna większe niż spikeThreshold odchyleń (MAD przeliczone na sigma)
+    const double spikeThreshold = 6.0;
+    const double madToSigma = 1.4826;
+    // Dolne ograniczenie rozrzutu: przy prawie stałym oknie drobne zmiany nie są skokami
+    const double minRelativeSpread = 0.2;
+    const double minAbsoluteSpread = 1.0;
+    // Skoki są oceniane dopiero, gdy okno ma tyle wartości
+    const size_t minSamples = 8;
+    // Zawieszony czujnik: tyle pomiarów z rzędu z identyczną wartością
+    const int flatlineRun = 12;
+    // Przerwa: tyle godzin bez ważnego pomiaru (brak danych lub null)
+    const std::time_t gapSeconds = 6 * 3600;
+}
+
+RollingMedian::RollingMedian(size_t window)
+    : window_(std::max<size_t>(window, 1)) {
+}
+
+void RollingMedian::Add(double value) {
+    values_.push_back(value);
+    if (low_.empty() || value <= *low_.rbegin()) {
+        low_.insert(value);
+    }
+    else {
+        high_.insert(value);
+    }
+
+    // Najstarsza wartość wypada z okna; równe wartości mogą być w obu połowach, usuwamy dowolną
+    if (values_.size() > window_) {
+        double oldest = values_.front();
+        values_.pop_front();
+        auto it = low_.find(oldest);
+        if (it != low_.end()) {
+            low_.erase(it);
+        }
+        else {
+            high_.erase(high_.find(oldest));
+        }
+    }
+    Rebalance();
+}
+
+void RollingMedian::Rebalance() {
+    while (low_.size() > high_.size() + 1) {
+        auto it = std::prev(low_.end());
+        high_.insert(*it);
+        low_.erase(it);
+    }
+    while (high_.size() > low_.size()) {
+        auto it = high_.begin();
+        low_.insert(*it);
+        high_.erase(it);
+    }
+}
+
+double RollingMedian::Median() const {
+    if (low_.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (low_.size() > high_.size()) {
+        return *low_.rbegin();
+    }
+    return (*low_.rbegin() + *high_.begin()) / 2.0;
+}
+
+double RollingMedian::Mad() const {
+    if (values_.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const double median = Median();
+    std::vector<double> deviations;
+    deviations.reserve(values_.size());
+    for (double value : values_) {
+        deviations.push_back(std::fabs(value - median));
+    }
+    const size_t middle = deviations.size() / 2;
+    std::nth_element(deviations.begin(), deviations.begin() + middle, deviations.end());
+    double mad = deviations[middle];
+    if (deviations.size() % 2 == 0) {
+        mad = (mad + *std::max_element(deviations.begin(), deviations.begin() + middle)) / 2.0;
+    }
+    return mad;
+}
+
+SensorAnomalyDetector::SensorAnomalyDetector(size_t window)
+    : median_(window), lastValidTime_(0), lastValue_(0.0), flatRun_(0) {
+}
+
+unsigned SensorAnomalyDetector::Add(std::time_t time, double value) {
+    // Wartości null nie są oceniane ani nie przesuwają czasu: API uzupełnia je później
+    if (time <= lastValidTime_ || std::isnan(value)) {
+        return ANOMALY_NONE;
+    }
+
+    unsigned flags = ANOMALY_NONE;
+    if (lastValidTime_ != 0 && time - lastValidTime_ >= gapSeconds) {
+        flags |= ANOMALY_GAP;
+    }
+
+    flatRun_ = (lastValidTime_ != 0 && value == lastValue_) ? flatRun_ + 1 : 1;
+    if (flatRun_ >= flatlineRun) {
+        flags |= ANOMALY_FLATLINE;
+    }
+
+    if (median_.Count() >= minSamples) {
+        const double median = median_.Median();
+        const double spread = std::max(median_.Mad() * madToSigma,
+            std::max(minRelativeSpread * std::fabs(median), minAbsoluteSpread));
+        if (std::fabs(value - median) > spikeThreshold * spread) {
+            flags |= ANOMALY_SPIKE;
+        }
+    }
+
+    // Skoki też trafiają do okna: mediana jest na nie odporna
+    median_.Add(value);
+    lastValue_ = value;
+    lastValidTime_ = time;
+    return flags;
+}
+
+wxString SensorAnomalyDetector::Describe(unsigned flags) {
+    wxString text;
+    auto append = [&text](const wxString& part) {
+        if (!text.IsEmpty()) {
+            text += ", ";
+        }
+        text += part;
+    };
+    if (flags & ANOMALY_SPIKE) {
+        append("skok");
+    }
+    if (flags & ANOMALY_FLATLINE) {
+        append("stała wartość");
+    }
+    if (flags & ANOMALY_GAP) {
+        append("po przerwie");
+    }
+    return text;
+}
+
+std::vector<unsigned> DetectAnomalies(SensorAnomalyDetector& detector, const std::vector<Measurement>& measurements) {
+    // Detektor dostaje pomiary rosnąco w czasie; flagi są zwracane w kolejności wejścia (API: od najnowszego)
+    std::vector<size_t> order(measurements.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&measurements](size_t a, size_t b) { return measurements[a].time < measurements[b].time; });
+
+    std::vector<unsigned> flags(measurements.size(), ANOMALY_NONE);
+    for (size_t i : order) {
+        flags[i] = detector.Add(measurements[i].time, measurements[i].value);
+    }
+    return flags;
+}
@@ -0,0 +1,66 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <wx/wx.h>
+#include <deque>
+#include <set>
+#include <vector>
+#include <ctime>
+#include "main.h"
+
+// Rodzaje podejrzanych pomiarów (flagi można łączyć)
+enum AnomalyFlag {
+    ANOMALY_NONE = 0,
+    ANOMALY_SPIKE = 1,      // nagły skok: wartość daleko od mediany okna (w jednostkach MAD)
+    ANOMALY_FLATLINE = 2,   // ta sama wartość przez wiele godzin z rzędu (zawieszony czujnik)
+    ANOMALY_GAP = 4         // pierwszy pomiar po długiej przerwie lub serii wartości null
+};
+
+// Mediana z ostatnich window wartości: dwa zbiory uporządkowane (dolna i górna połowa okna),
+// jak dwa kopce z usuwaniem. Dodanie wartości i usunięcie najstarszej to O(log window).
+class RollingMedian {
+public:
+    explicit RollingMedian(size_t window = 24);
+
+    void Add(double value);
+    size_t Count() const { return values_.size(); }
+    double Median() const;
+    // Mediana odchyleń bezwzględnych od mediany; liczona z okna w O(window)
+    double Mad() const;
+
+private:
+    void Rebalance();
+
+    size_t window_;
+    std::deque<double> values_;       // wartości okna w kolejności dodania
+    std::multiset<double> low_;       // dolna połowa; ma tyle samo lub o jeden więcej elementów niż high_
+    std::multiset<double> high_;
+};
+
+// Wykrywanie podejrzanych pomiarów jednego czujnika w strumieniu pomiarów (rosnąco w czasie).
+// Pamięć O(window): okno mediany i liczniki długości serii.
+class SensorAnomalyDetector {
+public:
+    explicit SensorAnomalyDetector(size_t window = 24);
+
+    // Przetwarza następny pomiar (NaN = null z API); zwraca flagi AnomalyFlag tego pomiaru.
+    // Pomiary nie nowsze od ostatniego ważnego są pomijane (ANOMALY_NONE); godzina opublikowana
+    // najpierw jako null jest więc oceniana, gdy później dostanie wartość.
+    unsigned Add(std::time_t time, double value);
+    std::time_t LastTime() const { return lastValidTime_; }
+
+    // Opis flag do podglądu, np. "skok, po przerwie"
+    static wxString Describe(unsigned flags);
+
+private:
+    RollingMedian median_;
+    std::time_t lastValidTime_;
+    double lastValue_;
+    int flatRun_;        // liczba kolejnych pomiarów z wartością równą lastValue_
+};
+
+// Przekazuje detektorowi pomiary serii rosnąco w czasie (seria może być w kolejności API);
+// zwraca flagi w kolejności pomiarów w wektorze. Pomiary już ocenione przez detektor mają ANOMALY_NONE.
+std::vector<unsigned> DetectAnomalies(SensorAnomalyDetector& detector, const std::vector<Measurement>& measurements);
+
+#endif // ANOMALY_DETECTOR_H
@@ -0,0 +1,169 @@
+#include "AqiEngine.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // Górne granice kategorii 0-4 dla stężeń 1-godzinnych (µg/m³), w kolejności AqiPollutant, według
+    // aktualnej skali Polskiego Indeksu Jakości Powietrza GIOŚ (dla NO2 40/90/120/230/340 zamiast
+    // dawnych 40/100/150/200/400); wartość powyżej ostatniej granicy to kategoria 5 (bardzo zły)
+    const float aqiThresholds[AQI_POLLUTANT_COUNT][AQI_CATEGORY_COUNT - 1] = {
+        { 20.0f, 50.0f, 80.0f, 110.0f, 150.0f },     // PM10
+        { 13.0f, 35.0f, 55.0f, 75.0f, 110.0f },      // PM2.5
+        { 40.0f, 90.0f, 120.0f, 230.0f, 340.0f },    // NO2
+        { 50.0f, 100.0f, 200.0f, 350.0f, 500.0f },   // SO2
+        { 70.0f, 120.0f, 150.0f, 180.0f, 240.0f },   // O3
+        { 6.0f, 11.0f, 16.0f, 21.0f, 51.0f }         // C6H6
+    };
+
+    const char* pollutantNames[AQI_POLLUTANT_COUNT] = { "PM10", "PM2.5", "NO2", "SO2", "O3", "C6H6" };
+
+    // Fragmenty nazw wskaźników w API (małe litery)
+    const char* pollutantMatches[AQI_POLLUTANT_COUNT] = {
+        "pm10", "pm2.5", "dwutlenek azotu", "dwutlenek siarki", "ozon", "benzen"
+    };
+
+    // Indeksy cząstkowe: liczba przekroczonych progów, -1 dla NaN. Pętla bez rozgałęzień i wywołań
+    // funkcji, więc kompilator wektoryzuje ją dla całej kolumny stacji.
+    void ComputeSubIndices(const float* values, size_t count, const float* thresholds, signed char* out) {
+        const float t0 = thresholds[0], t1 = thresholds[1], t2 = thresholds[2], t3 = thresholds[3], t4 = thresholds[4];
+        for (size_t i = 0; i < count; ++i) {
+            const float v = values[i];
+            const int category = (v > t0) + (v > t1) + (v > t2) + (v > t3) + (v > t4);
+            out[i] = (signed char)(v == v ? category : AQI_NO_INDEX);
+        }
+    }
+
+    // Indeks ogólny to najgorszy z dostępnych indeksów cząstkowych
+    void CombineIndices(const signed char* subIndices, size_t count, signed char* indices) {
+        for (size_t i = 0; i < count; ++i) {
+            indices[i] = std::max(indices[i], subIndices[i]);
+        }
+    }
+}
+
+void AqiEngine::SetStations(const std::vector<int>& stationIds) {
+    stationIds_ = stationIds;
+    rows_.clear();
+    for (size_t row = 0; row < stationIds_.size(); ++row) {
+        rows_[stationIds_[row]] = row;
+    }
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        values_[p].assign(stationIds_.size(), std::numeric_limits<float>::quiet_NaN());
+        subIndices_[p].assign(stationIds_.size(), (signed char)AQI_NO_INDEX);
+    }
+    indices_.assign(stationIds_.size(), (signed char)AQI_NO_INDEX);
+    dirty_.clear();
+    isDirty_.assign(stationIds_.size(), 0);
+}
+
+int AqiEngine::Row(int stationId) const {
+    auto it = rows_.find(stationId);
+    return it != rows_.end() ? (int)it->second : -1;
+}
+
+void AqiEngine::SetValue(int stationId, AqiPollutant pollutant, float value) {
+    int row = Row(stationId);
+    if (row < 0 || pollutant >= AQI_POLLUTANT_COUNT) {
+        return;
+    }
+    float& current = values_[pollutant][row];
+    if (current == value || (current != current && value != value)) {
+        return;
+    }
+    current = value;
+    if (!isDirty_[row]) {
+        isDirty_[row] = 1;
+        dirty_.push_back(row);
+    }
+}
+
+void AqiEngine::Compute() {
+    const size_t count = stationIds_.size();
+    std::fill(indices_.begin(), indices_.end(), (signed char)AQI_NO_INDEX);
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        ComputeSubIndices(values_[p].data(), count, aqiThresholds[p], subIndices_[p].data());
+        CombineIndices(subIndices_[p].data(), count, indices_.data());
+    }
+    for (size_t row : dirty_) {
+        isDirty_[row] = 0;
+    }
+    dirty_.clear();
+}
+
+size_t AqiEngine::Update() {
+    const size_t updated = dirty_.size();
+    // Przy zmianie dużej części stacji pełny przebieg po kolumnach jest szybszy niż po wierszach
+    if (updated * 4 > stationIds_.size()) {
+        Compute();
+        return updated;
+    }
+    for (size_t row : dirty_) {
+        ComputeRow(row);
+        isDirty_[row] = 0;
+    }
+    dirty_.clear();
+    return updated;
+}
+
+void AqiEngine::ComputeRow(size_t row) {
+    signed char index = (signed char)AQI_NO_INDEX;
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        ComputeSubIndices(&values_[p][row], 1, aqiThresholds[p], &subIndices_[p][row]);
+        index = std::max(index, subIndices_[p][row]);
+    }
+    indices_[row] = index;
+}
+
+int AqiEngine::Index(int stationId) const {
+    int row = Row(stationId);
+    return row >= 0 ? indices_[row] : AQI_NO_INDEX;
+}
+
+int AqiEngine::SubIndex(int stationId, AqiPollutant pollutant) const {
+    int row = Row(stationId);
+    return row >= 0 && pollutant < AQI_POLLUTANT_COUNT ? subIndices_[pollutant][row] : AQI_NO_INDEX;
+}
+
+float AqiEngine::Value(int stationId, AqiPollutant pollutant) const {
+    int row = Row(stationId);
+    return row >= 0 && pollutant < AQI_POLLUTANT_COUNT ? values_[pollutant][row] : std::numeric_limits<float>::quiet_NaN();
+}
+
+wxString AqiEngine::CategoryName(int index) {
+    switch (index) {
+    case 0: return "bardzo dobry";
+    case 1: return "dobry";
+    case 2: return "umiarkowany";
+    case 3: return "dostateczny";
+    case 4: return "zły";
+    case 5: return "bardzo zły";
+    default: return "brak indeksu";
+    }
+}
+
+wxColour AqiEngine::CategoryColour(int index) {
+    // Kolory kategorii jak na mapach GIOŚ
+    switch (index) {
+    case 0: return wxColour(87, 177, 8);
+    case 1: return wxColour(176, 221, 16);
+    case 2: return wxColour(255, 217, 17);
+    case 3: return wxColour(229, 129, 0);
+    case 4: return wxColour(229, 0, 0);
+    case 5: return wxColour(153, 0, 0);
+    default: return wxColour(170, 170, 170);
+    }
+}
+
+const char* AqiEngine::PollutantName(AqiPollutant pollutant) {
+    return pollutant < AQI_POLLUTANT_COUNT ? pollutantNames[pollutant] : "";
+}
+
+AqiPollutant AqiEngine::PollutantFromName(const wxString& paramName) {
+    std::string name(paramName.Lower().utf8_str());
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        if (name.find(pollutantMatches[p]) != std::string::npos) {
+            return (AqiPollutant)p;
+        }
+    }
+    return AQI_POLLUTANT_COUNT;
+}
@@ -0,0 +1,68 @@
+#ifndef AQI_ENGINE_H
+#define AQI_ENGINE_H
+
+#include <wx/wx.h>
+#include <vector>
+#include <unordered_map>
+
+// Zanieczyszczenia uwzględniane w Polskim Indeksie Jakości Powietrza
+enum AqiPollutant {
+    AQI_PM10,
+    AQI_PM25,
+    AQI_NO2,
+    AQI_SO2,
+    AQI_O3,
+    AQI_C6H6,
+    AQI_POLLUTANT_COUNT
+};
+
+// Kategorie indeksu: od 0 (bardzo dobry) do 5 (bardzo zły); -1 to brak indeksu
+const int AQI_CATEGORY_COUNT = 6;
+const int AQI_NO_INDEX = -1;
+
+// Indeks jakości powietrza wszystkich stacji, liczony z najnowszych stężeń (µg/m³).
+// Dane są przechowywane kolumnami (struktura tablic): jedna tablica stężeń i jedna tablica
+// indeksów cząstkowych na zanieczyszczenie, więc indeksy wszystkich stacji liczy jedna pętla
+// po progach, bez rozgałęzień. Po zmianie części stężeń przeliczane są tylko zmienione stacje.
+class AqiEngine {
+public:
+    // Ustawia listę stacji; stężenia i indeksy są puste
+    void SetStations(const std::vector<int>& stationIds);
+    size_t StationCount() const { return stationIds_.size(); }
+    // Identyfikatory stacji w kolejności wierszy (jak w SetStations)
+    const std::vector<int>& StationIds() const { return stationIds_; }
+    // Wiersz stacji lub -1, jeśli stacji nie ma w silniku
+    int Row(int stationId) const;
+
+    // Najnowsze stężenie zanieczyszczenia na stacji (NaN = brak pomiaru); stacja jest przeliczana
+    // przy następnym Update(), tylko jeśli wartość się zmieniła
+    void SetValue(int stationId, AqiPollutant pollutant, float value);
+    // Przelicza wszystkie stacje
+    void Compute();
+    // Przelicza stacje ze zmienionymi stężeniami; zwraca ich liczbę
+    size_t Update();
+
+    int Index(int stationId) const;
+    int SubIndex(int stationId, AqiPollutant pollutant) const;
+    // Ostatnio ustawione stężenie (NaN = brak pomiaru lub stacji)
+    float Value(int stationId, AqiPollutant pollutant) const;
+
+    static wxString CategoryName(int index);
+    static wxColour CategoryColour(int index);
+    static const char* PollutantName(AqiPollutant pollutant);
+    // Zanieczyszczenie dla nazwy wskaźnika z API ("pył zawieszony PM10" itp.) lub AQI_POLLUTANT_COUNT
+    static AqiPollutant PollutantFromName(const wxString& paramName);
+
+private:
+    void ComputeRow(size_t row);
+
+    std::vector<int> stationIds_;
+    std::unordered_map<int, size_t> rows_;
+    std::vector<float> values_[AQI_POLLUTANT_COUNT];
+    std::vector<signed char> subIndices_[AQI_POLLUTANT_COUNT];
+    std::vector<signed char> indices_;
+    std::vector<size_t> dirty_;          // wiersze do przeliczenia
+    std::vector<unsigned char> isDirty_; // czy wiersz jest już w dirty_
+};
+
+#endif // AQI_ENGINE_H
@@ -0,0 +1,243 @@
+#include "BackfillEngine.h"
+#include "mathplot.h"
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+namespace {
+    // Największa strona archiwum API
+    const int pageSize = 500;
+    // Ponowienia strony po błędzie sieci lub serwera (z rosnącą przerwą)
+    const int maxRetries = 3;
+
+    // Data w formacie parametrów dateFrom/dateTo API ("RRRR-MM-DD GG:MM", czas lokalny, spacja zakodowana).
+    // Wołana równolegle z wątków uzupełniania, więc czas lokalny z mpConvertTime, nie ze wspólnego bufora std::localtime
+    std::string FormatQueryDate(std::time_t time) {
+        std::tm tm = {};
+        if (!mpConvertTime(time, true, tm)) {
+            return std::string();
+        }
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%d%%20%H:%M", &tm);
+        return text;
+    }
+}
+
+wxString BackfillProgress::Format() const {
+    return wxString::Format("Czujniki: %zu z %zu zakończonych, %zu z błędem; strony: %zu, nowe godziny: %zu",
+        sensorsDone, sensors, sensorsFailed, pages, added);
+}
+
+BackfillEngine::BackfillEngine(const std::string& directory)
+    : store_(directory), cancelled_(false) {
+}
+
+BackfillProgress BackfillEngine::Run(std::vector<Station>& stations, std::time_t from, std::time_t to, unsigned maxThreads,
+    const std::function<void(const BackfillProgress&)>& onProgress) {
+    cancelled_ = false;
+    BackfillProgress progress;
+
+    // Brakujące czujniki stacji
+    RunParallel(stations.size(), maxThreads, [&](size_t i) {
+        if (stations[i].sensors.empty() && !cancelled_) {
+            FetchStationSensors(stations[i].id, stations[i].sensors);
+        }
+    });
+
+    // Każdy czujnik raz, nawet jeśli występuje w kilku stacjach
+    std::vector<int> sensorIds;
+    std::set<int> seen;
+    for (const auto& station : stations) {
+        for (const auto& sensor : station.sensors) {
+            if (seen.insert(sensor.id).second) {
+                sensorIds.push_back(sensor.id);
+            }
+        }
+    }
+    progress.sensors = sensorIds.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(store_.Directory(), ec);
+
+    // Każde zadanie pobiera i zapisuje tylko swój czujnik; wspólny jest tylko postęp
+    RunParallel(sensorIds.size(), maxThreads, [&](size_t i) {
+        if (cancelled_) {
+            return;
+        }
+        bool finished = BackfillSensor(sensorIds[i], from, to, progress, onProgress);
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        if (finished) {
+            ++progress.sensorsDone;
+        }
+        else if (!cancelled_) {
+            ++progress.sensorsFailed;
+        }
+        if (onProgress) {
+            onProgress(progress);
+        }
+    });
+    return progress;
+}
+
+void BackfillEngine::DaysRange(int days, std::time_t& from, std::time_t& to) {
+    std::time_t now = std::time(nullptr);
+    std::tm tm = {};
+    if (!mpConvertTime(now, true, tm)) {
+        from = to = now;
+        return;
+    }
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    to = std::mktime(&tm);
+    tm.tm_mday -= days;
+    tm.tm_isdst = -1;
+    from = std::mktime(&tm);
+}
+
+std::string BackfillEngine::CursorPath(int sensorId) const {
+    return (std::filesystem::path(store_.Directory()) / (std::to_string(sensorId) + ".cursor")).string();
+}
+
+bool BackfillEngine::LoadCursor(int sensorId, Cursor& cursor) const {
+    const std::string path = CursorPath(sensorId);
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+    json j = json::parse(ReadFromFile(path), nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        return false;
+    }
+    cursor.from = (std::time_t)j.value("from", (int64_t)0);
+    cursor.to = (std::time_t)j.value("to", (int64_t)0);
+    return cursor.from < cursor.to;
+}
+
+bool BackfillEngine::SaveCursor(int sensorId, const Cursor& cursor) const {
+    json j;
+    j["from"] = (int64_t)cursor.from;
+    j["to"] = (int64_t)cursor.to;
+    return SaveToFile(j.dump(), CursorPath(sensorId));
+}
+
+bool BackfillEngine::BackfillSensor(int sensorId, std::time_t from, std::time_t to,
+    BackfillProgress& progress, const std::function<void(const BackfillProgress&)>& onProgress) {
+    // Kursor rozłączny z zakresem (lub uszkodzony) nie skraca pobierania: zakres jest pobierany w całości,
+    // a kursor zaczyna się od nowa - powtórzone godziny scala archiwum
+    Cursor cursor;
+    if (!LoadCursor(sensorId, cursor) || cursor.from > to || cursor.to < from) {
+        cursor = Cursor();
+        return FetchRange(sensorId, from, to, cursor, progress, onProgress);
+    }
+    // Starsza część przed kursorem i nowsza po nim; obie przylegają do kursora
+    if (from < cursor.from && !FetchRange(sensorId, from, cursor.from, cursor, progress, onProgress)) {
+        return false;
+    }
+    if (to > cursor.to && !FetchRange(sensorId, cursor.to, to, cursor, progress, onProgress)) {
+        return false;
+    }
+    return true;
+}
+
+bool BackfillEngine::FetchRange(int sensorId, std::time_t from, std::time_t to, Cursor& cursor,
+    BackfillProgress& progress, const std::function<void(const BackfillProgress&)>& onProgress) {
+    // Kursor obejmuje tylko ciągły przedział: pobrana część, która go nie dotyka, jest już w archiwum,
+    // ale przy przerwaniu zostanie pobrana ponownie
+    auto extendCursor = [this, sensorId, &cursor](std::time_t fetchedFrom, std::time_t fetchedTo) {
+        if (cursor.from >= cursor.to) {
+            cursor.from = fetchedFrom;
+            cursor.to = fetchedTo;
+        }
+        else if (fetchedFrom <= cursor.to && fetchedTo >= cursor.from) {
+            cursor.from = std::min(cursor.from, fetchedFrom);
+            cursor.to = std::max(cursor.to, fetchedTo);
+        }
+        else {
+            return;
+        }
+        SaveCursor(sensorId, cursor);
+    };
+
+    // Zabezpieczenie przed API ignorującym zakres dat: więcej stron niż godzin w zakresie nie ma
+    const std::time_t rangeFrom = from;
+    const std::time_t rangeTo = to;
+    const int maxPages = (int)((to - from) / 3600 / pageSize) + 2;
+    int pages = 0;
+    while (from <= to) {
+        if (cancelled_) {
+            return false;
+        }
+        if (pages >= maxPages) {
+            wxLogError("Archiwum sensora %d: API nie zawęża zakresu dat, pobieranie przerwane", sensorId);
+            return false;
+        }
+
+        std::string target = "/pjp-api/v1/rest/archivalData/getDataBySensor/" + std::to_string(sensorId) +
+            "?size=" + std::to_string(pageSize) + "&page=0&dateFrom=" + FormatQueryDate(from) + "&dateTo=" + FormatQueryDate(to);
+        wxString data;
+        for (int attempt = 0; attempt <= maxRetries; ++attempt) {
+            if (attempt > 0) {
+                std::this_thread::sleep_for(std::chrono::seconds(attempt * 2));
+            }
+            ApiRateLimiter().Acquire();
+            data = fetch_data(target, "", false);
+            // HTTP 400 to błąd zapytania albo brak danych w zakresie - ponawianie nic nie zmieni
+            if (!data.StartsWith("ERROR:") || data.Contains("HTTP 400")) {
+                break;
+            }
+        }
+        if (data.StartsWith("ERROR:")) {
+            // Po pełnej stronie HTTP 400 oznacza, że w zawężonym zakresie nie ma już pomiarów. Na pierwszej
+            // stronie nie da się go odróżnić od błędu zapytania, więc czujnik nie jest uznawany za zakończony
+            if (pages > 0 && data.Contains("HTTP 400")) {
+                break;
+            }
+            wxLogError("Błąd pobierania archiwum sensora %d (strona %d): %s", sensorId, pages, data.c_str());
+            return false;
+        }
+
+        std::vector<Measurement> measurements;
+        if (!ParseMeasurements(data.ToStdString(wxConvUTF8), "Lista archiwalnych wyników pomiarów", measurements, true)) {
+            wxLogError("Nieprawidłowa odpowiedź archiwum sensora %d", sensorId);
+            return false;
+        }
+        long added = store_.Merge(sensorId, measurements);
+        if (added < 0) {
+            wxLogError("Nie udało się zapisać archiwum sensora %d", sensorId);
+            return false;
+        }
+        ++pages;
+
+        // Pełna strona obejmuje w całości godziny od swojego najstarszego pomiaru do końca zakresu (API zwraca
+        // od najnowszego) albo od początku zakresu do najnowszego (gdy zwróci od najstarszego); dalej pobierana
+        // jest tylko reszta zakresu. Niepełna strona kończy zakres.
+        const bool last = measurements.size() < (size_t)pageSize;
+        if (!last) {
+            auto range = std::minmax_element(measurements.begin(), measurements.end(),
+                [](const Measurement& a, const Measurement& b) { return a.time < b.time; });
+            if (measurements.front().time >= measurements.back().time) {
+                extendCursor(range.first->time, to);
+                to = range.first->time - 60;
+            }
+            else {
+                extendCursor(from, range.second->time);
+                from = range.second->time + 60;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        ++progress.pages;
+        progress.added += (size_t)added;
+        if (onProgress) {
+            onProgress(progress);
+        }
+        if (last) {
+            break;
+        }
+    }
+
+    // Cały zakres jest w archiwum; kursor po zapisie ostatniej strony, więc przerwanie powtórzy najwyżej ją
+    extendCursor(rangeFrom, rangeTo);
+    return true;
+}
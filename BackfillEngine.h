@@ -0,0 +1,71 @@
+#ifndef BACKFILL_ENGINE_H
+#define BACKFILL_ENGINE_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ctime>
+#include "main.h"
+#include "SeriesStore.h"
+
+// Postęp uzupełniania archiwum
+struct BackfillProgress {
+    size_t sensors = 0;         // wszystkie czujniki do pobrania
+    size_t sensorsDone = 0;     // zakończone (także wcześniej, wg zapisanego kursora)
+    size_t sensorsFailed = 0;   // przerwane błędem API; przy kolejnym uruchomieniu są wznawiane
+    size_t pages = 0;           // strony pobrane w tym uruchomieniu
+    size_t added = 0;           // nowe godziny zapisane w archiwum
+
+    wxString Format() const;
+};
+
+// Uzupełnianie lokalnego archiwum (SeriesStore) danymi archiwalnymi API dla wszystkich czujników
+// podanych stacji i zakresu dat. Czujniki są pobierane równolegle (ograniczona liczba wątków,
+// wspólny ogranicznik zapytań), strona po stronie; każda strona jest od razu scalana z archiwum
+// (powtórzenia godzin są usuwane), a po niej zapisywany jest kursor czujnika (<katalog>/<id>.cursor):
+// ciągły przedział czasu, który jest już w archiwum w całości. Kolejne uruchomienie z dowolnym
+// zakresem nakładającym się na ten przedział pobiera tylko brakujące części (starszą i nowszą).
+class BackfillEngine {
+public:
+    explicit BackfillEngine(const std::string& directory);
+
+    // Blokuje do zakończenia; stacje bez czujników mają je uzupełnione. onProgress jest wywoływane
+    // z wątków roboczych (po kolei, nigdy jednocześnie) po każdej stronie
+    BackfillProgress Run(std::vector<Station>& stations, std::time_t from, std::time_t to, unsigned maxThreads,
+        const std::function<void(const BackfillProgress&)>& onProgress = nullptr);
+    // Przerywa Run po bieżących stronach; kursory pozwalają wznowić później
+    void Cancel() { cancelled_ = true; }
+    bool IsCancelled() const { return cancelled_; }
+
+    SeriesStore& Store() { return store_; }
+
+    // Zakres ostatnich days dni, kończący się o północy dzisiejszego dnia (czas lokalny)
+    static void DaysRange(int days, std::time_t& from, std::time_t& to);
+
+private:
+    // Pomiary z [from, to] są w archiwum w całości; from == to == 0, gdy nic nie pobrano
+    struct Cursor {
+        std::time_t from = 0;
+        std::time_t to = 0;
+    };
+
+    std::string CursorPath(int sensorId) const;
+    bool LoadCursor(int sensorId, Cursor& cursor) const;
+    bool SaveCursor(int sensorId, const Cursor& cursor) const;
+    // Pobiera części zakresu, których nie obejmuje kursor; true, gdy czujnik jest zakończony,
+    // false przy błędzie API lub zapisu albo po przerwaniu
+    bool BackfillSensor(int sensorId, std::time_t from, std::time_t to,
+        BackfillProgress& progress, const std::function<void(const BackfillProgress&)>& onProgress);
+    // Pobiera [from, to] stronami, zawężając zakres o każdą pobraną stronę; kursor jest rozszerzany
+    // (i zapisywany) o każdą stronę, która do niego przylega
+    bool FetchRange(int sensorId, std::time_t from, std::time_t to, Cursor& cursor,
+        BackfillProgress& progress, const std::function<void(const BackfillProgress&)>& onProgress);
+
+    SeriesStore store_;
+    std::atomic<bool> cancelled_;
+    std::mutex progressMutex_;
+};
+
+#endif // BACKFILL_ENGINE_H
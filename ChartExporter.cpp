@@ -0,0 +1,261 @@
+#include "ChartExporter.h"
+#include <wx/filename.h>
+#include <mutex>
+#include <memory>
+#include <limits>
+
+namespace {
+    // Liczniki referencji obiektów GDI wxWidgets (pióra, czcionki) nie są bezpieczne wątkowo.
+    // Konstruktory warstw kopiują obiekty globalne (wxBLACK_PEN, wxNORMAL_FONT...), więc tworzenie
+    // warstw jest serializowane, a skopiowane obiekty są od razu zastępowane własnymi obiektami wątku.
+    std::mutex gdiMutex;
+
+    // Kolory serii, takie same w każdym wątku (bez generatora losowego)
+    const unsigned char seriesColors[][3] = {
+        { 31, 119, 180 }, { 255, 127, 14 }, { 44, 160, 44 }, { 214, 39, 40 },
+        { 148, 103, 189 }, { 140, 86, 75 }, { 227, 119, 194 }, { 127, 127, 127 }
+    };
+
+    double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+double ExportReport::ChartsPerSecond() const {
+    return wallSeconds > 0.0 ? charts / wallSeconds : 0.0;
+}
+
+wxString ExportReport::Format() const {
+    wxString text;
+    text += wxString::Format("Wykresy: %d, błędy: %d, wątki: %u\n", charts, failures, threads);
+    text += wxString::Format("Pobieranie: %.2f s\n", fetchSeconds);
+    text += wxString::Format("Parsowanie: %.2f s\n", parseSeconds);
+    text += wxString::Format("Rysowanie: %.2f s\n", renderSeconds);
+    text += wxString::Format("Kodowanie PNG: %.2f s\n", encodeSeconds);
+    text += wxString::Format("Czas całkowity: %.2f s (%.2f wykresów/s)\n", wallSeconds, ChartsPerSecond());
+    return text;
+}
+
+// Kontekst rysowania jednego wątku: renderer, osie oraz czcionka i pióra należące tylko do tego wątku
+struct ChartExporter::RenderContext {
+    mpImageRenderer renderer;
+    wxFont font;
+    std::unique_ptr<mpScaleX> xaxis;
+    std::unique_ptr<mpScaleY> yaxis;
+
+    RenderContext(int width, int height) : renderer(width, height) {
+        std::lock_guard<std::mutex> lock(gdiMutex);
+        font = wxFont(wxFontInfo(8).Family(wxFONTFAMILY_SWISS));
+        // Oś X jak w ChartFrame: sekundy od epoki, etykiety w czasie lokalnym
+        xaxis.reset(new mpScaleX("Czas", mpALIGN_BOTTOM, true, mpX_DATETIME));
+        yaxis.reset(new mpScaleY("Wartość", mpALIGN_LEFT, true));
+        xaxis->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+        xaxis->SetFont(font);
+        yaxis->SetFont(font);
+        xaxis->SetPen(wxPen(wxColour(128, 128, 128)));
+        yaxis->SetPen(wxPen(wxColour(128, 128, 128)));
+        renderer.SetMargins(20, 20, 40, 60);
+    }
+
+    mpFXYVector* CreateSeries(const wxColour& color) {
+        std::lock_guard<std::mutex> lock(gdiMutex);
+        mpFXYVector* layer = new mpFXYVector("");
+        layer->SetFont(font);
+        layer->SetPen(wxPen(color, 2));
+        return layer;
+    }
+};
+
+ChartExporter::ChartExporter(const wxString& outputDir, int width, int height)
+    : outputDir_(outputDir), cacheMaxAge_(0), width_(width), height_(height), threads_(0), next_(0) {
+}
+
+ExportReport ChartExporter::Export(const std::vector<Station>& stations) {
+    auto start = std::chrono::steady_clock::now();
+
+    unsigned threads = threads_ ? threads_ : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 4;
+    if (threads > stations.size()) threads = (unsigned)stations.size();
+
+    wxFileName::Mkdir(outputDir_, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    if (!cacheDir_.IsEmpty()) {
+        wxFileName::Mkdir(cacheDir_, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    }
+
+    // Każdy wątek zbiera własny raport, scalany po zakończeniu pracy
+    std::vector<ExportReport> reports(threads);
+    std::vector<std::thread> workers;
+    next_ = 0;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&ChartExporter::Worker, this, std::cref(stations), std::ref(reports[i]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ExportReport total;
+    total.threads = threads;
+    for (const auto& report : reports) {
+        total.charts += report.charts;
+        total.failures += report.failures;
+        total.fetchSeconds += report.fetchSeconds;
+        total.parseSeconds += report.parseSeconds;
+        total.renderSeconds += report.renderSeconds;
+        total.encodeSeconds += report.encodeSeconds;
+    }
+    total.wallSeconds = SecondsSince(start);
+    return total;
+}
+
+void ChartExporter::Worker(const std::vector<Station>& stations, ExportReport& report) {
+    RenderContext context(width_, height_);
+
+    // Stacje są pobierane z wspólnego licznika, więc wolniejsze stacje nie blokują pozostałych wątków
+    for (size_t i = next_++; i < stations.size(); i = next_++) {
+        try {
+            if (ExportStation(context, stations[i], report)) {
+                report.charts++;
+            }
+            else {
+                report.failures++;
+            }
+        }
+        catch (const std::exception& e) {
+            wxLogError("Błąd eksportu wykresu dla stacji %d: %s", stations[i].id, e.what());
+            report.failures++;
+        }
+    }
+}
+
+bool ChartExporter::FetchSensors(const Station& station, std::vector<Sensor>& sensors) {
+    if (!station.sensors.empty()) {
+        sensors = station.sensors;
+        return true;
+    }
+
+    ApiRateLimiter().Acquire();
+    std::string target = "/pjp-api/v1/rest/station/sensors/" + std::to_string(station.id) + "?size=20&page=0";
+    wxString sensorsData = fetch_data(target, "", false);
+    if (sensorsData.StartsWith("ERROR:")) {
+        wxLogError("Błąd podczas pobierania czujników dla stacji %d: %s", station.id, sensorsData.c_str());
+        return false;
+    }
+
+    json sensorsJson = json::parse(sensorsData.ToStdString(wxConvUTF8), nullptr, false);
+    if (sensorsJson.is_discarded() || !sensorsJson.contains("Lista stanowisk pomiarowych dla podanej stacji")) {
+        return false;
+    }
+    for (const auto& sensor : sensorsJson["Lista stanowisk pomiarowych dla podanej stacji"]) {
+        if (!sensor.contains("Identyfikator stanowiska") || !sensor.contains("Wskaźnik")) {
+            continue;
+        }
+        Sensor sensorData;
+        sensorData.id = sensor["Identyfikator stanowiska"].get<int>();
+        sensorData.paramName = wxString::FromUTF8(sensor["Wskaźnik"].get<std::string>().c_str());
+        sensors.push_back(sensorData);
+    }
+    return !sensors.empty();
+}
+
+string ChartExporter::FetchSeries(int sensorId) {
+    std::string cacheFile;
+    if (!cacheDir_.IsEmpty()) {
+        cacheFile = wxFileName(cacheDir_, wxString::Format("%d.json", sensorId)).GetFullPath().ToStdString();
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(cacheFile, ec);
+        if (!ec && std::filesystem::file_time_type::clock::now() - modified < std::chrono::seconds(cacheMaxAge_)) {
+            return ReadFromFile(cacheFile);
+        }
+    }
+
+    ApiRateLimiter().Acquire();
+    std::string target = "/pjp-api/v1/rest/data/getData/" + std::to_string(sensorId) + "?size=500&page=0";
+    wxString data = fetch_data(target, cacheFile, !cacheFile.empty());
+    if (data.StartsWith("ERROR:")) {
+        wxLogError("Błąd pobierania danych dla sensora %d: %s", sensorId, data.c_str());
+        return "";
+    }
+    return data.ToStdString(wxConvUTF8);
+}
+
+bool ChartExporter::ExportStation(RenderContext& context, const Station& station, ExportReport& report) {
+    // Pobieranie
+    auto stageStart = std::chrono::steady_clock::now();
+    std::vector<Sensor> sensors;
+    std::vector<std::string> series;
+    if (FetchSensors(station, sensors)) {
+        for (const auto& sensor : sensors) {
+            series.push_back(FetchSeries(sensor.id));
+        }
+    }
+    report.fetchSeconds += SecondsSince(stageStart);
+
+    // Parsowanie: X w sekundach od epoki (jak w ChartFrame), tylko ostatnie 3 dni
+    stageStart = std::chrono::steady_clock::now();
+    std::time_t now = std::time(nullptr);
+    std::time_t windowStart = now - 3 * 24 * 3600;
+    double yMin = std::numeric_limits<double>::max();
+    double yMax = std::numeric_limits<double>::lowest();
+    std::vector<std::vector<double>> xs, ys;
+    std::vector<Measurement> measurements;
+    for (const auto& data : series) {
+        std::vector<double> x_values, y_values;
+        if (!data.empty() && ParseMeasurements(data, "Lista danych pomiarowych", measurements)) {
+            for (const auto& m : measurements) {
+                if (m.time > now || m.time < windowStart) {
+                    continue;
+                }
+                x_values.push_back((double)m.time);
+                y_values.push_back(m.value);
+                yMin = std::min(yMin, m.value);
+                yMax = std::max(yMax, m.value);
+            }
+        }
+        xs.push_back(std::move(x_values));
+        ys.push_back(std::move(y_values));
+    }
+    report.parseSeconds += SecondsSince(stageStart);
+
+    if (yMin > yMax) { // Brak danych
+        return false;
+    }
+
+    // Rysowanie
+    stageStart = std::chrono::steady_clock::now();
+    mpImageRenderer& renderer = context.renderer;
+    renderer.DelAllLayers();
+    size_t colorIndex = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        if (xs[i].empty()) {
+            continue;
+        }
+        const unsigned char* rgb = seriesColors[colorIndex++ % (sizeof(seriesColors) / sizeof(seriesColors[0]))];
+        mpFXYVector* layer = context.CreateSeries(wxColour(rgb[0], rgb[1], rgb[2]));
+        layer->SetData(xs[i], ys[i]);
+        layer->SetContinuity(true);
+        layer->SetDrawOutsideMargins(false);
+        renderer.AddLayer(layer, true);
+    }
+    renderer.AddLayer(context.xaxis.get());
+    renderer.AddLayer(context.yaxis.get());
+
+    yMin = std::min(yMin, 0.0);
+    yMax = std::max(yMax, 0.0);
+    double margin = (yMax - yMin) * 0.1;
+    renderer.Fit((double)windowStart, (double)now, yMin - margin, yMax + margin);
+
+    wxImage image;
+    bool rendered = renderer.Render(image);
+    renderer.DelAllLayers();
+    report.renderSeconds += SecondsSince(stageStart);
+    if (!rendered) {
+        return false;
+    }
+
+    // Kodowanie i zapis
+    stageStart = std::chrono::steady_clock::now();
+    wxString filename = wxFileName(outputDir_, wxString::Format("stacja_%d.png", station.id)).GetFullPath();
+    bool saved = image.SaveFile(filename, wxBITMAP_TYPE_PNG);
+    report.encodeSeconds += SecondsSince(stageStart);
+    return saved;
+}
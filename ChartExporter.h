@@ -0,0 +1,57 @@
+#ifndef CHART_EXPORTER_H
+#define CHART_EXPORTER_H
+
+#include <wx/wx.h>
+#include "mathplot.h"
+#include <vector>
+#include <atomic>
+#include "main.h"
+
+// Wynik eksportu: sumaryczne czasy etapów (ze wszystkich wątków) i przepustowość
+struct ExportReport {
+    int charts = 0;          // zapisane wykresy
+    int failures = 0;        // stacje bez wykresu (brak danych lub błąd)
+    unsigned threads = 0;
+    double fetchSeconds = 0.0;
+    double parseSeconds = 0.0;
+    double renderSeconds = 0.0;
+    double encodeSeconds = 0.0;
+    double wallSeconds = 0.0;  // czas całego eksportu
+
+    double ChartsPerSecond() const;
+    wxString Format() const;
+};
+
+// Równoległy eksport wykresów stacji do plików PNG, bez otwierania okien.
+// Każdy wątek roboczy ma własny kontekst rysowania (mpImageRenderer, osie, czcionkę i pióra),
+// więc wątki nie współdzielą żadnych obiektów wxWidgets.
+class ChartExporter {
+public:
+    ChartExporter(const wxString& outputDir, int width = 1000, int height = 600);
+
+    // Liczba wątków roboczych; 0 = liczba rdzeni
+    void SetThreadCount(unsigned threads) { threads_ = threads; }
+    // Czytaj serie z plików w cacheDir, jeśli nie są starsze niż maxAgeSeconds; pobrane serie są tam zapisywane
+    void SetCacheDir(const wxString& cacheDir, int maxAgeSeconds = 1800) { cacheDir_ = cacheDir; cacheMaxAge_ = maxAgeSeconds; }
+
+    // Eksportuje wykresy podanych stacji; blokuje do zakończenia pracy wszystkich wątków
+    ExportReport Export(const std::vector<Station>& stations);
+
+private:
+    struct RenderContext;
+
+    void Worker(const std::vector<Station>& stations, ExportReport& report);
+    bool ExportStation(RenderContext& context, const Station& station, ExportReport& report);
+    bool FetchSensors(const Station& station, std::vector<Sensor>& sensors);
+    string FetchSeries(int sensorId);
+
+    wxString outputDir_;
+    wxString cacheDir_;
+    int cacheMaxAge_;
+    int width_;
+    int height_;
+    unsigned threads_;
+    std::atomic<size_t> next_;
+};
+
+#endif // CHART_EXPORTER_H
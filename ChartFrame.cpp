@@ -1,7 +1,28 @@
 #include "ChartFrame.h"
-#include <wx/datetime.h>
+#include "SeriesStore.h"
 #include <random>
 #include <limits>
+#include <algorithm>
+
+namespace {
+    // GIOŚ publikuje pomiary godzinowe z opóźnieniem; odświeżamy kilka minut po pełnej godzinie
+    const int livePublishDelaySeconds = 20 * 60;
+    // Pomiary są godzinowe: pojemność bufora to liczba godzin w oknie z zapasem na jeden dzień
+    const size_t pointsPerDay = 24;
+}
+
+// Pobranie w tle: dla każdej serii liczba wierszy do pobrania i wynik
+struct ChartFrame::FetchJob {
+    std::vector<int> sensorIds;
+    std::vector<int> rows;
+    std::vector<std::vector<Measurement>> measurements;
+    std::vector<char> fetched;     // 1, gdy pobranie serii się udało
+};
+
+// Stan współdzielony z wątkiem tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI
+struct ChartFrame::FetchState {
+    ChartFrame* frame = nullptr;
+};
 
 wxBEGIN_EVENT_TABLE(LegendPanel, wxPanel)
 EVT_PAINT(LegendPanel::OnPaint)
@@ -32,7 +53,9 @@ void LegendPanel::OnPaint(wxPaintEvent& event) {
 }
 
 ChartFrame::ChartFrame(const Station& station, const std::vector<Sensor>& sensors)
-    : wxFrame(nullptr, wxID_ANY, "Wykres danych dla " + station.name, wxDefaultPosition, wxSize(1000, 600)) {
+    : wxFrame(nullptr, wxID_ANY, "Wykres danych dla " + station.name, wxDefaultPosition, wxSize(1000, 600)),
+      liveTimer(this), visibleDays(3), fetching_(false), historyMode_(false), state_(std::make_shared<FetchState>()) {
+    state_->frame = this;
     wxPanel* mainPanel = new wxPanel(this);
     wxBoxSizer* mainSizer = new wxBoxSizer(wxHORIZONTAL);
 
@@ -42,6 +65,24 @@ ChartFrame::ChartFrame(const Station& station, const std::vector<Sensor>& sensor
     plot = new mpWindow(plotPanel, wxID_ANY);
     plotSizer->Add(plot, 1, wxEXPAND | wxALL, 10);
 
+    // Odświeżenie dopisuje tylko nowe pomiary
+    wxBoxSizer* controlsSizer = new wxBoxSizer(wxHORIZONTAL);
+    liveCheckBox = new wxCheckBox(plotPanel, wxID_ANY, "Na żywo");
+    statisticsCheckBox = new wxCheckBox(plotPanel, wxID_ANY, "Średnie i maksima");
+    statisticsCheckBox->SetValue(true);
+    historyCheckBox = new wxCheckBox(plotPanel, wxID_ANY, "Historia z archiwum");
+    refreshButton = new wxButton(plotPanel, wxID_ANY, "Odśwież");
+    controlsSizer->Add(historyCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(statisticsCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(liveCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(refreshButton, 0);
+    plotSizer->Add(controlsSizer, 0, wxALIGN_RIGHT | wxLEFT | wxRIGHT | wxBOTTOM, 10);
+    refreshButton->Bind(wxEVT_BUTTON, &ChartFrame::OnRefresh, this);
+    liveCheckBox->Bind(wxEVT_CHECKBOX, &ChartFrame::OnLiveToggle, this);
+    statisticsCheckBox->Bind(wxEVT_CHECKBOX, &ChartFrame::OnStatisticsToggle, this);
+    historyCheckBox->Bind(wxEVT_CHECKBOX, &ChartFrame::OnHistoryToggle, this);
+    Bind(wxEVT_TIMER, &ChartFrame::OnLiveTimer, this, liveTimer.GetId());
+
     // Zablokuj wszystkie interakcje myszą
     plot->EnableMousePanZoom(false);
 
@@ -73,92 +114,393 @@ ChartFrame::ChartFrame(const Station& station, const std::vector<Sensor>& sensor
     FetchAndPlotData(station, sensors);
 }
 
+ChartFrame::~ChartFrame() {
+    // Wyniki pobierania zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+}
+
 void ChartFrame::FetchAndPlotData(const Station& station, const std::vector<Sensor>& sensors) {
-    // Wyczyść kolory i legendę
-    sensorColors.clear();
-    std::vector<wxString> legendLabels;
+    // Wszystkie warstwy dodajemy w jednej paczce: obwiednia i odświeżenie wykresu
+    // zostaną wykonane tylko raz, na końcu funkcji
+    mpUpdateBatch updateBatch(plot);
 
-    wxDateTime now = wxDateTime::Now();
-    wxDateTime threeDaysAgo = now - wxTimeSpan::Days(3);
+    series.clear();
+    for (const auto& sensor : sensors) {
+        ChartSeries entry;
+        entry.sensor = sensor;
+        entry.statistics = SensorStatistics(sensor.paramName);
+        series.push_back(entry);
+    }
 
-    mpScaleX* xaxis = new mpScaleX("Czas (godziny wstecz)", mpALIGN_BOTTOM, true);
+    // Oś X w czasie bezwzględnym (sekundy od epoki), etykiety w czasie lokalnym
+    mpScaleX* xaxis = new mpScaleX("Czas", mpALIGN_BOTTOM, true, mpX_DATETIME);
     mpScaleY* yaxis = new mpScaleY("Wartość", mpALIGN_LEFT, true);
-    xaxis->SetTicks(true)
+    xaxis->SetTicks(true);
     yaxis->SetTicks(true);
-    xaxis->SetLabelFormat("%.0f");
+    xaxis->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+
+    // Dodaje osie
+    plot->AddLayer(xaxis);
+    plot->AddLayer(yaxis);
+
+    // Podgląd pomiaru najbliższego kursorowi: sensor, czas i wartość
+    mpInfoNearest* inspector = new mpInfoNearest(wxRect(80, 20, 10, 10), wxWHITE_BRUSH);
+    inspector->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+    plot->AddLayer(inspector);
+
+    // Zablokowanie przewijania i zoomowania myszą
+    plot->EnableMousePanZoom(false);
+
+    UpdateData();
+}
+
+void ChartFrame::UpdateData() {
+    if (fetching_ || series.empty()) {
+        return;
+    }
+
+    // Pomiary są od najnowszego, więc wystarczy pobrać tyle wierszy, ile godzin minęło od ostatniego
+    // pomiaru na wykresie (z zapasem na spóźnione publikacje); pierwsze pobranie obejmuje całe okno
+    std::time_t now = std::time(nullptr);
+    auto job = std::make_shared<FetchJob>();
+    for (const auto& entry : series) {
+        int rows = 500;
+        if (entry.layer) {
+            rows = std::min(rows, (int)((now - entry.lastTime) / 3600) + 3);
+        }
+        job->sensorIds.push_back(entry.sensor.id);
+        job->rows.push_back(rows);
+    }
+    job->measurements.resize(series.size());
+    job->fetched.assign(series.size(), 0);
+
+    // Zapytania HTTP w wątku tła, żeby okno nie zamarzało; wynik trafia do OnFetchDone w wątku GUI
+    fetching_ = true;
+    refreshButton->Disable();
+    std::shared_ptr<FetchState> state = state_;
+    std::thread([state, job]() {
+        for (size_t i = 0; i < job->sensorIds.size(); ++i) {
+            job->fetched[i] = FetchSeries(job->sensorIds[i], job->rows[i], job->measurements[i]) ? 1 : 0;
+        }
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnFetchDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void ChartFrame::OnFetchDone(FetchJob& job) {
+    fetching_ = false;
+    refreshButton->Enable();
+    mpUpdateBatch updateBatch(plot);
+
+    std::time_t now = std::time(nullptr);
+    std::time_t windowStart = now - visibleDays * 24 * 3600;
 
     // Generator kolorów dla różnych sensorów
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(0, 255);
 
-    // Zmienne do obliczania zakresu osi Y
-    double yMin = std::numeric_limits<double>::max();
-    double yMax = std::numeric_limits<double>::lowest();
-
-    for (const auto& sensor : sensors) {
-        // Pobierz dane dla sensora
-        std::string target = "/pjp-api/v1/rest/data/getData/" + std::to_string(sensor.id) + "?size=500&page=0";
-        wxString data = fetch_data(target, "", false);
-        if (data.StartsWith("ERROR:")) {
-            wxLogError("Błąd pobierania danych dla sensora %d: %s", sensor.id, data.c_str());
+    bool legendChanged = false;
+    for (size_t i = 0; i < series.size() && i < job.measurements.size(); ++i) {
+        ChartSeries& entry = series[i];
+        // Usuń punkty, które wyszły poza okno czasu, nawet jeśli pobranie się nie udało
+        if (entry.layer) {
+            entry.layer->EvictBefore((double)windowStart);
+        }
+        for (auto* overlay : entry.overlays) {
+            if (overlay) {
+                overlay->EvictBefore((double)windowStart);
+            }
+        }
+        if (entry.anomalies) {
+            entry.anomalies->EvictBefore((double)windowStart);
+        }
+        if (!job.fetched[i]) {
             continue;
         }
+        std::vector<Measurement>& measurements = job.measurements[i];
+
+        // API zwraca pomiary od najnowszego; seria jest rosnąca w czasie, żeby nowe punkty trafiały na koniec
+        std::sort(measurements.begin(), measurements.end(),
+            [](const Measurement& a, const Measurement& b) { return a.time < b.time; });
+
+        std::vector<double> x_values;
+        std::vector<double> y_values;
+        std::vector<double> anomalyX;
+        std::vector<double> anomalyY;
+        for (const auto& m : measurements) {
+            if (m.time > now) {
+                continue;
+            }
+            // Statystyki i detektor dostają każdy nowy pomiar, także sprzed okna czasu (rozbieg średnich 24 h
+            // i mediany); pomiary już ocenione detektor pomija
+            entry.statistics.Add(m.time, m.value);
+            unsigned flags = entry.detector.Add(m.time, m.value);
 
-        try {
-            nlohmann::json j = nlohmann::json::parse(data.ToStdString());
-            if (!j.contains("Lista danych pomiarowych")) {
-                wxLogError("Brak danych pomiarowych dla sensora %d", sensor.id);
+            // Tylko okno czasu i tylko pomiary, których jeszcze nie ma na wykresie
+            if (m.time < windowStart || (entry.layer && m.time <= entry.lastTime)) {
                 continue;
             }
+            x_values.push_back((double)m.time);
+            y_values.push_back(m.value);
+            entry.lastTime = m.time;
+            if (flags != ANOMALY_NONE) {
+                anomalyX.push_back((double)m.time);
+                anomalyY.push_back(m.value);
+            }
+        }
 
-            std::vector<double> x_values;
-            std::vector<double> y_values;
+        if (entry.layer) {
+            entry.layer->AppendData(x_values, y_values);
+            legendChanged |= UpdateOverlays(entry, windowStart);
+            legendChanged |= UpdateAnomalies(entry, anomalyX, anomalyY);
+            continue;
+        }
+        if (x_values.empty()) {
+            continue;
+        }
 
-            for (const auto& measurement : j["Lista danych pomiarowych"]) {
-                if (measurement.contains("Wartość") && !measurement["Wartość"].is_null()) {
-                    wxString dateStr = wxString::FromUTF8(measurement["Data"].get<std::string>().c_str());
-                    wxDateTime date;
-                    date.ParseFormat(dateStr, "%Y-%m-%d %H:%M:%S");
+        // Generuj losowy kolor dla sensora
+        wxColour color(dis(gen), dis(gen), dis(gen));
+
+        // warstwę dla sensora
+        // Nazwa warstwy nie jest rysowana (jest legenda), ale pokazuje ją podgląd najbliższego pomiaru
+        entry.layer = new mpFXYRingBuffer(entry.sensor.paramName, (visibleDays + 1) * pointsPerDay);
+        entry.layer->ShowName(false);
+        entry.layer->AppendData(x_values, y_values);
+        entry.layer->SetContinuity(true);
+        wxPen pen(color, 2);
+        entry.layer->SetPen(pen);
+        entry.layer->SetDrawOutsideMargins(false);
+        plot->AddLayer(entry.layer);
+        UpdateOverlays(entry, windowStart);
+        UpdateAnomalies(entry, anomalyX, anomalyY);
+        legendChanged = true;
+    }
 
-                    if (!date.IsValid() || date < threeDaysAgo || date > now) {
-                        continue;
-                    }
+    UpdateLayerVisibility();
+    if (legendChanged) {
+        UpdateLegend();
+    }
+    // W trybie historii widok ustawia użytkownik
+    if (!historyMode_) {
+        FitView();
+    }
+}
 
-                    // Oblicz czas w godzinach wstecz od teraz
-                    wxTimeSpan diff = now - date;
-                    double hours = diff.GetHours() + diff.GetMinutes() / 60.0;
-                    x_values.push_back(hours);
+void ChartFrame::OnRefresh(wxCommandEvent& event) {
+    UpdateData();
+}
 
-                    double value = measurement["Wartość"].get<double>();
-                    y_values.push_back(value);
+void ChartFrame::OnLiveToggle(wxCommandEvent& event) {
+    if (liveCheckBox->IsChecked()) {
+        UpdateData();
+        ScheduleLiveUpdate();
+    }
+    else {
+        liveTimer.Stop();
+    }
+}
+
+void ChartFrame::OnStatisticsToggle(wxCommandEvent& event) {
+    mpUpdateBatch updateBatch(plot);
+    UpdateLayerVisibility();
+}
 
-                    // Aktualizuj yMin i yMax
-                    yMin = std::min(yMin, value);
-                    yMax = std::max(yMax, value);
+void ChartFrame::OnHistoryToggle(wxCommandEvent& event) {
+    mpUpdateBatch updateBatch(plot);
+    historyMode_ = historyCheckBox->IsChecked();
+    if (historyMode_) {
+        // Archiwum jest wczytywane przy każdym włączeniu, bo mogło zostać uzupełnione w międzyczasie.
+        // Warstwa piramidy rysuje wieloletnią serię kosztem zależnym od szerokości wykresu, nie od liczby pomiarów.
+        SeriesStore store("database/history");
+        size_t loaded = 0;
+        bool legendChanged = false;
+        for (auto& entry : series) {
+            std::vector<Measurement> measurements;
+            std::vector<double> x_values;
+            std::vector<double> y_values;
+            if (store.Load(entry.sensor.id, measurements)) {
+                x_values.reserve(measurements.size());
+                y_values.reserve(measurements.size());
+                for (const auto& m : measurements) {
+                    x_values.push_back((double)m.time);
+                    y_values.push_back(m.value);
                 }
             }
+            if (x_values.empty() && !entry.history) {
+                continue;
+            }
+            if (!entry.history) {
+                entry.history = new mpFXYPyramid(entry.sensor.paramName);
+                entry.history->ShowName(false);
+                entry.history->SetContinuity(true);
+                wxColour color = entry.layer ? entry.layer->GetPen().GetColour() : wxColour(128, 128, 128);
+                entry.history->SetPen(wxPen(color, 1));
+                entry.history->SetDrawOutsideMargins(false);
+                plot->AddLayer(entry.history);
+                legendChanged |= !entry.layer;
+            }
+            entry.history->SetData(x_values, y_values);
+            loaded += x_values.size();
+        }
+        if (loaded == 0) {
+            wxLogMessage("Brak pomiarów tej stacji w lokalnym archiwum (database/history). Można je pobrać przyciskiem \"Uzupełnij archiwum\" w oknie głównym.");
+        }
+        if (legendChanged) {
+            UpdateLegend();
+        }
+    }
+
+    UpdateLayerVisibility();
+    plot->EnableMousePanZoom(historyMode_);
+    if (historyMode_) {
+        FitHistory();
+    }
+    else {
+        FitView();
+    }
+}
+
+void ChartFrame::UpdateLayerVisibility() {
+    const bool recent = !historyMode_;
+    for (auto& entry : series) {
+        if (entry.layer) {
+            entry.layer->SetVisible(recent);
+        }
+        for (auto* overlay : entry.overlays) {
+            if (overlay) {
+                overlay->SetVisible(recent && statisticsCheckBox->IsChecked());
+            }
+        }
+        if (entry.anomalies) {
+            entry.anomalies->SetVisible(recent);
+        }
+        if (entry.history) {
+            entry.history->SetVisible(historyMode_);
+        }
+    }
+}
+
+void ChartFrame::FitHistory() {
+    double xMin = std::numeric_limits<double>::max();
+    double xMax = std::numeric_limits<double>::lowest();
+    double yMin = 0.0;
+    double yMax = 0.0;
+    for (const auto& entry : series) {
+        if (entry.history && entry.history->GetCount() > 0) {
+            xMin = std::min(xMin, entry.history->GetMinX());
+            xMax = std::max(xMax, entry.history->GetMaxX());
+            yMin = std::min(yMin, entry.history->GetMinY());
+            yMax = std::max(yMax, entry.history->GetMaxY());
+        }
+    }
+    if (xMin > xMax) {
+        FitView();
+        return;
+    }
+    double margin = (yMax - yMin) * 0.1;
+    plot->Fit(xMin, xMax, yMin - margin, yMax + margin);
+}
+
+bool ChartFrame::UpdateOverlays(ChartSeries& entry, std::time_t windowStart) {
+    bool created = false;
+    std::vector<double> x_values;
+    std::vector<double> y_values;
+    for (int s = 0; s < STAT_COUNT; ++s) {
+        RollingStatistic statistic = (RollingStatistic)s;
+        entry.statistics.TakePending(statistic, windowStart, x_values, y_values);
+        // Średnia 1-godzinna z pomiarów godzinowych pokrywa się z samą serią, więc nie jest rysowana
+        if (statistic == STAT_MEAN_1H || !entry.statistics.IsEnabled(statistic)) {
+            continue;
+        }
+        if (entry.overlays[s]) {
+            entry.overlays[s]->AppendData(x_values, y_values);
+            continue;
+        }
+        if (x_values.empty()) {
+            continue;
+        }
+
+        // Kolor serii; średnie kreskowane, maksimum dobowe kropkowane. Pojemność jak seria - jeden punkt na godzinę okna
+        mpFXYRingBuffer* overlay = new mpFXYRingBuffer(entry.sensor.paramName + " - " + SensorStatistics::Name(statistic),
+            entry.layer->GetCapacity());
+        overlay->ShowName(false);
+        overlay->AppendData(x_values, y_values);
+        overlay->SetContinuity(true);
+        wxPen pen(entry.layer->GetPen().GetColour(), 1, statistic == STAT_DAILY_MAX ? wxPENSTYLE_DOT : wxPENSTYLE_SHORT_DASH);
+        overlay->SetPen(pen);
+        overlay->SetDrawOutsideMargins(false);
+        overlay->SetVisible(statisticsCheckBox->IsChecked());
+        plot->AddLayer(overlay);
+        entry.overlays[s] = overlay;
+        created = true;
+    }
+    return created;
+}
 
-            if (!x_values.empty()) {
-                // Generuj losowy kolor dla sensora
-                wxColour color(dis(gen), dis(gen), dis(gen));
-
-                // warstwę dla sensora
-                mpFXYVector* layer = new mpFXYVector("");
-                layer->SetData(x_values, y_values);
-                layer->SetContinuity(true);
-                wxPen pen(color, 2); 
-                layer->SetPen(pen);
-                layer->SetDrawOutsideMargins(false);
-                plot->AddLayer(layer);
-
-                // Dodaje sensory do legendy
-                legendLabels.push_back(sensor.paramName);
-                sensorColors.push_back(color);
+bool ChartFrame::UpdateAnomalies(ChartSeries& entry, const std::vector<double>& x_values, const std::vector<double>& y_values) {
+    if (entry.anomalies) {
+        entry.anomalies->AppendData(x_values, y_values);
+        return false;
+    }
+    if (x_values.empty()) {
+        return false;
+    }
+
+    // Punkty bez linii; gruby czerwony pisak rysuje je jako wyraźne kropki na serii.
+    // Znaczników nie może być więcej niż punktów serii, więc pojemność jest ta sama
+    entry.anomalies = new mpFXYRingBuffer(entry.sensor.paramName + " - podejrzany pomiar", entry.layer->GetCapacity());
+    entry.anomalies->ShowName(false);
+    entry.anomalies->AppendData(x_values, y_values);
+    entry.anomalies->SetContinuity(false);
+    wxPen pen(*wxRED, 8);
+    entry.anomalies->SetPen(pen);
+    entry.anomalies->SetDrawOutsideMargins(false);
+    plot->AddLayer(entry.anomalies);
+    return true;
+}
+
+void ChartFrame::OnLiveTimer(wxTimerEvent& event) {
+    UpdateData();
+    ScheduleLiveUpdate();
+}
+
+void ChartFrame::ScheduleLiveUpdate() {
+    // Następne odświeżenie: najbliższa pełna godzina plus opóźnienie publikacji
+    std::time_t now = std::time(nullptr);
+    std::time_t next = now - now % 3600 + livePublishDelaySeconds;
+    if (next <= now) {
+        next += 3600;
+    }
+    liveTimer.StartOnce((int)(next - now) * 1000);
+}
+
+void ChartFrame::UpdateLegend() {
+    // Dodaje sensory do legendy
+    std::vector<wxString> legendLabels;
+    sensorColors.clear();
+    for (const auto& entry : series) {
+        if (entry.layer) {
+            legendLabels.push_back(entry.sensor.paramName);
+            sensorColors.push_back(entry.layer->GetPen().GetColour());
+        }
+        else if (entry.history) {
+            legendLabels.push_back(entry.sensor.paramName);
+            sensorColors.push_back(entry.history->GetPen().GetColour());
+        }
+        for (int s = 0; s < STAT_COUNT; ++s) {
+            if (entry.overlays[s]) {
+                legendLabels.push_back("  " + SensorStatistics::Name((RollingStatistic)s));
+                sensorColors.push_back(entry.overlays[s]->GetPen().GetColour());
             }
         }
-        catch (const std::exception& e) {
-            wxLogError("Błąd parsowania danych dla sensora %d: %s", sensor.id, e.what());
+        if (entry.anomalies) {
+            legendLabels.push_back("  podejrzane pomiary");
+            sensorColors.push_back(entry.anomalies->GetPen().GetColour());
         }
     }
 
@@ -167,30 +509,36 @@ void ChartFrame::FetchAndPlotData(const Station& station, const std::vector<Sens
     legendPanel = new LegendPanel(legendContainer, legendLabels, sensorColors);
     legendContainer->GetSizer()->Add(legendPanel, 1, wxEXPAND | wxALL, 5);
     legendContainer->Layout();
+}
 
-    // Dodaje osie
-    plot->AddLayer(xaxis);
-    plot->AddLayer(yaxis);
-
-    // Zablokowanie przewijania i zoomowania myszą
-    plot->EnableMousePanZoom(false);
-
-    double maxHours = 3 * 24.0; // 3 dni to 72 godziny
-
+void ChartFrame::FitView() {
+    // Okno czasu: ostatnie dni, kończące się teraz
+    std::time_t now = std::time(nullptr);
+    double xMax = (double)now;
+    double xMin = xMax - visibleDays * 24 * 3600.0;
+
+    // Zakres Y z obwiedni buforów (utrzymywanej przyrostowo), tylko z punktów w oknie
+    double fitMin = std::numeric_limits<double>::max();
+    double fitMax = std::numeric_limits<double>::lowest();
+    for (const auto& entry : series) {
+        if (entry.layer && entry.layer->GetCount() > 0) {
+            fitMin = std::min(fitMin, entry.layer->GetMinY());
+            fitMax = std::max(fitMax, entry.layer->GetMaxY());
+        }
+    }
     // Jeśli nie ma danych, ustaw domyślny zakres osi Y
-    if (yMin > yMax) { // Brak danych
-        yMin = 0.0;
-        yMax = 72.0;
+    if (fitMin > fitMax) { // Brak danych
+        fitMin = 0.0;
+        fitMax = 72.0;
     }
     else {
-        yMin = std::min(yMin, 0.0);
-        yMax = std::max(yMax, 0.0);
+        fitMin = std::min(fitMin, 0.0);
+        fitMax = std::max(fitMax, 0.0);
         // margines do zakresu Y (np. 10% z każdej strony)
-        double margin = (yMax - yMin) * 0.1;
-        yMin -= margin;
-        yMax += margin;
+        double margin = (fitMax - fitMin) * 0.1;
+        fitMin -= margin;
+        fitMax += margin;
     }
 
-    plot->Fit(0.0, maxHours, yMin, yMax);
-    plot->UpdateAll();
-}
\ No newline at end of file
+    plot->Fit(xMin, xMax, fitMin, fitMax);
+}
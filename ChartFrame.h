@@ -2,10 +2,15 @@
 #define CHART_FRAME_H
 
 #include <wx/wx.h>
+#include <wx/timer.h>
 #include "mathplot.h"
 #include <nlohmann/json.hpp>
 #include <vector>
+#include <memory>
+#include <ctime>
 #include "main.h"
+#include "RollingStats.h"
+#include "AnomalyDetector.h"
 
 class LegendPanel : public wxPanel {
 public:
@@ -18,16 +23,65 @@ private:
     wxDECLARE_EVENT_TABLE();
 };
 
+// Seria jednego sensora na wykresie; X to sekundy od epoki, więc nowe pomiary są tylko dopisywane
+// do bufora cyklicznego, a najstarsze są z niego usuwane
+struct ChartSeries {
+    Sensor sensor;
+    mpFXYRingBuffer* layer = nullptr;  // nullptr, dopóki sensor nie ma żadnych danych
+    std::time_t lastTime = 0;      // czas ostatniego pomiaru na wykresie
+    SensorStatistics statistics;   // średnie kroczące i maksima dobowe, aktualizowane nowymi pomiarami
+    mpFXYRingBuffer* overlays[STAT_COUNT] = {};  // warstwy statystyk (okno czasu jak seria); nullptr, dopóki statystyka nie ma punktów
+    SensorAnomalyDetector detector;  // ocena każdego nowego pomiaru (skoki, stała wartość, przerwy)
+    mpFXYRingBuffer* anomalies = nullptr;  // znaczniki podejrzanych pomiarów w oknie czasu; nullptr, dopóki żadnego nie ma
+    mpFXYPyramid* history = nullptr;   // pomiary z lokalnego archiwum; nullptr, dopóki historia nie była pokazana
+};
+
 class ChartFrame : public wxFrame {
 public:
     ChartFrame(const Station& station, const std::vector<Sensor>& sensors);
+    ~ChartFrame();
 
 private:
+    struct FetchJob;
+    struct FetchState;
+
     void FetchAndPlotData(const Station& station, const std::vector<Sensor>& sensors);
+    // Pobiera w tle pomiary nowsze od już narysowanych; gdy pobieranie już trwa, nic nie robi
+    void UpdateData();
+    // Dopisuje pobrane pomiary do serii i przesuwa okno czasu (wątek GUI)
+    void OnFetchDone(FetchJob& job);
+    void OnRefresh(wxCommandEvent& event);
+    // Tryb na żywo: odświeżanie co godzinę, po publikacji nowych pomiarów
+    void OnLiveToggle(wxCommandEvent& event);
+    void OnStatisticsToggle(wxCommandEvent& event);
+    // Historia: wszystkie pomiary z lokalnego archiwum (SeriesStore), z przesuwaniem i powiększaniem
+    void OnHistoryToggle(wxCommandEvent& event);
+    // Widoczność warstw zgodnie z trybem (okno ostatnich dni albo historia) i przełącznikiem statystyk
+    void UpdateLayerVisibility();
+    void FitHistory();
+    void OnLiveTimer(wxTimerEvent& event);
+    void ScheduleLiveUpdate();
+    // Dopisuje nowe punkty statystyk serii do warstw nakładek (tworzy brakujące warstwy)
+    bool UpdateOverlays(ChartSeries& entry, std::time_t windowStart);
+    // Dopisuje podejrzane pomiary do warstwy znaczników serii (tworzy ją przy pierwszym)
+    bool UpdateAnomalies(ChartSeries& entry, const std::vector<double>& x_values, const std::vector<double>& y_values);
+    void UpdateLegend();
+    void FitView();
+
     mpWindow* plot;
     LegendPanel* legendPanel;
     wxPanel* legendContainer;
     std::vector<wxColour> sensorColors;
+    std::vector<ChartSeries> series;
+    wxCheckBox* liveCheckBox;
+    wxCheckBox* statisticsCheckBox;
+    wxCheckBox* historyCheckBox;
+    wxButton* refreshButton;
+    wxTimer liveTimer;
+    int visibleDays;  // długość okna czasu na wykresie
+    bool fetching_;   // pobieranie w tle trwa; kolejne odświeżenia są pomijane
+    bool historyMode_;  // pokazana historia z archiwum zamiast okna ostatnich dni
+    std::shared_ptr<FetchState> state_;
 };
 
 #endif // CHART_FRAME_H
\ No newline at end of file
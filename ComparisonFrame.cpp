@@ -0,0 +1,321 @@
+#include "ComparisonFrame.h"
+#include "ChartFrame.h"
+#include <algorithm>
+
+namespace {
+    // Wykres obejmuje ostatnie 3 dni, tak jak ChartFrame
+    const int comparisonHours = 3 * 24;
+    const unsigned maxFetchThreads = 8;
+
+    // Kolory serii rozłożone równomiernie na kole barw, więc są rozróżnialne także przy wielu stacjach
+    wxColour SeriesColour(size_t index, size_t count) {
+        wxImage::HSVValue hsv((double)index / std::max<size_t>(count, 1), 0.8, 0.85);
+        wxImage::RGBValue rgb = wxImage::HSVtoRGB(hsv);
+        return wxColour(rgb.red, rgb.green, rgb.blue);
+    }
+}
+
+void ParameterIndex::Build(const std::vector<Station>& stations) {
+    index_.clear();
+    for (const auto& station : stations) {
+        for (const auto& sensor : station.sensors) {
+            index_[sensor.paramName].push_back({ station.id, sensor.id });
+        }
+    }
+}
+
+std::vector<wxString> ParameterIndex::Parameters() const {
+    std::vector<wxString> parameters;
+    for (const auto& entry : index_) {
+        parameters.push_back(entry.first);
+    }
+    return parameters;
+}
+
+const std::vector<SensorRef>& ParameterIndex::Sensors(const wxString& paramName) const {
+    static const std::vector<SensorRef> empty;
+    auto it = index_.find(paramName);
+    return it != index_.end() ? it->second : empty;
+}
+
+// Uzupełnienie katalogu czujników: kopia stacji, w której wątki tła dopisują brakujące czujniki
+struct ComparisonFrame::CatalogJob {
+    std::vector<Station> stations;
+};
+
+// Pobranie serii wybranych czujników; każda pozycja wyników jest zapisywana tylko przez jedno zadanie
+struct ComparisonFrame::SeriesJob {
+    unsigned generation = 0;
+    wxString paramName;
+    std::vector<SensorRef> sensors;
+    std::vector<std::vector<Measurement>> measurements;
+};
+
+// Stan współdzielony z wątkami tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI
+struct ComparisonFrame::FetchState {
+    ComparisonFrame* frame = nullptr;
+};
+
+ComparisonFrame::ComparisonFrame(const std::vector<Station>& stations, int selectedStationId)
+    : wxFrame(nullptr, wxID_ANY, "Porównanie stacji", wxDefaultPosition, wxSize(1200, 700)),
+      stations_(stations), selectedStationId_(selectedStationId), hours_(comparisonHours), generation_(0),
+      state_(std::make_shared<FetchState>()) {
+    state_->frame = this;
+
+    wxPanel* mainPanel = new wxPanel(this);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxHORIZONTAL);
+
+    // Wybór wskaźnika i stacji
+    wxBoxSizer* selectionSizer = new wxBoxSizer(wxVERTICAL);
+    selectionSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Wskaźnik:"), 0, wxBOTTOM, 5);
+    parameterChoice = new wxChoice(mainPanel, wxID_ANY);
+    selectionSizer->Add(parameterChoice, 0, wxEXPAND | wxBOTTOM, 10);
+    selectionSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Stacje:"), 0, wxBOTTOM, 5);
+    stationChecks = new wxCheckListBox(mainPanel, wxID_ANY, wxDefaultPosition, wxSize(250, -1));
+    selectionSizer->Add(stationChecks, 1, wxEXPAND | wxBOTTOM, 5);
+    wxButton* selectAllButton = new wxButton(mainPanel, wxID_ANY, "Zaznacz wszystkie");
+    showButton = new wxButton(mainPanel, wxID_ANY, "Pokaż");
+    selectionSizer->Add(selectAllButton, 0, wxEXPAND | wxBOTTOM, 5);
+    selectionSizer->Add(showButton, 0, wxEXPAND);
+    mainSizer->Add(selectionSizer, 0, wxEXPAND | wxALL, 10);
+
+    // Wspólny wykres: oś czasu jak w ChartFrame, podgląd najbliższego pomiaru pokazuje nazwę stacji
+    plot = new mpWindow(mainPanel, wxID_ANY);
+    mpScaleX* xaxis = new mpScaleX("Czas", mpALIGN_BOTTOM, true, mpX_DATETIME);
+    mpScaleY* yaxis = new mpScaleY("Wartość", mpALIGN_LEFT, true);
+    xaxis->SetTicks(true);
+    yaxis->SetTicks(true);
+    xaxis->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+    plot->AddLayer(xaxis);
+    plot->AddLayer(yaxis);
+    mpInfoNearest* inspector = new mpInfoNearest(wxRect(80, 20, 10, 10), wxWHITE_BRUSH);
+    inspector->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+    plot->AddLayer(inspector);
+    mainSizer->Add(plot, 1, wxEXPAND | wxALL, 10);
+
+    legendContainer = new wxPanel(mainPanel);
+    wxBoxSizer* legendSizer = new wxBoxSizer(wxVERTICAL);
+    legendSizer->Add(new wxStaticText(legendContainer, wxID_ANY, "Legenda:"), 0, wxALL, 5);
+    legendPanel = new LegendPanel(legendContainer, std::vector<wxString>(), std::vector<wxColour>());
+    legendSizer->Add(legendPanel, 1, wxEXPAND | wxALL, 5);
+    legendContainer->SetSizer(legendSizer);
+    mainSizer->Add(legendContainer, 0, wxEXPAND | wxALL, 5);
+
+    mainPanel->SetSizer(mainSizer);
+    mainPanel->Layout();
+    CreateStatusBar();
+
+    parameterChoice->Bind(wxEVT_CHOICE, &ComparisonFrame::OnParameterChanged, this);
+    selectAllButton->Bind(wxEVT_BUTTON, &ComparisonFrame::OnSelectAll, this);
+    showButton->Bind(wxEVT_BUTTON, &ComparisonFrame::OnShow, this);
+
+    StartCatalogFetch();
+}
+
+ComparisonFrame::~ComparisonFrame() {
+    // Wyniki pobierania zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+}
+
+void ComparisonFrame::StartCatalogFetch() {
+    auto job = std::make_shared<CatalogJob>();
+    job->stations = stations_;
+    size_t missing = std::count_if(stations_.begin(), stations_.end(),
+        [](const Station& s) { return s.sensors.empty(); });
+    if (missing == 0) {
+        OnCatalogDone(*job);
+        return;
+    }
+
+    showButton->Disable();
+    SetStatusText(wxString::Format("Pobieranie katalogu czujników (%zu stacji)...", missing));
+    std::shared_ptr<FetchState> state = state_;
+    std::thread([state, job]() {
+        RunParallel(job->stations.size(), maxFetchThreads, [&job](size_t i) {
+            Station& station = job->stations[i];
+            try {
+                if (station.sensors.empty()) {
+                    FetchStationSensors(station.id, station.sensors);
+                }
+            }
+            catch (const std::exception& e) {
+                wxLogError("Błąd pobierania czujników dla stacji %d: %s", station.id, e.what());
+            }
+            });
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnCatalogDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void ComparisonFrame::OnCatalogDone(CatalogJob& job) {
+    stations_ = std::move(job.stations);
+    index_.Build(stations_);
+    showButton->Enable();
+
+    // Domyślnie wskaźnik mierzony na stacji zaznaczonej w oknie głównym
+    wxString preferred;
+    for (const auto& station : stations_) {
+        if (station.id == selectedStationId_ && !station.sensors.empty()) {
+            preferred = station.sensors.front().paramName;
+        }
+    }
+    parameterChoice->Clear();
+    for (const auto& parameter : index_.Parameters()) {
+        parameterChoice->Append(parameter);
+    }
+    int selection = preferred.IsEmpty() ? wxNOT_FOUND : parameterChoice->FindString(preferred);
+    if (!parameterChoice->IsEmpty()) {
+        parameterChoice->SetSelection(selection != wxNOT_FOUND ? selection : 0);
+    }
+    FillStations();
+    SetStatusText(wxString::Format("Katalog: %zu wskaźników na %zu stacjach.", index_.Parameters().size(), stations_.size()));
+}
+
+void ComparisonFrame::FillStations() {
+    stationChecks->Clear();
+    listed_.clear();
+    if (parameterChoice->GetSelection() == wxNOT_FOUND) {
+        return;
+    }
+
+    // Tylko stacje mierzące wybrany wskaźnik, alfabetycznie
+    std::vector<std::pair<wxString, SensorRef>> entries;
+    for (const auto& sensor : index_.Sensors(parameterChoice->GetStringSelection())) {
+        auto stationIt = std::find_if(stations_.begin(), stations_.end(),
+            [&sensor](const Station& s) { return s.id == sensor.stationId; });
+        if (stationIt != stations_.end()) {
+            entries.push_back({ stationIt->name + " (" + stationIt->province + ")", sensor });
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const std::pair<wxString, SensorRef>& a, const std::pair<wxString, SensorRef>& b) { return a.first < b.first; });
+
+    for (const auto& entry : entries) {
+        int item = stationChecks->Append(entry.first);
+        stationChecks->Check(item, entry.second.stationId == selectedStationId_);
+        listed_.push_back(entry.second);
+    }
+}
+
+void ComparisonFrame::OnParameterChanged(wxCommandEvent& event) {
+    FillStations();
+}
+
+void ComparisonFrame::OnSelectAll(wxCommandEvent& event) {
+    for (unsigned i = 0; i < stationChecks->GetCount(); ++i) {
+        stationChecks->Check(i, true);
+    }
+}
+
+void ComparisonFrame::OnShow(wxCommandEvent& event) {
+    auto job = std::make_shared<SeriesJob>();
+    job->generation = ++generation_;
+    job->paramName = parameterChoice->GetStringSelection();
+    for (unsigned i = 0; i < stationChecks->GetCount(); ++i) {
+        if (stationChecks->IsChecked(i)) {
+            job->sensors.push_back(listed_[i]);
+        }
+    }
+    if (job->sensors.empty()) {
+        SetStatusText("Zaznacz co najmniej jedną stację.");
+        return;
+    }
+    job->measurements.resize(job->sensors.size());
+
+    // Pobierane są tylko czujniki wybranego wskaźnika, równolegle z ograniczeniem liczby zapytań
+    SetStatusText(wxString::Format("Pobieranie %zu serii...", job->sensors.size()));
+    std::shared_ptr<FetchState> state = state_;
+    const int rows = hours_;
+    std::thread([state, job, rows]() {
+        RunParallel(job->sensors.size(), maxFetchThreads, [&job, rows](size_t i) {
+            int sensorId = job->sensors[i].sensorId;
+            try {
+                FetchSeries(sensorId, rows, job->measurements[i]);
+            }
+            catch (const std::exception& e) {
+                wxLogError("Błąd pobierania danych dla sensora %d: %s", sensorId, e.what());
+                job->measurements[i].clear();
+            }
+            });
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnSeriesDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void ComparisonFrame::OnSeriesDone(SeriesJob& job) {
+    // Wynik zastąpiony nowszym pobraniem
+    if (job.generation != generation_) {
+        return;
+    }
+
+    // Wszystkie serie są wymieniane w jednej paczce: obwiednia i odświeżenie wykresu tylko raz
+    mpUpdateBatch updateBatch(plot);
+    for (auto* layer : seriesLayers) {
+        plot->DelLayer(layer, true);
+    }
+    seriesLayers.clear();
+
+    std::time_t now = std::time(nullptr);
+    std::time_t windowStart = now - (std::time_t)hours_ * 3600;
+    double yMin = 0.0;
+    double yMax = 0.0;
+    std::vector<wxString> legendLabels;
+    std::vector<wxColour> legendColors;
+    for (size_t i = 0; i < job.sensors.size(); ++i) {
+        std::vector<Measurement>& measurements = job.measurements[i];
+        std::sort(measurements.begin(), measurements.end(),
+            [](const Measurement& a, const Measurement& b) { return a.time < b.time; });
+        std::vector<double> x_values;
+        std::vector<double> y_values;
+        for (const auto& m : measurements) {
+            if (m.time >= windowStart && m.time <= now) {
+                x_values.push_back((double)m.time);
+                y_values.push_back(m.value);
+                yMin = std::min(yMin, m.value);
+                yMax = std::max(yMax, m.value);
+            }
+        }
+        if (x_values.empty()) {
+            continue;
+        }
+
+        wxString name;
+        for (const auto& station : stations_) {
+            if (station.id == job.sensors[i].stationId) {
+                name = station.name;
+                break;
+            }
+        }
+        wxColour color = SeriesColour(i, job.sensors.size());
+        mpFXYVector* layer = new mpFXYVector(name);
+        layer->ShowName(false);
+        layer->SetData(x_values, y_values);
+        layer->SetContinuity(true);
+        layer->SetPen(wxPen(color, 2));
+        layer->SetDrawOutsideMargins(false);
+        plot->AddLayer(layer, false);
+        seriesLayers.push_back(layer);
+        legendLabels.push_back(name);
+        legendColors.push_back(color);
+    }
+
+    // Legenda
+    legendPanel->Destroy();
+    legendPanel = new LegendPanel(legendContainer, legendLabels, legendColors);
+    legendContainer->GetSizer()->Add(legendPanel, 1, wxEXPAND | wxALL, 5);
+    legendContainer->Layout();
+
+    if (seriesLayers.empty()) {
+        SetStatusText(wxString::Format("%s: brak danych z ostatnich %d godzin.", job.paramName, hours_));
+        return;
+    }
+    double margin = std::max((yMax - yMin) * 0.1, 1.0);
+    plot->Fit((double)windowStart, (double)now, yMin - margin, yMax + margin);
+    SetStatusText(wxString::Format("%s: %zu stacji z danymi.", job.paramName, seriesLayers.size()));
+}
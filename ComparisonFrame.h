@@ -0,0 +1,71 @@
+#ifndef COMPARISON_FRAME_H
+#define COMPARISON_FRAME_H
+
+#include <wx/wx.h>
+#include <wx/checklst.h>
+#include "mathplot.h"
+#include <map>
+#include <memory>
+#include <vector>
+#include "main.h"
+
+class LegendPanel;
+
+// Czujnik mierzący wskaźnik na stacji
+struct SensorRef {
+    int stationId;
+    int sensorId;
+};
+
+// Indeks odwrotny katalogu czujników: nazwa wskaźnika -> czujniki wszystkich stacji, które go mierzą
+class ParameterIndex {
+public:
+    void Build(const std::vector<Station>& stations);
+    // Nazwy wskaźników, alfabetycznie
+    std::vector<wxString> Parameters() const;
+    // Czujniki wskaźnika (pusta lista dla nieznanego wskaźnika)
+    const std::vector<SensorRef>& Sensors(const wxString& paramName) const;
+
+private:
+    std::map<wxString, std::vector<SensorRef>> index_;
+};
+
+// Porównanie jednego wskaźnika na wielu stacjach na wspólnym wykresie.
+// Pobierane są tylko czujniki wybranego wskaźnika, równolegle i w tle.
+class ComparisonFrame : public wxFrame {
+public:
+    ComparisonFrame(const std::vector<Station>& stations, int selectedStationId);
+    ~ComparisonFrame();
+
+private:
+    struct CatalogJob;
+    struct SeriesJob;
+    struct FetchState;
+
+    // Uzupełnia w tle czujniki stacji, których jeszcze nie znamy, i buduje indeks
+    void StartCatalogFetch();
+    void OnCatalogDone(CatalogJob& job);
+    void FillStations();
+    void OnParameterChanged(wxCommandEvent& event);
+    void OnSelectAll(wxCommandEvent& event);
+    void OnShow(wxCommandEvent& event);
+    void OnSeriesDone(SeriesJob& job);
+
+    mpWindow* plot;
+    wxChoice* parameterChoice;
+    wxCheckListBox* stationChecks;
+    wxButton* showButton;
+    LegendPanel* legendPanel;
+    wxPanel* legendContainer;
+    std::vector<mpLayer*> seriesLayers;
+
+    std::vector<Station> stations_;
+    int selectedStationId_;
+    ParameterIndex index_;
+    std::vector<SensorRef> listed_;     // czujniki stacji na liście, w kolejności pozycji listy
+    int hours_;                          // długość okna czasu na wykresie
+    unsigned generation_;                // numer ostatniego pobrania serii, starsze wyniki są pomijane
+    std::shared_ptr<FetchState> state_;
+};
+
+#endif // COMPARISON_FRAME_H
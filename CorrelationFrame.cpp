@@ -0,0 +1,311 @@
+#include "CorrelationFrame.h"
+#include "HeatmapFrame.h"
+#include "HourlyGrid.h"
+#include <wx/dcbuffer.h>
+#include <wx/filedlg.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    // Okresy do wyboru (dni) i liczba pomiarów na stronę archiwum API
+    const int windowDays[] = { 7, 30, 90 };
+    const int pageSize = 500;
+    const unsigned maxFetchThreads = 8;
+    // Korelacja jest liczona, gdy stacje mają co najmniej dobę wspólnych pomiarów
+    const size_t minOverlapHours = 24;
+
+    // Pomiary z ostatnich days dni: kolejne strony archiwum, aż strona będzie niepełna
+    bool FetchWindow(int sensorId, int days, std::vector<Measurement>& measurements) {
+        const int maxPages = days * 24 / pageSize + 2;
+        for (int page = 0; page < maxPages; ++page) {
+            ApiRateLimiter().Acquire();
+            std::string target = "/pjp-api/v1/rest/archivalData/getDataBySensor/" + std::to_string(sensorId) +
+                "?size=" + std::to_string(pageSize) + "&page=" + std::to_string(page) + "&dayNumber=" + std::to_string(days);
+            wxString data = fetch_data(target, "", false);
+            if (data.StartsWith("ERROR:")) {
+                wxLogError("Błąd pobierania danych dla sensora %d: %s", sensorId, data.c_str());
+                return !measurements.empty();
+            }
+            std::vector<Measurement> pageMeasurements;
+            if (!ParseMeasurements(data.ToStdString(wxConvUTF8), "Lista archiwalnych wyników pomiarów", pageMeasurements, true)) {
+                return !measurements.empty();
+            }
+            measurements.insert(measurements.end(), pageMeasurements.begin(), pageMeasurements.end());
+            if (pageMeasurements.size() < (size_t)pageSize) {
+                break;
+            }
+        }
+        return !measurements.empty();
+    }
+
+    // Pole CSV w cudzysłowie (nazwy stacji mogą zawierać separator)
+    wxString CsvField(const wxString& text) {
+        wxString escaped = text;
+        escaped.Replace("\"", "\"\"");
+        return "\"" + escaped + "\"";
+    }
+}
+
+// Obliczenie w tle: kopia stacji (wątki tła uzupełniają brakujące czujniki), pomiary i gotowa macierz
+struct CorrelationFrame::FetchJob {
+    unsigned generation = 0;
+    AqiPollutant pollutant = AQI_PM10;
+    int days = 7;
+    std::vector<Station> stations;
+    std::vector<std::vector<Measurement>> series;   // dla każdej stacji z stations
+    std::vector<size_t> matrixStations;             // stacje z pomiarami, w kolejności macierzy
+    CorrelationMatrix matrix;
+    double computeMs = 0.0;
+};
+
+// Stan współdzielony z wątkami tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI
+struct CorrelationFrame::FetchState {
+    CorrelationFrame* frame = nullptr;
+};
+
+CorrelationFrame::CorrelationFrame(const std::vector<Station>& stations)
+    : wxFrame(nullptr, wxID_ANY, "Korelacje stacji", wxDefaultPosition, wxSize(1000, 850)),
+      stations_(stations), generation_(0), state_(std::make_shared<FetchState>()) {
+    state_->frame = this;
+
+    wxPanel* mainPanel = new wxPanel(this);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    // Zanieczyszczenie, okres i przyciski
+    wxBoxSizer* controlsSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxArrayString labels;
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        labels.Add(AqiEngine::PollutantName((AqiPollutant)p));
+    }
+    pollutantChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, labels);
+    pollutantChoice->SetSelection(AQI_PM10);
+    wxArrayString windows;
+    for (int days : windowDays) {
+        windows.Add(wxString::Format("Ostatnie %d dni", days));
+    }
+    windowChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, windows);
+    windowChoice->SetSelection(0);
+    computeButton = new wxButton(mainPanel, wxID_ANY, "Oblicz");
+    exportButton = new wxButton(mainPanel, wxID_ANY, "Eksport CSV");
+    exportButton->Disable();
+    controlsSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Zanieczyszczenie:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    controlsSizer->Add(pollutantChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(windowChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(computeButton, 0, wxRIGHT, 5);
+    controlsSizer->Add(exportButton, 0);
+    mainSizer->Add(controlsSizer, 0, wxALL, 10);
+
+    // Macierz: wiersz 0 (pierwsza stacja) u góry, kolumny w tej samej kolejności
+    wxBoxSizer* plotSizer = new wxBoxSizer(wxHORIZONTAL);
+    plot = new mpWindow(mainPanel, wxID_ANY);
+    matrixLayer = new mpBitmapLayer();
+    matrixLayer->SetVisible(false);
+    plot->AddLayer(matrixLayer);
+    plotSizer->Add(plot, 1, wxEXPAND | wxRIGHT, 10);
+
+    scalePanel = new wxPanel(mainPanel, wxID_ANY, wxDefaultPosition, wxSize(90, -1));
+    scalePanel->SetBackgroundStyle(wxBG_STYLE_PAINT);
+    plotSizer->Add(scalePanel, 0, wxEXPAND);
+    mainSizer->Add(plotSizer, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
+
+    mainPanel->SetSizer(mainSizer);
+    mainPanel->Layout();
+    CreateStatusBar();
+    SetStatusText("Wybierz zanieczyszczenie i okres, a następnie kliknij Oblicz.");
+
+    colormap_.reset(new HeatmapColormap(-1.0f, 1.0f, true));
+
+    computeButton->Bind(wxEVT_BUTTON, &CorrelationFrame::OnCompute, this);
+    exportButton->Bind(wxEVT_BUTTON, &CorrelationFrame::OnExport, this);
+    plot->Bind(wxEVT_MOTION, &CorrelationFrame::OnPlotMotion, this);
+    scalePanel->Bind(wxEVT_PAINT, &CorrelationFrame::OnScalePaint, this);
+}
+
+CorrelationFrame::~CorrelationFrame() {
+    // Wyniki obliczenia zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+}
+
+void CorrelationFrame::OnCompute(wxCommandEvent& event) {
+    if (stations_.empty()) {
+        SetStatusText("Brak stacji do analizy.");
+        return;
+    }
+
+    auto job = std::make_shared<FetchJob>();
+    job->generation = ++generation_;
+    job->pollutant = (AqiPollutant)pollutantChoice->GetSelection();
+    job->days = windowDays[windowChoice->GetSelection()];
+    job->stations = stations_;
+    job->series.resize(job->stations.size());
+
+    computeButton->Disable();
+    exportButton->Disable();
+    SetStatusText(wxString::Format("Pobieranie pomiarów %zu stacji z %d dni...", job->stations.size(), job->days));
+
+    std::shared_ptr<FetchState> state = state_;
+    std::thread([state, job]() {
+        // Każde zadanie zapisuje tylko swoją stację i jej serię
+        RunParallel(job->stations.size(), maxFetchThreads, [&job](size_t i) {
+            Station& station = job->stations[i];
+            try {
+                if (station.sensors.empty()) {
+                    FetchStationSensors(station.id, station.sensors);
+                }
+                int sensorId = FindSensor(station.sensors, job->pollutant);
+                if (sensorId != 0) {
+                    FetchWindow(sensorId, job->days, job->series[i]);
+                }
+            }
+            catch (const std::exception& e) {
+                wxLogError("Błąd pobierania danych stacji %d: %s", station.id, e.what());
+            }
+            });
+
+        // Stacje z pomiarami, pogrupowane według województw, w województwie alfabetycznie
+        for (size_t i = 0; i < job->stations.size(); ++i) {
+            if (!job->series[i].empty()) {
+                job->matrixStations.push_back(i);
+            }
+        }
+        std::sort(job->matrixStations.begin(), job->matrixStations.end(), [&job](size_t a, size_t b) {
+            const Station& first = job->stations[a];
+            const Station& second = job->stations[b];
+            int province = first.province.CmpNoCase(second.province);
+            return province != 0 ? province < 0 : first.name.CmpNoCase(second.name) < 0;
+            });
+
+        // Siatka ostatnich days * 24 godzin, kończąca się na najnowszym pomiarze
+        std::time_t last = 0;
+        for (size_t i : job->matrixStations) {
+            for (const auto& m : job->series[i]) {
+                last = std::max(last, m.time);
+            }
+        }
+        const int hours = job->days * 24;
+        HourlyGrid grid;
+        grid.Reset(last - (std::time_t)(hours - 1) * 3600, hours, job->matrixStations.size());
+        for (size_t column = 0; column < job->matrixStations.size(); ++column) {
+            grid.SetColumn(column, job->series[job->matrixStations[column]]);
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        job->matrix.Compute(grid, minOverlapHours);
+        job->computeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnComputeDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void CorrelationFrame::OnComputeDone(FetchJob& job) {
+    if (job.generation != generation_) {
+        return;
+    }
+    computeButton->Enable();
+
+    // Czujniki pobrane w tle są zapamiętywane na kolejne obliczenia
+    for (size_t i = 0; i < job.stations.size() && i < stations_.size(); ++i) {
+        if (stations_[i].sensors.empty()) {
+            stations_[i].sensors = std::move(job.stations[i].sensors);
+        }
+    }
+
+    matrix_ = std::move(job.matrix);
+    matrixStations_ = std::move(job.matrixStations);
+    const size_t size = matrix_.Size();
+    if (size < 2) {
+        matrixLayer->SetVisible(false);
+        plot->UpdateAll();
+        SetStatusText("Za mało stacji z pomiarami, aby policzyć korelacje.");
+        return;
+    }
+
+    wxImage image((int)size, (int)size, false);
+    colormap_->Colorize(matrix_.Values().data(), matrix_.Values().size(), image.GetData());
+    matrixLayer->SetBitmap(image, 0.0, 0.0, (double)size, (double)size);
+    matrixLayer->SetVisible(true);
+    plot->Fit(0.0, (double)size, 0.0, (double)size);
+    scalePanel->Refresh();
+    exportButton->Enable();
+
+    SetStatusText(wxString::Format("%s, %d dni: %zu stacji, %zu par, macierz policzona w %.0f ms.",
+        AqiEngine::PollutantName(job.pollutant), job.days, size, size * (size - 1) / 2, job.computeMs));
+}
+
+void CorrelationFrame::OnExport(wxCommandEvent& event) {
+    const size_t size = matrix_.Size();
+    if (size == 0) {
+        return;
+    }
+    wxFileDialog dialog(this, "Zapisz macierz korelacji", wxGetCwd(), "korelacje.csv",
+        "Pliki CSV (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+
+    // Separator ';', kropka dziesiętna niezależnie od ustawień regionalnych, pusta komórka dla braku korelacji
+    wxString csv = "Stacja";
+    for (size_t i : matrixStations_) {
+        csv += ";" + CsvField(stations_[i].name);
+    }
+    csv += "\n";
+    for (size_t a = 0; a < size; ++a) {
+        csv += CsvField(stations_[matrixStations_[a]].name);
+        for (size_t b = 0; b < size; ++b) {
+            float r = matrix_.At(a, b);
+            csv += ";";
+            if (!std::isnan(r)) {
+                csv += wxString::FromCDouble(r, 4);
+            }
+        }
+        csv += "\n";
+    }
+
+    if (SaveToFile(std::string(csv.utf8_str()), dialog.GetPath().ToStdString())) {
+        SetStatusText("Zapisano macierz korelacji: " + dialog.GetPath());
+    }
+    else {
+        wxLogError("Nie udało się zapisać pliku %s", dialog.GetPath());
+    }
+}
+
+void CorrelationFrame::OnPlotMotion(wxMouseEvent& event) {
+    // Przesuwanie i powiększanie macierzy obsługuje mpWindow
+    event.Skip();
+    const size_t size = matrix_.Size();
+    if (size < 2) {
+        return;
+    }
+
+    int column = (int)std::floor(plot->p2x(event.GetX()));
+    int row = (int)size - 1 - (int)std::floor(plot->p2y(event.GetY()));
+    if (column < 0 || column >= (int)size || row < 0 || row >= (int)size) {
+        return;
+    }
+
+    const Station& a = stations_[matrixStations_[row]];
+    const Station& b = stations_[matrixStations_[column]];
+    wxString text = a.name + " (" + a.province + ") – " + b.name + " (" + b.province + "): ";
+    float r = matrix_.At(row, column);
+    if (std::isnan(r)) {
+        text += wxString::Format("za mało wspólnych pomiarów (%u godz.)", matrix_.Overlap(row, column));
+    }
+    else {
+        text += wxString::Format("r = %.3f (%u wspólnych godz.)", r, matrix_.Overlap(row, column));
+    }
+    SetStatusText(text);
+}
+
+void CorrelationFrame::OnScalePaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(scalePanel);
+    dc.SetBackground(wxBrush(scalePanel->GetBackgroundColour()));
+    dc.Clear();
+    if (colormap_ && matrixLayer->IsVisible()) {
+        colormap_->DrawScale(dc, scalePanel->GetClientSize());
+    }
+}
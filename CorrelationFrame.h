@@ -0,0 +1,48 @@
+#ifndef CORRELATION_FRAME_H
+#define CORRELATION_FRAME_H
+
+#include <wx/wx.h>
+#include "mathplot.h"
+#include <memory>
+#include <vector>
+#include "main.h"
+#include "AqiEngine.h"
+#include "CorrelationMatrix.h"
+
+class HeatmapColormap;
+
+// Korelacje stacji: współczynnik Pearsona jednego zanieczyszczenia dla każdej pary stacji z godzin
+// wybranego okresu, pokazany jako mapa cieplna (stacje w kolejności województw) i eksportowany do CSV.
+// Pomiary są pobierane równolegle, a macierz liczona w wątku tła.
+class CorrelationFrame : public wxFrame {
+public:
+    CorrelationFrame(const std::vector<Station>& stations);
+    ~CorrelationFrame();
+
+private:
+    struct FetchJob;
+    struct FetchState;
+
+    void OnCompute(wxCommandEvent& event);
+    void OnComputeDone(FetchJob& job);
+    void OnExport(wxCommandEvent& event);
+    void OnPlotMotion(wxMouseEvent& event);
+    void OnScalePaint(wxPaintEvent& event);
+
+    mpWindow* plot;
+    mpBitmapLayer* matrixLayer;
+    wxChoice* pollutantChoice;
+    wxChoice* windowChoice;
+    wxButton* computeButton;
+    wxButton* exportButton;
+    wxPanel* scalePanel;
+
+    std::vector<Station> stations_;
+    std::vector<size_t> matrixStations_;  // indeksy w stations_ dla kolejnych wierszy i kolumn macierzy
+    CorrelationMatrix matrix_;
+    std::unique_ptr<HeatmapColormap> colormap_;
+    unsigned generation_;                 // numer ostatniego obliczenia, starsze wyniki są pomijane
+    std::shared_ptr<FetchState> state_;
+};
+
+#endif // CORRELATION_FRAME_H
@@ -0,0 +1,121 @@
+#include "CorrelationMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Kolumny w bloku; akumulatory pary bloków to 6 * 32 * 32 liczb double (48 KB)
+    const size_t blockSize = 32;
+}
+
+CorrelationMatrix::CorrelationMatrix()
+    : size_(0) {
+}
+
+void CorrelationMatrix::Compute(const HourlyGrid& grid, size_t minOverlap, unsigned maxThreads) {
+    size_ = grid.Columns();
+    values_.assign(size_ * size_, std::numeric_limits<float>::quiet_NaN());
+    overlap_.assign(size_ * size_, 0);
+    const size_t hours = (size_t)grid.Hours();
+    if (size_ == 0 || hours == 0) {
+        return;
+    }
+
+    // Dane wierszami (godzina x kolumna), kolumny uzupełnione do pełnych bloków: wartość wycentrowana
+    // średnią kolumny (0 dla nieważnej godziny), jej kwadrat i maska 0/1. Centrowanie zmniejsza utratę
+    // dokładności przy odejmowaniu sum.
+    const size_t blocks = (size_ + blockSize - 1) / blockSize;
+    const size_t stride = blocks * blockSize;
+    std::vector<double> centered(hours * stride, 0.0);
+    std::vector<double> squared(hours * stride, 0.0);
+    std::vector<double> mask(hours * stride, 0.0);
+    for (size_t column = 0; column < size_; ++column) {
+        const size_t valid = grid.ValidCount(column);
+        if (valid == 0) {
+            continue;
+        }
+        const double* source = grid.Column(column);
+        double mean = 0.0;
+        for (size_t row = 0; row < hours; ++row) {
+            if (grid.IsValid((int)row, column)) {
+                mean += source[row];
+            }
+        }
+        mean /= valid;
+        for (size_t row = 0; row < hours; ++row) {
+            if (grid.IsValid((int)row, column)) {
+                const double value = source[row] - mean;
+                centered[row * stride + column] = value;
+                squared[row * stride + column] = value * value;
+                mask[row * stride + column] = 1.0;
+            }
+        }
+    }
+
+    // Pary bloków (i <= j); każde zadanie zapisuje tylko komórki swojej pary i ich odbicia
+    std::vector<std::pair<size_t, size_t>> blockPairs;
+    for (size_t i = 0; i < blocks; ++i) {
+        for (size_t j = i; j < blocks; ++j) {
+            blockPairs.push_back({ i, j });
+        }
+    }
+
+    RunParallel(blockPairs.size(), maxThreads, [&](size_t task) {
+        const size_t firstA = blockPairs[task].first * blockSize;
+        const size_t firstB = blockPairs[task].second * blockSize;
+        // Sumy dla par (a, b): godziny, suma a, suma b, suma a^2, suma b^2, suma a*b (tylko wspólne godziny)
+        std::vector<double> sums(6 * blockSize * blockSize, 0.0);
+        double* count = &sums[0];
+        double* sumA = count + blockSize * blockSize;
+        double* sumB = sumA + blockSize * blockSize;
+        double* sumAA = sumB + blockSize * blockSize;
+        double* sumBB = sumAA + blockSize * blockSize;
+        double* sumAB = sumBB + blockSize * blockSize;
+
+        for (size_t row = 0; row < hours; ++row) {
+            const double* xa = &centered[row * stride + firstA];
+            const double* x2a = &squared[row * stride + firstA];
+            const double* ma = &mask[row * stride + firstA];
+            const double* xb = &centered[row * stride + firstB];
+            const double* x2b = &squared[row * stride + firstB];
+            const double* mb = &mask[row * stride + firstB];
+            for (size_t a = 0; a < blockSize; ++a) {
+                const double valueA = xa[a];
+                const double squareA = x2a[a];
+                const double maskA = ma[a];
+                const size_t offset = a * blockSize;
+                // Pętla po kolumnach bloku b: niezależne sumy, wektoryzowana
+                for (size_t b = 0; b < blockSize; ++b) {
+                    count[offset + b] += maskA * mb[b];
+                    sumA[offset + b] += valueA * mb[b];
+                    sumB[offset + b] += maskA * xb[b];
+                    sumAA[offset + b] += squareA * mb[b];
+                    sumBB[offset + b] += maskA * x2b[b];
+                    sumAB[offset + b] += valueA * xb[b];
+                }
+            }
+        }
+
+        for (size_t a = 0; a < blockSize && firstA + a < size_; ++a) {
+            for (size_t b = 0; b < blockSize && firstB + b < size_; ++b) {
+                const size_t i = a * blockSize + b;
+                const double n = count[i];
+                float r = std::numeric_limits<float>::quiet_NaN();
+                if (n >= (double)std::max<size_t>(minOverlap, 2)) {
+                    const double covariance = sumAB[i] - sumA[i] * sumB[i] / n;
+                    const double varianceA = sumAA[i] - sumA[i] * sumA[i] / n;
+                    const double varianceB = sumBB[i] - sumB[i] * sumB[i] / n;
+                    if (varianceA > 0.0 && varianceB > 0.0) {
+                        r = (float)std::min(std::max(covariance / std::sqrt(varianceA * varianceB), -1.0), 1.0);
+                    }
+                }
+                const size_t columnA = firstA + a;
+                const size_t columnB = firstB + b;
+                values_[columnA * size_ + columnB] = r;
+                values_[columnB * size_ + columnA] = r;
+                overlap_[columnA * size_ + columnB] = (unsigned)n;
+                overlap_[columnB * size_ + columnA] = (unsigned)n;
+            }
+        }
+    });
+}
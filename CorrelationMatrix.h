@@ -0,0 +1,34 @@
+#ifndef CORRELATION_MATRIX_H
+#define CORRELATION_MATRIX_H
+
+#include <vector>
+#include <cstddef>
+#include "HourlyGrid.h"
+
+// Macierz współczynników korelacji Pearsona wszystkich par kolumn siatki godzinowej; każda para
+// jest liczona z godzin ważnych w obu kolumnach. Sumy par (liczba godzin, sumy, sumy kwadratów
+// i iloczynów) są zapisane jako iloczyny macierzy wartości i masek ważności, liczone blokami kolumn:
+// wewnętrzna pętla dodaje wiersz jednego bloku do sum całego bloku, bez redukcji i rozgałęzień,
+// więc kompilator ją wektoryzuje, a akumulatory bloku mieszczą się w pamięci podręcznej.
+// Bloki są liczone równolegle.
+class CorrelationMatrix {
+public:
+    CorrelationMatrix();
+
+    // Pary z mniej niż minOverlap wspólnymi godzinami (albo ze stałą kolumną) mają NaN
+    void Compute(const HourlyGrid& grid, size_t minOverlap = 24, unsigned maxThreads = 0);
+
+    size_t Size() const { return size_; }
+    float At(size_t a, size_t b) const { return values_[a * size_ + b]; }
+    // Liczba godzin ważnych w obu kolumnach
+    unsigned Overlap(size_t a, size_t b) const { return overlap_[a * size_ + b]; }
+    // Wierszami, Size() * Size()
+    const std::vector<float>& Values() const { return values_; }
+
+private:
+    size_t size_;
+    std::vector<float> values_;
+    std::vector<unsigned> overlap_;
+};
+
+#endif // CORRELATION_MATRIX_H
@@ -0,0 +1,488 @@
+#include "HeatmapFrame.h"
+#include <wx/dcbuffer.h>
+#include <wx/datetime.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace {
+    // Parametry do wyboru; skala kolorów od 0 do górnej granicy (µg/m³), wyższe wartości mają kolor granicy
+    const HeatmapParameter heatmapParameters[] = {
+        { "PM10", "pm10", 200.0f },
+        { "PM2.5", "pm2.5", 140.0f },
+        { "NO2", "dwutlenek azotu", 400.0f },
+        { "O3", "ozon", 240.0f },
+        { "SO2", "dwutlenek siarki", 350.0f },
+        { "CO", "tlenek węgla", 10000.0f },
+        { "C6H6", "benzen", 50.0f }
+    };
+
+    // Kolory skali od najniższych do najwyższych wartości, pośrednie są interpolowane liniowo
+    const unsigned char colormapStops[][3] = {
+        { 87, 177, 8 }, { 176, 221, 16 }, { 255, 217, 17 }, { 229, 129, 0 }, { 229, 0, 0 }, { 153, 0, 0 }
+    };
+    const int colormapStopCount = sizeof(colormapStops) / sizeof(colormapStops[0]);
+    // Skala dwukierunkowa (np. korelacja): niebieski - biały - czerwony
+    const unsigned char divergingStops[][3] = {
+        { 33, 102, 172 }, { 146, 197, 222 }, { 247, 247, 247 }, { 244, 165, 130 }, { 178, 24, 43 }
+    };
+    const int divergingStopCount = sizeof(divergingStops) / sizeof(divergingStops[0]);
+    const unsigned char missingColour[3] = { 220, 220, 220 };
+
+    // Mapa pokazuje ostatnie 3 dni, tak jak ChartFrame
+    const int heatmapHours = 3 * 24;
+    const unsigned maxFetchThreads = 8;
+
+    // Przesuwa piksele obrazu o columns kolumn w lewo; ostatnie kolumny są potem kolorowane od nowa
+    void ShiftImage(wxImage& image, int columns) {
+        const int width = image.GetWidth();
+        if (columns <= 0 || columns >= width) {
+            return;
+        }
+        unsigned char* data = image.GetData();
+        for (int y = 0; y < image.GetHeight(); ++y) {
+            unsigned char* row = data + (size_t)y * width * 3;
+            std::memmove(row, row + (size_t)columns * 3, (size_t)(width - columns) * 3);
+        }
+    }
+
+    // Początek godziny ostatniej kolumny: bieżąca pełna godzina
+    std::time_t CurrentHour() {
+        std::time_t now = std::time(nullptr);
+        return now - now % 3600;
+    }
+}
+
+float HeatmapScaleMax(const wxString& label) {
+    for (const auto& parameter : heatmapParameters) {
+        if (label == parameter.label) {
+            return parameter.maxValue;
+        }
+    }
+    return 0.0f;
+}
+
+void HeatmapMatrix::Reset(int rowCount, int columnCount, std::time_t startTime) {
+    rows = rowCount;
+    columns = columnCount;
+    start = startTime;
+    values.assign((size_t)rows * columns, std::numeric_limits<float>::quiet_NaN());
+    flags.assign((size_t)rows * columns, ANOMALY_NONE);
+}
+
+void HeatmapMatrix::Shift(int hours) {
+    if (hours <= 0) {
+        return;
+    }
+    start += (std::time_t)hours * 3600;
+    const int kept = std::max(columns - hours, 0);
+    for (int row = 0; row < rows; ++row) {
+        float* data = &values[(size_t)row * columns];
+        unsigned char* rowFlags = &flags[(size_t)row * columns];
+        if (kept > 0) {
+            std::memmove(data, data + hours, (size_t)kept * sizeof(float));
+            std::memmove(rowFlags, rowFlags + hours, (size_t)kept);
+        }
+        std::fill(data + kept, data + columns, std::numeric_limits<float>::quiet_NaN());
+        std::fill(rowFlags + kept, rowFlags + columns, (unsigned char)ANOMALY_NONE);
+    }
+}
+
+int HeatmapMatrix::Fill(int row, const HourlyGrid& grid, size_t column) {
+    int first = columns;
+    float* data = &values[(size_t)row * columns];
+    const double* source = grid.Column(column);
+    const int hours = std::min(columns, grid.Hours());
+    // Nieważne godziny siatki (niepobrane lub null z API) nie kasują wcześniej pobranych wartości
+    for (int c = 0; c < hours; ++c) {
+        if (!grid.IsValid(c, column)) {
+            continue;
+        }
+        // Pusta komórka (NaN) jest różna od każdej wartości
+        float value = (float)source[c];
+        if (data[c] != value) {
+            data[c] = value;
+            first = std::min(first, c);
+        }
+    }
+    return first;
+}
+
+void HeatmapMatrix::Flag(int row, const std::vector<Measurement>& measurements, const std::vector<unsigned>& measurementFlags) {
+    unsigned char* rowFlags = &flags[(size_t)row * columns];
+    for (size_t i = 0; i < measurements.size() && i < measurementFlags.size(); ++i) {
+        if (measurementFlags[i] == ANOMALY_NONE || measurements[i].time < start) {
+            continue;
+        }
+        std::time_t column = (measurements[i].time - start) / 3600;
+        if (column < columns) {
+            rowFlags[column] |= (unsigned char)measurementFlags[i];
+        }
+    }
+}
+
+HeatmapColormap::HeatmapColormap(float minValue, float maxValue, bool diverging)
+    : min_(minValue), max_(maxValue), diverging_(diverging),
+      scale_(254.0f / std::max(maxValue - minValue, std::numeric_limits<float>::epsilon())) {
+    const unsigned char (*stops)[3] = diverging ? divergingStops : colormapStops;
+    const int stopCount = diverging ? divergingStopCount : colormapStopCount;
+    std::memcpy(lut_[0], missingColour, 3);
+    for (int i = 1; i < 256; ++i) {
+        double position = (i - 1) / 254.0 * (stopCount - 1);
+        int stop = std::min((int)position, stopCount - 2);
+        double weight = position - stop;
+        for (int k = 0; k < 3; ++k) {
+            lut_[i][k] = (unsigned char)std::lround(stops[stop][k] * (1.0 - weight) + stops[stop + 1][k] * weight);
+        }
+    }
+}
+
+void HeatmapColormap::Colorize(const HeatmapMatrix& matrix, int first, int last, wxImage& image) const {
+    first = std::max(first, 0);
+    last = std::min(last, matrix.columns);
+    if (first >= last) {
+        return;
+    }
+    unsigned char* data = image.GetData();
+    for (int row = 0; row < matrix.rows; ++row) {
+        Colorize(matrix.Row(row) + first, last - first, data + ((size_t)row * matrix.columns + first) * 3);
+    }
+}
+
+void HeatmapColormap::Colorize(const float* values, size_t count, unsigned char* rgb) const {
+    std::vector<unsigned char> indices(count);
+    unsigned char* index = indices.data();
+
+    // Indeksy kolorów: pętla bez rozgałęzień i wywołań funkcji, więc kompilator ją wektoryzuje.
+    // NaN nie spełnia v == v i dostaje kolor braku pomiaru (0); wartości spoza zakresu są przycinane.
+    for (size_t c = 0; c < count; ++c) {
+        float v = values[c];
+        float t = (v - min_) * scale_ + 1.0f;
+        t = t < 1.0f ? 1.0f : t;
+        t = t > 255.0f ? 255.0f : t;
+        t = v == v ? t : 0.0f;
+        index[c] = (unsigned char)(int)t;
+    }
+
+    for (size_t c = 0; c < count; ++c) {
+        const unsigned char* colour = lut_[index[c]];
+        rgb[3 * c] = colour[0];
+        rgb[3 * c + 1] = colour[1];
+        rgb[3 * c + 2] = colour[2];
+    }
+}
+
+wxColour HeatmapColormap::ColourAt(double fraction) const {
+    fraction = std::min(std::max(fraction, 0.0), 1.0);
+    const unsigned char* colour = lut_[1 + (int)std::lround(fraction * 254.0)];
+    return wxColour(colour[0], colour[1], colour[2]);
+}
+
+// Zadanie pobrania: kopia danych potrzebnych w wątku tła i wyniki, odczytywane w wątku GUI
+struct HeatmapFrame::FetchJob {
+    unsigned generation = 0;
+    int parameter = 0;
+    bool full = false;
+    std::string match;                       // fragment nazwy wskaźnika (UTF-8, małe litery)
+    std::vector<Station> stations;           // full: wszystkie stacje, brakujące czujniki są pobierane
+    std::vector<int> sensors;                // czujnik parametru dla każdej pozycji (0 = brak)
+    int rows = 0;                            // liczba pomiarów pobieranych na czujnik
+    std::vector<std::vector<Measurement>> measurements;
+    std::vector<SensorAnomalyDetector> detectors;   // detektor dla każdej pozycji, kontynuowany między odświeżeniami
+    std::vector<std::vector<unsigned>> flags;       // flagi pomiarów z measurements
+};
+
+// Stan współdzielony z wątkami tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI
+struct HeatmapFrame::FetchState {
+    HeatmapFrame* frame = nullptr;
+};
+
+HeatmapFrame::HeatmapFrame(const std::vector<Station>& stations)
+    : wxFrame(nullptr, wxID_ANY, "Mapa cieplna stacji", wxDefaultPosition, wxSize(1100, 700)),
+      stations_(stations), parameter_(0), hours_(heatmapHours), generation_(0), state_(std::make_shared<FetchState>()) {
+    state_->frame = this;
+
+    wxPanel* mainPanel = new wxPanel(this);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    // Wybór parametru i odświeżanie
+    wxBoxSizer* controlsSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxArrayString labels;
+    for (const auto& parameter : heatmapParameters) {
+        labels.Add(parameter.label);
+    }
+    parameterChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, labels);
+    parameterChoice->SetSelection(0);
+    refreshButton = new wxButton(mainPanel, wxID_ANY, "Odśwież");
+    controlsSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Parametr:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    controlsSizer->Add(parameterChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(refreshButton, 0);
+    mainSizer->Add(controlsSizer, 0, wxALL, 10);
+
+    // Mapa: wiersze to stacje (pierwsza na górze), kolumny to godziny; legenda skali obok
+    wxBoxSizer* plotSizer = new wxBoxSizer(wxHORIZONTAL);
+    plot = new mpWindow(mainPanel, wxID_ANY);
+    layer = new mpBitmapLayer();
+    mpScaleX* xaxis = new mpScaleX("Czas", mpALIGN_BOTTOM, true, mpX_DATETIME);
+    xaxis->SetTicks(true);
+    xaxis->SetLabelMode(mpX_DATETIME, mpX_LOCALTIME);
+    plot->AddLayer(layer);
+    plot->AddLayer(xaxis);
+    plotSizer->Add(plot, 1, wxEXPAND | wxRIGHT, 10);
+
+    scalePanel = new wxPanel(mainPanel, wxID_ANY, wxDefaultPosition, wxSize(90, -1));
+    scalePanel->SetBackgroundStyle(wxBG_STYLE_PAINT);
+    plotSizer->Add(scalePanel, 0, wxEXPAND);
+    mainSizer->Add(plotSizer, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
+
+    mainPanel->SetSizer(mainSizer);
+    mainPanel->Layout();
+    CreateStatusBar();
+
+    parameterChoice->Bind(wxEVT_CHOICE, &HeatmapFrame::OnParameterChanged, this);
+    refreshButton->Bind(wxEVT_BUTTON, &HeatmapFrame::OnRefresh, this);
+    plot->Bind(wxEVT_MOTION, &HeatmapFrame::OnPlotMotion, this);
+    scalePanel->Bind(wxEVT_PAINT, &HeatmapFrame::OnScalePaint, this);
+
+    StartFetch(true);
+}
+
+HeatmapFrame::~HeatmapFrame() {
+    // Wyniki pobierania zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+}
+
+void HeatmapFrame::StartFetch(bool full) {
+    if (!full && rowSensors_.empty()) {
+        full = true;
+    }
+
+    auto job = std::make_shared<FetchJob>();
+    job->generation = ++generation_;
+    job->parameter = parameterChoice->GetSelection();
+    job->full = full;
+    job->match = heatmapParameters[job->parameter].match;
+    if (full) {
+        job->stations = stations_;
+        job->sensors.assign(stations_.size(), 0);
+        job->rows = hours_;
+    }
+    else {
+        // Pomiary są od najnowszego: wystarczą godziny od ostatniej kolumny, z zapasem na spóźnione publikacje
+        job->sensors = rowSensors_;
+        std::time_t lastColumn = matrix_.start + (std::time_t)(hours_ - 1) * 3600;
+        job->rows = std::min(hours_, (int)((CurrentHour() - lastColumn) / 3600) + 3);
+        job->detectors = std::move(detectors_);
+    }
+    job->measurements.resize(job->sensors.size());
+    job->detectors.resize(job->sensors.size());
+    job->flags.resize(job->sensors.size());
+
+    refreshButton->Disable();
+    SetStatusText(full ? "Pobieranie czujników i pomiarów stacji..." : "Pobieranie nowych pomiarów...");
+
+    std::shared_ptr<FetchState> state = state_;
+    std::thread([state, job]() {
+        RunFetch(*job);
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnFetchDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void HeatmapFrame::RunFetch(FetchJob& job) {
+    // Każde zadanie zapisuje tylko do swojej pozycji wyników
+    RunParallel(job.sensors.size(), maxFetchThreads, [&job](size_t i) {
+        try {
+            if (job.full) {
+                Station& station = job.stations[i];
+                if (station.sensors.empty()) {
+                    if (!FetchStationSensors(station.id, station.sensors)) {
+                        return;
+                    }
+                }
+                for (const auto& sensor : station.sensors) {
+                    std::string name(sensor.paramName.Lower().utf8_str());
+                    if (name.find(job.match) != std::string::npos) {
+                        job.sensors[i] = sensor.id;
+                        break;
+                    }
+                }
+            }
+            // Detekcja w tym samym wątku co pobranie: każdy czujnik ma własny detektor, bez blokad
+            if (job.sensors[i] > 0 && FetchSeries(job.sensors[i], job.rows, job.measurements[i], true)) {
+                job.flags[i] = DetectAnomalies(job.detectors[i], job.measurements[i]);
+            }
+        }
+        catch (const std::exception& e) {
+            wxLogError("Błąd pobierania danych mapy cieplnej: %s", e.what());
+        }
+    });
+}
+
+void HeatmapFrame::OnFetchDone(FetchJob& job) {
+    // Wynik zastąpiony nowszym pobraniem (np. po zmianie parametru)
+    if (job.generation != generation_) {
+        return;
+    }
+    refreshButton->Enable();
+
+    int firstColumn = 0;
+    if (job.full) {
+        stations_ = std::move(job.stations);
+        parameter_ = job.parameter;
+        colormap_.reset(new HeatmapColormap(0.0f, heatmapParameters[parameter_].maxValue));
+
+        // Wiersze: stacje mierzące parametr, pogrupowane według województw
+        rowStations_.clear();
+        for (size_t i = 0; i < job.sensors.size(); ++i) {
+            if (job.sensors[i] > 0) {
+                rowStations_.push_back(i);
+            }
+        }
+        std::sort(rowStations_.begin(), rowStations_.end(), [this](size_t a, size_t b) {
+            if (stations_[a].province != stations_[b].province) {
+                return stations_[a].province < stations_[b].province;
+            }
+            return stations_[a].name < stations_[b].name;
+            });
+
+        // Pomiary są wyrównywane do godzin okna na wspólnej siatce, kolumna siatki to wiersz mapy
+        rowSensors_.clear();
+        detectors_.clear();
+        matrix_.Reset((int)rowStations_.size(), hours_, CurrentHour() - (std::time_t)(hours_ - 1) * 3600);
+        HourlyGrid grid;
+        grid.Reset(matrix_.start, hours_, rowStations_.size());
+        for (size_t row = 0; row < rowStations_.size(); ++row) {
+            const size_t i = rowStations_[row];
+            rowSensors_.push_back(job.sensors[i]);
+            detectors_.push_back(std::move(job.detectors[i]));
+            grid.SetColumn(row, job.measurements[i]);
+            matrix_.Fill((int)row, grid, row);
+            matrix_.Flag((int)row, job.measurements[i], job.flags[i]);
+        }
+        if (matrix_.rows > 0) {
+            image_ = wxImage(matrix_.columns, matrix_.rows, false);
+        }
+        scalePanel->Refresh();
+    }
+    else {
+        // Przesunięcie okna czasu: stare kolumny przesuwają się razem z obrazem, kolorowane są tylko nowe
+        int shift = (int)((CurrentHour() - (std::time_t)(hours_ - 1) * 3600 - matrix_.start) / 3600);
+        shift = std::min(std::max(shift, 0), hours_);
+        matrix_.Shift(shift);
+        ShiftImage(image_, shift);
+        firstColumn = hours_ - shift;
+        HourlyGrid grid;
+        grid.Reset(matrix_.start, hours_, matrix_.rows);
+        for (int row = 0; row < matrix_.rows; ++row) {
+            grid.SetColumn(row, job.measurements[row]);
+            firstColumn = std::min(firstColumn, matrix_.Fill(row, grid, row));
+            matrix_.Flag(row, job.measurements[row], job.flags[row]);
+        }
+        detectors_ = std::move(job.detectors);
+    }
+
+    UpdateImage(firstColumn);
+    if (job.full) {
+        FitView();
+    }
+}
+
+void HeatmapFrame::UpdateImage(int firstColumn) {
+    if (matrix_.rows == 0) {
+        layer->SetVisible(false);
+        plot->UpdateAll();
+        SetStatusText(wxString::Format("Brak stacji mierzących %s.", heatmapParameters[parameter_].label));
+        return;
+    }
+
+    colormap_->Colorize(matrix_, firstColumn, matrix_.columns, image_);
+    layer->SetBitmap(image_, (double)matrix_.start, 0.0, matrix_.columns * 3600.0, (double)matrix_.rows);
+    layer->SetVisible(true);
+    plot->UpdateAll();
+    SetStatusText(wxString::Format("%s: %d stacji, ostatnie %d godzin.", heatmapParameters[parameter_].label, matrix_.rows, matrix_.columns));
+}
+
+void HeatmapFrame::FitView() {
+    if (matrix_.rows > 0) {
+        plot->Fit((double)matrix_.start, matrix_.start + matrix_.columns * 3600.0, 0.0, (double)matrix_.rows);
+    }
+}
+
+void HeatmapFrame::OnParameterChanged(wxCommandEvent& event) {
+    StartFetch(true);
+}
+
+void HeatmapFrame::OnRefresh(wxCommandEvent& event) {
+    StartFetch(false);
+}
+
+void HeatmapFrame::OnPlotMotion(wxMouseEvent& event) {
+    // Przesuwanie i powiększanie mapy obsługuje mpWindow
+    event.Skip();
+    if (matrix_.rows == 0) {
+        return;
+    }
+
+    double x = plot->p2x(event.GetX());
+    double y = plot->p2y(event.GetY());
+    int column = (int)std::floor((x - matrix_.start) / 3600.0);
+    int row = matrix_.rows - 1 - (int)std::floor(y);
+    if (column < 0 || column >= matrix_.columns || row < 0 || row >= matrix_.rows) {
+        return;
+    }
+
+    const Station& station = stations_[rowStations_[row]];
+    wxString time = wxDateTime((time_t)(matrix_.start + (std::time_t)column * 3600)).Format("%d.%m %H:%M");
+    float value = matrix_.At(row, column);
+    wxString text = station.name + " (" + station.province + "), " + time + ": ";
+    if (std::isnan(value)) {
+        text += "brak pomiaru";
+    }
+    else {
+        text += wxString::Format("%.1f µg/m³", value);
+    }
+    unsigned flags = matrix_.FlagsAt(row, column);
+    if (flags != ANOMALY_NONE) {
+        text += " (podejrzany pomiar: " + SensorAnomalyDetector::Describe(flags) + ")";
+    }
+    SetStatusText(text);
+}
+
+void HeatmapFrame::OnScalePaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(scalePanel);
+    dc.SetBackground(wxBrush(scalePanel->GetBackgroundColour()));
+    dc.Clear();
+    if (colormap_) {
+        colormap_->DrawScale(dc, scalePanel->GetClientSize());
+    }
+}
+
+void HeatmapColormap::DrawScale(wxDC& dc, const wxSize& size) const {
+    // Pasek skali od maksimum (góra) do minimum, pod nim kolor braku pomiaru
+    const int top = 10;
+    const int barWidth = 16;
+    const int barHeight = size.GetHeight() - 50;
+    if (barHeight <= 0) {
+        return;
+    }
+    for (int y = 0; y < barHeight; ++y) {
+        dc.SetPen(wxPen(ColourAt(1.0 - (double)y / (barHeight - 1))));
+        dc.DrawLine(0, top + y, barWidth, top + y);
+    }
+
+    dc.SetFont(*wxSMALL_FONT);
+    // Wartości powyżej skali zanieczyszczeń mają kolor górnej granicy
+    dc.DrawText(wxString::Format(diverging_ ? "%.0f" : "≥%.0f", max_), barWidth + 4, top - 2);
+    dc.DrawText(wxString::Format("%.0f", (min_ + max_) / 2), barWidth + 4, top + barHeight / 2 - 6);
+    dc.DrawText(wxString::Format("%.0f", min_), barWidth + 4, top + barHeight - 12);
+
+    dc.SetPen(*wxGREY_PEN);
+    dc.SetBrush(wxBrush(wxColour(missingColour[0], missingColour[1], missingColour[2])));
+    dc.DrawRectangle(0, top + barHeight + 10, barWidth, 12);
+    dc.DrawText("brak", barWidth + 4, top + barHeight + 8);
+}
@@ -0,0 +1,111 @@
+#ifndef HEATMAP_FRAME_H
+#define HEATMAP_FRAME_H
+
+#include <wx/wx.h>
+#include "mathplot.h"
+#include <vector>
+#include <memory>
+#include <ctime>
+#include "main.h"
+#include "HourlyGrid.h"
+#include "AnomalyDetector.h"
+
+// Gęsta macierz pomiarów jednego parametru: wiersz to stacja, kolumna to godzina.
+// Brak pomiaru to NaN.
+struct HeatmapMatrix {
+    int rows = 0;
+    int columns = 0;
+    std::time_t start = 0;       // początek godziny w kolumnie 0
+    std::vector<float> values;   // wierszami, rows * columns
+    std::vector<unsigned char> flags;  // flagi AnomalyFlag podejrzanych pomiarów godziny, układ jak values
+
+    void Reset(int rowCount, int columnCount, std::time_t startTime);
+    const float* Row(int row) const { return &values[(size_t)row * columns]; }
+    float At(int row, int column) const { return values[(size_t)row * columns + column]; }
+    unsigned FlagsAt(int row, int column) const { return flags[(size_t)row * columns + column]; }
+    // Przesuwa okno czasu o hours godzin do przodu; kolumny na końcu są puste (NaN)
+    void Shift(int hours);
+    // Wpisuje do wiersza ważne godziny kolumny siatki o tym samym początku i długości;
+    // zwraca pierwszą zmienioną kolumnę (columns, jeśli nic się nie zmieniło)
+    int Fill(int row, const HourlyGrid& grid, size_t column);
+    // Dopisuje flagi pomiarów (measurementFlags[i] dla measurements[i]) do godzin wiersza w oknie
+    void Flag(int row, const std::vector<Measurement>& measurements, const std::vector<unsigned>& measurementFlags);
+};
+
+// Skala kolorów: wartości z zakresu [minValue, maxValue] na 255 kolorów, kolor 0 to brak pomiaru.
+// Skala zanieczyszczeń idzie od zieleni do czerwieni, dwukierunkowa (diverging) od niebieskiego przez biały do czerwieni.
+class HeatmapColormap {
+public:
+    HeatmapColormap(float minValue, float maxValue, bool diverging = false);
+
+    // Koloruje kolumny [first, last) macierzy w obrazie o rozmiarze columns x rows
+    void Colorize(const HeatmapMatrix& matrix, int first, int last, wxImage& image) const;
+    // Koloruje count wartości do pikseli RGB (3 bajty na piksel)
+    void Colorize(const float* values, size_t count, unsigned char* rgb) const;
+    // Kolor dla ułamka zakresu (0..1), do rysowania legendy
+    wxColour ColourAt(double fraction) const;
+    // Rysuje pionowy pasek skali z opisem wartości (minimum, środek, maksimum) i kolorem braku pomiaru
+    void DrawScale(wxDC& dc, const wxSize& size) const;
+
+private:
+    float min_;
+    float max_;
+    bool diverging_;
+    float scale_;                    // indeksy kolorów na jednostkę wartości
+    unsigned char lut_[256][3];
+};
+
+// Parametr mapy cieplnej: nazwa, fragment nazwy wskaźnika w API i górna granica skali kolorów
+struct HeatmapParameter {
+    const char* label;
+    const char* match;
+    float maxValue;
+};
+
+// Górna granica skali kolorów parametru o podanej etykiecie ("PM10", "NO2" itp.) lub 0 dla nieznanej;
+// wspólna dla mapy cieplnej i mapy stacji
+float HeatmapScaleMax(const wxString& label);
+
+// Porównanie stacji: jeden parametr dla wszystkich stacji (wiersze) i ostatnich godzin (kolumny)
+class HeatmapFrame : public wxFrame {
+public:
+    HeatmapFrame(const std::vector<Station>& stations);
+    ~HeatmapFrame();
+
+private:
+    struct FetchJob;
+    struct FetchState;
+
+    // Pobranie w tle: full = czujniki i całe okno czasu, inaczej tylko godziny od ostatniego odświeżenia
+    void StartFetch(bool full);
+    // Wykonywane w wątku tła: czujniki stacji i pomiary, równolegle z ograniczeniem liczby zapytań
+    static void RunFetch(FetchJob& job);
+    void OnFetchDone(FetchJob& job);
+    // Odświeża obraz od kolumny firstColumn do końca i przekazuje go do warstwy
+    void UpdateImage(int firstColumn);
+    void FitView();
+    void OnParameterChanged(wxCommandEvent& event);
+    void OnRefresh(wxCommandEvent& event);
+    void OnPlotMotion(wxMouseEvent& event);
+    void OnScalePaint(wxPaintEvent& event);
+
+    mpWindow* plot;
+    mpBitmapLayer* layer;
+    wxChoice* parameterChoice;
+    wxButton* refreshButton;
+    wxPanel* scalePanel;
+
+    std::vector<Station> stations_;     // wszystkie stacje; czujniki uzupełniane przy pierwszym pobraniu
+    std::vector<size_t> rowStations_;   // indeks stacji w stations_ dla każdego wiersza
+    std::vector<int> rowSensors_;       // czujnik parametru dla każdego wiersza
+    std::vector<SensorAnomalyDetector> detectors_;  // detektor dla każdego wiersza; na czas pobrania przekazywany do zadania
+    HeatmapMatrix matrix_;
+    std::unique_ptr<HeatmapColormap> colormap_;
+    wxImage image_;
+    int parameter_;                      // parametr pokazywany na mapie (indeks w tablicy parametrów)
+    int hours_;                          // liczba kolumn (godzin) na mapie
+    unsigned generation_;                // numer ostatniego pobrania, starsze wyniki są pomijane
+    std::shared_ptr<FetchState> state_;
+};
+
+#endif // HEATMAP_FRAME_H
@@ -0,0 +1,111 @@
+#include "HourlyGrid.h"
+#include <bitset>
+#include <limits>
+
+namespace {
+    std::time_t HourStart(std::time_t time) {
+        std::time_t offset = time % 3600;
+        return time - (offset < 0 ? offset + 3600 : offset);
+    }
+}
+
+HourlyGrid::HourlyGrid()
+    : start_(0), hours_(0), columns_(0), words_(0) {
+}
+
+void HourlyGrid::Reset(std::time_t start, int hours, size_t columns) {
+    start_ = HourStart(start);
+    hours_ = std::max(hours, 0);
+    columns_ = columns;
+    words_ = (hours_ + 63) / 64;
+    values_.assign(columns_ * hours_, std::numeric_limits<double>::quiet_NaN());
+    validity_.assign(columns_ * words_, 0);
+}
+
+void HourlyGrid::ResetToSpan(const std::vector<std::vector<Measurement>>& series) {
+    std::time_t first = std::numeric_limits<std::time_t>::max();
+    std::time_t last = std::numeric_limits<std::time_t>::min();
+    for (const auto& measurements : series) {
+        for (const auto& m : measurements) {
+            first = std::min(first, m.time);
+            last = std::max(last, m.time);
+        }
+    }
+    if (first > last) {
+        Reset(0, 0, series.size());
+        return;
+    }
+    first = HourStart(first);
+    Reset(first, (int)((HourStart(last) - first) / 3600) + 1, series.size());
+}
+
+int HourlyGrid::Row(std::time_t time) const {
+    if (time < start_) {
+        return -1;
+    }
+    std::time_t row = (time - start_) / 3600;
+    return row < hours_ ? (int)row : -1;
+}
+
+void HourlyGrid::SetColumn(size_t column, const std::vector<Measurement>& measurements) {
+    // Seria rosnąca w czasie: bez zmian; malejąca (kolejność API): czytana od końca; inna: posortowana kopia
+    std::vector<Measurement> sorted;
+    const Measurement* samples = measurements.data();
+    const size_t count = measurements.size();
+    auto earlier = [](const Measurement& a, const Measurement& b) { return a.time < b.time; };
+    if (!std::is_sorted(measurements.begin(), measurements.end(), earlier)) {
+        sorted.assign(measurements.rbegin(), measurements.rend());
+        if (!std::is_sorted(sorted.begin(), sorted.end(), earlier)) {
+            std::sort(sorted.begin(), sorted.end(), earlier);
+        }
+        samples = sorted.data();
+    }
+
+    double* values = &values_[column * hours_];
+    uint64_t* validity = &validity_[column * words_];
+    std::fill(validity, validity + words_, 0);
+
+    // Scalanie: każda godzina siatki i każdy pomiar są odwiedzane raz
+    size_t i = 0;
+    while (i < count && samples[i].time < start_) {
+        ++i;
+    }
+    for (int row = 0; row < hours_; ++row) {
+        const std::time_t rowEnd = start_ + (std::time_t)(row + 1) * 3600;
+        double sum = 0.0;
+        int valid = 0;
+        for (; i < count && samples[i].time < rowEnd; ++i) {
+            const double value = samples[i].value;
+            if (value == value) {
+                sum += value;
+                ++valid;
+            }
+        }
+        if (valid > 0) {
+            values[row] = sum / valid;
+            validity[row / 64] |= (uint64_t)1 << (row % 64);
+        }
+        else {
+            values[row] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+}
+
+size_t HourlyGrid::ValidCount(size_t column) const {
+    size_t valid = 0;
+    const uint64_t* validity = Validity(column);
+    for (size_t w = 0; w < words_; ++w) {
+        valid += std::bitset<64>(validity[w]).count();
+    }
+    return valid;
+}
+
+size_t HourlyGrid::ValidCount(size_t a, size_t b) const {
+    size_t valid = 0;
+    const uint64_t* validityA = Validity(a);
+    const uint64_t* validityB = Validity(b);
+    for (size_t w = 0; w < words_; ++w) {
+        valid += std::bitset<64>(validityA[w] & validityB[w]).count();
+    }
+    return valid;
+}
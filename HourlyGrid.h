@@ -0,0 +1,53 @@
+#ifndef HOURLY_GRID_H
+#define HOURLY_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include "main.h"
+
+// Wspólna siatka godzinowa dla wielu serii (czujników stacji lub całej sieci).
+// Wartości są przechowywane kolumnami (seria = kolumna, godzina = wiersz) w jednej ciągłej tablicy,
+// a ważność każdej komórki w mapie bitowej kolumny. Komórka nieważna (brak pomiaru albo null
+// z API) ma wartość NaN, więc kolumn można używać bezpośrednio jako ciągłych tablic.
+class HourlyGrid {
+public:
+    HourlyGrid();
+
+    // Pusta siatka hours godzin od start (początek godziny) dla columns serii
+    void Reset(std::time_t start, int hours, size_t columns);
+    // Pusta siatka obejmująca godziny wszystkich pomiarów serii, po jednej kolumnie na serię
+    void ResetToSpan(const std::vector<std::vector<Measurement>>& series);
+
+    // Wyrównuje serię do siatki: wartość godziny to średnia jej pomiarów (pomiary NaN są pomijane).
+    // Pomiary i godziny siatki są scalane jak dwa posortowane ciągi, więc koszt jest liniowy;
+    // seria może być rosnąca lub malejąca w czasie (jak z API), inna kolejność jest sortowana.
+    void SetColumn(size_t column, const std::vector<Measurement>& measurements);
+
+    std::time_t Start() const { return start_; }
+    int Hours() const { return hours_; }
+    size_t Columns() const { return columns_; }
+    std::time_t Time(int row) const { return start_ + (std::time_t)row * 3600; }
+    // Wiersz godziny zawierającej time lub -1 poza siatką
+    int Row(std::time_t time) const;
+
+    const double* Column(size_t column) const { return &values_[column * hours_]; }
+    const uint64_t* Validity(size_t column) const { return &validity_[column * words_]; }
+    double Value(int row, size_t column) const { return values_[column * hours_ + row]; }
+    bool IsValid(int row, size_t column) const {
+        return (validity_[column * words_ + row / 64] >> (row % 64)) & 1;
+    }
+    // Liczba ważnych godzin kolumny i liczba godzin ważnych jednocześnie w dwóch kolumnach
+    size_t ValidCount(size_t column) const;
+    size_t ValidCount(size_t a, size_t b) const;
+
+private:
+    std::time_t start_;
+    int hours_;
+    size_t columns_;
+    size_t words_;                  // słowa mapy bitowej na kolumnę
+    std::vector<double> values_;    // columns_ * hours_
+    std::vector<uint64_t> validity_; // columns_ * words_
+};
+
+#endif // HOURLY_GRID_H
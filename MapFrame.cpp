@@ -0,0 +1,404 @@
+#include "MapFrame.h"
+#include "HeatmapFrame.h"
+#include <wx/dcbuffer.h>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Interpolacja z tylu najbliższych stacji, z wagą 1 / odległość^2
+    const size_t idwNeighbours = 8;
+    // Piksele dalej od najbliższej stacji nie są interpolowane (brak danych)
+    const double idwMaxDistanceKm = 60.0;
+    const int tileSize = 32;
+    // Podgląd podczas przesuwania: jeden punkt powierzchni na tyle pikseli w każdym kierunku
+    const int previewStep = 8;
+    // Dokładna powierzchnia jest liczona, gdy widok nie zmienia się przez tyle milisekund
+    const int refineDelayMs = 250;
+
+    const double kmPerDegree = 6371.0 * 3.14159265358979323846 / 180.0;
+    const double degreesToRadians = 3.14159265358979323846 / 180.0;
+}
+
+IdwInterpolator::IdwInterpolator(const std::vector<Station>& stations, const std::vector<float>& values) {
+    for (size_t i = 0; i < stations.size() && i < values.size(); ++i) {
+        if (stations[i].hasLocation && !std::isnan(values[i])) {
+            stations_.push_back(stations[i]);
+            values_.push_back(values[i]);
+        }
+    }
+    index_.Build(stations_);
+}
+
+bool IdwInterpolator::Render(const MapView& view, std::vector<float>& surface, unsigned maxThreads,
+    const std::function<bool()>& cancelled) const {
+    surface.assign((size_t)std::max(view.width, 0) * std::max(view.height, 0), std::numeric_limits<float>::quiet_NaN());
+    if (surface.empty() || index_.IsEmpty()) {
+        return true;
+    }
+
+    // Każde zadanie zapisuje tylko piksele swojego kafelka
+    const int tilesX = (view.width + tileSize - 1) / tileSize;
+    const int tilesY = (view.height + tileSize - 1) / tileSize;
+    float* data = surface.data();
+    std::atomic<bool> stopped(false);
+    RunParallel((size_t)tilesX * tilesY, maxThreads, [&](size_t tile) {
+        if (stopped || (cancelled && cancelled())) {
+            stopped = true;
+            return;
+        }
+        const int x0 = (int)(tile % tilesX) * tileSize;
+        const int y0 = (int)(tile / tilesX) * tileSize;
+        RenderTile(view, x0, y0, std::min(x0 + tileSize, view.width), std::min(y0 + tileSize, view.height), data);
+    });
+    return !stopped;
+}
+
+void IdwInterpolator::RenderTile(const MapView& view, int x0, int y0, int x1, int y1, float* surface) const {
+    const double pixelLongitude = (view.maxLongitude - view.minLongitude) / view.width;
+    const double pixelLatitude = (view.maxLatitude - view.minLatitude) / view.height;
+
+    // Środek kafelka i lokalny rzut na płaszczyznę w kilometrach
+    const double centerLongitude = view.minLongitude + (x0 + x1) / 2.0 * pixelLongitude;
+    const double centerLatitude = view.maxLatitude - (y0 + y1) / 2.0 * pixelLatitude;
+    const double kx = kmPerDegree * std::cos(centerLatitude * degreesToRadians);
+    const double ky = kmPerDegree;
+    const double halfDiagonal = 0.5 * std::hypot((x1 - x0) * pixelLongitude * kx, (y1 - y0) * pixelLatitude * ky);
+
+    // k najbliższych stacji każdego piksela leży nie dalej niż d_k(środek) + 2 * połowa przekątnej od środka
+    // (nierówność trójkąta); zapas pokrywa różnicę między rzutem lokalnym a odległością po kuli
+    std::vector<StationIndex::Hit> hits = index_.Nearest(centerLatitude, centerLongitude, idwNeighbours);
+    if (hits.empty()) {
+        return;
+    }
+    const double reach = (hits.back().distanceKm + 2.0 * halfDiagonal) * 1.05 + 1.0;
+    const double latitudeReach = reach / ky;
+    const double edgeCos = std::max(std::cos(std::min(std::fabs(centerLatitude) + latitudeReach, 89.0) * degreesToRadians), 1e-3);
+    const double longitudeReach = reach / (kmPerDegree * edgeCos);
+    std::vector<size_t> candidates = index_.InBox(centerLatitude - latitudeReach, centerLongitude - longitudeReach,
+        centerLatitude + latitudeReach, centerLongitude + longitudeReach);
+
+    // Stacje kandydujące jako osobne tablice: różnica długości od środka kafelka (stopnie), różnica
+    // szerokości (km), skala długości stacji i wartość. Odległość wschód-zachód piksela od stacji jest liczona
+    // ze skalą sqrt(cos(szerokość stacji) * cos(szerokość piksela)), bliską cos szerokości średniej,
+    // więc odległości zgadzają się z liczonymi po kuli także dla stacji odległych od kafelka.
+    const size_t count = candidates.size();
+    std::vector<float> stationX(count), stationY(count), stationScale(count), stationValue(count), distances(count);
+    for (size_t j = 0; j < count; ++j) {
+        const Station& station = stations_[candidates[j]];
+        stationX[j] = (float)(station.longitude - centerLongitude);
+        stationY[j] = (float)((station.latitude - centerLatitude) * ky);
+        stationScale[j] = (float)(kmPerDegree * std::sqrt(std::cos(station.latitude * degreesToRadians)));
+        stationValue[j] = values_[candidates[j]];
+    }
+    const float* sx = stationX.data();
+    const float* sy = stationY.data();
+    const float* sk = stationScale.data();
+    float* d2 = distances.data();
+    const size_t k = std::min(idwNeighbours, count);
+    const float maxDistance2 = (float)(idwMaxDistanceKm * idwMaxDistanceKm);
+
+    for (int y = y0; y < y1; ++y) {
+        const double latitude = view.maxLatitude - (y + 0.5) * pixelLatitude;
+        const float py = (float)((latitude - centerLatitude) * ky);
+        const float rowScale = (float)std::sqrt(std::cos(latitude * degreesToRadians));
+        float* row = surface + (size_t)y * view.width;
+        for (int x = x0; x < x1; ++x) {
+            const float px = (float)(view.minLongitude + (x + 0.5) * pixelLongitude - centerLongitude);
+
+            // Kwadraty odległości do wszystkich kandydatów: pętla bez rozgałęzień, wektoryzowana
+            for (size_t j = 0; j < count; ++j) {
+                const float dx = (sx[j] - px) * sk[j] * rowScale;
+                const float dy = sy[j] - py;
+                d2[j] = dx * dx + dy * dy;
+            }
+
+            // k najmniejszych odległości przez wstawianie (k jest małe)
+            float bestDistance[idwNeighbours];
+            float bestValue[idwNeighbours];
+            size_t best = 0;
+            for (size_t j = 0; j < count; ++j) {
+                if (best == k && d2[j] >= bestDistance[k - 1]) {
+                    continue;
+                }
+                size_t position = best < k ? best++ : k - 1;
+                while (position > 0 && bestDistance[position - 1] > d2[j]) {
+                    bestDistance[position] = bestDistance[position - 1];
+                    bestValue[position] = bestValue[position - 1];
+                    --position;
+                }
+                bestDistance[position] = d2[j];
+                bestValue[position] = stationValue[j];
+            }
+
+            float value = std::numeric_limits<float>::quiet_NaN();
+            if (best > 0 && bestDistance[0] <= maxDistance2) {
+                if (bestDistance[0] < 1e-6f) {
+                    value = bestValue[0];
+                }
+                else {
+                    float weightSum = 0.0f;
+                    float valueSum = 0.0f;
+                    for (size_t j = 0; j < best; ++j) {
+                        const float weight = 1.0f / bestDistance[j];
+                        weightSum += weight;
+                        valueSum += weight * bestValue[j];
+                    }
+                    value = valueSum / weightSum;
+                }
+            }
+            row[x] = value;
+        }
+    }
+}
+
+// Przeliczenie powierzchni w tle; wynik jest odczytywany w wątku GUI
+struct MapFrame::RenderJob {
+    unsigned generation = 0;
+    MapView view;
+    std::shared_ptr<const IdwInterpolator> interpolator;
+    std::vector<float> surface;
+};
+
+// Stan współdzielony z wątkami tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI,
+// generation to numer aktualnego widoku, po którego zmianie przeliczenie w tle jest przerywane
+struct MapFrame::RenderState {
+    MapFrame* frame = nullptr;
+    std::atomic<unsigned> generation{ 0 };
+};
+
+MapFrame::MapFrame(const std::vector<Station>& stations, const AqiEngine& aqi)
+    : wxFrame(nullptr, wxID_ANY, "Mapa stacji", wxDefaultPosition, wxSize(1000, 800)),
+      refineTimer(this), pollutant_(0), viewCheckPending_(false), generation_(0),
+      state_(std::make_shared<RenderState>()) {
+    state_->frame = this;
+
+    // Tylko stacje ze współrzędnymi; stężenia z ostatniego obliczenia indeksu
+    for (const auto& station : stations) {
+        if (!station.hasLocation) {
+            continue;
+        }
+        stations_.push_back(station);
+        for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+            values_[p].push_back(aqi.Value(station.id, (AqiPollutant)p));
+        }
+    }
+
+    wxPanel* mainPanel = new wxPanel(this);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    wxBoxSizer* controlsSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxArrayString labels;
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        labels.Add(AqiEngine::PollutantName((AqiPollutant)p));
+    }
+    pollutantChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, labels);
+    pollutantChoice->SetSelection(0);
+    controlsSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Zanieczyszczenie:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    controlsSizer->Add(pollutantChoice, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(controlsSizer, 0, wxALL, 10);
+
+    // Powierzchnia pod punktami stacji; osie w stopniach geograficznych
+    wxBoxSizer* plotSizer = new wxBoxSizer(wxHORIZONTAL);
+    plot = new mpWindow(mainPanel, wxID_ANY);
+    surfaceLayer = new mpBitmapLayer();
+    stationLayer = new mpFXYVector("Stacje");
+    stationLayer->ShowName(false);
+    stationLayer->SetContinuity(false);
+    stationLayer->SetPen(wxPen(*wxBLACK, 5));
+    stationLayer->SetDrawOutsideMargins(false);
+    mpScaleX* xaxis = new mpScaleX("Długość geograficzna", mpALIGN_BOTTOM, true);
+    mpScaleY* yaxis = new mpScaleY("Szerokość geograficzna", mpALIGN_LEFT, true);
+    plot->AddLayer(surfaceLayer);
+    plot->AddLayer(stationLayer);
+    plot->AddLayer(xaxis);
+    plot->AddLayer(yaxis);
+    plotSizer->Add(plot, 1, wxEXPAND | wxRIGHT, 10);
+
+    scalePanel = new wxPanel(mainPanel, wxID_ANY, wxDefaultPosition, wxSize(90, -1));
+    scalePanel->SetBackgroundStyle(wxBG_STYLE_PAINT);
+    plotSizer->Add(scalePanel, 0, wxEXPAND);
+    mainSizer->Add(plotSizer, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
+
+    mainPanel->SetSizer(mainSizer);
+    mainPanel->Layout();
+    CreateStatusBar();
+
+    pollutantChoice->Bind(wxEVT_CHOICE, &MapFrame::OnPollutantChanged, this);
+    plot->Bind(wxEVT_PAINT, &MapFrame::OnPlotPaint, this);
+    plot->Bind(wxEVT_MOTION, &MapFrame::OnPlotMotion, this);
+    scalePanel->Bind(wxEVT_PAINT, &MapFrame::OnScalePaint, this);
+    Bind(wxEVT_TIMER, &MapFrame::OnRefineTimer, this, refineTimer.GetId());
+
+    SetPollutant(0);
+
+    // Widok obejmuje wszystkie stacje z niewielkim marginesem
+    if (!stations_.empty()) {
+        double minLatitude = stations_.front().latitude, maxLatitude = minLatitude;
+        double minLongitude = stations_.front().longitude, maxLongitude = minLongitude;
+        for (const auto& station : stations_) {
+            minLatitude = std::min(minLatitude, station.latitude);
+            maxLatitude = std::max(maxLatitude, station.latitude);
+            minLongitude = std::min(minLongitude, station.longitude);
+            maxLongitude = std::max(maxLongitude, station.longitude);
+        }
+        plot->Fit(minLongitude - 0.3, maxLongitude + 0.3, minLatitude - 0.3, maxLatitude + 0.3);
+    }
+}
+
+MapFrame::~MapFrame() {
+    // Przeliczenie w toku jest przerywane, a wyniki zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+    ++state_->generation;
+}
+
+void MapFrame::SetPollutant(int pollutant) {
+    pollutant_ = pollutant;
+    interpolator_ = std::make_shared<IdwInterpolator>(stations_, values_[pollutant_]);
+    colormap_.reset(new HeatmapColormap(0.0f, HeatmapScaleMax(AqiEngine::PollutantName((AqiPollutant)pollutant_))));
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    for (size_t i = 0; i < interpolator_->StationCount(); ++i) {
+        xs.push_back(interpolator_->StationAt(i).longitude);
+        ys.push_back(interpolator_->StationAt(i).latitude);
+    }
+    stationLayer->SetData(xs, ys);
+
+    SetStatusText(wxString::Format("%s: %zu stacji z aktualnym pomiarem.",
+        AqiEngine::PollutantName((AqiPollutant)pollutant_), interpolator_->StationCount()));
+    scalePanel->Refresh();
+
+    // Powierzchnia poprzedniego zanieczyszczenia jest nieaktualna niezależnie od widoku
+    requested_ = MapView();
+    OnViewChanged();
+}
+
+MapView MapFrame::CurrentView() const {
+    MapView view;
+    view.width = plot->GetScrX();
+    view.height = plot->GetScrY();
+    view.minLongitude = plot->p2x(0);
+    view.maxLongitude = plot->p2x(view.width);
+    view.maxLatitude = plot->p2y(0);
+    view.minLatitude = plot->p2y(view.height);
+    return view;
+}
+
+void MapFrame::OnPlotPaint(wxPaintEvent& event) {
+    // Każda zmiana widoku (przesunięcie, powiększenie, zmiana rozmiaru) kończy się odrysowaniem;
+    // powierzchnię można zmienić dopiero po zakończeniu rysowania
+    event.Skip();
+    if (!viewCheckPending_ && CurrentView() != requested_) {
+        viewCheckPending_ = true;
+        CallAfter(&MapFrame::OnViewChanged);
+    }
+}
+
+void MapFrame::OnViewChanged() {
+    viewCheckPending_ = false;
+    MapView view = CurrentView();
+    if (view == requested_ || view.width <= 0 || view.height <= 0) {
+        return;
+    }
+    requested_ = view;
+    state_->generation = ++generation_;
+
+    // Podgląd w niskiej rozdzielczości od razu, w wątku GUI (kilkadziesiąt razy mniej pikseli)
+    MapView preview = view;
+    preview.width = std::max(view.width / previewStep, 1);
+    preview.height = std::max(view.height / previewStep, 1);
+    std::vector<float> surface;
+    interpolator_->Render(preview, surface, 0);
+    ShowSurface(preview, surface);
+
+    refineTimer.StartOnce(refineDelayMs);
+}
+
+void MapFrame::OnRefineTimer(wxTimerEvent& event) {
+    // Dokładna powierzchnia tego widoku jest już pokazana
+    if (shown_ == requested_) {
+        return;
+    }
+    auto job = std::make_shared<RenderJob>();
+    job->generation = generation_;
+    job->view = requested_;
+    job->interpolator = interpolator_;
+
+    // Przeliczenie przerywa się po zmianie widoku: jego wynik i tak zostałby pominięty,
+    // a kolejne przesunięcia nie mnożą pracujących w tle przeliczeń
+    std::shared_ptr<RenderState> state = state_;
+    std::thread([state, job]() {
+        const unsigned generation = job->generation;
+        if (!job->interpolator->Render(job->view, job->surface, 0,
+            [&state, generation]() { return state->generation != generation; })) {
+            return;
+        }
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnRefineDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void MapFrame::OnRefineDone(RenderJob& job) {
+    // Widok lub zanieczyszczenie zmieniły się w trakcie liczenia
+    if (job.generation != generation_) {
+        return;
+    }
+    ShowSurface(job.view, job.surface);
+}
+
+void MapFrame::ShowSurface(const MapView& view, std::vector<float>& surface) {
+    wxImage image(view.width, view.height, false);
+    colormap_->Colorize(surface.data(), surface.size(), image.GetData());
+    surfaceLayer->SetBitmap(image, view.minLongitude, view.minLatitude,
+        view.maxLongitude - view.minLongitude, view.maxLatitude - view.minLatitude);
+    shown_ = view;
+    surface_.swap(surface);
+    plot->UpdateAll();
+}
+
+void MapFrame::OnPollutantChanged(wxCommandEvent& event) {
+    SetPollutant(pollutantChoice->GetSelection());
+}
+
+void MapFrame::OnPlotMotion(wxMouseEvent& event) {
+    // Przesuwanie i powiększanie mapy obsługuje mpWindow
+    event.Skip();
+    if (interpolator_->StationCount() == 0 || shown_.width <= 0) {
+        return;
+    }
+
+    double longitude = plot->p2x(event.GetX());
+    double latitude = plot->p2y(event.GetY());
+    wxString text = wxString::Format("%.3f° N, %.3f° E: ", latitude, longitude);
+
+    // Wartość pokazanej powierzchni pod kursorem
+    int column = (int)std::floor((longitude - shown_.minLongitude) / (shown_.maxLongitude - shown_.minLongitude) * shown_.width);
+    int row = (int)std::floor((shown_.maxLatitude - latitude) / (shown_.maxLatitude - shown_.minLatitude) * shown_.height);
+    float value = std::numeric_limits<float>::quiet_NaN();
+    if (column >= 0 && column < shown_.width && row >= 0 && row < shown_.height) {
+        value = surface_[(size_t)row * shown_.width + column];
+    }
+    text += std::isnan(value) ? wxString("brak danych") : wxString::Format("ok. %.1f µg/m³", value);
+
+    std::vector<StationIndex::Hit> nearest = interpolator_->Index().Nearest(latitude, longitude, 1);
+    if (!nearest.empty()) {
+        const StationIndex::Hit& hit = nearest.front();
+        text += wxString::Format("; najbliższa stacja: %s (%.1f km, %.1f µg/m³)",
+            interpolator_->StationAt(hit.station).name, hit.distanceKm, interpolator_->ValueAt(hit.station));
+    }
+    SetStatusText(text);
+}
+
+void MapFrame::OnScalePaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(scalePanel);
+    dc.SetBackground(wxBrush(scalePanel->GetBackgroundColour()));
+    dc.Clear();
+    if (colormap_) {
+        colormap_->DrawScale(dc, scalePanel->GetClientSize());
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef MAP_FRAME_H
+#define MAP_FRAME_H
+
+#include <wx/wx.h>
+#include <wx/timer.h>
+#include "mathplot.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include "main.h"
+#include "AqiEngine.h"
+#include "StationIndex.h"
+
+class HeatmapColormap;
+
+// Prostokąt współrzędnych i rozdzielczość siatki powierzchni (wiersz 0 to północny brzeg)
+struct MapView {
+    double minLatitude = 0.0;
+    double minLongitude = 0.0;
+    double maxLatitude = 0.0;
+    double maxLongitude = 0.0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const MapView& other) const {
+        return minLatitude == other.minLatitude && minLongitude == other.minLongitude &&
+            maxLatitude == other.maxLatitude && maxLongitude == other.maxLongitude &&
+            width == other.width && height == other.height;
+    }
+    bool operator!=(const MapView& other) const { return !(*this == other); }
+};
+
+// Interpolacja stężeń metodą odwrotnych odległości (IDW) z k najbliższych stacji.
+// Siatka jest liczona kafelkami, równolegle. Dla kafelka indeks przestrzenny wybiera stacje, które mogą
+// być wśród k najbliższych dla któregokolwiek z jego pikseli, a odległości piksela do tych stacji liczy
+// pętla bez rozgałęzień na tablicach współrzędnych (wektoryzowana przez kompilator).
+// Obiekt nie zmienia się po utworzeniu, więc może być używany jednocześnie przez wiele wątków.
+class IdwInterpolator {
+public:
+    // Stacje bez współrzędnych lub bez wartości (NaN) są pomijane
+    IdwInterpolator(const std::vector<Station>& stations, const std::vector<float>& values);
+
+    size_t StationCount() const { return stations_.size(); }
+    const Station& StationAt(size_t i) const { return stations_[i]; }
+    float ValueAt(size_t i) const { return values_[i]; }
+    const StationIndex& Index() const { return index_; }
+
+    // Wypełnia surface (view.width * view.height, wierszami) wartościami interpolowanymi; piksele dalej
+    // niż zasięg interpolacji od najbliższej stacji mają NaN. Gdy cancelled zwróci true, pozostałe kafelki
+    // są pomijane, a funkcja zwraca false (powierzchnia jest niepełna)
+    bool Render(const MapView& view, std::vector<float>& surface, unsigned maxThreads,
+        const std::function<bool()>& cancelled = std::function<bool()>()) const;
+
+private:
+    void RenderTile(const MapView& view, int x0, int y0, int x1, int y1, float* surface) const;
+
+    std::vector<Station> stations_;
+    std::vector<float> values_;
+    StationIndex index_;
+};
+
+// Mapa stacji: stacje w ich współrzędnych i powierzchnia stężeń wybranego zanieczyszczenia,
+// interpolowana z najnowszych pomiarów. Przy przesuwaniu i powiększaniu powierzchnia jest od razu
+// liczona w niskiej rozdzielczości, a po zatrzymaniu widoku w pełnej, w tle.
+class MapFrame : public wxFrame {
+public:
+    // Stężenia są kopiowane z silnika indeksu jakości powietrza (najnowsze pomiary stacji)
+    MapFrame(const std::vector<Station>& stations, const AqiEngine& aqi);
+    ~MapFrame();
+
+private:
+    struct RenderJob;
+    struct RenderState;
+
+    void SetPollutant(int pollutant);
+    MapView CurrentView() const;
+    void OnPlotPaint(wxPaintEvent& event);
+    // Widok się zmienił: szybki podgląd w niskiej rozdzielczości i dokładne przeliczenie po chwili
+    void OnViewChanged();
+    void OnRefineTimer(wxTimerEvent& event);
+    void OnRefineDone(RenderJob& job);
+    void ShowSurface(const MapView& view, std::vector<float>& surface);
+    void OnPollutantChanged(wxCommandEvent& event);
+    void OnPlotMotion(wxMouseEvent& event);
+    void OnScalePaint(wxPaintEvent& event);
+
+    mpWindow* plot;
+    mpBitmapLayer* surfaceLayer;
+    mpFXYVector* stationLayer;
+    wxChoice* pollutantChoice;
+    wxPanel* scalePanel;
+    wxTimer refineTimer;
+
+    std::vector<Station> stations_;
+    std::vector<float> values_[AQI_POLLUTANT_COUNT];   // stężenia dla każdej stacji z stations_
+    int pollutant_;
+    std::shared_ptr<const IdwInterpolator> interpolator_;
+    std::unique_ptr<HeatmapColormap> colormap_;
+    MapView requested_;                  // widok, dla którego liczona jest powierzchnia
+    MapView shown_;                      // widok powierzchni pokazanej w warstwie
+    std::vector<float> surface_;         // wartości pokazanej powierzchni (podgląd wartości pod kursorem)
+    bool viewCheckPending_;
+    unsigned generation_;                // numer ostatniego przeliczenia, starsze wyniki są pomijane
+    std::shared_ptr<RenderState> state_;
+};
+
+#endif // MAP_FRAME_H
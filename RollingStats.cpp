@@ -0,0 +1,167 @@
+#include "RollingStats.h"
+#include "mathplot.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Średnia jest ważna, gdy okno zawiera co najmniej 75% pomiarów godzinowych
+    bool HasCoverage(const RollingMean& mean) {
+        return mean.Count() * 4 >= (size_t)(mean.Window() / 3600) * 3;
+    }
+
+    // Początek doby (czas lokalny), do której należy time. Bez std::localtime: jego wspólny bufor
+    // nadpisują równocześnie wątki eksportu i uzupełniania archiwum
+    std::time_t LocalDayStart(std::time_t time) {
+        std::tm tm;
+        if (!mpConvertTime(time, true, tm)) {
+            return time;
+        }
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        return std::mktime(&tm);
+    }
+}
+
+RollingMean::RollingMean(std::time_t window)
+    : window_(window), sum_(0.0) {
+}
+
+void RollingMean::Add(std::time_t time, double value) {
+    samples_.push_back({ time, value });
+    sum_ += value;
+    // Okno (time - window, time]: pomiar sprzed pełnego okna wypada
+    while (samples_.front().time <= time - window_) {
+        sum_ -= samples_.front().value;
+        samples_.pop_front();
+    }
+    // Suma liczona odejmowaniem gubi precyzję; po opróżnieniu okna zaczyna od zera
+    if (samples_.size() == 1) {
+        sum_ = value;
+    }
+}
+
+RollingExtreme::RollingExtreme(bool maximum)
+    : maximum_(maximum) {
+}
+
+void RollingExtreme::Add(std::time_t time, double value) {
+    // Starsze pomiary nie gorsze od nowego nie będą już ekstremum: wypadną z okna wcześniej
+    while (!queue_.empty() && (maximum_ ? queue_.back().value <= value : queue_.back().value >= value)) {
+        queue_.pop_back();
+    }
+    queue_.push_back({ time, value });
+}
+
+void RollingExtreme::EvictBefore(std::time_t start) {
+    while (!queue_.empty() && queue_.front().time < start) {
+        queue_.pop_front();
+    }
+}
+
+CovarianceAccumulator::CovarianceAccumulator()
+    : count_(0), meanX_(0.0), meanY_(0.0), m2X_(0.0), m2Y_(0.0), coMoment_(0.0) {
+}
+
+void CovarianceAccumulator::Add(double x, double y) {
+    ++count_;
+    const double dx = x - meanX_;
+    meanX_ += dx / count_;
+    const double dy = y - meanY_;
+    meanY_ += dy / count_;
+    // Odchylenie od poprzedniej średniej razy odchylenie od nowej
+    m2X_ += dx * (x - meanX_);
+    m2Y_ += dy * (y - meanY_);
+    coMoment_ += dx * (y - meanY_);
+}
+
+void CovarianceAccumulator::Merge(const CovarianceAccumulator& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    // Łączenie momentów dwóch grup (Chan i in.)
+    const double total = (double)(count_ + other.count_);
+    const double dx = other.meanX_ - meanX_;
+    const double dy = other.meanY_ - meanY_;
+    const double weight = (double)count_ * other.count_ / total;
+    m2X_ += other.m2X_ + dx * dx * weight;
+    m2Y_ += other.m2Y_ + dy * dy * weight;
+    coMoment_ += other.coMoment_ + dx * dy * weight;
+    meanX_ += dx * other.count_ / total;
+    meanY_ += dy * other.count_ / total;
+    count_ += other.count_;
+}
+
+double CovarianceAccumulator::Correlation() const {
+    const double denominator = std::sqrt(m2X_ * m2Y_);
+    return denominator > 0.0 ? coMoment_ / denominator : std::numeric_limits<double>::quiet_NaN();
+}
+
+SensorStatistics::SensorStatistics(const wxString& paramName)
+    : dailyMax_(true), dayStart_(0), lastTime_(0) {
+    means_[STAT_MEAN_1H] = RollingMean(3600);
+    means_[STAT_MEAN_8H] = RollingMean(8 * 3600);
+    means_[STAT_MEAN_24H] = RollingMean(24 * 3600);
+
+    // Normy: średnie 8-godzinne dla ozonu i tlenku węgla, dobowe dla pyłów
+    wxString name = paramName.Lower();
+    enabled_[STAT_MEAN_1H] = true;
+    enabled_[STAT_MEAN_8H] = name.Contains("ozon") || (name.Contains("tlenek w") && !name.Contains("dwutlenek"));
+    enabled_[STAT_MEAN_24H] = name.Contains("pm10") || name.Contains("pm2.5");
+    enabled_[STAT_DAILY_MAX] = true;
+}
+
+void SensorStatistics::Add(std::time_t time, double value) {
+    if (time <= lastTime_) {
+        return;
+    }
+    lastTime_ = time;
+
+    for (int s = STAT_MEAN_1H; s <= STAT_MEAN_24H; ++s) {
+        if (!enabled_[s]) {
+            continue;
+        }
+        means_[s].Add(time, value);
+        if (HasCoverage(means_[s])) {
+            pending_[s].push_back({ time, means_[s].Mean() });
+        }
+    }
+
+    if (enabled_[STAT_DAILY_MAX]) {
+        // Nowa doba: pomiary z poprzedniej wypadają z kolejki
+        std::time_t dayStart = LocalDayStart(time);
+        if (dayStart != dayStart_) {
+            dailyMax_.EvictBefore(dayStart);
+            dayStart_ = dayStart;
+        }
+        dailyMax_.Add(time, value);
+        pending_[STAT_DAILY_MAX].push_back({ time, dailyMax_.Value() });
+    }
+}
+
+void SensorStatistics::TakePending(RollingStatistic statistic, std::time_t from, std::vector<double>& xs, std::vector<double>& ys) {
+    xs.clear();
+    ys.clear();
+    for (const auto& point : pending_[statistic]) {
+        if (point.time >= from) {
+            xs.push_back((double)point.time);
+            ys.push_back(point.value);
+        }
+    }
+    pending_[statistic].clear();
+}
+
+wxString SensorStatistics::Name(RollingStatistic statistic) {
+    switch (statistic) {
+    case STAT_MEAN_1H: return "średnia 1 h";
+    case STAT_MEAN_8H: return "średnia 8 h";
+    case STAT_MEAN_24H: return "średnia 24 h";
+    case STAT_DAILY_MAX: return "maksimum dobowe";
+    default: return "";
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+#include <wx/wx.h>
+#include <deque>
+#include <vector>
+#include <ctime>
+#include "main.h"
+
+// Średnia z okna czasu (window sekund, kończącego się na ostatnim pomiarze).
+// Kolejka pomiarów w oknie oraz ich suma: dodanie pomiaru to O(1) (zamortyzowane).
+class RollingMean {
+public:
+    explicit RollingMean(std::time_t window = 3600);
+
+    // Dodaje pomiar; czasy muszą rosnąć
+    void Add(std::time_t time, double value);
+    double Mean() const { return samples_.empty() ? 0.0 : sum_ / samples_.size(); }
+    size_t Count() const { return samples_.size(); }
+    std::time_t Window() const { return window_; }
+
+private:
+    std::time_t window_;
+    std::deque<Measurement> samples_;
+    double sum_;
+};
+
+// Maksimum lub minimum pomiarów od zadanego czasu: kolejka monotoniczna, w której zostają tylko pomiary
+// mogące jeszcze być ekstremum, więc dodanie pomiaru i usunięcie starych to O(1) (zamortyzowane).
+class RollingExtreme {
+public:
+    explicit RollingExtreme(bool maximum = true);
+
+    // Dodaje pomiar; czasy muszą rosnąć
+    void Add(std::time_t time, double value);
+    // Usuwa pomiary starsze niż start
+    void EvictBefore(std::time_t start);
+    bool IsEmpty() const { return queue_.empty(); }
+    double Value() const { return queue_.front().value; }
+
+private:
+    bool maximum_;
+    std::deque<Measurement> queue_;
+};
+
+// Średnie, wariancje i kowariancja par wartości (x, y) liczone w jednym przebiegu metodą Welforda:
+// dodanie pary to O(1) i nie wymaga przechowywania danych, a wynik jest stabilny numerycznie także
+// przy setkach tysięcy par o dużej średniej. Dwa akumulatory można połączyć (np. z różnych wątków).
+class CovarianceAccumulator {
+public:
+    CovarianceAccumulator();
+
+    void Add(double x, double y);
+    // Dołącza pary zebrane przez inny akumulator, jakby były dodane tutaj
+    void Merge(const CovarianceAccumulator& other);
+
+    size_t Count() const { return count_; }
+    double MeanX() const { return meanX_; }
+    double MeanY() const { return meanY_; }
+    // Wariancje i kowariancja z próby (dzielone przez n - 1); 0 dla mniej niż dwóch par
+    double VarianceX() const { return count_ > 1 ? m2X_ / (count_ - 1) : 0.0; }
+    double VarianceY() const { return count_ > 1 ? m2Y_ / (count_ - 1) : 0.0; }
+    double Covariance() const { return count_ > 1 ? coMoment_ / (count_ - 1) : 0.0; }
+    // Współczynnik korelacji Pearsona (NaN, gdy jedna ze zmiennych jest stała)
+    double Correlation() const;
+
+private:
+    size_t count_;
+    double meanX_;
+    double meanY_;
+    double m2X_;        // suma kwadratów odchyleń od średniej
+    double m2Y_;
+    double coMoment_;   // suma iloczynów odchyleń
+};
+
+// Statystyki wymagane przy ocenie zgodności z normami
+enum RollingStatistic {
+    STAT_MEAN_1H,      // średnia 1-godzinna
+    STAT_MEAN_8H,      // średnia krocząca 8-godzinna (O3, CO)
+    STAT_MEAN_24H,     // średnia krocząca 24-godzinna (PM10, PM2.5)
+    STAT_DAILY_MAX,    // maksimum od początku doby (czas lokalny)
+    STAT_COUNT
+};
+
+// Statystyki strumieniowe jednego sensora: każdy nowy pomiar aktualizuje okna kroczące bez
+// ponownego przeglądania historii, a nowe wartości statystyk czekają na odebranie przez TakePending()
+class SensorStatistics {
+public:
+    // Zestaw statystyk zależy od wskaźnika (nazwa z API)
+    explicit SensorStatistics(const wxString& paramName = "");
+
+    bool IsEnabled(RollingStatistic statistic) const { return enabled_[statistic]; }
+    // Czas ostatniego dodanego pomiaru (0, jeśli nie było pomiarów)
+    std::time_t LastTime() const { return lastTime_; }
+
+    // Dodaje pomiar; pomiary nie nowsze od LastTime() są pomijane
+    void Add(std::time_t time, double value);
+    // Przenosi nowe punkty statystyki (od czasu from) do xs i ys; starsze punkty są odrzucane
+    void TakePending(RollingStatistic statistic, std::time_t from, std::vector<double>& xs, std::vector<double>& ys);
+
+    static wxString Name(RollingStatistic statistic);
+
+private:
+    bool enabled_[STAT_COUNT];
+    RollingMean means_[STAT_COUNT];
+    RollingExtreme dailyMax_;
+    std::time_t dayStart_;
+    std::time_t lastTime_;
+    std::vector<Measurement> pending_[STAT_COUNT];
+};
+
+#endif // ROLLING_STATS_H
@@ -0,0 +1,242 @@
+#include "ScatterFrame.h"
+#include "HourlyGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Pary z ostatnich 500 godzin (około 3 tygodnie) każdej stacji
+    const int scatterHours = 500;
+    const unsigned maxFetchThreads = 8;
+
+}
+
+// Pobranie: kopia stacji (wątki tła uzupełniają brakujące czujniki) i wybrana para zanieczyszczeń
+struct ScatterFrame::FetchJob {
+    unsigned generation = 0;
+    AqiPollutant x = AQI_PM10;
+    AqiPollutant y = AQI_PM25;
+    std::vector<Station> stations;
+};
+
+// Pary jednej stacji wraz z ich akumulatorem, policzonym w wątku tła
+struct ScatterFrame::StationPairs {
+    unsigned generation = 0;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    CovarianceAccumulator accumulator;
+};
+
+// Stan współdzielony z wątkami tła; frame jest zerowany w destruktorze okna i czytany tylko w wątku GUI
+struct ScatterFrame::FetchState {
+    ScatterFrame* frame = nullptr;
+};
+
+ScatterFrame::ScatterFrame(const std::vector<Station>& stations, int selectedStationId)
+    : wxFrame(nullptr, wxID_ANY, "Wykres rozrzutu zanieczyszczeń", wxDefaultPosition, wxSize(900, 750)),
+      stations_(stations), selectedStationId_(selectedStationId), pairStations_(0), generation_(0),
+      state_(std::make_shared<FetchState>()) {
+    state_->frame = this;
+
+    wxPanel* mainPanel = new wxPanel(this);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    // Para zanieczyszczeń i zakres stacji
+    wxBoxSizer* controlsSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxArrayString labels;
+    for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+        labels.Add(AqiEngine::PollutantName((AqiPollutant)p));
+    }
+    xChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, labels);
+    xChoice->SetSelection(AQI_PM10);
+    yChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, labels);
+    yChoice->SetSelection(AQI_PM25);
+    wxString scopes[] = { "Zaznaczona stacja", "Wszystkie stacje" };
+    scopeChoice = new wxChoice(mainPanel, wxID_ANY, wxDefaultPosition, wxDefaultSize, 2, scopes);
+    scopeChoice->SetSelection(selectedStationId_ > 0 ? 0 : 1);
+    showButton = new wxButton(mainPanel, wxID_ANY, "Pokaż");
+    controlsSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Oś X:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    controlsSizer->Add(xChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(new wxStaticText(mainPanel, wxID_ANY, "Oś Y:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    controlsSizer->Add(yChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(scopeChoice, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    controlsSizer->Add(showButton, 0);
+    mainSizer->Add(controlsSizer, 0, wxALL, 10);
+
+    plot = new mpWindow(mainPanel, wxID_ANY);
+    xaxis = new mpScaleX("", mpALIGN_BOTTOM, true);
+    yaxis = new mpScaleY("", mpALIGN_LEFT, true);
+    xaxis->SetTicks(true);
+    yaxis->SetTicks(true);
+    pointsLayer = new mpFXYVector("Pary pomiarów");
+    pointsLayer->ShowName(false);
+    pointsLayer->SetContinuity(false);
+    pointsLayer->SetPen(wxPen(wxColour(30, 90, 200), 2));
+    pointsLayer->SetDrawOutsideMargins(false);
+    ellipse = new mpCovarianceEllipse(1, 1, 0, 2, 64, "Elipsa kowariancji (2σ)");
+    ellipse->ShowName(false);
+    ellipse->SetPen(wxPen(*wxRED, 2));
+    ellipse->SetVisible(false);
+    plot->AddLayer(xaxis);
+    plot->AddLayer(yaxis);
+    plot->AddLayer(pointsLayer);
+    plot->AddLayer(ellipse);
+    mainSizer->Add(plot, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
+
+    mainPanel->SetSizer(mainSizer);
+    mainPanel->Layout();
+    CreateStatusBar();
+
+    showButton->Bind(wxEVT_BUTTON, &ScatterFrame::OnShow, this);
+
+    wxCommandEvent event;
+    OnShow(event);
+}
+
+ScatterFrame::~ScatterFrame() {
+    // Wyniki pobierania zakończonego po zamknięciu okna są pomijane
+    state_->frame = nullptr;
+}
+
+void ScatterFrame::OnShow(wxCommandEvent& event) {
+    auto job = std::make_shared<FetchJob>();
+    job->generation = ++generation_;
+    job->x = (AqiPollutant)xChoice->GetSelection();
+    job->y = (AqiPollutant)yChoice->GetSelection();
+    if (scopeChoice->GetSelection() == 0) {
+        for (const auto& station : stations_) {
+            if (station.id == selectedStationId_) {
+                job->stations.push_back(station);
+            }
+        }
+    }
+    else {
+        job->stations = stations_;
+    }
+    if (job->stations.empty()) {
+        SetStatusText("Proszę wybrać stację na liście w oknie głównym.");
+        return;
+    }
+
+    // Nowy wykres: punkty i akumulator od zera
+    pointsLayer->Clear();
+    accumulator_ = CovarianceAccumulator();
+    pairStations_ = 0;
+    xaxis->SetName(AqiEngine::PollutantName(job->x) + wxString(" [µg/m³]"));
+    yaxis->SetName(AqiEngine::PollutantName(job->y) + wxString(" [µg/m³]"));
+    UpdateEllipse();
+    plot->UpdateAll();
+
+    showButton->Disable();
+    SetStatusText(wxString::Format("Pobieranie pomiarów %zu stacji...", job->stations.size()));
+
+    std::shared_ptr<FetchState> state = state_;
+    std::thread([state, job]() {
+        // Każde zadanie zapisuje tylko swoją stację; pary są wysyłane do okna zaraz po policzeniu
+        RunParallel(job->stations.size(), maxFetchThreads, [&state, &job](size_t i) {
+            Station& station = job->stations[i];
+            try {
+                if (station.sensors.empty()) {
+                    FetchStationSensors(station.id, station.sensors);
+                }
+                int xSensor = FindSensor(station.sensors, job->x);
+                int ySensor = FindSensor(station.sensors, job->y);
+                std::vector<std::vector<Measurement>> series(2);
+                if (xSensor == 0 || ySensor == 0 || !FetchSeries(xSensor, scatterHours, series[0]) || !FetchSeries(ySensor, scatterHours, series[1])) {
+                    return;
+                }
+
+                // Pary: godziny, w których są oba pomiary
+                HourlyGrid grid;
+                grid.ResetToSpan(series);
+                grid.SetColumn(0, series[0]);
+                grid.SetColumn(1, series[1]);
+                auto pairs = std::make_shared<StationPairs>();
+                pairs->generation = job->generation;
+                for (int row = 0; row < grid.Hours(); ++row) {
+                    if (grid.IsValid(row, 0) && grid.IsValid(row, 1)) {
+                        pairs->xs.push_back(grid.Value(row, 0));
+                        pairs->ys.push_back(grid.Value(row, 1));
+                        pairs->accumulator.Add(grid.Value(row, 0), grid.Value(row, 1));
+                    }
+                }
+                if (!pairs->xs.empty()) {
+                    wxTheApp->CallAfter([state, pairs]() {
+                        if (state->frame) {
+                            state->frame->OnPairsArrived(*pairs);
+                        }
+                        });
+                }
+            }
+            catch (const std::exception& e) {
+                wxLogError("Błąd pobierania danych stacji %d: %s", station.id, e.what());
+            }
+            });
+        wxTheApp->CallAfter([state, job]() {
+            if (state->frame) {
+                state->frame->OnFetchDone(*job);
+            }
+            });
+        }).detach();
+}
+
+void ScatterFrame::OnPairsArrived(StationPairs& pairs) {
+    // Pary z pobrania zastąpionego nowszym
+    if (pairs.generation != generation_) {
+        return;
+    }
+    mpUpdateBatch updateBatch(plot);
+    pointsLayer->AppendData(pairs.xs, pairs.ys);
+    accumulator_.Merge(pairs.accumulator);
+    ++pairStations_;
+    UpdateEllipse();
+    plot->Fit();
+    UpdateStatus();
+}
+
+void ScatterFrame::OnFetchDone(FetchJob& job) {
+    if (job.generation != generation_) {
+        return;
+    }
+    showButton->Enable();
+
+    // Czujniki pobrane w tle są zapamiętywane na kolejne wykresy
+    for (auto& station : job.stations) {
+        auto it = std::find_if(stations_.begin(), stations_.end(),
+            [&station](const Station& s) { return s.id == station.id; });
+        if (it != stations_.end() && it->sensors.empty()) {
+            it->sensors = std::move(station.sensors);
+        }
+    }
+
+    if (accumulator_.Count() == 0) {
+        SetStatusText("Brak godzin z pomiarami obu zanieczyszczeń.");
+        return;
+    }
+    UpdateStatus();
+}
+
+void ScatterFrame::UpdateEllipse() {
+    // Elipsa wymaga dodatnio określonej macierzy kowariancji
+    const double varianceX = accumulator_.VarianceX();
+    const double varianceY = accumulator_.VarianceY();
+    const double covariance = accumulator_.Covariance();
+    if (accumulator_.Count() < 3 || varianceX * varianceY - covariance * covariance <= 0.0) {
+        ellipse->SetVisible(false);
+        return;
+    }
+    ellipse->SetCovarianceMatrix(varianceX, covariance, varianceY);
+    ellipse->SetCoordinateBase(accumulator_.MeanX(), accumulator_.MeanY());
+    ellipse->SetVisible(true);
+}
+
+void ScatterFrame::UpdateStatus() {
+    wxString text = wxString::Format("%zu par z %zu stacji; średnie: X %.1f, Y %.1f",
+        accumulator_.Count(), pairStations_, accumulator_.MeanX(), accumulator_.MeanY());
+    const double correlation = accumulator_.Correlation();
+    if (!std::isnan(correlation)) {
+        // Nachylenie prostej regresji Y względem X: cov(X, Y) / var(X)
+        text += wxString::Format("; korelacja r = %.3f, nachylenie Y/X = %.3f",
+            correlation, accumulator_.Covariance() / accumulator_.VarianceX());
+    }
+    SetStatusText(text);
+}
@@ -0,0 +1,50 @@
+#ifndef SCATTER_FRAME_H
+#define SCATTER_FRAME_H
+
+#include <wx/wx.h>
+#include "mathplot.h"
+#include <memory>
+#include <vector>
+#include "main.h"
+#include "AqiEngine.h"
+#include "RollingStats.h"
+
+// Wykres rozrzutu dwóch zanieczyszczeń (np. PM2.5 względem PM10) z jednej lub wszystkich stacji:
+// pary pomiarów z tej samej godziny i elipsa kowariancji (2 sigma) wokół średniej.
+// Stacje są pobierane równolegle, a pary każdej stacji trafiają na wykres, gdy tylko są gotowe;
+// elipsa jest aktualizowana przez łączenie akumulatorów kowariancji, bez ponownego przeglądania punktów.
+class ScatterFrame : public wxFrame {
+public:
+    ScatterFrame(const std::vector<Station>& stations, int selectedStationId);
+    ~ScatterFrame();
+
+private:
+    struct FetchJob;
+    struct StationPairs;
+    struct FetchState;
+
+    void OnShow(wxCommandEvent& event);
+    void OnPairsArrived(StationPairs& pairs);
+    void OnFetchDone(FetchJob& job);
+    void UpdateEllipse();
+    void UpdateStatus();
+
+    mpWindow* plot;
+    mpScaleX* xaxis;
+    mpScaleY* yaxis;
+    mpFXYVector* pointsLayer;
+    mpCovarianceEllipse* ellipse;
+    wxChoice* xChoice;
+    wxChoice* yChoice;
+    wxChoice* scopeChoice;
+    wxButton* showButton;
+
+    std::vector<Station> stations_;
+    int selectedStationId_;
+    CovarianceAccumulator accumulator_;  // wszystkie pary na wykresie
+    size_t pairStations_;                // liczba stacji, z których są pary
+    unsigned generation_;                // numer ostatniego pobrania, starsze wyniki są pomijane
+    std::shared_ptr<FetchState> state_;
+};
+
+#endif // SCATTER_FRAME_H
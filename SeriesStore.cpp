@@ -0,0 +1,123 @@
+#include "SeriesStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+namespace {
+    // Nagłówek pliku: znacznik formatu, potem rekordy stałej długości
+    const char seriesMagic[8] = { 'A', 'Q', 'S', 'E', 'R', 'I', 'E', '1' };
+
+    struct SeriesRecord {
+        int64_t time;
+        double value;
+    };
+}
+
+SeriesStore::SeriesStore(const std::string& directory)
+    : directory_(directory) {
+}
+
+std::string SeriesStore::SeriesPath(int sensorId) const {
+    return (std::filesystem::path(directory_) / (std::to_string(sensorId) + ".bin")).string();
+}
+
+bool SeriesStore::Load(int sensorId, std::vector<Measurement>& measurements) const {
+    measurements.clear();
+    std::ifstream file(SeriesPath(sensorId), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    char magic[sizeof(seriesMagic)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, seriesMagic, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    const std::streamoff size = (std::streamoff)file.tellg() - (std::streamoff)sizeof(seriesMagic);
+    if (size < 0 || size % sizeof(SeriesRecord) != 0) {
+        return false;
+    }
+    std::vector<SeriesRecord> records((size_t)size / sizeof(SeriesRecord));
+    file.seekg(sizeof(seriesMagic), std::ios::beg);
+    if (!records.empty() && !file.read(reinterpret_cast<char*>(records.data()), size)) {
+        return false;
+    }
+
+    measurements.reserve(records.size());
+    for (const auto& record : records) {
+        measurements.push_back({ (std::time_t)record.time, record.value });
+    }
+    return true;
+}
+
+long SeriesStore::Merge(int sensorId, const std::vector<Measurement>& measurements) {
+    // Nowe pomiary posortowane po czasie; z powtórzeń tej samej godziny zostaje ostatni
+    std::vector<Measurement> incoming;
+    incoming.reserve(measurements.size());
+    for (const auto& m : measurements) {
+        if (!std::isnan(m.value)) {
+            incoming.push_back(m);
+        }
+    }
+    std::stable_sort(incoming.begin(), incoming.end(),
+        [](const Measurement& a, const Measurement& b) { return a.time < b.time; });
+    size_t unique = 0;
+    for (size_t i = 0; i < incoming.size(); ++i) {
+        if (unique > 0 && incoming[unique - 1].time == incoming[i].time) {
+            incoming[unique - 1] = incoming[i];
+        }
+        else {
+            incoming[unique++] = incoming[i];
+        }
+    }
+    incoming.resize(unique);
+    if (incoming.empty()) {
+        return 0;
+    }
+
+    // Scalanie dwóch posortowanych ciągów; przy tej samej godzinie wygrywa nowy pomiar
+    std::vector<Measurement> stored;
+    Load(sensorId, stored);
+    std::vector<SeriesRecord> merged;
+    merged.reserve(stored.size() + incoming.size());
+    long added = 0;
+    size_t s = 0;
+    size_t n = 0;
+    while (s < stored.size() || n < incoming.size()) {
+        if (n == incoming.size() || (s < stored.size() && stored[s].time < incoming[n].time)) {
+            merged.push_back({ (int64_t)stored[s].time, stored[s].value });
+            ++s;
+            continue;
+        }
+        if (s < stored.size() && stored[s].time == incoming[n].time) {
+            ++s;
+        }
+        else {
+            ++added;
+        }
+        merged.push_back({ (int64_t)incoming[n].time, incoming[n].value });
+        ++n;
+    }
+
+    // Zapis do pliku tymczasowego i podmiana, żeby przerwanie nie zostawiło połowy pliku
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    const std::string path = SeriesPath(sensorId);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return -1;
+        }
+        file.write(seriesMagic, sizeof(seriesMagic));
+        file.write(reinterpret_cast<const char*>(merged.data()), (std::streamsize)(merged.size() * sizeof(SeriesRecord)));
+        if (!file) {
+            return -1;
+        }
+    }
+    std::filesystem::rename(temporary, path, ec);
+    return ec ? -1 : added;
+}
@@ -0,0 +1,31 @@
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include "main.h"
+
+// Lokalne archiwum pomiarów: jeden plik binarny na czujnik (<katalog>/<id>.bin) z rekordami
+// (czas, wartość) posortowanymi rosnąco po czasie, bez powtórzeń godzin. Zapis łączy nowe pomiary
+// z zapisanymi (dla tej samej godziny wygrywa nowszy odczyt z API) i podmienia plik w całości,
+// więc przerwany zapis nie uszkadza archiwum. Różne czujniki można zapisywać z wielu wątków
+// jednocześnie, ale jeden czujnik - tylko z jednego.
+class SeriesStore {
+public:
+    explicit SeriesStore(const std::string& directory);
+
+    const std::string& Directory() const { return directory_; }
+    std::string SeriesPath(int sensorId) const;
+
+    // Pomiary czujnika rosnąco po czasie; false, gdy brak pliku lub jest uszkodzony
+    bool Load(int sensorId, std::vector<Measurement>& measurements) const;
+    // Dołącza pomiary (w dowolnej kolejności, pomiary NaN są pomijane); zwraca liczbę nowych godzin
+    // albo -1 przy błędzie zapisu
+    long Merge(int sensorId, const std::vector<Measurement>& measurements);
+
+private:
+    std::string directory_;
+};
+
+#endif // SERIES_STORE_H
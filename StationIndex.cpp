@@ -0,0 +1,144 @@
+#include "StationIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double earthRadiusKm = 6371.0;
+    const double degreesToRadians = 3.14159265358979323846 / 180.0;
+
+    // Dolne ograniczenie odległości od punktu do stacji po drugiej stronie równoleżnika podziału:
+    // droga po kuli jest co najmniej tak długa jak różnica szerokości
+    double LatitudeBoundKm(double latitude, double splitLatitude) {
+        return std::fabs(splitLatitude - latitude) * degreesToRadians * earthRadiusKm;
+    }
+
+    // Dolne ograniczenie dla stacji po drugiej stronie południka podziału: odległość punktu od koła
+    // wielkiego tego południka (dla różnicy długości do 90 stopni)
+    double LongitudeBoundKm(double latitude, double longitude, double splitLongitude) {
+        double delta = std::min(std::fabs(splitLongitude - longitude), 90.0) * degreesToRadians;
+        double sine = std::fabs(std::cos(latitude * degreesToRadians) * std::sin(delta));
+        return std::asin(std::min(1.0, sine)) * earthRadiusKm;
+    }
+}
+
+void StationIndex::Build(const std::vector<Station>& stations) {
+    nodes_.clear();
+    for (size_t i = 0; i < stations.size(); ++i) {
+        if (stations[i].hasLocation) {
+            nodes_.push_back({ stations[i].latitude, stations[i].longitude, i });
+        }
+    }
+    BuildRange(0, nodes_.size(), 0);
+}
+
+void StationIndex::BuildRange(size_t begin, size_t end, int depth) {
+    if (end - begin <= 1) {
+        return;
+    }
+    // Podział na medianie: na parzystych poziomach według długości, na nieparzystych według szerokości
+    const size_t mid = begin + (end - begin) / 2;
+    const bool byLongitude = depth % 2 == 0;
+    std::nth_element(nodes_.begin() + begin, nodes_.begin() + mid, nodes_.begin() + end,
+        [byLongitude](const Node& a, const Node& b) {
+            return byLongitude ? a.longitude < b.longitude : a.latitude < b.latitude;
+        });
+    BuildRange(begin, mid, depth + 1);
+    BuildRange(mid + 1, end, depth + 1);
+}
+
+std::vector<StationIndex::Hit> StationIndex::Nearest(double latitude, double longitude, size_t k) const {
+    std::vector<Hit> hits;
+    if (k == 0 || nodes_.empty()) {
+        return hits;
+    }
+
+    // Kopiec (max) k najlepszych kandydatów; jego wierzchołek to obecnie najdalszy z nich
+    std::vector<Candidate> heap;
+    heap.reserve(std::min(k, nodes_.size()));
+    NearestRange(0, nodes_.size(), 0, latitude, longitude, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    hits.reserve(heap.size());
+    for (const auto& candidate : heap) {
+        hits.push_back({ nodes_[candidate.second].station, candidate.first });
+    }
+    return hits;
+}
+
+void StationIndex::NearestRange(size_t begin, size_t end, int depth, double latitude, double longitude, size_t k,
+    std::vector<Candidate>& heap) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    const Node& node = nodes_[mid];
+    const double distance = DistanceKm(latitude, longitude, node.latitude, node.longitude);
+    if (heap.size() < k) {
+        heap.push_back({ distance, mid });
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (distance < heap.front().first) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = { distance, mid };
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    // Najpierw strona punktu; druga tylko wtedy, gdy może zawierać bliższą stację niż najdalszy kandydat
+    const bool byLongitude = depth % 2 == 0;
+    const bool left = byLongitude ? longitude < node.longitude : latitude < node.latitude;
+    if (left) {
+        NearestRange(begin, mid, depth + 1, latitude, longitude, k, heap);
+    }
+    else {
+        NearestRange(mid + 1, end, depth + 1, latitude, longitude, k, heap);
+    }
+    const double bound = byLongitude ? LongitudeBoundKm(latitude, longitude, node.longitude)
+        : LatitudeBoundKm(latitude, node.latitude);
+    if (heap.size() < k || bound < heap.front().first) {
+        if (left) {
+            NearestRange(mid + 1, end, depth + 1, latitude, longitude, k, heap);
+        }
+        else {
+            NearestRange(begin, mid, depth + 1, latitude, longitude, k, heap);
+        }
+    }
+}
+
+std::vector<size_t> StationIndex::InBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude) const {
+    std::vector<size_t> result;
+    BoxRange(0, nodes_.size(), 0, minLatitude, minLongitude, maxLatitude, maxLongitude, result);
+    return result;
+}
+
+void StationIndex::BoxRange(size_t begin, size_t end, int depth, double minLatitude, double minLongitude,
+    double maxLatitude, double maxLongitude, std::vector<size_t>& result) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    const Node& node = nodes_[mid];
+    if (node.latitude >= minLatitude && node.latitude <= maxLatitude
+        && node.longitude >= minLongitude && node.longitude <= maxLongitude) {
+        result.push_back(node.station);
+    }
+
+    // Poddrzewa leżące całkowicie poza prostokątem są pomijane
+    const bool byLongitude = depth % 2 == 0;
+    const double value = byLongitude ? node.longitude : node.latitude;
+    if ((byLongitude ? minLongitude : minLatitude) <= value) {
+        BoxRange(begin, mid, depth + 1, minLatitude, minLongitude, maxLatitude, maxLongitude, result);
+    }
+    if ((byLongitude ? maxLongitude : maxLatitude) >= value) {
+        BoxRange(mid + 1, end, depth + 1, minLatitude, minLongitude, maxLatitude, maxLongitude, result);
+    }
+}
+
+double StationIndex::DistanceKm(double latitude1, double longitude1, double latitude2, double longitude2) {
+    const double phi1 = latitude1 * degreesToRadians;
+    const double phi2 = latitude2 * degreesToRadians;
+    const double dPhi = phi2 - phi1;
+    const double dLambda = (longitude2 - longitude1) * degreesToRadians;
+    const double a = std::sin(dPhi / 2) * std::sin(dPhi / 2)
+        + std::cos(phi1) * std::cos(phi2) * std::sin(dLambda / 2) * std::sin(dLambda / 2);
+    return 2.0 * earthRadiusKm * std::asin(std::min(1.0, std::sqrt(a)));
+}
@@ -0,0 +1,52 @@
+#ifndef STATION_INDEX_H
+#define STATION_INDEX_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "main.h"
+
+// Statyczny indeks przestrzenny stacji (drzewo k-d po szerokości i długości geograficznej),
+// budowany raz po wczytaniu listy stacji. Odległości są liczone po kuli ziemskiej, a poddrzewa są
+// odrzucane na podstawie dolnych ograniczeń odległości od południka lub równoleżnika podziału,
+// więc wyniki są dokładne. Drzewo jest zapisane w tablicy: węzłem zakresu [begin, end) jest element środkowy, lewe poddrzewo
+// to [begin, mid), prawe [mid + 1, end). Indeks przechowuje pozycje stacji w wektorze przekazanym
+// do Build, więc po zmianie listy stacji trzeba go zbudować od nowa.
+class StationIndex {
+public:
+    struct Hit {
+        size_t station;      // pozycja stacji w wektorze przekazanym do Build
+        double distanceKm;
+    };
+
+    // Buduje drzewo ze stacji, które mają współrzędne; O(n log n)
+    void Build(const std::vector<Station>& stations);
+    size_t Size() const { return nodes_.size(); }
+    bool IsEmpty() const { return nodes_.empty(); }
+
+    // k najbliższych stacji punktu, od najbliższej
+    std::vector<Hit> Nearest(double latitude, double longitude, size_t k) const;
+    // Wszystkie stacje w prostokącie współrzędnych (granice włącznie), w kolejności drzewa
+    std::vector<size_t> InBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude) const;
+
+    // Odległość po kuli ziemskiej (wzór haversine) w kilometrach
+    static double DistanceKm(double latitude1, double longitude1, double latitude2, double longitude2);
+
+private:
+    struct Node {
+        double latitude;
+        double longitude;
+        size_t station;
+    };
+    typedef std::pair<double, size_t> Candidate;   // odległość (km) i pozycja węzła
+
+    void BuildRange(size_t begin, size_t end, int depth);
+    void NearestRange(size_t begin, size_t end, int depth, double latitude, double longitude, size_t k,
+        std::vector<Candidate>& heap) const;
+    void BoxRange(size_t begin, size_t end, int depth, double minLatitude, double minLongitude,
+        double maxLatitude, double maxLongitude, std::vector<size_t>& result) const;
+
+    std::vector<Node> nodes_;
+};
+
+#endif // STATION_INDEX_H
@@ -1,5 +1,17 @@
 ﻿#include "main.h"
 #include "ChartFrame.h"
+#include "ChartExporter.h"
+#include "HeatmapFrame.h"
+#include "AqiEngine.h"
+#include "ComparisonFrame.h"
+#include "StationIndex.h"
+#include "MapFrame.h"
+#include "ScatterFrame.h"
+#include "CorrelationFrame.h"
+#include "BackfillEngine.h"
+#include <atomic>
+#include <limits>
+#include <wx/filename.h>
 
 // Specjalny event do aktualizacji GUI z wątku
 wxDECLARE_EVENT(MY_THREAD_UPDATE_EVENT, wxThreadEvent);
@@ -114,6 +126,237 @@ wxString fetch_data(std::string target, std::string filename, bool saveToFile) {
     }
 }
 
+// Zamiana daty z API ("RRRR-MM-DD GG:MM:SS", czas lokalny) na sekundy epoki
+bool ParseMeasurementTime(const std::string& date, std::time_t& time) {
+    std::tm tm = {};
+    if (std::sscanf(date.c_str(), "%d-%d-%d %d:%d:%d",
+        &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    time = std::mktime(&tm);
+    return time != (std::time_t)-1;
+}
+
+// Parsowanie listy pomiarów z odpowiedzi API; pomija pomiary z błędną datą oraz pomiary bez wartości,
+// chyba że keepNulls - wtedy mają wartość NaN (godzina jest znana, ale pomiar nieważny)
+bool ParseMeasurements(const std::string& data, const std::string& listKey, std::vector<Measurement>& measurements, bool keepNulls) {
+    measurements.clear();
+    json j = json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.contains(listKey)) {
+        return false;
+    }
+
+    const auto& list = j[listKey];
+    measurements.reserve(list.size());
+    for (const auto& measurement : list) {
+        if (!measurement.contains("Data") || !measurement["Data"].is_string()) {
+            continue;
+        }
+        bool isNull = !measurement.contains("Wartość") || measurement["Wartość"].is_null();
+        if (isNull && !keepNulls) {
+            continue;
+        }
+        // Wartość inna niż liczba (np. tekst) jest pomijana, żeby get<double>() nie rzucił wyjątku w wątku pobierania
+        if (!isNull && !measurement["Wartość"].is_number()) {
+            continue;
+        }
+        Measurement m;
+        if (!ParseMeasurementTime(measurement["Data"].get<std::string>(), m.time)) {
+            continue;
+        }
+        m.value = isNull ? std::numeric_limits<double>::quiet_NaN() : measurement["Wartość"].get<double>();
+        measurements.push_back(m);
+    }
+    return true;
+}
+
+bool ParseStationLocation(const json& station, Station& s) {
+    s.hasLocation = false;
+    double coordinates[2];
+    const char* keys[2] = { "gegrLat", "gegrLon" };
+    for (int i = 0; i < 2; ++i) {
+        if (!station.contains(keys[i])) {
+            return false;
+        }
+        const json& value = station[keys[i]];
+        if (value.is_number()) {
+            coordinates[i] = value.get<double>();
+        }
+        else if (value.is_string()) {
+            // API zwraca współrzędne jako tekst z kropką dziesiętną, niezależnie od ustawień regionalnych
+            if (!wxString::FromUTF8(value.get<std::string>().c_str()).ToCDouble(&coordinates[i])) {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    if (coordinates[0] < -90.0 || coordinates[0] > 90.0 || coordinates[1] < -180.0 || coordinates[1] > 180.0) {
+        return false;
+    }
+    s.latitude = coordinates[0];
+    s.longitude = coordinates[1];
+    s.hasLocation = true;
+    return true;
+}
+
+// Pobranie listy czujników stacji; udane pobranie trafia do katalogu, więc każda stacja jest pobierana raz
+bool FetchStationSensors(int stationId, std::vector<Sensor>& sensors) {
+    if (StationSensorCatalog().Find(stationId, sensors)) {
+        return true;
+    }
+
+    ApiRateLimiter().Acquire();
+    std::string target = "/pjp-api/v1/rest/station/sensors/" + std::to_string(stationId) + "?size=20&page=0";
+    wxString sensorsData = fetch_data(target, "", false);
+    if (sensorsData.StartsWith("ERROR:")) {
+        wxLogError("Błąd podczas pobierania czujników dla stacji %d: %s", stationId, sensorsData.c_str());
+        return false;
+    }
+
+    json sensorsJson = json::parse(sensorsData.ToStdString(wxConvUTF8), nullptr, false);
+    if (sensorsJson.is_discarded() || !sensorsJson.contains("Lista stanowisk pomiarowych dla podanej stacji")) {
+        return false;
+    }
+    for (const auto& sensor : sensorsJson["Lista stanowisk pomiarowych dla podanej stacji"]) {
+        if (!sensor.contains("Identyfikator stanowiska") || !sensor.contains("Wskaźnik") ||
+            !sensor["Identyfikator stanowiska"].is_number_integer() || !sensor["Wskaźnik"].is_string()) {
+            continue;
+        }
+        Sensor sensorData;
+        sensorData.id = sensor["Identyfikator stanowiska"].get<int>();
+        sensorData.paramName = wxString::FromUTF8(sensor["Wskaźnik"].get<std::string>().c_str());
+        sensors.push_back(sensorData);
+    }
+    if (sensors.empty()) {
+        return false;
+    }
+    StationSensorCatalog().Store(stationId, sensors);
+    return true;
+}
+
+bool FetchSeries(int sensorId, int rows, std::vector<Measurement>& measurements, bool keepNulls) {
+    ApiRateLimiter().Acquire();
+    std::string target = "/pjp-api/v1/rest/data/getData/" + std::to_string(sensorId) + "?size=" + std::to_string(rows) + "&page=0";
+    wxString data = fetch_data(target, "", false);
+    if (data.StartsWith("ERROR:")) {
+        wxLogError("Błąd pobierania danych dla sensora %d: %s", sensorId, data.c_str());
+        measurements.clear();
+        return false;
+    }
+    return ParseMeasurements(data.ToStdString(wxConvUTF8), "Lista danych pomiarowych", measurements, keepNulls);
+}
+
+int FindSensor(const std::vector<Sensor>& sensors, AqiPollutant pollutant) {
+    for (const auto& sensor : sensors) {
+        if (AqiEngine::PollutantFromName(sensor.paramName) == pollutant) {
+            return sensor.id;
+        }
+    }
+    return 0;
+}
+
+void RunParallel(size_t count, unsigned maxThreads, const std::function<void(size_t)>& task) {
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 4;
+    if (maxThreads && threads > maxThreads) threads = maxThreads;
+    if (threads > count) threads = (unsigned)count;
+
+    // Każdy wątek bierze kolejne zadania ze wspólnego licznika, więc wolniejsze zadania nie blokują pozostałych
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t item = next++; item < count; item = next++) {
+                task(item);
+            }
+            });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+RateLimiter::RateLimiter(double requestsPerSecond, double burst)
+    : rate_(requestsPerSecond), burst_(burst), tokens_(burst), last_(std::chrono::steady_clock::now()) {
+}
+
+void RateLimiter::Acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Uzupełnij żetony proporcjonalnie do czasu, który upłynął
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        last_ = now;
+        tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+
+        if (tokens_ >= 1.0) {
+            tokens_ -= 1.0;
+            return;
+        }
+
+        // Poczekaj na brakującą część żetonu (bez trzymania blokady)
+        double wait = (1.0 - tokens_) / rate_;
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        lock.lock();
+    }
+}
+
+RateLimiter& ApiRateLimiter() {
+    // Maksymalnie 10 zapytań na sekundę, chwilowo do 20
+    static RateLimiter limiter(10.0, 20.0);
+    return limiter;
+}
+
+bool SensorCatalog::Find(int stationId, std::vector<Sensor>& sensors) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sensors_.find(stationId);
+    if (it == sensors_.end()) {
+        return false;
+    }
+    sensors = it->second;
+    return true;
+}
+
+void SensorCatalog::Store(int stationId, const std::vector<Sensor>& sensors) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sensors_[stationId] = sensors;
+}
+
+size_t SensorCatalog::Fill(std::vector<Station>& stations) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t filled = 0;
+    for (auto& station : stations) {
+        if (!station.sensors.empty()) {
+            continue;
+        }
+        auto it = sensors_.find(station.id);
+        if (it != sensors_.end()) {
+            station.sensors = it->second;
+            ++filled;
+        }
+    }
+    return filled;
+}
+
+SensorCatalog& StationSensorCatalog() {
+    static SensorCatalog catalog;
+    return catalog;
+}
+
+// Najnowsze stężenia zanieczyszczeń indeksu dla jednej stacji, zebrane w wątku tła
+struct AqiReading {
+    int stationId;
+    std::vector<Sensor> sensors;               // czujniki stacji (zapamiętywane, żeby nie pobierać ich ponownie)
+    float values[AQI_POLLUTANT_COUNT];         // NaN = brak aktualnego pomiaru
+    std::vector<std::pair<int, Measurement>> latest; // najnowszy pomiar każdego czujnika indeksu (id czujnika, pomiar)
+};
+
 // Okno główne
 class MainFrame : public wxFrame {
 public:
@@ -123,10 +366,18 @@ public:
         // Pole do filtrowania listy
         filtr = new wxTextCtrl(panel, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
         filtr->SetHint("Wpisz nazwę stacji do filtrowania...");
-        sizer->Add(filtr, 0, wxALL | wxEXPAND, 10);
+        // Kolejność listy: z API albo od najbliższej stacji (indeks przestrzenny stacji)
+        wxString sortChoices[] = { "Kolejność z API", "Najbliżej zaznaczonej stacji", "Najbliżej mnie (współrzędne)..." };
+        sortChoice = new wxChoice(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, 3, sortChoices);
+        sortChoice->SetSelection(0);
+        wxBoxSizer* filterSizer = new wxBoxSizer(wxHORIZONTAL);
+        filterSizer->Add(filtr, 1, wxRIGHT | wxEXPAND, 5);
+        filterSizer->Add(sortChoice, 0, wxALIGN_CENTER_VERTICAL);
+        sizer->Add(filterSizer, 0, wxALL | wxEXPAND, 10);
 
         // Lista stacji
-        stationList = new wxListBox(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize);
+        // Lista stacji; kolor przy nazwie to kategoria indeksu jakości powietrza
+        stationList = new wxSimpleHtmlListBox(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize);
         sizer->Add(stationList, 1, wxALL | wxEXPAND, 10);
 
         wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -134,9 +385,25 @@ public:
         wxButton* fetchButton = new wxButton(panel, wxID_ANY, "Pobierz dane stacji");
         wxButton* historicalButton = new wxButton(panel, wxID_ANY, "Pobierz dane historyczne");
         wxButton* chartButton = new wxButton(panel, wxID_ANY, "Wyświetl dane");
+        exportButton = new wxButton(panel, wxID_ANY, "Eksportuj wykresy");
+        wxButton* heatmapButton = new wxButton(panel, wxID_ANY, "Mapa cieplna");
+        aqiButton = new wxButton(panel, wxID_ANY, "Indeks jakości");
+        wxButton* compareButton = new wxButton(panel, wxID_ANY, "Porównaj stacje");
+        wxButton* mapButton = new wxButton(panel, wxID_ANY, "Mapa stacji");
+        wxButton* scatterButton = new wxButton(panel, wxID_ANY, "Wykres rozrzutu");
+        wxButton* correlationButton = new wxButton(panel, wxID_ANY, "Korelacje stacji");
+        backfillButton = new wxButton(panel, wxID_ANY, "Uzupełnij archiwum");
         buttonSizer->Add(fetchButton, 0, wxALL, 5);
         buttonSizer->Add(historicalButton, 0, wxALL, 5);
         buttonSizer->Add(chartButton, 0, wxALL, 5);
+        buttonSizer->Add(exportButton, 0, wxALL, 5);
+        buttonSizer->Add(heatmapButton, 0, wxALL, 5);
+        buttonSizer->Add(aqiButton, 0, wxALL, 5);
+        buttonSizer->Add(compareButton, 0, wxALL, 5);
+        buttonSizer->Add(mapButton, 0, wxALL, 5);
+        buttonSizer->Add(scatterButton, 0, wxALL, 5);
+        buttonSizer->Add(correlationButton, 0, wxALL, 5);
+        buttonSizer->Add(backfillButton, 0, wxALL, 5);
         sizer->Add(buttonSizer, 0, wxCENTER, 10);
         // Pole tekstowe
         textCtrl = new wxTextCtrl(panel, wxID_ANY, "Ładowanie danych...", wxDefaultPosition, wxDefaultSize,
@@ -151,13 +418,43 @@ public:
         fetchButton->Bind(wxEVT_BUTTON, &MainFrame::OnFetchData, this);
         historicalButton->Bind(wxEVT_BUTTON, &MainFrame::OnFetchHistoricalData, this);
         chartButton->Bind(wxEVT_BUTTON, &MainFrame::OnShowChart, this);
+        exportButton->Bind(wxEVT_BUTTON, &MainFrame::OnExportCharts, this);
+        heatmapButton->Bind(wxEVT_BUTTON, &MainFrame::OnShowHeatmap, this);
+        aqiButton->Bind(wxEVT_BUTTON, &MainFrame::OnComputeAqi, this);
+        compareButton->Bind(wxEVT_BUTTON, &MainFrame::OnCompareStations, this);
+        mapButton->Bind(wxEVT_BUTTON, &MainFrame::OnShowMap, this);
+        scatterButton->Bind(wxEVT_BUTTON, &MainFrame::OnShowScatter, this);
+        correlationButton->Bind(wxEVT_BUTTON, &MainFrame::OnShowCorrelations, this);
+        backfillButton->Bind(wxEVT_BUTTON, &MainFrame::OnBackfill, this);
         filtr->Bind(wxEVT_TEXT, &MainFrame::OnFilterText, this);
+        sortChoice->Bind(wxEVT_CHOICE, &MainFrame::OnSortChanged, this);
         Bind(MY_THREAD_UPDATE_EVENT, &MainFrame::OnThreadUpdate, this);
         stations.clear(); // Initialize the vector
+        workerState->frame = this;
         LoadStations();
     }
 
+    ~MainFrame() {
+        // Uzupełnianie w toku jest przerywane (kursory pozwalają je wznowić) i okno czeka na wątki,
+        // żeby nie zamknąć aplikacji w trakcie zapisu archiwum lub plików wykresów
+        workerState->frame = nullptr;
+        if (backfill) {
+            backfill->Cancel();
+        }
+        if (backfillThread.joinable()) {
+            backfillThread.join();
+        }
+        if (exportThread.joinable()) {
+            exportThread.join();
+        }
+    }
+
 private:
+    // Stan współdzielony z wątkami w tle (uzupełnianie archiwum, eksport, indeks jakości); frame jest zerowane przy zamykaniu okna
+    struct WorkerState {
+        MainFrame* frame = nullptr;
+    };
+
     void LoadStations() {
         // Pobieranie stacji z API
         wxString data = fetch_data("/pjp-api/rest/station/findAll?size=500", "database/stations.json");
@@ -176,11 +473,11 @@ private:
                 s.id = station["id"].get<int>();
                 s.name = wxString::FromUTF8(station["stationName"].get<std::string>().c_str());
                 s.province = wxString::FromUTF8(station["city"]["commune"]["provinceName"].get<std::string>().c_str());
+                ParseStationLocation(station, s);
                 stations.push_back(s);
-                wxString displayText = s.name + " (" + s.province + ")";
-                // Dodajemy stację do listy i powiązujemy jej ID jako wxClientData
-                stationList->Append(displayText, new wxStringClientData(std::to_string(s.id)));
             }
+            stationIndex.Build(stations);
+            FillStationList();
             textCtrl->SetValue("Wybierz stację z listy i kliknij 'Pobierz dane stacji'.");
         }
         catch (const std::exception& e) {
@@ -211,6 +508,7 @@ private:
                 s.id = station["id"].get<int>();
                 s.name = wxString::FromUTF8(station["stationName"].get<std::string>().c_str());
                 s.province = wxString::FromUTF8(station["city"]["commune"]["provinceName"].get<std::string>().c_str());
+                ParseStationLocation(station, s);
 
                 // Pobieranie danych czujników dla tej stacji
                 std::string target = "/pjp-api/v1/rest/station/sensors/" + std::to_string(s.id) + "?size=20&page=0";
@@ -269,11 +567,8 @@ private:
             }
 
             // Aktualizacja listy stacji w GUI
-            stationList->Clear();
-            for (const auto& station : stations) {
-                wxString displayText = station.name + " (" + station.province + ")";
-                stationList->Append(displayText, new wxStringClientData(std::to_string(station.id)));
-            }
+            stationIndex.Build(stations);
+            FillStationList();
             textCtrl->SetValue("Wybierz stację z listy i kliknij 'Pobierz dane stacji'.");
         }
         catch (const std::exception& e) {
@@ -566,22 +861,418 @@ private:
     }
 
     void OnFilterText(wxCommandEvent& event) {
+        FillStationList();
+    }
+
+    void OnSortChanged(wxCommandEvent& event) {
+        sortByDistance = false;
+        if (sortChoice->GetSelection() == 1) {
+            // Punkt odniesienia to stacja zaznaczona w chwili wyboru sortowania
+            const Station* origin = nullptr;
+            int selection = stationList->GetSelection();
+            if (selection != wxNOT_FOUND) {
+                wxStringClientData* clientData = dynamic_cast<wxStringClientData*>(stationList->GetClientObject(selection));
+                if (clientData) {
+                    int stationId = wxAtoi(clientData->GetData());
+                    for (const auto& station : stations) {
+                        if (station.id == stationId) {
+                            origin = &station;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (origin && origin->hasLocation) {
+                sortByDistance = true;
+                sortLatitude = origin->latitude;
+                sortLongitude = origin->longitude;
+                textCtrl->SetValue("Stacje od najbliższej do stacji " + origin->name + ".");
+            }
+            else {
+                textCtrl->SetValue("Proszę wybrać z listy stację ze współrzędnymi.");
+            }
+        }
+        else if (sortChoice->GetSelection() == 2) {
+            wxString current = sortPointText.IsEmpty() ? wxString("52.2297 21.0122") : sortPointText;
+            wxString text = wxGetTextFromUser("Szerokość i długość geograficzna (z kropką dziesiętną), np. 52.2297 21.0122",
+                "Najbliżej mnie", current, this);
+            double latitude = 0.0;
+            double longitude = 0.0;
+            wxString parsed = text;
+            parsed.Replace(",", " ");
+            parsed.Trim(false).Trim();
+            wxString latitudeText = parsed.BeforeFirst(' ');
+            wxString longitudeText = parsed.AfterFirst(' ').Trim(false);
+            if (latitudeText.ToCDouble(&latitude) && longitudeText.ToCDouble(&longitude)
+                && latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0) {
+                sortByDistance = true;
+                sortLatitude = latitude;
+                sortLongitude = longitude;
+                sortPointText = text;
+                textCtrl->SetValue(wxString::Format("Stacje od najbliższej do punktu %.4f, %.4f.", latitude, longitude));
+            }
+            else if (!text.IsEmpty()) {
+                textCtrl->SetValue("Niepoprawne współrzędne: " + text);
+            }
+        }
+        if (!sortByDistance) {
+            sortChoice->SetSelection(0);
+        }
+        FillStationList();
+    }
+
+    // Wypełnia listę stacjami pasującymi do filtra, z zachowaniem zaznaczonej stacji
+    void FillStationList() {
+        wxString selectedId;
+        int selection = stationList->GetSelection();
+        if (selection != wxNOT_FOUND) {
+            wxStringClientData* clientData = dynamic_cast<wxStringClientData*>(stationList->GetClientObject(selection));
+            if (clientData) {
+                selectedId = clientData->GetData();
+            }
+        }
+
         wxString filterText = filtr->GetValue().Lower();
         filterText.Replace(",", "");
-        stationList->Clear();
 
-        for (const auto& station : stations) {
+        // Kolejność stacji: z API albo według odległości z indeksu, stacje bez współrzędnych na końcu
+        std::vector<size_t> order;
+        std::vector<double> distances(stations.size(), -1.0);
+        if (sortByDistance) {
+            for (const auto& hit : stationIndex.Nearest(sortLatitude, sortLongitude, stations.size())) {
+                order.push_back(hit.station);
+                distances[hit.station] = hit.distanceKm;
+            }
+            for (size_t i = 0; i < stations.size(); ++i) {
+                if (!stations[i].hasLocation) {
+                    order.push_back(i);
+                }
+            }
+        }
+        else {
+            for (size_t i = 0; i < stations.size(); ++i) {
+                order.push_back(i);
+            }
+        }
+
+        stationList->Clear();
+        for (size_t i : order) {
+            const Station& station = stations[i];
             wxString stationName = station.name.Lower();
             stationName.Replace(",", "");
             wxString province = station.province.Lower();
             province.Replace(",", "");
 
             if (stationName.Contains(filterText) || province.Contains(filterText) || filterText.IsEmpty()) {
-                wxString displayText = station.name + " (" + station.province + ")";
-                // Dodajemy stację do listy i powiązujemy jej ID jako wxClientData
-                stationList->Append(displayText, new wxStringClientData(std::to_string(station.id)));
+                int item = AppendStation(station, distances[i]);
+                if (!selectedId.IsEmpty() && selectedId == std::to_string(station.id)) {
+                    stationList->SetSelection(item);
+                }
+            }
+        }
+    }
+
+    void OnCompareStations(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do porównania.");
+            return;
+        }
+
+        // Stacja zaznaczona na liście jest domyślnie zaznaczona także w porównaniu
+        int stationId = 0;
+        int selection = stationList->GetSelection();
+        if (selection != wxNOT_FOUND) {
+            wxStringClientData* clientData = dynamic_cast<wxStringClientData*>(stationList->GetClientObject(selection));
+            if (clientData) {
+                stationId = wxAtoi(clientData->GetData());
             }
         }
+        StationSensorCatalog().Fill(stations);
+        ComparisonFrame* comparisonFrame = new ComparisonFrame(stations, stationId);
+        comparisonFrame->Show(true);
+    }
+
+    // Dodaje stację do listy: kwadrat w kolorze kategorii indeksu, nazwa i województwo,
+    // odległość przy sortowaniu według odległości (distanceKm >= 0), a gdy indeks jest policzony -
+    // nazwa kategorii. ID stacji jest zapisywane jako wxClientData.
+    int AppendStation(const Station& station, double distanceKm = -1.0) {
+        int index = aqi.Index(station.id);
+        wxString text = wxString::Format("<font color=\"%s\">&#9632;</font> ",
+            AqiEngine::CategoryColour(index).GetAsString(wxC2S_HTML_SYNTAX));
+        text += EscapeHtml(station.name + " (" + station.province + ")");
+        if (distanceKm >= 0.0) {
+            text += wxString::Format(" - %.1f km", distanceKm);
+        }
+        if (index != AQI_NO_INDEX) {
+            text += " - <i>" + EscapeHtml(AqiEngine::CategoryName(index)) + "</i>";
+        }
+        return stationList->Append(text, new wxStringClientData(std::to_string(station.id)));
+    }
+
+    static wxString EscapeHtml(wxString text) {
+        text.Replace("&", "&amp;");
+        text.Replace("<", "&lt;");
+        text.Replace(">", "&gt;");
+        return text;
+    }
+
+    void OnComputeAqi(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do obliczenia indeksu.");
+            return;
+        }
+        aqiButton->Disable();
+        textCtrl->SetValue(wxString::Format("Pobieranie najnowszych pomiarów dla %zu stacji...", stations.size()));
+
+        // Pomiary są pobierane w tle, równolegle; czujniki znane z poprzedniego pobrania nie są pobierane ponownie.
+        // API nie ma zbiorczego zapytania o najnowsze stężenia, więc pierwsze obliczenie to jedno zapytanie
+        // na czujnik indeksu (rzędu kilkuset); kolejne pomijają czujniki z pomiarem z bieżącej godziny
+        StationSensorCatalog().Fill(stations);
+        std::vector<Station> stationsCopy = stations;
+        std::unordered_map<int, Measurement> latestCopy = latestMeasurements;
+        // Wątek nie trzyma wskaźnika na okno: odczyty wracają przez stan współdzielony
+        std::shared_ptr<WorkerState> state = workerState;
+        std::thread([state, stationsCopy, latestCopy]() {
+            std::vector<AqiReading> readings = FetchAqiReadings(stationsCopy, latestCopy);
+            wxTheApp->CallAfter([state, readings]() {
+                if (state->frame) {
+                    state->frame->ApplyAqiReadings(readings);
+                }
+                });
+            }).detach();
+    }
+
+    static std::vector<AqiReading> FetchAqiReadings(const std::vector<Station>& stations,
+        const std::unordered_map<int, Measurement>& known) {
+        std::vector<AqiReading> readings(stations.size());
+        const std::time_t now = std::time(nullptr);
+
+        // Każde zadanie zapisuje tylko odczyt swojej stacji
+        RunParallel(stations.size(), 8, [&](size_t i) {
+            std::vector<Measurement> measurements;
+            AqiReading& reading = readings[i];
+            reading.stationId = stations[i].id;
+            reading.sensors = stations[i].sensors;
+            std::fill(std::begin(reading.values), std::end(reading.values), std::numeric_limits<float>::quiet_NaN());
+            try {
+                if (reading.sensors.empty()) {
+                    FetchStationSensors(reading.stationId, reading.sensors);
+                }
+                for (const auto& sensor : reading.sensors) {
+                    AqiPollutant pollutant = AqiEngine::PollutantFromName(sensor.paramName);
+                    if (pollutant == AQI_POLLUTANT_COUNT) {
+                        continue;
+                    }
+                    // Pomiary są publikowane co godzinę: pomiar z bieżącej godziny jest najnowszy możliwy
+                    Measurement latest;
+                    auto knownIt = known.find(sensor.id);
+                    if (knownIt != known.end() && std::difftime(now, knownIt->second.time) < 3600.0) {
+                        latest = knownIt->second;
+                    }
+                    else {
+                        // Pomiary są od najnowszego, więc wystarczy kilka ostatnich (część godzin bywa pusta)
+                        ApiRateLimiter().Acquire();
+                        std::string target = "/pjp-api/v1/rest/data/getData/" + std::to_string(sensor.id) + "?size=3&page=0";
+                        wxString data = fetch_data(target, "", false);
+                        if (data.StartsWith("ERROR:") ||
+                            !ParseMeasurements(data.ToStdString(wxConvUTF8), "Lista danych pomiarowych", measurements) ||
+                            measurements.empty()) {
+                            continue;
+                        }
+                        latest = measurements.front();
+                    }
+                    reading.latest.push_back({ sensor.id, latest });
+                    // Indeks jest liczony tylko z aktualnych pomiarów (z ostatnich 3 godzin)
+                    if (std::difftime(now, latest.time) <= 3 * 3600.0) {
+                        reading.values[pollutant] = (float)latest.value;
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                wxLogError("Błąd pobierania pomiarów dla stacji %d: %s", reading.stationId, e.what());
+            }
+        });
+        return readings;
+    }
+
+    void ApplyAqiReadings(const std::vector<AqiReading>& readings) {
+        aqiButton->Enable();
+
+        // Pierwsze obliczenie (także po wczytaniu innej listy stacji) dla wszystkich stacji,
+        // potem tylko dla stacji ze zmienionymi pomiarami
+        bool first = !AqiMatchesStations();
+        if (first) {
+            std::vector<int> ids;
+            for (const auto& station : stations) {
+                ids.push_back(station.id);
+            }
+            aqi.SetStations(ids);
+        }
+
+        for (const auto& reading : readings) {
+            auto stationIt = std::find_if(stations.begin(), stations.end(),
+                [&reading](const Station& s) { return s.id == reading.stationId; });
+            if (stationIt != stations.end() && stationIt->sensors.empty()) {
+                stationIt->sensors = reading.sensors;
+            }
+            for (int p = 0; p < AQI_POLLUTANT_COUNT; ++p) {
+                aqi.SetValue(reading.stationId, (AqiPollutant)p, reading.values[p]);
+            }
+            for (const auto& latest : reading.latest) {
+                latestMeasurements[latest.first] = latest.second;
+            }
+        }
+
+        size_t updated = aqi.StationCount();
+        if (first) {
+            aqi.Compute();
+        }
+        else {
+            updated = aqi.Update();
+        }
+
+        FillStationList();
+        textCtrl->SetValue(wxString::Format("Indeks jakości powietrza: przeliczono %zu z %zu stacji.", updated, stations.size()));
+
+        if (showMapAfterAqi) {
+            showMapAfterAqi = false;
+            StationSensorCatalog().Fill(stations);
+            MapFrame* mapFrame = new MapFrame(stations, aqi);
+            mapFrame->Show(true);
+        }
+    }
+
+    // Czy silnik indeksu ma te same stacje, w tej samej kolejności, co lista stacji
+    bool AqiMatchesStations() const {
+        const std::vector<int>& ids = aqi.StationIds();
+        return ids.size() == stations.size() &&
+            std::equal(ids.begin(), ids.end(), stations.begin(),
+                [](int id, const Station& station) { return id == station.id; });
+    }
+
+    void OnShowScatter(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do analizy.");
+            return;
+        }
+
+        // Domyślnie pary zaznaczonej stacji; w oknie można przełączyć na wszystkie stacje
+        int stationId = 0;
+        int selection = stationList->GetSelection();
+        if (selection != wxNOT_FOUND) {
+            wxStringClientData* clientData = dynamic_cast<wxStringClientData*>(stationList->GetClientObject(selection));
+            if (clientData) {
+                stationId = wxAtoi(clientData->GetData());
+            }
+        }
+        StationSensorCatalog().Fill(stations);
+        ScatterFrame* scatterFrame = new ScatterFrame(stations, stationId);
+        scatterFrame->Show(true);
+    }
+
+    void OnBackfill(wxCommandEvent& event) {
+        // Drugie kliknięcie przerywa trwające pobieranie; kursory czujników pozwalają je później wznowić
+        if (backfill) {
+            backfill->Cancel();
+            textCtrl->SetValue("Przerywanie uzupełniania archiwum...");
+            return;
+        }
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do pobrania.");
+            return;
+        }
+
+        wxString text = wxGetTextFromUser("Liczba dni wstecz (pomiary są zapisywane w database/history)",
+            "Uzupełnij archiwum", "365", this);
+        if (text.IsEmpty()) {
+            return;
+        }
+        long days = 0;
+        if (!text.ToLong(&days) || days < 1 || days > 3660) {
+            textCtrl->SetValue("Nieprawidłowa liczba dni.");
+            return;
+        }
+
+        std::time_t from = 0;
+        std::time_t to = 0;
+        BackfillEngine::DaysRange((int)days, from, to);
+        backfill = std::make_shared<BackfillEngine>("database/history");
+        backfillButton->SetLabel("Przerwij uzupełnianie");
+        textCtrl->SetValue(wxString::Format("Uzupełnianie archiwum z %ld dni dla %zu stacji...", days, stations.size()));
+
+        // Pobieranie w tle; postęp trafia do pola tekstowego po każdej stronie. Wątek nie trzyma wskaźnika
+        // na okno: wyniki przekazuje przez stan współdzielony, a okno przy zamykaniu czeka na jego koniec
+        std::shared_ptr<BackfillEngine> engine = backfill;
+        std::shared_ptr<WorkerState> state = workerState;
+        StationSensorCatalog().Fill(stations);
+        std::vector<Station> stationsCopy = stations;
+        backfillThread = std::thread([state, engine, stationsCopy, from, to]() mutable {
+            BackfillProgress progress = engine->Run(stationsCopy, from, to, 8, [state](const BackfillProgress& current) {
+                wxString text = "Uzupełnianie archiwum...\n" + current.Format();
+                wxTheApp->CallAfter([state, text]() {
+                    if (state->frame) {
+                        state->frame->textCtrl->SetValue(text);
+                    }
+                    });
+                });
+            wxTheApp->CallAfter([state, progress, stationsCopy]() {
+                if (state->frame) {
+                    state->frame->OnBackfillDone(progress, stationsCopy);
+                }
+                });
+            });
+    }
+
+    void OnBackfillDone(const BackfillProgress& progress, const std::vector<Station>& fetchedStations) {
+        // Wątek kończy się zaraz po zleceniu tego wywołania
+        if (backfillThread.joinable()) {
+            backfillThread.join();
+        }
+        bool cancelled = backfill->IsCancelled();
+        backfill.reset();
+        backfillButton->SetLabel("Uzupełnij archiwum");
+
+        // Czujniki pobrane w tle są zapamiętywane na kolejne pobrania
+        for (const auto& fetched : fetchedStations) {
+            auto stationIt = std::find_if(stations.begin(), stations.end(),
+                [&fetched](const Station& s) { return s.id == fetched.id; });
+            if (stationIt != stations.end() && stationIt->sensors.empty()) {
+                stationIt->sensors = fetched.sensors;
+            }
+        }
+
+        textCtrl->SetValue((cancelled ? "Uzupełnianie archiwum przerwane (można je wznowić).\n" : "Uzupełnianie archiwum zakończone.\n")
+            + progress.Format());
+    }
+
+    void OnShowCorrelations(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do analizy.");
+            return;
+        }
+        StationSensorCatalog().Fill(stations);
+        CorrelationFrame* correlationFrame = new CorrelationFrame(stations);
+        correlationFrame->Show(true);
+    }
+
+    void OnShowMap(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do pokazania na mapie.");
+            return;
+        }
+
+        // Mapa korzysta z najnowszych stężeń zebranych dla indeksu; przy pierwszym otwarciu są pobierane
+        if (!AqiMatchesStations()) {
+            // Pobieranie w toku kończy się otwarciem mapy, inaczej jest uruchamiane teraz
+            showMapAfterAqi = true;
+            if (aqiButton->IsEnabled()) {
+                OnComputeAqi(event);
+            }
+            return;
+        }
+        StationSensorCatalog().Fill(stations);
+        MapFrame* mapFrame = new MapFrame(stations, aqi);
+        mapFrame->Show(true);
     }
 
     void OnShowChart(wxCommandEvent& event) {
@@ -608,6 +1299,7 @@ private:
             return;
         }
 
+        StationSensorCatalog().Fill(stations);
         Station& selectedStation = *stationIt;
 
         // Sprawdź, czy istnieje zapisany plik z danymi
@@ -686,6 +1378,7 @@ private:
 
                 // Zaktualizuj sensory w selectedStation
                 selectedStation.sensors = sensors;
+                StationSensorCatalog().Store(selectedStation.id, sensors);
 
                 // Zapisz zaktualizowane sensory do pliku sensors.json
                 nlohmann::json sensorsOutput;
@@ -717,20 +1410,205 @@ private:
         chartFrame->Show(true);
     }
 
-    wxListBox* stationList;
+    void OnExportCharts(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do eksportu.");
+            return;
+        }
+
+        wxDirDialog dialog(this, "Wybierz katalog na wykresy", wxGetCwd());
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+        wxString outputDir = dialog.GetPath();
+
+        textCtrl->SetValue(wxString::Format("Eksport wykresów dla %zu stacji...", stations.size()));
+        exportButton->Disable();
+
+        // Eksport w tle: wykresy są rysowane równolegle poza oknami, GUI pozostaje responsywne.
+        // Raport wraca przez stan współdzielony; przycisk jest nieaktywny do jego nadejścia
+        std::shared_ptr<WorkerState> state = workerState;
+        StationSensorCatalog().Fill(stations);
+        std::vector<Station> stationsCopy = stations;
+        exportThread = std::thread([state, stationsCopy, outputDir]() {
+            ChartExporter exporter(outputDir);
+            exporter.SetCacheDir("database/series");
+            ExportReport report = exporter.Export(stationsCopy);
+
+            wxTheApp->CallAfter([state, report]() {
+                if (state->frame) {
+                    state->frame->OnExportDone(report);
+                }
+                });
+            });
+    }
+
+    void OnExportDone(const ExportReport& report) {
+        // Wątek kończy się zaraz po zleceniu tego wywołania
+        if (exportThread.joinable()) {
+            exportThread.join();
+        }
+        exportButton->Enable();
+        textCtrl->SetValue("Eksport zakończony.\n" + report.Format());
+    }
+
+    void OnShowHeatmap(wxCommandEvent& event) {
+        if (stations.empty()) {
+            textCtrl->SetValue("Brak stacji do porównania.");
+            return;
+        }
+
+        // Jeden parametr dla wszystkich stacji; dane są pobierane w tle przez okno mapy
+        StationSensorCatalog().Fill(stations);
+        HeatmapFrame* heatmapFrame = new HeatmapFrame(stations);
+        heatmapFrame->Show(true);
+    }
+
+    wxSimpleHtmlListBox* stationList;
+    wxButton* aqiButton;
+    wxButton* backfillButton;
+    wxButton* exportButton;
+    std::shared_ptr<BackfillEngine> backfill;   // trwające uzupełnianie archiwum (puste, gdy nie trwa)
+    std::thread backfillThread;
+    std::thread exportThread;
+    std::shared_ptr<WorkerState> workerState = std::make_shared<WorkerState>();
+    AqiEngine aqi;
+    std::unordered_map<int, Measurement> latestMeasurements;    // najnowszy pomiar czujników indeksu (wg id czujnika)
+    bool showMapAfterAqi = false;       // otwarcie mapy po zakończeniu pobierania stężeń
     wxTextCtrl* textCtrl;
     wxTextCtrl* filtr;
+    wxChoice* sortChoice;
     std::vector<Station> stations;
+    StationIndex stationIndex;          // budowany po każdym wczytaniu listy stacji
+    bool sortByDistance = false;
+    double sortLatitude = 0.0;          // punkt odniesienia sortowania według odległości
+    double sortLongitude = 0.0;
+    wxString sortPointText;             // ostatnio podane współrzędne "najbliżej mnie"
 };
 
 // Aplikacja
 class MyApp : public wxApp {
 public:
     bool OnInit() override {
+        wxImage::AddHandler(new wxPNGHandler);
+
+        // Tryb wsadowy: AirQualityApp --export <katalog> [id stacji...]
+        // Kod wyjścia dla harmonogramu zadań jest zwracany z OnRun, bez otwierania okien
+        if (argc >= 3 && argv[1] == "--export") {
+            batchMode = true;
+            batchExitCode = RunExport();
+            return true;
+        }
+        // Uzupełnianie archiwum: AirQualityApp --backfill <dni> [id stacji...], np. całoroczne w nocy
+        if (argc >= 3 && argv[1] == "--backfill") {
+            batchMode = true;
+            batchExitCode = RunBackfill();
+            return true;
+        }
+
         auto* frame = new MainFrame();
         frame->Show(true);
         return true;
     }
+
+    int OnRun() override {
+        if (batchMode) {
+            return batchExitCode;
+        }
+        return wxApp::OnRun();
+    }
+
+private:
+    // Kody wyjścia trybu wsadowego
+    enum {
+        EXIT_BATCH_OK = 0,          // wszystko wykonane
+        EXIT_BATCH_ERROR = 1,       // zadanie się nie rozpoczęło (argumenty, lista stacji, zapis raportu)
+        EXIT_BATCH_PARTIAL = 2      // zadanie zakończone, ale część stacji lub czujników z błędem
+    };
+
+    // Stacje z argumentów wiersza poleceń od pozycji firstId (wszystkie, gdy nie podano żadnej)
+    bool FetchStations(int firstId, std::vector<Station>& stations) {
+        std::vector<int> ids;
+        for (int i = firstId; i < argc; ++i) {
+            ids.push_back(wxAtoi(argv[i]));
+        }
+
+        wxString data = fetch_data("/pjp-api/rest/station/findAll?size=500", "database/stations.json", true);
+        if (data.StartsWith("ERROR:")) {
+            wxLogError("Błąd pobierania listy stacji: %s", data.c_str());
+            return false;
+        }
+
+        try {
+            json j = json::parse(data.ToStdString(wxConvUTF8));
+            for (const auto& station : j) {
+                Station s;
+                s.id = station["id"].get<int>();
+                if (!ids.empty() && std::find(ids.begin(), ids.end(), s.id) == ids.end()) {
+                    continue;
+                }
+                s.name = wxString::FromUTF8(station["stationName"].get<std::string>().c_str());
+                s.province = wxString::FromUTF8(station["city"]["commune"]["provinceName"].get<std::string>().c_str());
+                ParseStationLocation(station, s);
+                stations.push_back(s);
+            }
+        }
+        catch (const std::exception& e) {
+            wxLogError("Błąd parsowania listy stacji: %s", e.what());
+            return false;
+        }
+        return true;
+    }
+
+    // Eksport wykresów bez okien, np. z harmonogramu zadań
+    int RunExport() {
+        wxString outputDir = argv[2];
+        std::vector<Station> stations;
+        if (!FetchStations(3, stations)) {
+            return EXIT_BATCH_ERROR;
+        }
+
+        ChartExporter exporter(outputDir);
+        exporter.SetCacheDir("database/series");
+        ExportReport report = exporter.Export(stations);
+
+        // Raport zapisywany obok wykresów
+        wxString reportFile = wxFileName(outputDir, "raport.txt").GetFullPath();
+        if (!SaveToFile(std::string(report.Format().utf8_str()), reportFile.ToStdString())) {
+            return EXIT_BATCH_ERROR;
+        }
+        return report.failures > 0 ? EXIT_BATCH_PARTIAL : EXIT_BATCH_OK;
+    }
+
+    // Uzupełnianie archiwum bez okien; przerwane (np. zamknięte) wznawia się od kursorów czujników
+    int RunBackfill() {
+        wxString daysText = argv[2];
+        long days = 0;
+        if (!daysText.ToLong(&days) || days < 1) {
+            wxLogError("Nieprawidłowa liczba dni: %s", daysText);
+            return EXIT_BATCH_ERROR;
+        }
+        std::vector<Station> stations;
+        if (!FetchStations(3, stations)) {
+            return EXIT_BATCH_ERROR;
+        }
+
+        std::time_t from = 0;
+        std::time_t to = 0;
+        BackfillEngine::DaysRange((int)days, from, to);
+        BackfillEngine engine("database/history");
+        BackfillProgress progress = engine.Run(stations, from, to, 8);
+
+        // Raport zapisywany obok archiwum
+        wxString reportFile = wxFileName("database/history", "raport.txt").GetFullPath();
+        if (!SaveToFile(std::string(progress.Format().utf8_str()), reportFile.ToStdString())) {
+            return EXIT_BATCH_ERROR;
+        }
+        return progress.sensorsFailed > 0 ? EXIT_BATCH_PARTIAL : EXIT_BATCH_OK;
+    }
+
+    bool batchMode = false;     // zadanie z wiersza poleceń wykonane w OnInit, bez pętli zdarzeń
+    int batchExitCode = EXIT_BATCH_OK;
 };
 
 // Definicja zdarzeń
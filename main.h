@@ -4,6 +4,7 @@
 #include <wx/wx.h>
 #include <wx/thread.h>
 #include <wx/listbox.h>
+#include <wx/htmllbox.h>
 #include <wx/textctrl.h>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
@@ -14,6 +15,14 @@
 #include <thread>
 #include <vector>
 #include <string>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include "AqiEngine.h"
 
 // Struktury
 struct Sensor {
@@ -26,6 +35,15 @@ struct Station {
     wxString name;
     wxString province;
     std::vector<Sensor> sensors;
+    bool hasLocation = false;    // współrzędne z pól gegrLat/gegrLon listy stacji
+    double latitude = 0.0;
+    double longitude = 0.0;
+};
+
+// Pojedynczy pomiar: czas jako sekundy epoki (czas lokalny z API) i wartość
+struct Measurement {
+    std::time_t time;
+    double value;
 };
 
 // Definicje przestrzeni nazw
@@ -43,6 +61,52 @@ using std::string;
 bool SaveToFile(const string& data, const string& filename);
 string ReadFromFile(const string& filename);
 wxString fetch_data(string target, string filename, bool saveToFile = false);
+bool ParseMeasurementTime(const string& date, std::time_t& time);
+bool ParseMeasurements(const string& data, const string& listKey, vector<Measurement>& measurements, bool keepNulls = false);
+// Czujniki stacji z katalogu (SensorCatalog), a gdy ich tam nie ma - z API (z żetonem ApiRateLimiter())
+bool FetchStationSensors(int stationId, vector<Sensor>& sensors);
+// Najnowsze rows pomiarów czujnika z API (z żetonem ApiRateLimiter()); wartości null jako NaN, gdy keepNulls
+bool FetchSeries(int sensorId, int rows, vector<Measurement>& measurements, bool keepNulls = false);
+// Identyfikator pierwszego czujnika mierzącego zanieczyszczenie indeksu lub 0, gdy stacja go nie mierzy
+int FindSensor(const vector<Sensor>& sensors, AqiPollutant pollutant);
+// Współrzędne stacji z obiektu listy stacji (liczby lub tekst); false, gdy ich brak
+bool ParseStationLocation(const json& station, Station& s);
+// Wykonuje task(0..count-1) w maxThreads wątkach (0 = liczba rdzeni); blokuje do zakończenia wszystkich
+void RunParallel(size_t count, unsigned maxThreads, const std::function<void(size_t)>& task);
+
+// Ogranicznik liczby zapytań do API (kubełek z żetonami), wspólny dla wszystkich wątków
+class RateLimiter {
+public:
+    RateLimiter(double requestsPerSecond, double burst);
+    // Blokuje wątek, aż będzie dostępny żeton
+    void Acquire();
+
+private:
+    std::mutex mutex_;
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+// Ogranicznik używany przy zapytaniach wykonywanych równolegle
+RateLimiter& ApiRateLimiter();
+
+// Katalog czujników stacji pobranych w dowolnym oknie lub wątku; okna dostają kopie listy stacji,
+// więc to przez katalog czujniki wracają do listy okna głównego i nie są pobierane ponownie
+class SensorCatalog {
+public:
+    bool Find(int stationId, vector<Sensor>& sensors) const;
+    void Store(int stationId, const vector<Sensor>& sensors);
+    // Uzupełnia czujniki stacji, które ich nie mają; zwraca liczbę uzupełnionych stacji
+    size_t Fill(vector<Station>& stations) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<int, vector<Sensor>> sensors_;
+};
+
+SensorCatalog& StationSensorCatalog();
 
 // Specjalny event do aktualizacji GUI z wątku
 wxDECLARE_EVENT(MY_THREAD_UPDATE_EVENT, wxThreadEvent);
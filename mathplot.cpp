@@ -38,6 +38,10 @@
 #include "wx/intl.h"
 #include "wx/dcclient.h"
 #include "wx/cursor.h"
+#if wxUSE_GRAPHICS_CONTEXT
+#include "wx/graphics.h"
+#include "wx/dcgraph.h"
+#endif
 #endif
 
 #include "mathplot.h"
@@ -50,6 +54,10 @@
 #include <cmath>
 #include <cstdio> // used only for debug
 #include <ctime> // used for representation of x axes involving date
+#include <algorithm> // used by the level of detail layer
+#include <thread> // used by the bitmap layer tile scaling
+#include <mutex>
+#include <wx/weakref.h>
 
 // #include "pixel.xpm"
 
@@ -69,16 +77,78 @@
 // Number of pixels to scroll when scrolling by a line
 #define mpSCROLL_NUM_PIXELS_PER_LINE  10
 
+// Milliseconds between two repaints while panning with the mouse (about one display frame)
+#define mpPAN_REPAINT_INTERVAL  16
+
 // See doxygen comments.
 double mpWindow::zoomIncrementalFactor = 1.5;
 
+// See doxygen comments.
+bool mpConvertTime(time_t when, bool local, struct tm &out)
+{
+#ifdef _MSC_VER
+    return (local ? localtime_s(&out, &when) : gmtime_s(&out, &when)) == 0;
+#else
+    return (local ? localtime_r(&when, &out) : gmtime_r(&when, &out)) != NULL;
+#endif
+}
+
+// Label formats of date and time axes. mpScaleX::Plot picks one of them from the tick step.
+static const wxChar* mpDATETIME_FMT = wxT("%04.0f-%02.0f-%02.0fT%02.0f:%02.0f:%02.0f");
+static const wxChar* mpDATETIME_SHORT_FMT = wxT("%02.0f.%02.0f %02.0f:%02.0f");
+static const wxChar* mpDATE_FMT = wxT("%04.0f-%02.0f-%02.0f");
+
+// Tick steps of date and time axes, in seconds: they fall on whole minutes, hours, days and weeks
+static const double mpCalendarSteps[] = {
+	1, 2, 5, 10, 15, 30,
+	60, 2*60, 5*60, 10*60, 15*60, 30*60,
+	3600, 2*3600, 3*3600, 6*3600, 12*3600,
+	86400, 2*86400, 7*86400, 14*86400, 28*86400
+};
+
+// Returns the smallest calendar step not shorter than minStep (whole weeks above the table)
+static double mpCalendarStep(double minStep)
+{
+	for (size_t i = 0; i < sizeof(mpCalendarSteps)/sizeof(mpCalendarSteps[0]); i++)
+		if (mpCalendarSteps[i] >= minStep)
+			return mpCalendarSteps[i];
+	return ceil(minStep / (7*86400)) * (7*86400);
+}
+
+// Offset of local time from UTC at the given moment, in seconds (DST included)
+static double mpLocalTimeOffset(time_t when)
+{
+	struct tm lt;
+	if ((when <= 0) || !mpConvertTime(when, true, lt))
+		return 0;
+	// Days since the epoch of the local calendar date (proleptic Gregorian calendar)
+	long y = lt.tm_year + 1900 - (lt.tm_mon < 2 ? 1 : 0);
+	const long era = (y >= 0 ? y : y - 399) / 400;
+	const long yoe = y - era * 400;
+	const long doy = (153 * (lt.tm_mon + (lt.tm_mon < 2 ? 10 : -2)) + 2) / 5 + lt.tm_mday - 1;
+	const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	const double days = (double)(era * 146097 + doe - 719468);
+	return days * 86400 + lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec - (double)when;
+}
+
+// Returns the last calendar boundary of the given step at or before t.
+// Boundaries are counted in local or UTC time, weekly steps start on Monday.
+static double mpAlignTime(double t, double step, bool local)
+{
+	const double offset = local ? mpLocalTimeOffset((time_t)t) : 0;
+	const double origin = (step >= 7*86400) ? 4*86400 : 0; // 1970-01-05 was a Monday
+	return floor((t + offset - origin) / step) * step + origin - offset;
+}
+
 //-----------------------------------------------------------------------------
 // mpLayer
 //-----------------------------------------------------------------------------
 
 IMPLEMENT_ABSTRACT_CLASS(mpLayer, wxObject)
 
-mpLayer::mpLayer() : m_type(mpLAYER_UNDEF)
+std::atomic<unsigned long> mpLayer::ms_globalDataVersion(0);
+
+mpLayer::mpLayer() : m_type(mpLAYER_UNDEF), m_dataVersion(0)
 {
     SetPen((wxPen&) *wxBLACK_PEN);
     SetFont((wxFont&) *wxNORMAL_FONT);
@@ -158,7 +228,7 @@ void mpInfoLayer::UpdateReference()
 }
 
 
-void   mpInfoLayer::Plot(wxDC & dc, mpWindow & w)
+void   mpInfoLayer::Plot(wxDC & dc, mpView & w)
 {
     if (m_visible) {
         // Adjust relative position inside the window
@@ -239,22 +309,12 @@ void mpInfoCoords::UpdateInfo(mpWindow& w, wxEvent& event)
 			m_content.Printf(wxT("x = %f\ny = %f"), xVal, yVal);
 		else if (m_labelType == mpX_DATETIME) {
 			when = (time_t) xVal;
-			if (when > 0) {
-				if (m_timeConv == mpX_LOCALTIME) {
-					timestruct = *localtime(&when);
-				} else {
-					timestruct = *gmtime(&when);
-				}
+			if ((when > 0) && mpConvertTime(when, m_timeConv == mpX_LOCALTIME, timestruct)) {
 				m_content.Printf(wxT("x = %04.0f-%02.0f-%02.0fT%02.0f:%02.0f:%02.0f\ny = %f"), (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, (double)timestruct.tm_hour, (double)timestruct.tm_min, (double)timestruct.tm_sec, yVal);
 			}
 		} else if (m_labelType == mpX_DATE) {
 			when = (time_t) xVal;
-			if (when > 0) {
-				if (m_timeConv == mpX_LOCALTIME) {
-					timestruct = *localtime(&when);
-				} else {
-					timestruct = *gmtime(&when);
-				}
+			if ((when > 0) && mpConvertTime(when, m_timeConv == mpX_LOCALTIME, timestruct)) {
 				m_content.Printf(wxT("x = %04.0f-%02.0f-%02.0f\ny = %f"), (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, yVal);
 			}
 		} else if ((m_labelType == mpX_TIME) || (m_labelType == mpX_HOURS)) {
@@ -269,7 +329,7 @@ void mpInfoCoords::UpdateInfo(mpWindow& w, wxEvent& event)
 	}
 }
 
-void mpInfoCoords::Plot(wxDC & dc, mpWindow & w)
+void mpInfoCoords::Plot(wxDC & dc, mpView & w)
 {
     if (m_visible) {
 			int textX = 0, textY = 0;
@@ -321,6 +381,119 @@ void mpInfoCoords::Plot(wxDC & dc, mpWindow & w)
     }
 }
 
+//-----------------------------------------------------------------------------
+// mpInfoNearest
+//-----------------------------------------------------------------------------
+
+mpInfoNearest::mpInfoNearest() : mpInfoCoords()
+{
+	m_timeConv = mpX_RAWTIME;
+	m_radius = 10;
+}
+
+mpInfoNearest::mpInfoNearest(wxRect rect, const wxBrush* brush) : mpInfoCoords(rect, brush)
+{
+	m_timeConv = mpX_RAWTIME;
+	m_radius = 10;
+}
+
+wxString mpInfoNearest::FormatX(double xVal)
+{
+	wxString s;
+	struct tm timestruct;
+	const time_t when = (time_t) xVal;
+	if (m_labelType == mpX_DATETIME) {
+		if ((when > 0) && mpConvertTime(when, m_timeConv == mpX_LOCALTIME, timestruct))
+			s.Printf(wxT("%04.0f-%02.0f-%02.0f %02.0f:%02.0f"), (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, (double)timestruct.tm_hour, (double)timestruct.tm_min);
+	} else if (m_labelType == mpX_DATE) {
+		if ((when > 0) && mpConvertTime(when, m_timeConv == mpX_LOCALTIME, timestruct))
+			s.Printf(wxT("%04.0f-%02.0f-%02.0f"), (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday);
+	} else if ((m_labelType == mpX_TIME) || (m_labelType == mpX_HOURS)) {
+		double modulus = fabs(xVal);
+		double sign = (xVal < 0) ? -1 : 1;
+		double hh = floor(modulus/3600);
+		double mm = floor((modulus - hh*3600)/60);
+		double ss = modulus - hh*3600 - mm*60;
+		s.Printf(wxT("%02.0f:%02.0f:%02.0f"), sign*hh, mm, floor(ss));
+	} else {
+		s.Printf(wxT("%g"), xVal);
+	}
+	return s;
+}
+
+void mpInfoNearest::UpdateInfo(mpWindow& w, wxEvent& event)
+{
+	if (event.GetEventType() != wxEVT_MOTION)
+		return;
+	const wxPoint pos(((wxMouseEvent&)event).GetX(), ((wxMouseEvent&)event).GetY());
+
+	mpLayer* nearest = NULL;
+	double nearestX = 0, nearestY = 0, nearestDist2 = 0;
+	for (unsigned int i = 0; i < w.CountAllLayers(); i++) {
+		mpLayer* layer = w.GetLayer(i);
+		mpFXY* fxy = wxDynamicCast(layer, mpFXY);
+		if (fxy == NULL || !fxy->IsVisible())
+			continue;
+		double x, y, dist2;
+		if (fxy->GetNearestPoint(w, pos, m_radius, x, y, dist2) && (nearest == NULL || dist2 < nearestDist2)) {
+			nearest = layer;
+			nearestX = x;
+			nearestY = y;
+			nearestDist2 = dist2;
+		}
+	}
+
+	m_content.Clear();
+	if (nearest != NULL) {
+		if (!nearest->GetName().IsEmpty())
+			m_content << nearest->GetName() << wxT("\n");
+		m_content << FormatX(nearestX) << wxT("\n") << wxString::Format(wxT("%g"), nearestY);
+	}
+}
+
+void mpInfoNearest::Plot(wxDC & dc, mpView & w)
+{
+	if (!m_visible || m_content.IsEmpty())
+		return;
+
+	// Keep the relative position inside the window, as mpInfoCoords does
+	int scrx = w.GetScrX();
+	int scry = w.GetScrY();
+	if ((m_winX != scrx) || (m_winY != scry)) {
+		if (m_winX != 1) m_dim.x = (int) floor((double)(m_dim.x*scrx/m_winX));
+		if (m_winY != 1) {
+			m_dim.y = (int) floor((double)(m_dim.y*scry/m_winY));
+			UpdateReference();
+		}
+		m_winX = scrx;
+		m_winY = scry;
+	}
+	dc.SetPen(m_pen);
+	dc.SetBrush(m_brush);
+	dc.SetFont(m_font);
+
+	// Measure and draw line by line: GetTextExtent ignores newlines on some platforms
+	wxArrayString lines = wxSplit(m_content, wxT('\n'), 0);
+	int textW = 0, textH = 0;
+	for (size_t i = 0; i < lines.GetCount(); i++) {
+		int lw, lh;
+		dc.GetTextExtent(lines[i], &lw, &lh);
+		textW = (lw > textW) ? lw : textW;
+		textH += lh;
+	}
+	if (m_dim.width < textW + 10) m_dim.width = textW + 10;
+	if (m_dim.height < textH + 10) m_dim.height = textH + 10;
+
+	dc.DrawRectangle(m_dim.x, m_dim.y, m_dim.width, m_dim.height);
+	int ty = m_dim.y + 5;
+	for (size_t i = 0; i < lines.GetCount(); i++) {
+		int lw, lh;
+		dc.GetTextExtent(lines[i], &lw, &lh);
+		dc.DrawText(lines[i], m_dim.x + 5, ty);
+		ty += lh;
+	}
+}
+
 mpInfoLegend::mpInfoLegend() : mpInfoLayer()
 {
 	m_item_mode = mpLEGEND_LINE;
@@ -341,7 +514,7 @@ void mpInfoLegend::UpdateInfo(mpWindow& w, wxEvent& event)
     
 }
 
-void mpInfoLegend::Plot(wxDC & dc, mpWindow & w)
+void mpInfoLegend::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		// Adjust relative position inside the window
@@ -435,6 +608,21 @@ void mpInfoLegend::SetItemMode(int mode)
 // mpLayer implementations - functions
 //-----------------------------------------------------------------------------
 
+bool mpSampleCache::Prepare(double pos, double scale, wxCoord first, size_t count, unsigned long version)
+{
+    if (m_valid && m_pos == pos && m_scale == scale && m_first == first && m_values.size() == count && m_version == version)
+        return false;
+
+    m_args.resize(count);
+    m_values.resize(count);
+    m_pos = pos;
+    m_scale = scale;
+    m_first = first;
+    m_version = version;
+    m_valid = true;
+    return true;
+}
+
 IMPLEMENT_ABSTRACT_CLASS(mpFX, mpLayer)
 
 mpFX::mpFX(wxString name, int flags)
@@ -444,7 +632,13 @@ mpFX::mpFX(wxString name, int flags)
     m_type = mpLAYER_PLOT;
 }
 
-void mpFX::Plot(wxDC & dc, mpWindow & w)
+void mpFX::EvaluateBatch(const double* in, double* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = GetY(in[i]);
+}
+
+void mpFX::Plot(wxDC & dc, mpView & w)
 {
     if (m_visible) {
 		dc.SetPen( m_pen);
@@ -454,12 +648,22 @@ void mpFX::Plot(wxDC & dc, mpWindow & w)
 		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
 		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
 
+		// Evaluate the function at each pixel column, unless the view has not changed since last time
+		size_t n = endPx > startPx ? endPx - startPx : 0;
+		if (m_samples.Prepare(w.GetPosX(), w.GetScaleX(), startPx, n, GetDataVersion()))
+		{
+			for (size_t k = 0; k < n; ++k)
+				m_samples.m_args[k] = w.p2x(startPx + (wxCoord) k);
+			if (n > 0)
+				EvaluateBatch(&m_samples.m_args[0], &m_samples.m_values[0], n);
+		}
+
 		wxCoord iy = 0;
 		if (m_pen.GetWidth() <= 1)
 		{
 			for (wxCoord i = startPx; i < endPx; ++i)
 			{
-				iy = w.y2p( GetY(w.p2x(i)));
+				iy = w.y2p( m_samples.m_values[i - startPx]);
 				// Draw the point only if you can draw outside margins or if the point is inside margins
 				if (m_drawOutsideMargins || ((iy >= minYpx) && (iy <= maxYpx)))
 					dc.DrawPoint(i, iy );// (wxCoord) ((w.GetPosY() - GetY( (double)i / w.GetScaleX() + w.GetPosX()) ) * w.GetScaleY()));
@@ -469,7 +673,7 @@ void mpFX::Plot(wxDC & dc, mpWindow & w)
 		{
 			for (wxCoord i = startPx; i < endPx; ++i)
 			{
-				iy = w.y2p( GetY(w.p2x(i)));
+				iy = w.y2p( m_samples.m_values[i - startPx]);
 				// Draw the point only if you can draw outside margins or if the point is inside margins
 				if (m_drawOutsideMargins || ((iy >= minYpx) && (iy <= maxYpx)))
 					dc.DrawLine( i, iy, i, iy);
@@ -512,7 +716,13 @@ mpFY::mpFY(wxString name, int flags)
     m_type = mpLAYER_PLOT;
 }
 
-void mpFY::Plot(wxDC & dc, mpWindow & w)
+void mpFY::EvaluateBatch(const double* in, double* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = GetX(in[i]);
+}
+
+void mpFY::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen( m_pen);
@@ -524,11 +734,25 @@ void mpFY::Plot(wxDC & dc, mpWindow & w)
 		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
 		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
 
+		// Thin pens plot the rows inside margins, thick pens all the rows
+		wxCoord firstPy = (m_pen.GetWidth() <= 1) ? minYpx : 0;
+		wxCoord lastPy  = (m_pen.GetWidth() <= 1) ? maxYpx : w.GetScrY();
+
+		// Evaluate the function at each pixel row, unless the view has not changed since last time
+		size_t n = lastPy > firstPy ? lastPy - firstPy : 0;
+		if (m_samples.Prepare(w.GetPosY(), w.GetScaleY(), firstPy, n, GetDataVersion()))
+		{
+			for (size_t k = 0; k < n; ++k)
+				m_samples.m_args[k] = w.p2y(firstPy + (wxCoord) k);
+			if (n > 0)
+				EvaluateBatch(&m_samples.m_args[0], &m_samples.m_values[0], n);
+		}
+
 		if (m_pen.GetWidth() <= 1)
 		{
 			for (i = minYpx; i < maxYpx; ++i)
 			{
-				ix = w.x2p(GetX(w.p2y(i)));
+				ix = w.x2p(m_samples.m_values[i - firstPy]);
 				if (m_drawOutsideMargins || ((ix >= startPx) && (ix <= endPx)))
 					dc.DrawPoint(ix, i);
 			}
@@ -537,7 +761,7 @@ void mpFY::Plot(wxDC & dc, mpWindow & w)
 		{
 			for (i=0;i< w.GetScrY(); ++i)
 			{
-				ix = w.x2p(GetX(w.p2y(i)));
+				ix = w.x2p(m_samples.m_values[i - firstPy]);
 				if (m_drawOutsideMargins || ((ix >= startPx) && (ix <= endPx)))
 					dc.DrawLine(ix, i, ix, i);
 	//             wxCoord c =  w.x2p(GetX(w.p2y(i))); //(wxCoord) ((GetX( (double)i / w.GetScaleY() + w.GetPosY()) - w.GetPosX()) * w.GetScaleX());
@@ -583,7 +807,72 @@ void mpFXY::UpdateViewBoundary(wxCoord xnew, wxCoord ynew)
 	//drawnPoints++;
 }
 
-void mpFXY::Plot(wxDC & dc, mpWindow & w)
+// Index of the first of n points sorted by X whose X is not lower than x
+template <class XAt>
+static size_t mpLowerBoundX(size_t n, double x, XAt xAt)
+{
+	size_t lo = 0, hi = n;
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (xAt(mid) < x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// Nearest point to a window position among n points sorted by X: only the points less than
+// radius pixels away along X are scanned, after a binary search for the first of them.
+template <class XAt, class YAt>
+static bool mpNearestSortedPoint(mpView & w, const wxPoint & pos, int radius, size_t n, XAt xAt, YAt yAt,
+	double & x, double & y, double & dist2)
+{
+	const double xc = w.p2x(pos.x);
+	const double yc = w.p2y(pos.y);
+	const double r2 = (double)radius * radius;
+	bool found = FALSE;
+	for (size_t i = mpLowerBoundX(n, w.p2x(pos.x - radius), xAt); i < n; i++) {
+		const double xi = xAt(i);
+		const double dx = (xi - xc) * w.GetScaleX();
+		if (dx > radius)
+			break;
+		const double yi = yAt(i);
+		const double dy = (yi - yc) * w.GetScaleY();
+		const double d2 = dx*dx + dy*dy;
+		if (d2 <= r2 && (!found || d2 < dist2)) {
+			found = TRUE;
+			dist2 = d2;
+			x = xi;
+			y = yi;
+		}
+	}
+	return found;
+}
+
+bool mpFXY::GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2)
+{
+	const double xc = w.p2x(pos.x);
+	const double yc = w.p2y(pos.y);
+	const double r2 = (double)radius * radius;
+	bool found = FALSE;
+	double xi, yi;
+	Rewind();
+	while (GetNextXY(xi, yi)) {
+		const double dx = (xi - xc) * w.GetScaleX();
+		const double dy = (yi - yc) * w.GetScaleY();
+		const double d2 = dx*dx + dy*dy;
+		if (d2 <= r2 && (!found || d2 < dist2)) {
+			found = TRUE;
+			dist2 = d2;
+			x = xi;
+			y = yi;
+		}
+	}
+	return found;
+}
+
+void mpFXY::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen( m_pen);
@@ -743,7 +1032,13 @@ mpProfile::mpProfile(wxString name, int flags)
     m_type = mpLAYER_PLOT;
 }
 
-void mpProfile::Plot(wxDC & dc, mpWindow & w)
+void mpProfile::EvaluateBatch(const double* in, double* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = GetY(in[i]);
+}
+
+void mpProfile::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 	dc.SetPen( m_pen);
@@ -753,10 +1048,21 @@ void mpProfile::Plot(wxDC & dc, mpWindow & w)
 		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
 		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
 
+		// Evaluate the function once at each column from startPx to endPx included (segment i goes from i to i+1),
+		// unless the view has not changed since last time
+		size_t n = endPx > startPx ? endPx - startPx + 1 : 0;
+		if (m_samples.Prepare(w.GetPosX(), w.GetScaleX(), startPx, n, GetDataVersion()))
+		{
+			for (size_t k = 0; k < n; ++k)
+				m_samples.m_args[k] = w.p2x(startPx + (wxCoord) k);
+			if (n > 0)
+				EvaluateBatch(&m_samples.m_args[0], &m_samples.m_values[0], n);
+		}
+
 	// Plot profile linking subsequent point of the profile, instead of mpFY, which plots simple points.
 	for (wxCoord i = startPx; i < endPx; ++i) {
-			wxCoord c0 = w.y2p( GetY(w.p2x(i)) ); // (wxCoord) ((w.GetYpos() - GetY( (double)i / w.GetXscl() + w.GetXpos()) ) * w.GetYscl());
-		wxCoord c1 = w.y2p( GetY(w.p2x(i+1)) );//(wxCoord) ((w.GetYpos() - GetY( (double)(i+1) / w.GetXscl() + (w.GetXpos() ) ) ) * w.GetYscl());
+			wxCoord c0 = w.y2p( m_samples.m_values[i - startPx] ); // (wxCoord) ((w.GetYpos() - GetY( (double)i / w.GetXscl() + w.GetXpos()) ) * w.GetYscl());
+		wxCoord c1 = w.y2p( m_samples.m_values[i + 1 - startPx] );//(wxCoord) ((w.GetYpos() - GetY( (double)(i+1) / w.GetXscl() + (w.GetXpos() ) ) ) * w.GetYscl());
 			// c0 = (c0 <= maxYpx) ? ((c0 >= minYpx) ? c0 : minYpx) : maxYpx;
 			// c1 = (c1 <= maxYpx) ? ((c1 >= minYpx) ? c1 : minYpx) : maxYpx;
 			if (!m_drawOutsideMargins) {
@@ -804,7 +1110,7 @@ mpScaleX::mpScaleX(wxString name, int flags, bool ticks, unsigned int type)
 	m_labelFormat = wxT("");
 }
 
-void mpScaleX::Plot(wxDC & dc, mpWindow & w)
+void mpScaleX::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen( m_pen);
@@ -839,187 +1145,149 @@ void mpScaleX::Plot(wxDC & dc, mpWindow & w)
         else
             dc.DrawLine( w.GetMarginLeft(), orgy, w.GetScrX() - w.GetMarginRight(), orgy); */
 
-		const double dig  = floor( log( 128.0 / w.GetScaleX() ) / mpLN10 );
-		const double step = exp( mpLN10 * dig);
-		const double end  = w.GetPosX() + (double)extend / w.GetScaleX();
+		wxCoord startPx = m_drawOutsideMargins ? 0 : w.GetMarginLeft();
+		wxCoord endPx   = m_drawOutsideMargins ? w.GetScrX() : w.GetScrX() - w.GetMarginRight();
+		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
+		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
 
-		wxCoord tx, ty;
-		wxString s;
-		wxString fmt;
-		int tmp = (int)dig;
-		if (m_labelType == mpX_NORMAL) {
-			if (!m_labelFormat.IsEmpty()) {
-				fmt = m_labelFormat;
-			} else {
-				if (tmp>=1) {
-					fmt = wxT("%.f");
+		// Ticks and labels only depend on the view, the layer settings and the DC resolution:
+		// compute the step, format and measure them again only if any of them has changed since last time.
+		std::vector<double> key;
+		key.push_back(w.GetPosX());
+		key.push_back(w.GetScaleX());
+		key.push_back(extend);
+		key.push_back(startPx);
+		key.push_back(endPx);
+		key.push_back(dc.GetPPI().x);
+		key.push_back(dc.GetPPI().y);
+		key.push_back(m_labelType);
+		key.push_back(m_timeConv);
+		key.push_back(GetDataVersion());
+		if (!m_layout.Matches(key, m_font, m_labelFormat)) {
+			m_layout.Store(key, m_font, m_labelFormat);
+			m_layout.m_ticks.clear();
+			m_layout.m_labels.clear();
+
+			// Date axes hold seconds since the epoch: their ticks fall on calendar steps
+			// (minutes, hours, days, weeks) instead of powers of ten
+			const bool calendar = (m_labelType == mpX_DATETIME) || (m_labelType == mpX_DATE);
+			const bool local = (m_timeConv == mpX_LOCALTIME);
+			const double dig  = floor( log( 128.0 / w.GetScaleX() ) / mpLN10 );
+			const double step = calendar ? mpCalendarStep(32.0 / w.GetScaleX()) : exp( mpLN10 * dig);
+			const double end  = w.GetPosX() + (double)extend / w.GetScaleX();
+
+			wxString fmt;
+			int tmp = (int)dig;
+			if (m_labelType == mpX_NORMAL) {
+				if (!m_labelFormat.IsEmpty()) {
+					fmt = m_labelFormat;
 				} else {
-					tmp=8-tmp;
-					fmt.Printf(wxT("%%.%df"), tmp >= -1 ? 2 : -tmp);
+					if (tmp>=1) {
+						fmt = wxT("%.f");
+					} else {
+						tmp=8-tmp;
+						fmt.Printf(wxT("%%.%df"), tmp >= -1 ? 2 : -tmp);
+					}
 				}
-			}
-		} else {
-			// Date and/or time axis representation
-			if (m_labelType == mpX_DATETIME) {
-				fmt = (wxT("%04.0f-%02.0f-%02.0fT%02.0f:%02.0f:%02.0f"));
-			} else if (m_labelType == mpX_DATE) {
-				fmt = (wxT("%04.0f-%02.0f-%02.0f"));
-			} else if ((m_labelType == mpX_TIME) && (end/60 < 2)) {
-				fmt = (wxT("%02.0f:%02.3f"));
 			} else {
-				fmt = (wxT("%02.0f:%02.0f:%02.0f"));
+				// Date and/or time axis representation
+				if ((m_labelType == mpX_DATE) || ((m_labelType == mpX_DATETIME) && (step >= 86400))) {
+					fmt = mpDATE_FMT;
+				} else if ((m_labelType == mpX_DATETIME) && (step >= 60)) {
+					fmt = mpDATETIME_SHORT_FMT;
+				} else if (m_labelType == mpX_DATETIME) {
+					fmt = mpDATETIME_FMT;
+				} else if ((m_labelType == mpX_TIME) && (end/60 < 2)) {
+					fmt = (wxT("%02.0f:%02.3f"));
+				} else {
+					fmt = (wxT("%02.0f:%02.0f:%02.0f"));
+				}
 			}
-		}
 
-		//double n = floor( (w.GetPosX() - (double)extend / w.GetScaleX()) / step ) * step ;
-		double n0 = floor( (w.GetPosX() /* - (double)(extend - w.GetMarginLeft() - w.GetMarginRight())/ w.GetScaleX() */) / step ) * step ;
-		double n = 0;
+			//double n = floor( (w.GetPosX() - (double)extend / w.GetScaleX()) / step ) * step ;
+			double n0 = calendar ? mpAlignTime(w.GetPosX(), step, local) :
+				floor( (w.GetPosX() /* - (double)(extend - w.GetMarginLeft() - w.GetMarginRight())/ w.GetScaleX() */) / step ) * step ;
+			double n = 0;
 #ifdef MATHPLOT_DO_LOGGING
-		wxLogMessage(wxT("mpScaleX::Plot: dig: %f , step: %f, end: %f, n: %f"), dig, step, end, n0);
+			wxLogMessage(wxT("mpScaleX::Plot: dig: %f , step: %f, end: %f, n: %f"), dig, step, end, n0);
 #endif
-		wxCoord startPx = m_drawOutsideMargins ? 0 : w.GetMarginLeft();
-		wxCoord endPx   = m_drawOutsideMargins ? w.GetScrX() : w.GetScrX() - w.GetMarginRight();
-		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
-		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
-		
-		tmp=-65535;
-		int labelH = 0; // Control labels heigth to decide where to put axis name (below labels or on top of axis)
-		int maxExtent = 0;
-		time_t when = 0;
-		struct tm timestruct;
-		for (n = n0; n < end; n += step) {
-			const int p = (int)((n - w.GetPosX()) * w.GetScaleX());
+			int labelH = 0; // Control labels heigth to decide where to put axis name (below labels or on top of axis)
+			int maxExtent = 0;
+			for (n = n0; n < end; n += step) {
+				const int p = (int)((n - w.GetPosX()) * w.GetScaleX());
 #ifdef MATHPLOT_DO_LOGGING
-		wxLogMessage(wxT("mpScaleX::Plot: n: %f -> p = %d"), n, p);
+			wxLogMessage(wxT("mpScaleX::Plot: n: %f -> p = %d"), n, p);
 #endif
-			if ((p >= startPx) && (p <= endPx)) {
-				if (m_ticks) { // draw axis ticks
-					if (m_flags == mpALIGN_BORDER_BOTTOM)
-						dc.DrawLine( p, orgy, p, orgy-4);
-					else
-						dc.DrawLine( p, orgy, p, orgy+4);
-				} else { // draw grid dotted lines
-					m_pen.SetStyle(wxDOT);
-					dc.SetPen(m_pen);
-					if ((m_flags == mpALIGN_BOTTOM) && !m_drawOutsideMargins) {
-						dc.DrawLine( p, orgy+4, p, minYpx );
-					} else {
-						if ((m_flags == mpALIGN_TOP) && !m_drawOutsideMargins) {
-							dc.DrawLine( p, orgy-4, p, maxYpx );
-						} else {
-							dc.DrawLine( p, 0/*-w.GetScrY()*/, p, w.GetScrY() );
-						}
-					}
-					m_pen.SetStyle(wxSOLID);
-					dc.SetPen(m_pen);
-				}
-				// Write ticks labels in s string
-				if (m_labelType == mpX_NORMAL)
-					s.Printf(fmt, n);
-				else if (m_labelType == mpX_DATETIME) {
-					when = (time_t)n;
-					if (when > 0) {
-						if (m_timeConv == mpX_LOCALTIME) {
-							timestruct = *localtime(&when);
-						} else {
-							timestruct = *gmtime(&when);
-						}
-						s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, (double)timestruct.tm_hour, (double)timestruct.tm_min, (double)timestruct.tm_sec);
-					}
-				} else if (m_labelType == mpX_DATE) {
-					when = (time_t)n;
-					if (when > 0) {
-						if (m_timeConv == mpX_LOCALTIME) {
-							timestruct = *localtime(&when);
-						} else {
-							timestruct = *gmtime(&when);
-						}
-						s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday);
-					}
-				} else if ((m_labelType == mpX_TIME) || (m_labelType == mpX_HOURS)) {
-					double modulus = fabs(n);
-					double sign = n/modulus;
-					double hh = floor(modulus/3600);
-					double mm = floor((modulus - hh*3600)/60);
-					double ss = modulus - hh*3600 - mm*60;
-	#ifdef MATHPLOT_DO_LOGGING
-					wxLogMessage(wxT("%02.0f Hours, %02.0f minutes, %02.0f seconds"), sign*hh, mm, ss);
-	#endif // MATHPLOT_DO_LOGGING
-					if (fmt.Len() == 20) // Format with hours has 11 chars
-						s.Printf(fmt, sign*hh, mm, floor(ss));
-					else
-						s.Printf(fmt, sign*mm, ss);
-				}
-				dc.GetTextExtent(s, &tx, &ty);
-				labelH = (labelH <= ty) ? ty : labelH;
-/*				if ((p-tx/2-tmp) > 64) { // Problem about non-regular axis labels
-					if ((m_flags == mpALIGN_BORDER_BOTTOM) || (m_flags == mpALIGN_TOP)) {
-						dc.DrawText( s, p-tx/2, orgy-4-ty);
-					} else {
-						dc.DrawText( s, p-tx/2, orgy+4);
-					}
-					tmp=p+tx/2;
+				if ((p >= startPx) && (p <= endPx)) {
+					mpAxisTick tick;
+					tick.pos = p;
+					tick.label = FormatLabel(n, fmt);
+					dc.GetTextExtent(tick.label, &tick.width, &tick.height);
+					labelH = (labelH <= tick.height) ? tick.height : labelH;
+					maxExtent = (tick.width > maxExtent) ? tick.width : maxExtent; // Keep in mind max label width
+					m_layout.m_ticks.push_back(tick);
 				}
-				*/
-				maxExtent = (tx > maxExtent) ? tx : maxExtent; // Keep in mind max label width
 			}
-		}
-		// Actually draw labels, taking care of not overlapping them, and distributing them regularly
-		double labelStep = ceil((maxExtent + mpMIN_X_AXIS_LABEL_SEPARATION)/(w.GetScaleX()*step))*step;
-		for (n = n0; n < end; n += labelStep) {
-			const int p = (int)((n - w.GetPosX()) * w.GetScaleX());
+			// Labels are not overlapping, and distributed regularly
+			double labelStep = ceil((maxExtent + mpMIN_X_AXIS_LABEL_SEPARATION)/(w.GetScaleX()*step))*step;
+			if (calendar) {
+				// Keep labels on calendar boundaries too (e.g. every 12 h rather than every 18 h)
+				labelStep = mpCalendarStep(labelStep);
+				n0 = mpAlignTime(w.GetPosX(), labelStep, local);
+			}
+			for (n = n0; n < end; n += labelStep) {
+				const int p = (int)((n - w.GetPosX()) * w.GetScaleX());
 #ifdef MATHPLOT_DO_LOGGING
-		wxLogMessage(wxT("mpScaleX::Plot: n_label = %f -> p_label = %d"), n, p);
+			wxLogMessage(wxT("mpScaleX::Plot: n_label = %f -> p_label = %d"), n, p);
 #endif
-			if ((p >= startPx) && (p <= endPx)) {
-				// Write ticks labels in s string
-				if (m_labelType == mpX_NORMAL)
-					s.Printf(fmt, n);
-				else if (m_labelType == mpX_DATETIME) {
-					when = (time_t)n;
-					if (when > 0) {
-						if (m_timeConv == mpX_LOCALTIME) {
-							timestruct = *localtime(&when);
-						} else {
-							timestruct = *gmtime(&when);
-						}
-						s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, (double)timestruct.tm_hour, (double)timestruct.tm_min, (double)timestruct.tm_sec);
-					}
-				} else if (m_labelType == mpX_DATE) {
-					when = (time_t)n;
-					if (when > 0) {
-						if (m_timeConv == mpX_LOCALTIME) {
-							timestruct = *localtime(&when);
-						} else {
-							timestruct = *gmtime(&when);
-						}
-						s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday);
-					}
-				} else if ((m_labelType == mpX_TIME) || (m_labelType == mpX_HOURS)) {
-					double modulus = fabs(n);
-					double sign = n/modulus;
-					double hh = floor(modulus/3600);
-					double mm = floor((modulus - hh*3600)/60);
-					double ss = modulus - hh*3600 - mm*60;
-	#ifdef MATHPLOT_DO_LOGGING
-					wxLogMessage(wxT("%02.0f Hours, %02.0f minutes, %02.0f seconds"), sign*hh, mm, ss);
-	#endif // MATHPLOT_DO_LOGGING
-					if (fmt.Len() == 20) // Format with hours has 11 chars
-						s.Printf(fmt, sign*hh, mm, floor(ss));
-					else
-						s.Printf(fmt, sign*mm, ss);
+				if ((p >= startPx) && (p <= endPx)) {
+					mpAxisTick label;
+					label.pos = p;
+					label.label = FormatLabel(n, fmt);
+					dc.GetTextExtent(label.label, &label.width, &label.height);
+					m_layout.m_labels.push_back(label);
 				}
-				dc.GetTextExtent(s, &tx, &ty);
-				if ((m_flags == mpALIGN_BORDER_BOTTOM) || (m_flags == mpALIGN_TOP)) {
-					dc.DrawText( s, p-tx/2, orgy-4-ty);
+			}
+			m_layout.m_labelSize = labelH;
+			dc.GetTextExtent(m_name, &m_layout.m_nameWidth, &m_layout.m_nameHeight);
+		}
+
+		for (std::vector<mpAxisTick>::const_iterator it = m_layout.m_ticks.begin(); it != m_layout.m_ticks.end(); ++it) {
+			const int p = it->pos;
+			if (m_ticks) { // draw axis ticks
+				if (m_flags == mpALIGN_BORDER_BOTTOM)
+					dc.DrawLine( p, orgy, p, orgy-4);
+				else
+					dc.DrawLine( p, orgy, p, orgy+4);
+			} else { // draw grid dotted lines
+				m_pen.SetStyle(wxDOT);
+				dc.SetPen(m_pen);
+				if ((m_flags == mpALIGN_BOTTOM) && !m_drawOutsideMargins) {
+					dc.DrawLine( p, orgy+4, p, minYpx );
 				} else {
-					dc.DrawText( s, p-tx/2, orgy+4);
+					if ((m_flags == mpALIGN_TOP) && !m_drawOutsideMargins) {
+						dc.DrawLine( p, orgy-4, p, maxYpx );
+					} else {
+						dc.DrawLine( p, 0/*-w.GetScrY()*/, p, w.GetScrY() );
+					}
 				}
+				m_pen.SetStyle(wxSOLID);
+				dc.SetPen(m_pen);
+			}
+		}
+		// Actually draw labels
+		for (std::vector<mpAxisTick>::const_iterator it = m_layout.m_labels.begin(); it != m_layout.m_labels.end(); ++it) {
+			if ((m_flags == mpALIGN_BORDER_BOTTOM) || (m_flags == mpALIGN_TOP)) {
+				dc.DrawText( it->label, it->pos - it->width/2, orgy-4-it->height);
+			} else {
+				dc.DrawText( it->label, it->pos - it->width/2, orgy+4);
 			}
 		}
 
 		// Draw axis name
-		dc.GetTextExtent(m_name, &tx, &ty);
+		const int labelH = m_layout.m_labelSize;
+		const wxCoord tx = m_layout.m_nameWidth;
+		const wxCoord ty = m_layout.m_nameHeight;
 		switch (m_flags) {
 			case mpALIGN_BORDER_BOTTOM:
 				dc.DrawText( m_name, extend - tx - 4, orgy - 8 - ty - labelH);
@@ -1058,6 +1326,39 @@ void mpScaleX::Plot(wxDC & dc, mpWindow & w)
     }; */
 }
 
+wxString mpScaleX::FormatLabel(double n, const wxString& fmt)
+{
+	wxString s;
+	if (m_labelType == mpX_NORMAL)
+		s.Printf(fmt, n);
+	else if ((m_labelType == mpX_DATETIME) || (m_labelType == mpX_DATE)) {
+		time_t when = (time_t)n;
+		struct tm timestruct;
+		if ((when > 0) && mpConvertTime(when, m_timeConv == mpX_LOCALTIME, timestruct)) {
+			if (fmt == mpDATETIME_SHORT_FMT)
+				s.Printf(fmt, (double)timestruct.tm_mday, (double)timestruct.tm_mon+1, (double)timestruct.tm_hour, (double)timestruct.tm_min);
+			else if (fmt == mpDATE_FMT)
+				s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday);
+			else
+				s.Printf(fmt, (double)timestruct.tm_year+1900, (double)timestruct.tm_mon+1, (double)timestruct.tm_mday, (double)timestruct.tm_hour, (double)timestruct.tm_min, (double)timestruct.tm_sec);
+		}
+	} else if ((m_labelType == mpX_TIME) || (m_labelType == mpX_HOURS)) {
+		double modulus = fabs(n);
+		double sign = n/modulus;
+		double hh = floor(modulus/3600);
+		double mm = floor((modulus - hh*3600)/60);
+		double ss = modulus - hh*3600 - mm*60;
+#ifdef MATHPLOT_DO_LOGGING
+		wxLogMessage(wxT("%02.0f Hours, %02.0f minutes, %02.0f seconds"), sign*hh, mm, ss);
+#endif // MATHPLOT_DO_LOGGING
+		if (fmt.Len() == 20) // Format with hours has 11 chars
+			s.Printf(fmt, sign*hh, mm, floor(ss));
+		else
+			s.Printf(fmt, sign*mm, ss);
+	}
+	return s;
+}
+
 IMPLEMENT_DYNAMIC_CLASS(mpScaleY, mpLayer)
 
 mpScaleY::mpScaleY(wxString name, int flags, bool ticks)
@@ -1071,7 +1372,7 @@ mpScaleY::mpScaleY(wxString name, int flags, bool ticks)
 	m_labelFormat = wxT("");
 }
 
-void mpScaleY::Plot(wxDC & dc, mpWindow & w)
+void mpScaleY::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen( m_pen);
@@ -1108,51 +1409,93 @@ void mpScaleY::Plot(wxDC & dc, mpWindow & w)
         else
 		    dc.DrawLine( orgx, w.GetMarginTop(), orgx, w.GetScrY() - w.GetMarginBottom()); */
 
-		const double dig  = floor( log( 128.0 / w.GetScaleY() ) / mpLN10 );
-		const double step = exp( mpLN10 * dig);
-		const double end  = w.GetPosY() + (double)extend / w.GetScaleY();
-
-		wxCoord tx = 0, ty = 0;
-		wxString s;
-		wxString fmt;
-		int tmp = (int)dig;
-		double maxScaleAbs = fabs(w.GetDesiredYmax());
-		double minScaleAbs = fabs(w.GetDesiredYmin()); 
-		double endscale = (maxScaleAbs > minScaleAbs) ? maxScaleAbs : minScaleAbs;
-		if (m_labelFormat.IsEmpty()) {
-			if ((endscale < 1e4) && (endscale > 1e-3))
-				fmt = wxT("%.2f");
-			else
-				fmt = wxT("%.1e");
-		} else {
-			fmt = m_labelFormat;
-		}
-	/*    if (tmp>=1)
-		{*/
-		//    fmt = wxT("%7.5g");
-	//     }
-	//     else
-	//     {
-	//         tmp=8-tmp;
-	//         fmt.Printf(wxT("%%.%dg"), (tmp >= -1) ? 2 : -tmp);
-	//     }
-
-		double n = floor( (w.GetPosY() - (double)(extend - w.GetMarginTop() - w.GetMarginBottom())/ w.GetScaleY()) / step ) * step ;
-
 		/* wxCoord startPx = m_drawOutsideMargins ? 0 : w.GetMarginLeft(); */
 		wxCoord endPx   = m_drawOutsideMargins ? w.GetScrX() : w.GetScrX() - w.GetMarginRight();
 		wxCoord minYpx  = m_drawOutsideMargins ? 0 : w.GetMarginTop();
 		wxCoord maxYpx  = m_drawOutsideMargins ? w.GetScrY() : w.GetScrY() - w.GetMarginBottom();
 
-		tmp=65536;
-		int labelW = 0;
-		// Before staring cycle, calculate label height
-		int labelHeigth = 0;
-		s.Printf(fmt,n);
-		dc.GetTextExtent(s, &tx, &labelHeigth);
-		for (;n < end; n += step) {
-			const int p = (int)((w.GetPosY() - n) * w.GetScaleY());
-		if ((p >= minYpx) && (p <= maxYpx)) {
+		// Ticks and labels only depend on the view, the layer settings and the DC resolution:
+		// compute the step, format and measure them again only if any of them has changed since last time.
+		std::vector<double> key;
+		key.push_back(w.GetPosY());
+		key.push_back(w.GetScaleY());
+		key.push_back(extend);
+		key.push_back(w.GetMarginTop());
+		key.push_back(w.GetMarginBottom());
+		key.push_back(minYpx);
+		key.push_back(maxYpx);
+		key.push_back(w.GetDesiredYmin());
+		key.push_back(w.GetDesiredYmax());
+		key.push_back(dc.GetPPI().x);
+		key.push_back(dc.GetPPI().y);
+		key.push_back(GetDataVersion());
+		if (!m_layout.Matches(key, m_font, m_labelFormat)) {
+			m_layout.Store(key, m_font, m_labelFormat);
+			m_layout.m_ticks.clear();
+			m_layout.m_labels.clear();
+
+			const double dig  = floor( log( 128.0 / w.GetScaleY() ) / mpLN10 );
+			const double step = exp( mpLN10 * dig);
+			const double end  = w.GetPosY() + (double)extend / w.GetScaleY();
+
+			wxCoord tx = 0;
+			wxString s;
+			wxString fmt;
+			int tmp = (int)dig;
+			double maxScaleAbs = fabs(w.GetDesiredYmax());
+			double minScaleAbs = fabs(w.GetDesiredYmin()); 
+			double endscale = (maxScaleAbs > minScaleAbs) ? maxScaleAbs : minScaleAbs;
+			if (m_labelFormat.IsEmpty()) {
+				if ((endscale < 1e4) && (endscale > 1e-3))
+					fmt = wxT("%.2f");
+				else
+					fmt = wxT("%.1e");
+			} else {
+				fmt = m_labelFormat;
+			}
+		/*    if (tmp>=1)
+			{*/
+			//    fmt = wxT("%7.5g");
+		//     }
+		//     else
+		//     {
+		//         tmp=8-tmp;
+		//         fmt.Printf(wxT("%%.%dg"), (tmp >= -1) ? 2 : -tmp);
+		//     }
+
+			double n = floor( (w.GetPosY() - (double)(extend - w.GetMarginTop() - w.GetMarginBottom())/ w.GetScaleY()) / step ) * step ;
+
+			tmp=65536;
+			int labelW = 0;
+			// Before staring cycle, calculate label height
+			int labelHeigth = 0;
+			s.Printf(fmt,n);
+			dc.GetTextExtent(s, &tx, &labelHeigth);
+			for (;n < end; n += step) {
+				const int p = (int)((w.GetPosY() - n) * w.GetScaleY());
+				if ((p >= minYpx) && (p <= maxYpx)) {
+					mpAxisTick tick;
+					tick.pos = p;
+					tick.label.Printf(fmt, n);
+					dc.GetTextExtent(tick.label, &tick.width, &tick.height);
+#ifdef MATHPLOT_DO_LOGGING
+					if (tick.height != labelHeigth) wxLogMessage(wxT("mpScaleY::Plot: ty(%f) and labelHeigth(%f) differ!"), tick.height, labelHeigth);
+#endif
+					labelW = (labelW <= tick.width) ? tick.width : labelW;
+					// Labels are drawn only if not overlapping the previous one
+					if ((tmp-p+labelHeigth/2) > mpMIN_Y_AXIS_LABEL_SEPARATION) {
+						m_layout.m_labels.push_back(tick);
+						tmp=p-labelHeigth/2;
+					}
+					m_layout.m_ticks.push_back(tick);
+				}
+			}
+			m_layout.m_labelSize = labelW;
+			dc.GetTextExtent(m_name, &m_layout.m_nameWidth, &m_layout.m_nameHeight);
+		}
+
+		for (std::vector<mpAxisTick>::const_iterator it = m_layout.m_ticks.begin(); it != m_layout.m_ticks.end(); ++it) {
+			const int p = it->pos;
 			if (m_ticks) { // Draw axis ticks
 				if (m_flags == mpALIGN_BORDER_LEFT) {
 					dc.DrawLine( orgx, p, orgx+4, p);
@@ -1174,25 +1517,19 @@ void mpScaleY::Plot(wxDC & dc, mpWindow & w)
 				m_pen.SetStyle(wxSOLID);
 				dc.SetPen( m_pen);
 			}
-			// Print ticks labels
-			s.Printf(fmt, n);
-			dc.GetTextExtent(s, &tx, &ty);
-#ifdef MATHPLOT_DO_LOGGING
-			if (ty != labelHeigth) wxLogMessage(wxT("mpScaleY::Plot: ty(%f) and labelHeigth(%f) differ!"), ty, labelHeigth);
-#endif
-			labelW = (labelW <= tx) ? tx : labelW;
-			if ((tmp-p+labelHeigth/2) > mpMIN_Y_AXIS_LABEL_SEPARATION) {
-				if ((m_flags == mpALIGN_BORDER_LEFT) || (m_flags == mpALIGN_RIGHT))
-					dc.DrawText( s, orgx+4, p-ty/2);
-				else
-					dc.DrawText( s, orgx-4-tx, p-ty/2); //( s, orgx+4, p-ty/2);
-				tmp=p-labelHeigth/2;
-			}
 		}
+		// Print ticks labels
+		for (std::vector<mpAxisTick>::const_iterator it = m_layout.m_labels.begin(); it != m_layout.m_labels.end(); ++it) {
+			if ((m_flags == mpALIGN_BORDER_LEFT) || (m_flags == mpALIGN_RIGHT))
+				dc.DrawText( it->label, orgx+4, it->pos - it->height/2);
+			else
+				dc.DrawText( it->label, orgx-4-it->width, it->pos - it->height/2); //( s, orgx+4, p-ty/2);
 		}
 		
 		// Draw axis name
-		dc.GetTextExtent(m_name, &tx, &ty);
+		const int labelW = m_layout.m_labelSize;
+		const wxCoord tx = m_layout.m_nameWidth;
+		const wxCoord ty = m_layout.m_nameHeight;
 		switch (m_flags) {
 			case mpALIGN_BORDER_LEFT:
 				dc.DrawText( m_name, labelW + 8, 4);
@@ -1236,95 +1573,225 @@ void mpScaleY::Plot(wxDC & dc, mpWindow & w)
 }
 
 //-----------------------------------------------------------------------------
-// mpWindow
+// mpView
 //-----------------------------------------------------------------------------
 
-IMPLEMENT_DYNAMIC_CLASS(mpWindow, wxWindow)
-
-BEGIN_EVENT_TABLE(mpWindow, wxWindow)
-    EVT_PAINT    ( mpWindow::OnPaint)
-    EVT_SIZE     ( mpWindow::OnSize)
-    EVT_SCROLLWIN_THUMBTRACK(mpWindow::OnScrollThumbTrack)
-    EVT_SCROLLWIN_PAGEUP(mpWindow::OnScrollPageUp)
-    EVT_SCROLLWIN_PAGEDOWN(mpWindow::OnScrollPageDown)
-    EVT_SCROLLWIN_LINEUP(mpWindow::OnScrollLineUp)
-    EVT_SCROLLWIN_LINEDOWN(mpWindow::OnScrollLineDown)
-    EVT_SCROLLWIN_TOP(mpWindow::OnScrollTop)
-    EVT_SCROLLWIN_BOTTOM(mpWindow::OnScrollBottom)
-
-    EVT_MIDDLE_UP( mpWindow::OnShowPopupMenu)
-    EVT_RIGHT_DOWN( mpWindow::OnMouseRightDown) // JLB
-    EVT_RIGHT_UP ( mpWindow::OnShowPopupMenu)
-    EVT_MOUSEWHEEL( mpWindow::OnMouseWheel )   // JLB
-    EVT_MOTION( mpWindow::OnMouseMove )   // JLB
-    EVT_LEFT_DOWN( mpWindow::OnMouseLeftDown)
-    EVT_LEFT_UP( mpWindow::OnMouseLeftRelease)
-
-    EVT_MENU( mpID_CENTER,    mpWindow::OnCenter)
-    EVT_MENU( mpID_FIT,       mpWindow::OnFit)
-    EVT_MENU( mpID_ZOOM_IN,   mpWindow::OnZoomIn)
-    EVT_MENU( mpID_ZOOM_OUT,  mpWindow::OnZoomOut)
-    EVT_MENU( mpID_LOCKASPECT,mpWindow::OnLockAspect)
-    EVT_MENU( mpID_HELP_MOUSE,mpWindow::OnMouseHelp)
-END_EVENT_TABLE()
-
-mpWindow::mpWindow( wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size, long flag )
-    : wxWindow( parent, id, pos, size, flag, wxT("mathplot") )
+mpView::mpView()
 {
     m_scaleX = m_scaleY = 1.0;
     m_posX   = m_posY   = 0;
     m_desiredXmin=m_desiredYmin=0;
     m_desiredXmax=m_desiredYmax=1;
     m_scrX   = m_scrY   = 64; // Fixed from m_scrX = m_scrX = 64;
-    m_minX   = m_minY   = 0;
-    m_maxX   = m_maxY   = 0;
-    m_last_lx= m_last_ly= 0;
-    m_buff_bmp = NULL;
-    m_enableDoubleBuffer        = FALSE;
-    m_enableMouseNavigation     = TRUE;
-    m_mouseMovedAfterRightClick = FALSE;
-    m_movingInfoLayer = NULL;
     // Set margins to 0
     m_marginTop = 0; m_marginRight = 0; m_marginBottom = 0; m_marginLeft = 0;
-
-
     m_lockaspect = FALSE;
+}
 
-    m_popmenu.Append( mpID_CENTER,     _("Center"),      _("Center plot view to this position"));
-    m_popmenu.Append( mpID_FIT,        _("Fit"),         _("Set plot view to show all items"));
-    m_popmenu.Append( mpID_ZOOM_IN,    _("Zoom in"),     _("Zoom in plot view."));
-    m_popmenu.Append( mpID_ZOOM_OUT,   _("Zoom out"),    _("Zoom out plot view."));
-    m_popmenu.AppendCheckItem( mpID_LOCKASPECT, _("Lock aspect"), _("Lock horizontal and vertical zoom aspect."));
-    m_popmenu.Append( mpID_HELP_MOUSE,   _("Show mouse commands..."),    _("Show help about the mouse commands."));
-
-    m_layers.clear();
-    SetBackgroundColour( *wxWHITE );
-	 m_bgColour = *wxWHITE;
-	 m_fgColour = *wxBLACK;
-
-    m_enableScrollBars = false;
-    SetSizeHints(128, 128);
-
-    // J.L.Blanco: Eliminates the "flick" with the double buffer.
-    SetBackgroundStyle( wxBG_STYLE_CUSTOM );
+// New methods implemented by Davide Rondini
 
-    UpdateAll();
+unsigned int mpView::CountLayers()
+{
+    //wxNode *node = m_layers.GetFirst();
+    unsigned int layerNo = 0;
+    for(wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)//while(node)
+    	{
+        if ((*li)->HasBBox()) layerNo++;
+	// node = node->GetNext();
+    	};
+    return layerNo;
 }
 
-mpWindow::~mpWindow()
+mpLayer* mpView::GetLayer(int position)
 {
-	// Free all the layers:
-	DelAllLayers( true, false );
-	
-    if (m_buff_bmp)
-    {
-        delete m_buff_bmp;
-        m_buff_bmp = NULL;
-    }
+    if ((position >= (int) m_layers.size()) || position < 0) return NULL;
+    return m_layers[position];
 }
 
-// Mouse handler, for detecting when the user drag with the right button or just "clicks" for the menu
-// JLB
+mpLayer* mpView::GetLayerByName( const wxString &name)
+{
+    for (wxLayerList::iterator it=m_layers.begin();it!=m_layers.end();it++)
+        if (! (*it)->GetName().Cmp( name ) )
+            return *it;
+    return NULL;    // Not found
+}
+
+void mpView::SetMargins(int top, int right, int bottom, int left)
+{
+    m_marginTop = top;
+    m_marginRight = right;
+    m_marginBottom = bottom;
+    m_marginLeft = left;
+}
+
+void mpView::ComputeFit(double xMin, double xMax, double yMin, double yMax)
+{
+	// Save desired borders:
+	m_desiredXmin=xMin; m_desiredXmax=xMax;
+	m_desiredYmin=yMin; m_desiredYmax=yMax;
+
+	double Ax,Ay;
+
+	Ax = xMax - xMin;
+	Ay = yMax - yMin;
+
+	m_scaleX = (Ax!=0) ? (m_scrX - m_marginLeft - m_marginRight)/Ax : 1; //m_scaleX = (Ax!=0) ? m_scrX/Ax : 1;
+	m_scaleY = (Ay!=0) ? (m_scrY - m_marginTop - m_marginBottom)/Ay : 1; //m_scaleY = (Ay!=0) ? m_scrY/Ay : 1;
+
+	if (m_lockaspect)
+	{
+#ifdef MATHPLOT_DO_LOGGING
+	wxLogMessage(_("mpView::ComputeFit()(lock) m_scaleX=%f,m_scaleY=%f"), m_scaleX,m_scaleY);
+#endif
+		// Keep the lowest "scale" to fit the whole range required by that axis (to actually "fit"!):
+		double s = m_scaleX < m_scaleY ? m_scaleX : m_scaleY;
+		m_scaleX = s;
+		m_scaleY = s;
+	}
+
+	// Adjusts corner coordinates: This should be simply:
+	//   m_posX = m_minX;
+	//   m_posY = m_maxY;
+	// But account for centering if we have lock aspect:
+	m_posX = (xMin+xMax)/2 - ((m_scrX - m_marginLeft - m_marginRight)/2 + m_marginLeft)/m_scaleX ; // m_posX = (xMin+xMax)/2 - (m_scrX/2)/m_scaleX;
+//	m_posY = (yMin+yMax)/2 + ((m_scrY - m_marginTop - m_marginBottom)/2 - m_marginTop)/m_scaleY;  // m_posY = (yMin+yMax)/2 + (m_scrY/2)/m_scaleY;
+	m_posY = (yMin+yMax)/2 + ((m_scrY - m_marginTop - m_marginBottom)/2 + m_marginTop)/m_scaleY;  // m_posY = (yMin+yMax)/2 + (m_scrY/2)/m_scaleY;
+
+#ifdef MATHPLOT_DO_LOGGING
+	wxLogMessage(_("mpView::ComputeFit() m_desiredXmin=%f m_desiredXmax=%f  m_desiredYmin=%f m_desiredYmax=%f"), xMin,xMax,yMin,yMax);
+	wxLogMessage(_("mpView::ComputeFit() m_scaleX = %f , m_scrX = %d,m_scrY=%d, Ax=%f, Ay=%f, m_posX=%f, m_posY=%f"), m_scaleX, m_scrX,m_scrY, Ax,Ay,m_posX,m_posY);
+#endif
+}
+
+bool mpView::ComputeLayersBBox(double &minX, double &maxX, double &minY, double &maxY)
+{
+    bool first = TRUE;
+
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+    {
+        mpLayer* f = *li;
+        if (!f->HasBBox()) continue;
+
+        if (first)
+        {
+            first = FALSE;
+            minX = f->GetMinX(); maxX = f->GetMaxX();
+            minY = f->GetMinY(); maxY = f->GetMaxY();
+        }
+        else
+        {
+            if (f->GetMinX()<minX) minX=f->GetMinX(); if (f->GetMaxX()>maxX) maxX=f->GetMaxX();
+            if (f->GetMinY()<minY) minY=f->GetMinY(); if (f->GetMaxY()>maxY) maxY=f->GetMaxY();
+        }
+    }
+    return first == FALSE;
+}
+
+//-----------------------------------------------------------------------------
+// mpWindow
+//-----------------------------------------------------------------------------
+
+IMPLEMENT_DYNAMIC_CLASS(mpWindow, wxWindow)
+
+BEGIN_EVENT_TABLE(mpWindow, wxWindow)
+    EVT_PAINT    ( mpWindow::OnPaint)
+    EVT_SIZE     ( mpWindow::OnSize)
+    EVT_SCROLLWIN_THUMBTRACK(mpWindow::OnScrollThumbTrack)
+    EVT_SCROLLWIN_PAGEUP(mpWindow::OnScrollPageUp)
+    EVT_SCROLLWIN_PAGEDOWN(mpWindow::OnScrollPageDown)
+    EVT_SCROLLWIN_LINEUP(mpWindow::OnScrollLineUp)
+    EVT_SCROLLWIN_LINEDOWN(mpWindow::OnScrollLineDown)
+    EVT_SCROLLWIN_TOP(mpWindow::OnScrollTop)
+    EVT_SCROLLWIN_BOTTOM(mpWindow::OnScrollBottom)
+
+    EVT_MIDDLE_UP( mpWindow::OnShowPopupMenu)
+    EVT_RIGHT_DOWN( mpWindow::OnMouseRightDown) // JLB
+    EVT_RIGHT_UP ( mpWindow::OnShowPopupMenu)
+    EVT_MOUSEWHEEL( mpWindow::OnMouseWheel )   // JLB
+    EVT_MOTION( mpWindow::OnMouseMove )   // JLB
+    EVT_LEFT_DOWN( mpWindow::OnMouseLeftDown)
+    EVT_LEFT_UP( mpWindow::OnMouseLeftRelease)
+    EVT_TIMER( mpID_PAN_TIMER, mpWindow::OnPanTimer)
+
+    EVT_MENU( mpID_CENTER,    mpWindow::OnCenter)
+    EVT_MENU( mpID_FIT,       mpWindow::OnFit)
+    EVT_MENU( mpID_ZOOM_IN,   mpWindow::OnZoomIn)
+    EVT_MENU( mpID_ZOOM_OUT,  mpWindow::OnZoomOut)
+    EVT_MENU( mpID_LOCKASPECT,mpWindow::OnLockAspect)
+    EVT_MENU( mpID_HELP_MOUSE,mpWindow::OnMouseHelp)
+END_EVENT_TABLE()
+
+mpWindow::mpWindow( wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size, long flag )
+    : wxWindow( parent, id, pos, size, flag, wxT("mathplot") )
+{
+    m_minX   = m_minY   = 0;
+    m_maxX   = m_maxY   = 0;
+    m_bboxValid = FALSE;
+    m_bboxDirty = FALSE;
+    m_bboxGlobalVersion = mpLayer::GetGlobalDataVersion();
+    m_last_lx= m_last_ly= 0;
+    m_buff_bmp = NULL;
+    m_layerCache_bmp = NULL;
+    m_panCache_bmp = NULL;
+    m_panCacheValid = FALSE;
+    m_panTimer.SetOwner(this, mpID_PAN_TIMER);
+    m_enableDoubleBuffer        = FALSE;
+    m_enableLayerCache          = TRUE;
+    m_layerCacheValid           = FALSE;
+    m_layerCache_size[0] = m_layerCache_size[1] = -1;
+    m_enableMouseNavigation     = TRUE;
+    m_mouseMovedAfterRightClick = FALSE;
+    m_movingInfoLayer = NULL;
+    m_updateBatchLevel = 0;
+    m_updatePending = FALSE;
+
+    m_popmenu.Append( mpID_CENTER,     _("Center"),      _("Center plot view to this position"));
+    m_popmenu.Append( mpID_FIT,        _("Fit"),         _("Set plot view to show all items"));
+    m_popmenu.Append( mpID_ZOOM_IN,    _("Zoom in"),     _("Zoom in plot view."));
+    m_popmenu.Append( mpID_ZOOM_OUT,   _("Zoom out"),    _("Zoom out plot view."));
+    m_popmenu.AppendCheckItem( mpID_LOCKASPECT, _("Lock aspect"), _("Lock horizontal and vertical zoom aspect."));
+    m_popmenu.Append( mpID_HELP_MOUSE,   _("Show mouse commands..."),    _("Show help about the mouse commands."));
+
+    m_layers.clear();
+    SetBackgroundColour( *wxWHITE );
+	 m_bgColour = *wxWHITE;
+	 m_fgColour = *wxBLACK;
+
+    m_enableScrollBars = false;
+    SetSizeHints(128, 128);
+
+    // J.L.Blanco: Eliminates the "flick" with the double buffer.
+    SetBackgroundStyle( wxBG_STYLE_CUSTOM );
+
+    UpdateAll();
+}
+
+mpWindow::~mpWindow()
+{
+	// Free all the layers:
+	DelAllLayers( true, false );
+	
+    if (m_buff_bmp)
+    {
+        delete m_buff_bmp;
+        m_buff_bmp = NULL;
+    }
+    if (m_layerCache_bmp)
+    {
+        m_layerCache_dc.SelectObject(wxNullBitmap);
+        delete m_layerCache_bmp;
+        m_layerCache_bmp = NULL;
+    }
+    if (m_panCache_bmp)
+    {
+        m_panCache_dc.SelectObject(wxNullBitmap);
+        delete m_panCache_bmp;
+        m_panCache_bmp = NULL;
+    }
+}
+
+// Mouse handler, for detecting when the user drag with the right button or just "clicks" for the menu
+// JLB
 void mpWindow::OnMouseRightDown(wxMouseEvent     &event)
 {
     m_mouseMovedAfterRightClick = FALSE;
@@ -1380,12 +1847,30 @@ void mpWindow::OnMouseWheel( wxMouseEvent &event )
     }
 }
 
+void mpWindow::UpdateInfoLayers(wxMouseEvent &event)
+{
+    wxLayerList::iterator li;
+    for (li = m_layers.begin(); li != m_layers.end(); li++) {
+        if ((*li)->IsInfo() && (*li)->IsVisible()) {
+            mpInfoLayer* tmpLyr = (mpInfoLayer*) (*li);
+            // Invalidate the old box too, in case the layer shrinks or moves
+            wxRect dirty = tmpLyr->GetRectangle();
+            tmpLyr->UpdateInfo(*this, event);
+            // UpdateAll();
+            RefreshRect(dirty.Union(tmpLyr->GetRectangle()).Inflate(1));
+        }
+    }
+}
+
 // If the user "drags" with the right buttom pressed, do "pan"
 // JLB
 void mpWindow::OnMouseMove(wxMouseEvent     &event)
 {
     if (!m_enableMouseNavigation)
     {
+        // No pan nor zoom, but info layers still follow the mouse
+        if (!event.m_leftDown && !event.m_rightDown)
+            UpdateInfoLayers(event);
         event.Skip();
         return;
     }
@@ -1412,7 +1897,9 @@ void mpWindow::OnMouseMove(wxMouseEvent     &event)
 	m_desiredYmax 	+= Ay_units;
 	m_desiredYmin 	+= Ay_units;
 
-        UpdateAll();
+        // Render at most once per display frame: the timer renders all the motion accumulated meanwhile
+        if (!m_panTimer.IsRunning())
+            m_panTimer.StartOnce(mpPAN_REPAINT_INTERVAL);
 
 #ifdef MATHPLOT_DO_LOGGING
         wxLogMessage(_("[mpWindow::OnMouseMove] Ax:%i Ay:%i m_posX:%f m_posY:%f"),Ax,Ay,m_posX,m_posY);
@@ -1420,26 +1907,23 @@ void mpWindow::OnMouseMove(wxMouseEvent     &event)
     } else {
         if (event.m_leftDown) {
             if (m_movingInfoLayer == NULL) {
+                // The zoom box is drawn on an overlay, the plot below it is neither rendered nor painted again
                 wxClientDC dc(this);
+                wxDCOverlay overlaydc(m_zoomOverlay, &dc);
+                overlaydc.Clear();
                 wxPen pen(*wxBLACK, 1, wxDOT);
                 dc.SetPen(pen);
                 dc.SetBrush(*wxTRANSPARENT_BRUSH);
                 dc.DrawRectangle(m_mouseLClick_X, m_mouseLClick_Y, event.GetX() - m_mouseLClick_X, event.GetY() - m_mouseLClick_Y);
             } else {
+                // Info layers are painted over the cached plot: repaint the old and new boxes only
+                wxRect dirty = m_movingInfoLayer->GetRectangle();
                 wxPoint moveVector(event.GetX() - m_mouseLClick_X, event.GetY() - m_mouseLClick_Y);
                 m_movingInfoLayer->Move(moveVector);
+                RefreshRect(dirty.Union(m_movingInfoLayer->GetRectangle()).Inflate(1));
             }
-            UpdateAll();
         } else {
-            wxLayerList::iterator li;
-            for (li = m_layers.begin(); li != m_layers.end(); li++) {
-                if ((*li)->IsInfo() && (*li)->IsVisible()) {
-                    mpInfoLayer* tmpLyr = (mpInfoLayer*) (*li);
-                    tmpLyr->UpdateInfo(*this, event);
-                    // UpdateAll();
-					RefreshRect(tmpLyr->GetRectangle());
-                }
-            }
+            UpdateInfoLayers(event);
             /* if (m_coordTooltip) {
                 wxString toolTipContent;
                 toolTipContent.Printf(_("X = %f\nY = %f"), p2x(event.GetX()), p2y(event.GetY()));
@@ -1478,6 +1962,13 @@ void mpWindow::OnMouseLeftRelease (wxMouseEvent &event)
         m_movingInfoLayer->UpdateReference();
         m_movingInfoLayer = NULL;
     } else {
+        // Remove the zoom box
+        {
+            wxClientDC dc(this);
+            wxDCOverlay overlaydc(m_zoomOverlay, &dc);
+            overlaydc.Clear();
+        }
+        m_zoomOverlay.Reset();
         if (release != press) {
             ZoomRect(press, release);
         } /*else {
@@ -1501,10 +1992,6 @@ void mpWindow::Fit()
 // JL
 void mpWindow::Fit(double xMin, double xMax, double yMin, double yMax, wxCoord *printSizeX,wxCoord *printSizeY)
 {
-	// Save desired borders:
-	m_desiredXmin=xMin; m_desiredXmax=xMax;
-	m_desiredYmin=yMin; m_desiredYmax=yMax;
-
 	if (printSizeX!=NULL && printSizeY!=NULL)
 	{
 		// Printer:
@@ -1517,37 +2004,7 @@ void mpWindow::Fit(double xMin, double xMax, double yMin, double yMax, wxCoord *
 		GetClientSize( &m_scrX,&m_scrY);
 	}
 
-	double Ax,Ay;
-
-	Ax = xMax - xMin;
-	Ay = yMax - yMin;
-
-	m_scaleX = (Ax!=0) ? (m_scrX - m_marginLeft - m_marginRight)/Ax : 1; //m_scaleX = (Ax!=0) ? m_scrX/Ax : 1;
-	m_scaleY = (Ay!=0) ? (m_scrY - m_marginTop - m_marginBottom)/Ay : 1; //m_scaleY = (Ay!=0) ? m_scrY/Ay : 1;
-
-	if (m_lockaspect)
-	{
-#ifdef MATHPLOT_DO_LOGGING
-	wxLogMessage(_("mpWindow::Fit()(lock) m_scaleX=%f,m_scaleY=%f"), m_scaleX,m_scaleY);
-#endif
-		// Keep the lowest "scale" to fit the whole range required by that axis (to actually "fit"!):
-		double s = m_scaleX < m_scaleY ? m_scaleX : m_scaleY;
-		m_scaleX = s;
-		m_scaleY = s;
-	}
-
-	// Adjusts corner coordinates: This should be simply:
-	//   m_posX = m_minX;
-	//   m_posY = m_maxY;
-	// But account for centering if we have lock aspect:
-	m_posX = (xMin+xMax)/2 - ((m_scrX - m_marginLeft - m_marginRight)/2 + m_marginLeft)/m_scaleX ; // m_posX = (xMin+xMax)/2 - (m_scrX/2)/m_scaleX;
-//	m_posY = (yMin+yMax)/2 + ((m_scrY - m_marginTop - m_marginBottom)/2 - m_marginTop)/m_scaleY;  // m_posY = (yMin+yMax)/2 + (m_scrY/2)/m_scaleY;
-	m_posY = (yMin+yMax)/2 + ((m_scrY - m_marginTop - m_marginBottom)/2 + m_marginTop)/m_scaleY;  // m_posY = (yMin+yMax)/2 + (m_scrY/2)/m_scaleY;
-
-#ifdef MATHPLOT_DO_LOGGING
-	wxLogMessage(_("mpWindow::Fit() m_desiredXmin=%f m_desiredXmax=%f  m_desiredYmin=%f m_desiredYmax=%f"), xMin,xMax,yMin,yMax);
-	wxLogMessage(_("mpWindow::Fit() m_scaleX = %f , m_scrX = %d,m_scrY=%d, Ax=%f, Ay=%f, m_posX=%f, m_posY=%f"), m_scaleX, m_scrX,m_scrY, Ax,Ay,m_posX,m_posY);
-#endif
+	ComputeFit(xMin, xMax, yMin, yMax);
 
 	// It is VERY IMPORTANT to DO NOT call Refresh if we are drawing to the printer!!
 	// Otherwise, the DC dimensions will be those of the window instead of the printer device
@@ -1751,6 +2208,16 @@ void mpWindow::OnShowPopupMenu(wxMouseEvent &event)
         SetCursor( *wxSTANDARD_CURSOR );
     }
 
+    // End of a pan: render again in full, the scrolled frames draw axes over the plots and may
+    // have placed the layer names for a previous view
+    if (m_mouseMovedAfterRightClick)
+    {
+        m_panTimer.Stop();
+        m_panCacheValid = FALSE;
+        m_layerCacheValid = FALSE;
+        UpdateAll();
+    }
+
     if (!m_mouseMovedAfterRightClick)   // JLB
     {
         m_clickedX = event.GetX();
@@ -1811,6 +2278,21 @@ bool mpWindow::AddLayer( mpLayer* layer, bool refreshDisplay )
 {
     if (layer != NULL) {
 	m_layers.push_back( layer );
+	// Extend the global bounding box with the new layer only
+	mpLayerBBox box = ReadLayerBBox(layer);
+	m_layerBBoxes.push_back( box );
+	if (box.hasBBox && !m_bboxDirty) {
+		if (!m_bboxValid) {
+			m_minX = box.minX; m_maxX = box.maxX;
+			m_minY = box.minY; m_maxY = box.maxY;
+			m_bboxValid = TRUE;
+		} else {
+			if (box.minX < m_minX) m_minX = box.minX;
+			if (box.maxX > m_maxX) m_maxX = box.maxX;
+			if (box.minY < m_minY) m_minY = box.minY;
+			if (box.maxY > m_maxY) m_maxY = box.maxY;
+		}
+	}
     	if (refreshDisplay) UpdateAll();
     	return true;
     	};
@@ -1830,6 +2312,8 @@ bool mpWindow::DelLayer(
 	        // Also delete the object?
         	if (alsoDeleteObject) 
 			delete *layIt;
+		m_layerBBoxes.erase(m_layerBBoxes.begin() + (layIt - m_layers.begin()));
+		m_bboxDirty = TRUE;
 	    	m_layers.erase(layIt); // this deleted the reference only
 	    	if (refreshDisplay) 
 			UpdateAll();
@@ -1847,6 +2331,8 @@ void mpWindow::DelAllLayers( bool alsoDeleteObject, bool refreshDisplay)
 		if (alsoDeleteObject) delete m_layers[0];
 		m_layers.erase( m_layers.begin() ); // this deleted the reference only
     }
+	m_layerBBoxes.clear();
+	m_bboxDirty = TRUE;
 	if (refreshDisplay)  UpdateAll();
 }
 
@@ -1869,6 +2355,11 @@ void mpWindow::OnPaint( wxPaintEvent& WXUNUSED(event) )
     }
 #endif
 
+    // Only the invalidated area has to be painted: e.g. RefreshRect of an info layer invalidates its box only
+    wxRegion updateRegion = GetUpdateRegion();
+    if (updateRegion.IsEmpty())
+        updateRegion = wxRegion(0, 0, m_scrX, m_scrY);
+
     // Selects direct or buffered draw:
     wxDC    *trgDc;
 
@@ -1882,6 +2373,8 @@ void mpWindow::OnPaint( wxPaintEvent& WXUNUSED(event) )
             m_buff_dc.SelectObject(*m_buff_bmp);
             m_last_lx=m_scrX;
             m_last_ly=m_scrY;
+            // The new buffer holds nothing yet
+            updateRegion = wxRegion(0, 0, m_scrX, m_scrY);
         }
         trgDc = &m_buff_dc;
     }
@@ -1890,28 +2383,58 @@ void mpWindow::OnPaint( wxPaintEvent& WXUNUSED(event) )
         trgDc = &dc;
     }
 
-    // Draw background:
-    //trgDc->SetDeviceOrigin(0,0);
-    trgDc->SetPen( *wxTRANSPARENT_PEN );
-    wxBrush brush( GetBackgroundColour() );
-    trgDc->SetBrush( brush );
-		trgDc->SetTextForeground(m_fgColour);
-    trgDc->DrawRectangle(0,0,m_scrX,m_scrY);
+    const bool fullPaint = (updateRegion.Contains(wxRect(0, 0, m_scrX, m_scrY)) == wxInRegion);
+    trgDc->SetDeviceClippingRegion(updateRegion);
 
-    // Draw all the layers:
-    //trgDc->SetDeviceOrigin( m_scrX>>1, m_scrY>>1);  // Origin at the center
     wxLayerList::iterator li;
-    for (li = m_layers.begin(); li != m_layers.end(); li++)
+    if (m_enableLayerCache)
     {
-    	(*li)->Plot(*trgDc, *this);
-    };
+        // Render axes and plots only if something changed since last time, then
+        // draw the cached image and the info layers on top of it.
+        if (!IsLayerCacheValid())
+            RenderLayerCache();
+        for (wxRegionIterator ri(updateRegion); ri; ++ri)
+        {
+            const wxRect r = ri.GetRect();
+            trgDc->Blit(r.x, r.y, r.width, r.height, &m_layerCache_dc, r.x, r.y);
+        }
+        trgDc->SetTextForeground(m_fgColour);
+        for (li = m_layers.begin(); li != m_layers.end(); li++)
+        {
+            if ((*li)->IsInfo() && (fullPaint || LayerIntersects(*li, updateRegion)))
+                (*li)->Plot(*trgDc, *this);
+        }
+    }
+    else
+    {
+        // Draw background:
+        //trgDc->SetDeviceOrigin(0,0);
+        trgDc->SetPen( *wxTRANSPARENT_PEN );
+        wxBrush brush( GetBackgroundColour() );
+        trgDc->SetBrush( brush );
+        trgDc->SetTextForeground(m_fgColour);
+        trgDc->DrawRectangle(0,0,m_scrX,m_scrY);
 
-    // If doublebuffer, draw now to the window:
+        // Draw the layers which may draw inside the update region:
+        //trgDc->SetDeviceOrigin( m_scrX>>1, m_scrY>>1);  // Origin at the center
+        for (li = m_layers.begin(); li != m_layers.end(); li++)
+        {
+            if (fullPaint || LayerIntersects(*li, updateRegion))
+                (*li)->Plot(*trgDc, *this);
+        };
+    }
+    trgDc->DestroyClippingRegion();
+
+    // If doublebuffer, draw now to the window, only the invalidated rectangles:
     if (m_enableDoubleBuffer)
     {
         //trgDc->SetDeviceOrigin(0,0);
         //dc.SetDeviceOrigin(0,0);  // Origin at the center
-        dc.Blit(0,0,m_scrX,m_scrY,trgDc,0,0);
+        for (wxRegionIterator ri(updateRegion); ri; ++ri)
+        {
+            const wxRect r = ri.GetRect();
+            dc.Blit(r.x, r.y, r.width, r.height, trgDc, r.x, r.y);
+        }
     }
     
 /*    if (m_coordTooltip) {
@@ -1934,40 +2457,209 @@ void mpWindow::OnPaint( wxPaintEvent& WXUNUSED(event) )
 
 }
 
-// void mpWindow::OnScroll2(wxScrollWinEvent &event)
-// {
-// #ifdef MATHPLOT_DO_LOGGING
-//     wxLogMessage(_("[mpWindow::OnScroll2] Init: m_posX=%f m_posY=%f, sc_pos = %d"),m_posX,m_posY, event.GetPosition());
-// #endif
-//     // If scrollbars are not enabled, Skip operation
-//     if (!m_enableScrollBars) {
-//         event.Skip();
-//         return;
-//     }
-// //     m_scrollX = (int) floor((m_posX - m_minX)*m_scaleX);
-// //     m_scrollY = (int) floor((m_maxY - m_posY /*- m_minY*/)*m_scaleY);
-// //     Scroll(m_scrollX, m_scrollY);
-// 
-// //     GetClientSize( &m_scrX, &m_scrY);
-//     //Scroll(x2p(m_desiredXmin), y2p(m_desiredYmin));
-//     int pixelStep = 1;
-//     if (event.GetOrientation() == wxHORIZONTAL) {
-//         //m_desiredXmin -= (m_scrollX - event.GetPosition())/m_scaleX;
-//         //m_desiredXmax -= (m_scrollX - event.GetPosition())/m_scaleX;
-//         m_posX -= (m_scrollX - event.GetPosition())/m_scaleX;
-//         m_scrollX = event.GetPosition();
-//     }
-//     Fit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax);
-// // /*    int pixelStep = 1;
-// //     if (event.GetOrientation() == wxHORIZONTAL) {
-// //         m_posX 		-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
-// // 	m_desiredXmax 	-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
-// // 	m_desiredXmin 	-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
-// //         //SetPosX( (double)px / GetScaleX() + m_minX + (double)(width>>1)/GetScaleX());
-// // //         m_posX = p2x(px); //m_minX + (double)(px /*+ (m_scrX)*/)/GetScaleX();
-// //     } else {
-// //         m_posY 		+= (py - event.GetPosition())/m_scaleY;//(pixelStep/m_scaleY);
-// // 	m_desiredYmax	+= (py - event.GetPosition())/m_scaleY;//(pixelStep/m_scaleY);
+bool mpWindow::IsLayerCacheValid(bool checkPosition)
+{
+    if (!m_layerCacheValid || m_layerCache_bmp == NULL)
+        return false;
+    if (m_layerCache_size[0] != m_scrX || m_layerCache_size[1] != m_scrY)
+        return false;
+    if (checkPosition && (m_layerCache_view[0] != m_posX || m_layerCache_view[1] != m_posY))
+        return false;
+    if (m_layerCache_view[2] != m_scaleX || m_layerCache_view[3] != m_scaleY)
+        return false;
+    if (m_layerCache_margins[0] != m_marginTop || m_layerCache_margins[1] != m_marginRight ||
+        m_layerCache_margins[2] != m_marginBottom || m_layerCache_margins[3] != m_marginLeft)
+        return false;
+    if (m_layerCache_bg != GetBackgroundColour() || m_layerCache_fg != m_fgColour)
+        return false;
+    // Layers added, removed or modified since the last rendering?
+    if (m_layerCache_versions.size() != m_layers.size())
+        return false;
+    for (size_t i = 0; i < m_layers.size(); i++)
+    {
+        if (m_layerCache_versions[i].first != m_layers[i] ||
+            m_layerCache_versions[i].second != m_layers[i]->GetDataVersion())
+            return false;
+    }
+    return true;
+}
+
+// Layers which move with the view when panning: their cached image can be scrolled
+static bool mpIsScrollableLayer(mpLayer* layer)
+{
+    return (layer->GetLayerType() == mpLAYER_PLOT) || (layer->GetLayerType() == mpLAYER_BITMAP);
+}
+
+void mpWindow::RenderLayerCache(bool panning)
+{
+    // A window not sized yet still gets a 1x1 bitmap: the cache key keeps the real screen size
+    const int bmpX = m_scrX > 0 ? m_scrX : 1;
+    const int bmpY = m_scrY > 0 ? m_scrY : 1;
+    if (m_layerCache_bmp == NULL || m_layerCache_bmp->GetWidth() != bmpX || m_layerCache_bmp->GetHeight() != bmpY)
+    {
+        m_layerCache_dc.SelectObject(wxNullBitmap);
+        if (m_layerCache_bmp) delete m_layerCache_bmp;
+        m_layerCache_bmp = new wxBitmap(bmpX, bmpY);
+        m_layerCache_dc.SelectObject(*m_layerCache_bmp);
+    }
+
+    // While panning, background and plot layers are first drawn in the pan cache, which is scrolled afterwards
+    if (panning && (m_panCache_bmp == NULL || m_panCache_bmp->GetWidth() != bmpX || m_panCache_bmp->GetHeight() != bmpY))
+    {
+        m_panCache_dc.SelectObject(wxNullBitmap);
+        if (m_panCache_bmp) delete m_panCache_bmp;
+        m_panCache_bmp = new wxBitmap(bmpX, bmpY);
+        m_panCache_dc.SelectObject(*m_panCache_bmp);
+    }
+    wxMemoryDC &dc = panning ? m_panCache_dc : m_layerCache_dc;
+
+    // Draw background:
+    dc.SetPen( *wxTRANSPARENT_PEN );
+    wxBrush brush( GetBackgroundColour() );
+    dc.SetBrush( brush );
+    dc.SetTextForeground(m_fgColour);
+    dc.DrawRectangle(0,0,m_scrX,m_scrY);
+
+    // Draw all the layers, except info boxes which are drawn at each paint event:
+    m_layerCache_versions.clear();
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+    {
+        if (!(*li)->IsInfo() && (!panning || mpIsScrollableLayer(*li)))
+            (*li)->Plot(dc, *this);
+        m_layerCache_versions.push_back(std::make_pair(*li, (*li)->GetDataVersion()));
+    }
+    if (panning)
+    {
+        m_layerCache_dc.Blit(0, 0, m_scrX, m_scrY, &m_panCache_dc, 0, 0);
+        m_layerCache_dc.SetTextForeground(m_fgColour);
+        for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+        {
+            if (!(*li)->IsInfo() && !mpIsScrollableLayer(*li))
+                (*li)->Plot(m_layerCache_dc, *this);
+        }
+    }
+    m_panCacheValid = panning;
+
+    // Save the state used for this rendering
+    m_layerCache_size[0] = m_scrX;
+    m_layerCache_size[1] = m_scrY;
+    m_layerCache_view[0] = m_posX;
+    m_layerCache_view[1] = m_posY;
+    m_layerCache_view[2] = m_scaleX;
+    m_layerCache_view[3] = m_scaleY;
+    m_layerCache_margins[0] = m_marginTop;
+    m_layerCache_margins[1] = m_marginRight;
+    m_layerCache_margins[2] = m_marginBottom;
+    m_layerCache_margins[3] = m_marginLeft;
+    m_layerCache_bg = GetBackgroundColour();
+    m_layerCache_fg = m_fgColour;
+    m_layerCacheValid = true;
+#ifdef MATHPLOT_DO_LOGGING
+    wxLogMessage(_("[mpWindow::RenderLayerCache] rendered %d layers at %ix%i"), (int)m_layers.size(), m_scrX, m_scrY);
+#endif
+}
+
+bool mpWindow::ScrollLayerCache()
+{
+    if (!m_panCacheValid || m_panCache_bmp == NULL || !IsLayerCacheValid(false))
+        return false;
+
+    // Shift of the plot since the cached rendering; moves which are not whole pixels are rendered again
+    const double fdx = (m_layerCache_view[0] - m_posX) * m_scaleX;
+    const double fdy = (m_posY - m_layerCache_view[1]) * m_scaleY;
+    const int dx = (int) floor(fdx + 0.5);
+    const int dy = (int) floor(fdy + 0.5);
+    if (fabs(fdx - dx) > 1e-3 || fabs(fdy - dy) > 1e-3)
+        return false;
+    if (abs(dx) >= m_scrX || abs(dy) >= m_scrY)
+        return false;
+
+    // Shift the plot layers image into the static layers cache, used as scratch
+    const int w = m_scrX - abs(dx);
+    const int h = m_scrY - abs(dy);
+    m_layerCache_dc.Blit(dx > 0 ? dx : 0, dy > 0 ? dy : 0, w, h, &m_panCache_dc, dx < 0 ? -dx : 0, dy < 0 ? -dy : 0);
+
+    // Only the plot area still covered by the shifted image is up to date: layers are clipped to the
+    // margins, so everything else (exposed strips and margins) is rendered again
+    wxRect plotArea(m_marginLeft, m_marginTop, m_scrX - m_marginLeft - m_marginRight, m_scrY - m_marginTop - m_marginBottom);
+    wxRect valid(plotArea);
+    valid.Offset(dx, dy);
+    valid.Intersect(plotArea);
+    wxRegion exposed(0, 0, m_scrX, m_scrY);
+    exposed.Subtract(valid);
+
+    m_layerCache_dc.SetDeviceClippingRegion(exposed);
+    m_layerCache_dc.SetPen( *wxTRANSPARENT_PEN );
+    wxBrush brush( GetBackgroundColour() );
+    m_layerCache_dc.SetBrush( brush );
+    m_layerCache_dc.SetTextForeground(m_fgColour);
+    m_layerCache_dc.DrawRectangle(0,0,m_scrX,m_scrY);
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+    {
+        if (!(*li)->IsInfo() && mpIsScrollableLayer(*li))
+            (*li)->Plot(m_layerCache_dc, *this);
+    }
+    m_layerCache_dc.DestroyClippingRegion();
+    m_panCache_dc.Blit(0, 0, m_scrX, m_scrY, &m_layerCache_dc, 0, 0);
+
+    // Axes and other layers anchored to the window are drawn on top at each frame
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+    {
+        if (!(*li)->IsInfo() && !mpIsScrollableLayer(*li))
+            (*li)->Plot(m_layerCache_dc, *this);
+    }
+
+    m_layerCache_view[0] = m_posX;
+    m_layerCache_view[1] = m_posY;
+#ifdef MATHPLOT_DO_LOGGING
+    wxLogMessage(_("[mpWindow::ScrollLayerCache] scrolled by %i,%i"), dx, dy);
+#endif
+    return true;
+}
+
+void mpWindow::OnPanTimer(wxTimerEvent& WXUNUSED(event))
+{
+    // Bring the cache to the current position: scroll it if possible, otherwise render it for scrolling
+    // next time. UpdateAll then only has to paint it.
+    if (m_enableLayerCache && m_updateBatchLevel == 0 && !ScrollLayerCache())
+        RenderLayerCache(TRUE);
+    UpdateAll();
+}
+
+// void mpWindow::OnScroll2(wxScrollWinEvent &event)
+// {
+// #ifdef MATHPLOT_DO_LOGGING
+//     wxLogMessage(_("[mpWindow::OnScroll2] Init: m_posX=%f m_posY=%f, sc_pos = %d"),m_posX,m_posY, event.GetPosition());
+// #endif
+//     // If scrollbars are not enabled, Skip operation
+//     if (!m_enableScrollBars) {
+//         event.Skip();
+//         return;
+//     }
+// //     m_scrollX = (int) floor((m_posX - m_minX)*m_scaleX);
+// //     m_scrollY = (int) floor((m_maxY - m_posY /*- m_minY*/)*m_scaleY);
+// //     Scroll(m_scrollX, m_scrollY);
+// 
+// //     GetClientSize( &m_scrX, &m_scrY);
+//     //Scroll(x2p(m_desiredXmin), y2p(m_desiredYmin));
+//     int pixelStep = 1;
+//     if (event.GetOrientation() == wxHORIZONTAL) {
+//         //m_desiredXmin -= (m_scrollX - event.GetPosition())/m_scaleX;
+//         //m_desiredXmax -= (m_scrollX - event.GetPosition())/m_scaleX;
+//         m_posX -= (m_scrollX - event.GetPosition())/m_scaleX;
+//         m_scrollX = event.GetPosition();
+//     }
+//     Fit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax);
+// // /*    int pixelStep = 1;
+// //     if (event.GetOrientation() == wxHORIZONTAL) {
+// //         m_posX 		-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
+// // 	m_desiredXmax 	-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
+// // 	m_desiredXmin 	-= (px - event.GetPosition())/m_scaleX;//(pixelStep/m_scaleX);
+// //         //SetPosX( (double)px / GetScaleX() + m_minX + (double)(width>>1)/GetScaleX());
+// // //         m_posX = p2x(px); //m_minX + (double)(px /*+ (m_scrX)*/)/GetScaleX();
+// //     } else {
+// //         m_posY 		+= (py - event.GetPosition())/m_scaleY;//(pixelStep/m_scaleY);
+// // 	m_desiredYmax	+= (py - event.GetPosition())/m_scaleY;//(pixelStep/m_scaleY);
 // // 	m_desiredYmax	+= (py - event.GetPosition())/m_scaleY;//(pixelStep/m_scaleY);
 // //         //SetPosY( m_maxY - (double)py / GetScaleY() - (double)(height>>1)/GetScaleY());
 // //         //m_posY = m_maxY - (double)py / GetScaleY() - (double)(height>>1)/GetScaleY();
@@ -2022,46 +2714,98 @@ void mpWindow::SetMPScrollbars(bool status)
 //     Refresh(false);*/
 };
 
-bool mpWindow::UpdateBBox()
+bool mpWindow::LayerIntersects(mpLayer* layer, const wxRegion& region)
+{
+    if (layer->IsInfo())
+    {
+        // The box border is drawn on the rectangle edges
+        wxRect rect = ((mpInfoLayer*) layer)->GetRectangle();
+        rect.Inflate(1);
+        return region.Contains(rect) != wxOutRegion;
+    }
+    if (!wxDynamicCast(layer, mpFXY) || !layer->HasBBox())
+        return TRUE;
+
+    // Compare in plot units, so that far away bounding boxes do not overflow pixel coordinates.
+    // The slack covers the pen width and the layer name, drawn next to the plotted points.
+    const int slack = 32 + layer->GetPen().GetWidth();
+    const wxRect box = region.GetBox();
+    const double x0 = p2x(box.GetLeft() - slack);
+    const double x1 = p2x(box.GetRight() + slack);
+    const double y0 = p2y(box.GetBottom() + slack);
+    const double y1 = p2y(box.GetTop() - slack);
+    return !(layer->GetMaxX() < x0 || layer->GetMinX() > x1 || layer->GetMaxY() < y0 || layer->GetMinY() > y1);
+}
+
+mpLayerBBox mpWindow::ReadLayerBBox(mpLayer* layer)
+{
+    mpLayerBBox box;
+    box.version = layer->GetDataVersion();
+    box.hasBBox = layer->HasBBox();
+    box.minX = box.maxX = box.minY = box.maxY = 0;
+    if (box.hasBBox)
+    {
+        box.minX = layer->GetMinX();
+        box.maxX = layer->GetMaxX();
+        box.minY = layer->GetMinY();
+        box.maxY = layer->GetMaxY();
+    }
+    return box;
+}
+
+void mpWindow::MergeBBoxes()
 {
     bool first = TRUE;
 
-    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+    for (mpLayerBBoxList::iterator bi = m_layerBBoxes.begin(); bi != m_layerBBoxes.end(); bi++)
     {
-        mpLayer* f = *li;
+        if (!bi->hasBBox)
+            continue;
+        if (first)
+        {
+            first = FALSE;
+            m_minX = bi->minX;
+            m_maxX = bi->maxX;
+            m_minY = bi->minY;
+            m_maxY = bi->maxY;
+        }
+        else
+        {
+            if (bi->minX < m_minX) m_minX = bi->minX;
+            if (bi->maxX > m_maxX) m_maxX = bi->maxX;
+            if (bi->minY < m_minY) m_minY = bi->minY;
+            if (bi->maxY > m_maxY) m_maxY = bi->maxY;
+        }
+    }
+    m_bboxValid = (first == FALSE);
+    m_bboxDirty = FALSE;
+}
 
-        if (f->HasBBox())
+bool mpWindow::UpdateBBox()
+{
+    // Nothing changed in any layer since last time: the cached box is still good.
+    // This is the case of pan, zoom and mouse moves.
+    unsigned long globalVersion = mpLayer::GetGlobalDataVersion();
+    if (!m_bboxDirty && globalVersion == m_bboxGlobalVersion)
+        return m_bboxValid;
+
+    // Query again only the layers whose data version changed
+    for (size_t i = 0; i < m_layers.size(); i++)
+    {
+        if (m_layerBBoxes[i].version != m_layers[i]->GetDataVersion())
         {
-            if (first)
-            {
-                first = FALSE;
-                m_minX = f->GetMinX(); 
-								m_maxX=f->GetMaxX();
-                m_minY = f->GetMinY(); 
-								m_maxY=f->GetMaxY();
-            }
-            else
-            {
-                if (f->GetMinX() < m_minX) {
-									m_minX=f->GetMinX();
-								}
-								if (f->GetMaxX() > m_maxX) {
-									m_maxX=f->GetMaxX();
-								}
-                if (f->GetMinY() < m_minY) {
-									m_minY=f->GetMinY();
-								}
-								if (f->GetMaxY() > m_maxY) {
-									m_maxY=f->GetMaxY();
-								}
-            }
+            m_layerBBoxes[i] = ReadLayerBBox(m_layers[i]);
+            m_bboxDirty = TRUE;
         }
-        //node = node->GetNext();
     }
+    m_bboxGlobalVersion = globalVersion;
+    if (m_bboxDirty)
+        MergeBBoxes();
+
 #ifdef MATHPLOT_DO_LOGGING
 	wxLogDebug(wxT("[mpWindow::UpdateBBox] Bounding box: Xmin = %f, Xmax = %f, Ymin = %f, YMax = %f"), m_minX, m_maxX, m_minY, m_maxY);
 #endif // MATHPLOT_DO_LOGGING
-    return first == FALSE;
+    return m_bboxValid;
 }
 
 // void mpWindow::UpdateAll()
@@ -2120,6 +2864,13 @@ bool mpWindow::UpdateBBox()
 
 void mpWindow::UpdateAll()
 {
+	// Inside an update batch: remember the request, it will be satisfied by EndUpdateBatch
+	if (m_updateBatchLevel > 0)
+	{
+		m_updatePending = TRUE;
+		return;
+	}
+
 	if (UpdateBBox())
     {
         if (m_enableScrollBars)
@@ -2160,6 +2911,18 @@ void mpWindow::UpdateAll()
     Refresh( FALSE );
 }
 
+void mpWindow::EndUpdateBatch()
+{
+    if (m_updateBatchLevel <= 0)
+        return;
+    m_updateBatchLevel--;
+    if (m_updateBatchLevel == 0 && m_updatePending)
+    {
+        m_updatePending = FALSE;
+        UpdateAll();
+    }
+}
+
 void mpWindow::DoScrollCalc    (const int position, const int orientation)
 {
     if (orientation == wxVERTICAL)
@@ -2273,34 +3036,6 @@ void mpWindow::SetScaleX(double scaleX)
     UpdateAll();
 }
 
-// New methods implemented by Davide Rondini
-
-unsigned int mpWindow::CountLayers()
-{
-    //wxNode *node = m_layers.GetFirst();
-    unsigned int layerNo = 0;
-    for(wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)//while(node)
-    	{
-        if ((*li)->HasBBox()) layerNo++;
-	// node = node->GetNext();
-    	};
-    return layerNo;
-}
-
-mpLayer* mpWindow::GetLayer(int position)
-{
-    if ((position >= (int) m_layers.size()) || position < 0) return NULL;
-    return m_layers[position];
-}
-
-mpLayer* mpWindow::GetLayerByName( const wxString &name)
-{
-    for (wxLayerList::iterator it=m_layers.begin();it!=m_layers.end();it++)
-        if (! (*it)->GetName().Cmp( name ) )
-            return *it;
-    return NULL;    // Not found
-}
-
 void mpWindow::GetBoundingBox(double* bbox)
 {
 	bbox[0] = m_minX;
@@ -2311,69 +3046,25 @@ void mpWindow::GetBoundingBox(double* bbox)
 
 bool mpWindow::SaveScreenshot(const wxString& filename, int type, wxSize imageSize, bool fit)
 {
-	int sizeX, sizeY;
-	int bk_scrX, bk_scrY;
+	// Draw off-screen with the same layers and view settings, so that the window itself is not touched
+	mpImageRenderer renderer;
 	if (imageSize == wxDefaultSize) {
-		sizeX = m_scrX;
-		sizeY = m_scrY;
+		renderer.SetSize(m_scrX, m_scrY);
 	} else {
-		sizeX = imageSize.x;
-		sizeY = imageSize.y;
-		bk_scrX = m_scrX;
-		bk_scrY = m_scrY;
-		SetScr(sizeX, sizeY);
+		renderer.SetSize(imageSize.x, imageSize.y);
 	}
-
-	wxBitmap screenBuffer(sizeX,sizeY);
-	wxMemoryDC screenDC;
-	screenDC.SelectObject(screenBuffer);
-	// screenDC.SetPen( *wxTRANSPARENT_PEN );
-	screenDC.SetPen( *wxWHITE_PEN );
-	screenDC.SetTextForeground(m_fgColour);
-	wxBrush brush( GetBackgroundColour() );
-	screenDC.SetBrush( brush );
-	screenDC.DrawRectangle(0,0,sizeX,sizeY);
-
-	if (fit) {
-		Fit(m_minX, m_maxX, m_minY, m_maxY, &sizeX, &sizeY);
+	renderer.SetMargins(m_marginTop, m_marginRight, m_marginBottom, m_marginLeft);
+	renderer.LockAspect(m_lockaspect);
+	renderer.SetColourTheme(GetBackgroundColour(), m_fgColour, m_axColour); // before adding layers: their pens are left untouched
+	for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+		renderer.AddLayer(*li);
+
+	if (fit && UpdateBBox()) {
+		renderer.Fit(m_minX, m_maxX, m_minY, m_maxY);
 	} else {
-		Fit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax, &sizeX, &sizeY);
+		renderer.Fit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax);
 	}
-    // Draw all the layers:
-    wxLayerList::iterator li;
-    for (li = m_layers.begin(); li != m_layers.end(); li++) {
-    	(*li)->Plot(screenDC, *this);
-			// DEBUG
-// 			wxString layerTypeName;
-// 			if ((*li)->GetLayerType() == mpLAYER_PLOT) {
-// 				layerTypeName = wxT("Plot");
-// 			} else if ((*li)->GetLayerType() == mpLAYER_AXIS) {
-// 				layerTypeName = wxT("Axis");
-// 			} else if ((*li)->GetLayerType() == mpLAYER_INFO) {
-// 				layerTypeName = wxT("Info");
-// 			}	else {
-// 				layerTypeName = wxT("Undefined");
-// 			}
-// 			wxLogMessage(_("Layer %s (%s): color %s"), (*li)->GetName(), layerTypeName.c_str(), (*li)->GetPen().GetColour().GetAsString().c_str());
-		}
-
-		if (imageSize != wxDefaultSize) {
-			// Restore dimensions
-			SetScr(bk_scrX, bk_scrY);
-			Fit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax, &bk_scrX, &bk_scrY);
-			UpdateAll();
-		}
-    // Once drawing is complete, actually save screen shot
-    wxImage screenImage = screenBuffer.ConvertToImage();
-    return screenImage.SaveFile(filename, (wxBitmapType) type);
-}
-
-void mpWindow::SetMargins(int top, int right, int bottom, int left)
-{
-    m_marginTop = top;
-    m_marginRight = right;
-    m_marginBottom = bottom;
-    m_marginLeft = left;
+	return renderer.SaveFile(filename, (wxBitmapType) type);
 }
 
 mpInfoLayer* mpWindow::IsInsideInfoLayer(wxPoint& point)
@@ -2504,6 +3195,141 @@ wxCoord mpWindow::y2p(double y, bool drawOutside)
 */
 
 
+//-----------------------------------------------------------------------------
+// mpImageRenderer
+//-----------------------------------------------------------------------------
+
+mpImageRenderer::mpImageRenderer(int width, int height)
+{
+    m_scrX = width > 0 ? width : 1;
+    m_scrY = height > 0 ? height : 1;
+    m_bgColour = *wxWHITE;
+    m_fgColour = *wxBLACK;
+    m_axColour = *wxBLACK;
+    ComputeFit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax);
+}
+
+mpImageRenderer::~mpImageRenderer()
+{
+    DelAllLayers();
+}
+
+void mpImageRenderer::AddLayer(mpLayer* layer, bool takeOwnership)
+{
+    if (layer == NULL) return;
+    m_layers.push_back(layer);
+    if (takeOwnership) m_ownedLayers.push_back(layer);
+}
+
+void mpImageRenderer::DelAllLayers()
+{
+    for (std::vector<mpLayer*>::iterator li = m_ownedLayers.begin(); li != m_ownedLayers.end(); li++)
+        delete *li;
+    m_ownedLayers.clear();
+    m_layers.clear();
+}
+
+void mpImageRenderer::SetSize(int width, int height)
+{
+    m_scrX = width > 0 ? width : 1;
+    m_scrY = height > 0 ? height : 1;
+    ComputeFit(m_desiredXmin, m_desiredXmax, m_desiredYmin, m_desiredYmax);
+}
+
+void mpImageRenderer::SetColourTheme(const wxColour& bgColour, const wxColour& drawColour, const wxColour& axesColour)
+{
+    m_bgColour = bgColour;
+    m_fgColour = drawColour;
+    m_axColour = axesColour;
+    // same as mpWindow::SetColourTheme: only the pen colour is changed, not style or width
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++) {
+        if ((*li)->GetLayerType() == mpLAYER_AXIS) {
+            wxPen axisPen = (*li)->GetPen();
+            axisPen.SetColour(axesColour);
+            (*li)->SetPen(axisPen);
+        }
+        if ((*li)->GetLayerType() == mpLAYER_INFO) {
+            wxPen infoPen = (*li)->GetPen();
+            infoPen.SetColour(drawColour);
+            (*li)->SetPen(infoPen);
+        }
+    }
+}
+
+bool mpImageRenderer::Fit()
+{
+    double minX, maxX, minY, maxY;
+    if (!ComputeLayersBBox(minX, maxX, minY, maxY)) return false;
+    ComputeFit(minX, maxX, minY, maxY);
+    return true;
+}
+
+void mpImageRenderer::Draw(wxDC& dc)
+{
+    // Draw background. No stock GDI objects here: their reference count is not thread safe and
+    // the renderer may be used outside of the GUI thread.
+    dc.SetPen( wxPen(m_bgColour) );
+    wxBrush brush( m_bgColour );
+    dc.SetBrush( brush );
+    dc.SetTextForeground( m_fgColour );
+    dc.DrawRectangle(0, 0, m_scrX, m_scrY);
+
+    // Draw all the layers:
+    for (wxLayerList::iterator li = m_layers.begin(); li != m_layers.end(); li++)
+        (*li)->Plot(dc, *this);
+}
+
+bool mpImageRenderer::Render(wxImage& image)
+{
+#if wxUSE_GRAPHICS_CONTEXT
+    // Draw directly on the image pixels: no native bitmap is involved, so this works without a display
+    image.Create(m_scrX, m_scrY, false);
+    if (!image.IsOk()) return false;
+    wxGraphicsContext* gc = wxGraphicsContext::Create(image);
+    if (gc != NULL)
+    {
+        wxGCDC gcdc(gc); // Takes ownership of gc, the image is updated when gcdc is destroyed
+        Draw(gcdc);
+        return true;
+    }
+#endif
+    // Fallback: draw on a memory bitmap and convert it
+    wxBitmap bitmap(m_scrX, m_scrY);
+    if (!bitmap.IsOk()) return false;
+    {
+        wxMemoryDC dc(bitmap);
+        Draw(dc);
+    }
+    image = bitmap.ConvertToImage();
+    return image.IsOk();
+}
+
+bool mpImageRenderer::RenderRGBA(std::vector<unsigned char>& rgba)
+{
+    wxImage image;
+    if (!Render(image)) return false;
+
+    const int npixels = image.GetWidth() * image.GetHeight();
+    const unsigned char* rgb = image.GetData();
+    const unsigned char* alpha = image.HasAlpha() ? image.GetAlpha() : NULL;
+    rgba.resize(npixels * 4);
+    for (int i = 0; i < npixels; i++)
+    {
+        rgba[4*i  ] = rgb[3*i  ];
+        rgba[4*i+1] = rgb[3*i+1];
+        rgba[4*i+2] = rgb[3*i+2];
+        rgba[4*i+3] = alpha ? alpha[i] : 255;
+    }
+    return true;
+}
+
+bool mpImageRenderer::SaveFile(const wxString& filename, wxBitmapType type)
+{
+    wxImage image;
+    if (!Render(image)) return false;
+    return image.SaveFile(filename, type);
+}
+
 //-----------------------------------------------------------------------------
 // mpFXYVector implementation - by Jose Luis Blanco (AGO-2007)
 //-----------------------------------------------------------------------------
@@ -2514,6 +3340,8 @@ IMPLEMENT_DYNAMIC_CLASS(mpFXYVector, mpFXY)
 mpFXYVector::mpFXYVector(wxString name, int flags ) : mpFXY(name,flags)
 {
     m_index = 0;
+    m_sortedX = TRUE;
+    m_orderVersion = 0;
     m_minX  = -1;
     m_maxX  = 1;
     m_minY  = -1;
@@ -2542,6 +3370,8 @@ void mpFXYVector::Clear()
 {
     m_xs.clear();
     m_ys.clear();
+    m_sortedX = TRUE;
+    DataChanged();
 }
 
 void mpFXYVector::SetData( const std::vector<double> &xs,const std::vector<double> &ys)
@@ -2554,6 +3384,9 @@ void mpFXYVector::SetData( const std::vector<double> &xs,const std::vector<doubl
     // Copy the data:
     m_xs = xs;
     m_ys = ys;
+    m_sortedX = TRUE;
+    for (size_t i = 1; m_sortedX && i < m_xs.size(); i++)
+        m_sortedX = (m_xs[i] >= m_xs[i - 1]);
 
 
     // Update internal variables for the bounding box.
@@ -2588,6 +3421,448 @@ void mpFXYVector::SetData( const std::vector<double> &xs,const std::vector<doubl
         m_minY  = -1;
         m_maxY  = 1;
     }
+    DataChanged();
+}
+
+void mpFXYVector::AppendData( const std::vector<double> &xs,const std::vector<double> &ys)
+{
+	if (xs.size() != ys.size()) {
+		wxLogError(_("wxMathPlot error: X and Y vector are not of the same length!"));
+		return;
+	}
+	if (xs.empty())
+		return;
+	if (m_xs.empty()) {
+		SetData(xs, ys);
+		return;
+	}
+
+	for (size_t i = 0; m_sortedX && i < xs.size(); i++)
+		m_sortedX = (xs[i] >= (i ? xs[i - 1] : m_xs.back()));
+	m_xs.insert(m_xs.end(), xs.begin(), xs.end());
+	m_ys.insert(m_ys.end(), ys.begin(), ys.end());
+
+	// Extend the bounding box (which keeps the same 0.5 padding as SetData) by the new points only
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		if (xs[i] - 0.5 < m_minX) m_minX = xs[i] - 0.5;
+		if (xs[i] + 0.5 > m_maxX) m_maxX = xs[i] + 0.5;
+		if (ys[i] - 0.5 < m_minY) m_minY = ys[i] - 0.5;
+		if (ys[i] + 0.5 > m_maxY) m_maxY = ys[i] + 0.5;
+	}
+	DataChanged();
+}
+
+bool mpFXYVector::GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2)
+{
+	if (m_sortedX)
+		return mpNearestSortedPoint(w, pos, radius, m_xs.size(),
+			[this](size_t i) { return m_xs[i]; }, [this](size_t i) { return m_ys[i]; }, x, y, dist2);
+
+	// Unsorted data: search through the points indexes sorted by X, rebuilt only when the data changes
+	if (m_order.size() != m_xs.size() || m_orderVersion != GetDataVersion()) {
+		m_order.resize(m_xs.size());
+		for (size_t i = 0; i < m_order.size(); i++)
+			m_order[i] = i;
+		const std::vector<double> &xs = m_xs;
+		std::sort(m_order.begin(), m_order.end(), [&xs](size_t a, size_t b) { return xs[a] < xs[b]; });
+		m_orderVersion = GetDataVersion();
+	}
+	return mpNearestSortedPoint(w, pos, radius, m_order.size(),
+		[this](size_t i) { return m_xs[m_order[i]]; }, [this](size_t i) { return m_ys[m_order[i]]; }, x, y, dist2);
+}
+
+//-----------------------------------------------------------------------------
+// mpFXYRingBuffer implementation
+//-----------------------------------------------------------------------------
+
+IMPLEMENT_DYNAMIC_CLASS(mpFXYRingBuffer, mpFXY)
+
+mpFXYRingBuffer::mpFXYRingBuffer(wxString name, size_t capacity, int flags) : mpFXY(name, flags)
+{
+	m_capacity = capacity > 0 ? capacity : 1;
+	m_xs.resize(m_capacity);
+	m_ys.resize(m_capacity);
+	m_head = 0;
+	m_count = 0;
+	m_index = 0;
+	m_seqHead = 0;
+	m_sortedX = TRUE;
+	m_type = mpLAYER_PLOT;
+}
+
+void mpFXYRingBuffer::SetCapacity(size_t capacity)
+{
+	if (capacity == 0)
+		capacity = 1;
+	if (capacity == m_capacity)
+		return;
+
+	// Keep the newest points, in order, at the start of the new storage
+	std::vector<double> xs, ys;
+	const size_t keep = m_count < capacity ? m_count : capacity;
+	xs.reserve(keep);
+	ys.reserve(keep);
+	for (size_t i = m_count - keep; i < m_count; i++) {
+		xs.push_back(m_xs[Slot(i)]);
+		ys.push_back(m_ys[Slot(i)]);
+	}
+
+	m_capacity = capacity;
+	m_xs.assign(m_capacity, 0);
+	m_ys.assign(m_capacity, 0);
+	m_head = 0;
+	m_count = 0;
+	m_minX.clear();
+	m_maxX.clear();
+	m_minY.clear();
+	m_maxY.clear();
+	for (size_t i = 0; i < keep; i++)
+		Push(xs[i], ys[i]);
+	DataChanged();
+}
+
+void mpFXYRingBuffer::Push(double x, double y)
+{
+	if (m_count == m_capacity)
+		PopFront();
+	if (m_count > 0 && x < m_xs[Slot(m_count - 1)])
+		m_sortedX = FALSE;
+
+	const size_t slot = Slot(m_count);
+	m_xs[slot] = x;
+	m_ys[slot] = y;
+	const unsigned long long seq = m_seqHead + m_count;
+	m_count++;
+
+	// Drop the queue entries that can never be an extreme again: they are older and not better than the new point
+	while (!m_minX.empty() && m_minX.back().value >= x) m_minX.pop_back();
+	while (!m_maxX.empty() && m_maxX.back().value <= x) m_maxX.pop_back();
+	while (!m_minY.empty() && m_minY.back().value >= y) m_minY.pop_back();
+	while (!m_maxY.empty() && m_maxY.back().value <= y) m_maxY.pop_back();
+	Extreme ex = { seq, x };
+	Extreme ey = { seq, y };
+	m_minX.push_back(ex);
+	m_maxX.push_back(ex);
+	m_minY.push_back(ey);
+	m_maxY.push_back(ey);
+}
+
+void mpFXYRingBuffer::PopFront()
+{
+	if (m_count == 0)
+		return;
+
+	// The evicted point can only be at the front of the queues
+	if (!m_minX.empty() && m_minX.front().seq == m_seqHead) m_minX.pop_front();
+	if (!m_maxX.empty() && m_maxX.front().seq == m_seqHead) m_maxX.pop_front();
+	if (!m_minY.empty() && m_minY.front().seq == m_seqHead) m_minY.pop_front();
+	if (!m_maxY.empty() && m_maxY.front().seq == m_seqHead) m_maxY.pop_front();
+
+	m_head = (m_head + 1) % m_capacity;
+	m_count--;
+	m_seqHead++;
+}
+
+void mpFXYRingBuffer::Append(double x, double y)
+{
+	Push(x, y);
+	DataChanged();
+}
+
+void mpFXYRingBuffer::AppendData(const std::vector<double> &xs, const std::vector<double> &ys)
+{
+	if (xs.size() != ys.size()) {
+		wxLogError(_("wxMathPlot error: X and Y vector are not of the same length!"));
+		return;
+	}
+	if (xs.empty())
+		return;
+	for (size_t i = 0; i < xs.size(); i++)
+		Push(xs[i], ys[i]);
+	DataChanged();
+}
+
+size_t mpFXYRingBuffer::EvictBefore(double xMin)
+{
+	size_t evicted = 0;
+	while (m_count > 0 && m_xs[m_head] < xMin) {
+		PopFront();
+		evicted++;
+	}
+	if (evicted > 0)
+		DataChanged();
+	return evicted;
+}
+
+void mpFXYRingBuffer::Clear()
+{
+	m_head = 0;
+	m_seqHead += m_count;
+	m_count = 0;
+	m_sortedX = TRUE;
+	m_minX.clear();
+	m_maxX.clear();
+	m_minY.clear();
+	m_maxY.clear();
+	DataChanged();
+}
+
+void mpFXYRingBuffer::Rewind()
+{
+	m_index = 0;
+}
+
+bool mpFXYRingBuffer::GetNextXY(double & x, double & y)
+{
+	if (m_index >= m_count)
+		return FALSE;
+	const size_t slot = Slot(m_index++);
+	x = m_xs[slot];
+	y = m_ys[slot];
+	return TRUE;
+}
+
+bool mpFXYRingBuffer::GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2)
+{
+	if (!m_sortedX)
+		return mpFXY::GetNearestPoint(w, pos, radius, x, y, dist2);
+	return mpNearestSortedPoint(w, pos, radius, m_count,
+		[this](size_t i) { return m_xs[Slot(i)]; }, [this](size_t i) { return m_ys[Slot(i)]; }, x, y, dist2);
+}
+
+//-----------------------------------------------------------------------------
+// mpFXYPyramid implementation
+//-----------------------------------------------------------------------------
+
+IMPLEMENT_DYNAMIC_CLASS(mpFXYPyramid, mpFXY)
+
+mpFXYPyramid::mpFXYPyramid(wxString name, int flags) : mpFXY(name, flags)
+{
+	m_minX = -1;
+	m_maxX = 1;
+	m_minY = -1;
+	m_maxY = 1;
+	m_envelope = TRUE;
+	m_level = -1;
+	m_first = 0;
+	m_last = 0;
+	m_index = 0;
+	m_second = FALSE;
+	m_type = mpLAYER_PLOT;
+
+	// 1 hour, 6 hours, 1 day and 1 week for X in seconds
+	std::vector<double> widths;
+	widths.push_back(3600);
+	widths.push_back(6 * 3600);
+	widths.push_back(86400);
+	widths.push_back(7 * 86400);
+	SetLevels(widths);
+}
+
+void mpFXYPyramid::SetLevels(const std::vector<double> &widths)
+{
+	std::vector<double> sorted(widths);
+	std::sort(sorted.begin(), sorted.end());
+	m_levels.clear();
+	for (size_t i = 0; i < sorted.size(); i++) {
+		if (sorted[i] <= 0)
+			continue;
+		mpLodLevel level;
+		level.width = sorted[i];
+		m_levels.push_back(level);
+	}
+	Rebuild();
+}
+
+void mpFXYPyramid::SetData(const std::vector<double> &xs, const std::vector<double> &ys)
+{
+	if (xs.size() != ys.size()) {
+		wxLogError(_("wxMathPlot error: X and Y vector are not of the same length!"));
+		return;
+	}
+	m_xs = xs;
+	m_ys = ys;
+	Rebuild();
+}
+
+void mpFXYPyramid::AppendData(const std::vector<double> &xs, const std::vector<double> &ys)
+{
+	if (xs.size() != ys.size()) {
+		wxLogError(_("wxMathPlot error: X and Y vector are not of the same length!"));
+		return;
+	}
+	if (xs.empty())
+		return;
+
+	const bool wasEmpty = m_xs.empty();
+	bool ordered = wasEmpty || (xs[0] >= m_xs.back());
+	for (size_t i = 1; ordered && i < xs.size(); i++)
+		ordered = (xs[i] >= xs[i - 1]);
+
+	m_xs.insert(m_xs.end(), xs.begin(), xs.end());
+	m_ys.insert(m_ys.end(), ys.begin(), ys.end());
+	if (ordered) {
+		for (size_t i = 0; i < xs.size(); i++)
+			AddToLevels(xs[i], ys[i], wasEmpty && i == 0);
+		DataChanged();
+	} else {
+		Rebuild();
+	}
+}
+
+void mpFXYPyramid::Clear()
+{
+	m_xs.clear();
+	m_ys.clear();
+	Rebuild();
+}
+
+void mpFXYPyramid::AddToLevels(double x, double y, bool first)
+{
+	if (first) {
+		m_minX = x - 0.5;
+		m_maxX = x + 0.5;
+		m_minY = y - 0.5;
+		m_maxY = y + 0.5;
+	} else {
+		// Same 0.5 padding as mpFXYVector
+		if (x - 0.5 < m_minX) m_minX = x - 0.5;
+		if (x + 0.5 > m_maxX) m_maxX = x + 0.5;
+		if (y - 0.5 < m_minY) m_minY = y - 0.5;
+		if (y + 0.5 > m_maxY) m_maxY = y + 0.5;
+	}
+
+	for (size_t i = 0; i < m_levels.size(); i++) {
+		mpLodLevel &level = m_levels[i];
+		const double start = floor(x / level.width) * level.width;
+		if (level.buckets.empty() || level.buckets.back().start != start) {
+			mpLodBucket bucket = { start, y, y, y, 1 };
+			level.buckets.push_back(bucket);
+		} else {
+			mpLodBucket &bucket = level.buckets.back();
+			if (y < bucket.min) bucket.min = y;
+			if (y > bucket.max) bucket.max = y;
+			bucket.sum += y;
+			bucket.count++;
+		}
+	}
+}
+
+void mpFXYPyramid::Rebuild()
+{
+	// Sort the points by X if needed, keeping the order of equal X
+	bool ordered = TRUE;
+	for (size_t i = 1; ordered && i < m_xs.size(); i++)
+		ordered = (m_xs[i] >= m_xs[i - 1]);
+	if (!ordered) {
+		std::vector<size_t> order(m_xs.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		const std::vector<double> &xs = m_xs;
+		std::stable_sort(order.begin(), order.end(), [&xs](size_t a, size_t b) { return xs[a] < xs[b]; });
+		std::vector<double> sortedX(m_xs.size()), sortedY(m_ys.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			sortedX[i] = m_xs[order[i]];
+			sortedY[i] = m_ys[order[i]];
+		}
+		m_xs.swap(sortedX);
+		m_ys.swap(sortedY);
+	}
+
+	for (size_t i = 0; i < m_levels.size(); i++)
+		m_levels[i].buckets.clear();
+	m_minX = -1;
+	m_maxX = 1;
+	m_minY = -1;
+	m_maxY = 1;
+
+	// The first point replaces the default bounding box
+	for (size_t i = 0; i < m_xs.size(); i++)
+		AddToLevels(m_xs[i], m_ys[i], i == 0);
+	DataChanged();
+}
+
+static bool mpLodBucketBefore(const mpLodBucket &bucket, double x)
+{
+	return bucket.start < x;
+}
+
+void mpFXYPyramid::Plot(wxDC & dc, mpView & w)
+{
+	if (!m_visible)
+		return;
+
+	// Coarsest level whose buckets are at most one pixel wide
+	m_level = -1;
+	for (size_t i = m_levels.size(); i-- > 0; ) {
+		if (m_levels[i].width * w.GetScaleX() <= 1.0) {
+			m_level = (int)i;
+			break;
+		}
+	}
+
+	// Visible range, with one item more on each side so that lines reach the plot borders
+	const double xFrom = w.p2x(m_drawOutsideMargins ? 0 : w.GetMarginLeft());
+	const double xTo = w.p2x(m_drawOutsideMargins ? w.GetScrX() : w.GetScrX() - w.GetMarginRight());
+	size_t count;
+	if (m_level < 0) {
+		count = m_xs.size();
+		m_first = std::lower_bound(m_xs.begin(), m_xs.end(), xFrom) - m_xs.begin();
+		m_last = std::upper_bound(m_xs.begin(), m_xs.end(), xTo) - m_xs.begin();
+	} else {
+		const mpLodLevel &level = m_levels[m_level];
+		count = level.buckets.size();
+		m_first = std::lower_bound(level.buckets.begin(), level.buckets.end(), xFrom - level.width, mpLodBucketBefore) - level.buckets.begin();
+		m_last = std::lower_bound(level.buckets.begin(), level.buckets.end(), xTo, mpLodBucketBefore) - level.buckets.begin();
+	}
+	if (m_first > 0)
+		m_first--;
+	if (m_last < count)
+		m_last++;
+
+	mpFXY::Plot(dc, w);
+}
+
+bool mpFXYPyramid::GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2)
+{
+	return mpNearestSortedPoint(w, pos, radius, m_xs.size(),
+		[this](size_t i) { return m_xs[i]; }, [this](size_t i) { return m_ys[i]; }, x, y, dist2);
+}
+
+void mpFXYPyramid::Rewind()
+{
+	m_index = m_first;
+	m_second = FALSE;
+}
+
+bool mpFXYPyramid::GetNextXY(double & x, double & y)
+{
+	if (m_index >= m_last)
+		return FALSE;
+
+	if (m_level < 0) {
+		x = m_xs[m_index];
+		y = m_ys[m_index++];
+		return TRUE;
+	}
+
+	// Buckets are drawn at their center: min then max for the envelope, or the mean
+	const mpLodLevel &level = m_levels[m_level];
+	const mpLodBucket &bucket = level.buckets[m_index];
+	x = bucket.start + level.width / 2;
+	if (!m_envelope) {
+		y = bucket.Mean();
+		m_index++;
+	} else if (!m_second) {
+		y = bucket.min;
+		m_second = TRUE;
+	} else {
+		y = bucket.max;
+		m_second = FALSE;
+		m_index++;
+	}
+	return TRUE;
 }
 
 //-----------------------------------------------------------------------------
@@ -2621,7 +3896,7 @@ mpText::mpText( wxString name, int offsetx, int offsety )
 This implementation will plot the text adjusted to the visible area.
 */
 
-void mpText::Plot(wxDC & dc, mpWindow & w)
+void mpText::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen(m_pen);
@@ -2767,9 +4042,10 @@ void mpMovableObject::ShapeUpdated()
             if (*itYo > m_bbox_max_y) m_bbox_max_y = *itYo;
         }
     }
+    DataChanged();
 }
 
-void mpMovableObject::Plot(wxDC & dc, mpWindow & w)
+void mpMovableObject::Plot(wxDC & dc, mpView & w)
 {
 	if (m_visible) {
 		dc.SetPen( m_pen);
@@ -2993,12 +4269,133 @@ void mpPolygon::setPoints(
 //-----------------------------------------------------------------------------
 // mpBitmapLayer - provided by Jose Luis Blanco
 //-----------------------------------------------------------------------------
+// Size in pixels of the tiles of mpBitmapLayer pyramid levels
+#define mpBITMAP_TILE_SIZE  256
+
+// Maximum number of tiles kept by an mpBitmapLayer (each one holds up to two bitmaps of mpBITMAP_TILE_SIZE^2 pixels)
+#define mpBITMAP_TILE_CACHE_SIZE  256
+
+struct mpBitmapTileQueue
+{
+    /** A tile to scale: its pixels are copied, so that no wxImage is shared between threads. */
+    struct Job
+    {
+        unsigned long generation;
+        unsigned long long key;
+        int srcWidth, srcHeight, dstWidth, dstHeight;
+        std::vector<unsigned char> rgb, alpha;
+    };
+
+    std::mutex mutex;           //!< Protects jobs, results, working, notified and stopping
+    std::deque<Job> jobs;       //!< Tiles waiting to be scaled, replaced at each Plot by the visible ones
+    std::deque<Job> results;    //!< Scaled tiles (dst size in srcWidth/srcHeight), collected by the next Plot
+    bool working;               //!< A worker thread is running
+    bool notified;              //!< A repaint has been requested and not yet handled
+    bool stopping;              //!< The owner layer is being destroyed: the worker must exit without notifying
+
+    // Used on the GUI thread only:
+    mpBitmapLayer* layer;       //!< The owner layer, reset when it is destroyed
+    wxWeakRef<wxWindow> window; //!< The window the layer was last plotted in
+    std::thread worker;         //!< The last started worker, joined before starting another one and by the layer destructor
+
+    mpBitmapTileQueue() : working(false), notified(false), stopping(false), layer(NULL) {}
+};
+
+// Scales the queued tiles until the queue is empty, then asks the window to plot the layer again
+static void mpBitmapTileWorker(std::shared_ptr<mpBitmapTileQueue> queue)
+{
+    for (;;)
+    {
+        mpBitmapTileQueue::Job job;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->jobs.empty() || queue->stopping)
+            {
+                queue->working = false;
+                return;
+            }
+            job = std::move(queue->jobs.front());
+            queue->jobs.pop_front();
+        }
+
+        // Both images only live in this thread: the source uses the job buffers, the scaled one is copied out
+        mpBitmapTileQueue::Job result;
+        {
+            wxImage src(job.srcWidth, job.srcHeight, &job.rgb[0], true);
+            if (!job.alpha.empty())
+                src.SetAlpha(&job.alpha[0], true);
+            wxImage scaled = src.Scale(job.dstWidth, job.dstHeight, wxIMAGE_QUALITY_HIGH);
+            const size_t pixels = (size_t)job.dstWidth * job.dstHeight;
+            result.generation = job.generation;
+            result.key = job.key;
+            result.srcWidth = result.dstWidth = job.dstWidth;
+            result.srcHeight = result.dstHeight = job.dstHeight;
+            result.rgb.assign(scaled.GetData(), scaled.GetData() + pixels * 3);
+            if (scaled.HasAlpha())
+                result.alpha.assign(scaled.GetAlpha(), scaled.GetAlpha() + pixels);
+        }
+
+        bool notify;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->stopping)
+            {
+                queue->working = false;
+                return;
+            }
+            queue->results.push_back(std::move(result));
+            notify = !queue->notified;
+            queue->notified = true;
+        }
+        if (notify && wxTheApp)
+        {
+            wxTheApp->CallAfter([queue]() {
+                {
+                    std::lock_guard<std::mutex> lock(queue->mutex);
+                    queue->notified = false;
+                }
+                // New tiles change the layer rendering: invalidate the cached frame and repaint
+                if (queue->layer)
+                    queue->layer->DataChanged();
+                mpWindow* win = wxDynamicCast(queue->window.get(), mpWindow);
+                if (win)
+                    win->UpdateAll();
+            });
+        }
+    }
+}
+
+mpBitmapLayer::mpBitmapLayer()
+{
+    m_min_x = m_max_x =
+    m_min_y = m_max_y = 0;
+    m_validImg = false;
+    m_type = mpLAYER_BITMAP;
+    m_frame = 0;
+    m_generation = 0;
+    m_tileQueue = std::make_shared<mpBitmapTileQueue>();
+    m_tileQueue->layer = this;
+}
+
+mpBitmapLayer::~mpBitmapLayer()
+{
+    // Stop the worker after its current tile and wait for it, so that no thread outlives the layer
+    // (a pending repaint request keeps the queue alive, but does not reach this layer anymore)
+    m_tileQueue->layer = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_tileQueue->mutex);
+        m_tileQueue->stopping = true;
+        m_tileQueue->jobs.clear();
+    }
+    if (m_tileQueue->worker.joinable())
+        m_tileQueue->worker.join();
+}
+
 void mpBitmapLayer::GetBitmapCopy( wxImage &outBmp ) const
 {
     if (m_validImg)
         outBmp = m_bitmap;
 }
-
 void mpBitmapLayer::SetBitmap( const wxImage &inBmp, double x, double y, double lx, double ly )
 {
     if (!inBmp.Ok())
@@ -3013,96 +4410,188 @@ void mpBitmapLayer::SetBitmap( const wxImage &inBmp, double x, double y, double
         m_max_x = x+lx;
         m_max_y = y+ly;
         m_validImg = true;
+
+        // Build the mip-map pyramid, down to a single tile
+        m_levels.clear();
+        m_levels.push_back(m_bitmap);
+        while (m_levels.back().GetWidth() > mpBITMAP_TILE_SIZE || m_levels.back().GetHeight() > mpBITMAP_TILE_SIZE)
+        {
+            const wxImage &last = m_levels.back();
+            if (last.GetWidth() < 2 || last.GetHeight() < 2)
+                break;
+            m_levels.push_back(last.ShrinkBy(2, 2));
+        }
+
+        // Forget the tiles of the previous bitmap, including the ones being scaled
+        m_tiles.clear();
+        m_generation++;
+        {
+            std::lock_guard<std::mutex> lock(m_tileQueue->mutex);
+            m_tileQueue->jobs.clear();
+            m_tileQueue->results.clear();
+        }
+        DataChanged();
+    }
+}
+
+void mpBitmapLayer::CollectScaledTiles()
+{
+    std::deque<mpBitmapTileQueue::Job> results;
+    {
+        std::lock_guard<std::mutex> lock(m_tileQueue->mutex);
+        results.swap(m_tileQueue->results);
+    }
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        mpBitmapTileQueue::Job &r = results[i];
+        std::map<unsigned long long, mpBitmapTile>::iterator it = m_tiles.find(r.key);
+        if (r.generation != m_generation || it == m_tiles.end())
+            continue;
+        wxImage img(r.dstWidth, r.dstHeight, &r.rgb[0], true);
+        if (!r.alpha.empty())
+            img.SetAlpha(&r.alpha[0], true);
+        it->second.scaled = wxBitmap(img);
+    }
+}
+
+void mpBitmapLayer::TrimTiles()
+{
+    if (m_tiles.size() <= mpBITMAP_TILE_CACHE_SIZE)
+        return;
+    std::vector< std::pair<unsigned long, unsigned long long> > ages;
+    for (std::map<unsigned long long, mpBitmapTile>::iterator it = m_tiles.begin(); it != m_tiles.end(); it++)
+    {
+        if (it->second.lastUsed != m_frame)
+            ages.push_back(std::make_pair(it->second.lastUsed, it->first));
     }
+    std::sort(ages.begin(), ages.end());
+    for (size_t i = 0; i < ages.size() && m_tiles.size() > mpBITMAP_TILE_CACHE_SIZE; i++)
+        m_tiles.erase(ages[i].second);
 }
 
+void mpBitmapLayer::DrawStretched(wxDC & dc, mpBitmapTile & tile, const wxImage & level, const wxRect & src, const wxRect & dst)
+{
+    if (!tile.source.IsOk())
+        tile.source = wxBitmap(level.GetSubImage(src));
+    wxMemoryDC srcDc;
+    srcDc.SelectObjectAsSource(tile.source);
+    dc.StretchBlit(dst.x, dst.y, dst.width, dst.height, &srcDc, 0, 0, src.width, src.height, wxCOPY, true);
+    srcDc.SelectObject(wxNullBitmap);
+}
 
-void mpBitmapLayer::Plot(wxDC & dc, mpWindow & w)
+void mpBitmapLayer::Plot(wxDC & dc, mpView & w)
 {
     if (m_visible && m_validImg)
     {
-	/*	1st: We compute (x0,y0)-(x1,y1), the pixel coordinates of the real outer limits
-		     of the image rectangle within the (screen) mpWindow. Note that these coordinates 
-		     might fall well far away from the real view limits when the user zoom in.
-
-		2nd: We compute (dx0,dy0)-(dx1,dy1), the pixel coordinates the rectangle that will 
-		     be actually drawn into the mpWindow, i.e. the clipped real rectangle that 
-		     avoids the non-visible parts. (offset_x,offset_y) are the pixel coordinates
-		     that correspond to the window point (dx0,dy0) within the image "m_bitmap", and
-		     (b_width,b_height) is the size of the bitmap patch that will be drawn.
-
-	(x0,y0) .................  (x1,y0)
-	    .                          .
-	    .                          .
-	(x0,y1) ................   (x1,y1)
-                  (In pixels!!)
-	*/
-
-	// 1st step -------------------------------
-        wxCoord x0 = w.x2p(m_min_x);
-        wxCoord y0 = w.y2p(m_max_y);
-        wxCoord x1 = w.x2p(m_max_x);
-        wxCoord y1 = w.y2p(m_min_y);
-
-	// 2nd step -------------------------------
-	// Precompute the size of the actual bitmap pixel on the screen (e.g. will be >1 if zoomed in)
-	double screenPixelX = ( x1-x0 ) / (double)m_bitmap.GetWidth();
-	double screenPixelY = ( y1-y0 ) / (double)m_bitmap.GetHeight();
-
-	// The minimum number of pixels that the streched image will overpass the actual mpWindow borders:
-	wxCoord borderMarginX = (wxCoord)(screenPixelX+1); // ceil
-	wxCoord borderMarginY = (wxCoord)(screenPixelY+1); // ceil
-
-	// The actual drawn rectangle (dx0,dy0)-(dx1,dy1) is (x0,y0)-(x1,y1) clipped:
-	wxCoord dx0=x0,dx1=x1,dy0=y0,dy1=y1;
-	if (dx0<0) dx0=-borderMarginX;
-	if (dy0<0) dy0=-borderMarginY;
-	if (dx1>w.GetScrX()) dx1=w.GetScrX()+borderMarginX;
-	if (dy1>w.GetScrY()) dy1=w.GetScrY()+borderMarginY;
-
-	// For convenience, compute the width/height of the rectangle to be actually drawn:
-	wxCoord d_width = dx1-dx0+1;
-	wxCoord d_height = dy1-dy0+1;
-
-	// Compute the pixel offsets in the internally stored bitmap:
-	wxCoord offset_x= (wxCoord) ( (dx0-x0)/screenPixelX );
-	wxCoord offset_y= (wxCoord) ( (dy0-y0)/screenPixelY );
-
-	// and the size in pixel of the area to be actually drawn from the internally stored bitmap:
-	wxCoord b_width  = (wxCoord) ( (dx1-dx0+1)/screenPixelX );
-	wxCoord b_height = (wxCoord) ( (dy1-dy0+1)/screenPixelY );
-
-	#ifdef MATHPLOT_DO_LOGGING
-		wxLogMessage(_("[mpBitmapLayer::Plot] screenPixel: x=%f y=%f  d_width=%ix%i"),screenPixelX,screenPixelY,d_width,d_height);
-		wxLogMessage(_("[mpBitmapLayer::Plot] offset: x=%i y=%i  bmpWidth=%ix%i"),offset_x,offset_y,b_width,b_height);
-	#endif
-
-	// Is there any visible region?
-	if (d_width>0 && d_height>0) 
-	{
-		// Build the scaled bitmap from the image, only if it has changed:
-		if (m_scaledBitmap.GetWidth()!=d_width || 
-		    m_scaledBitmap.GetHeight()!=d_height || 
-		    m_scaledBitmap_offset_x != offset_x ||
-		    m_scaledBitmap_offset_y != offset_y  )
-		{
-			wxRect r(wxRect(offset_x,offset_y,b_width,b_height));
-			// Just for the case....
-			if (r.x<0) r.x=0;
-			if (r.y<0) r.y=0;
-			if (r.width>m_bitmap.GetWidth()) r.width=m_bitmap.GetWidth();
-			if (r.height>m_bitmap.GetHeight()) r.height=m_bitmap.GetHeight();
-
-			m_scaledBitmap = wxBitmap( 
-				wxBitmap(m_bitmap).GetSubBitmap( r ).ConvertToImage()
-				.Scale(d_width,d_height) );
-			m_scaledBitmap_offset_x = offset_x;
-			m_scaledBitmap_offset_y = offset_y;
-		}
+        m_frame++;
+        CollectScaledTiles();
 
-		// Draw it:
-		dc.DrawBitmap( m_scaledBitmap, dx0,dy0, true );
-	}
+        // Screen position and size of the whole image, in floating point: far away borders would overflow wxCoord
+        const double X0 = (m_min_x - w.GetPosX()) * w.GetScaleX();
+        const double Y0 = (w.GetPosY() - m_max_y) * w.GetScaleY();
+        const double spanX = (m_max_x - m_min_x) * w.GetScaleX();
+        const double spanY = (m_max_y - m_min_y) * w.GetScaleY();
+
+        if (spanX > 0 && spanY > 0)
+        {
+            // Coarsest level whose pixels are not larger than screen pixels (level 0 when zoomed in)
+            const double pixel = spanX / m_levels[0].GetWidth();
+            size_t levelIndex = 0;
+            while (levelIndex + 1 < m_levels.size() && pixel * (2 << levelIndex) <= 1.0)
+                levelIndex++;
+            const wxImage &level = m_levels[levelIndex];
+            const int lw = level.GetWidth();
+            const int lh = level.GetHeight();
+            const double px = spanX / lw; // Screen pixels per level pixel
+            const double py = spanY / lh;
+            const bool magnified = (px > 1.0 || py > 1.0);
+
+            // Visible level pixels, then visible tiles
+            int u0 = (int) floor(-X0 / px), u1 = (int) ceil((w.GetScrX() - X0) / px);
+            int v0 = (int) floor(-Y0 / py), v1 = (int) ceil((w.GetScrY() - Y0) / py);
+            u0 = u0 < 0 ? 0 : u0;  u1 = u1 > lw ? lw : u1;
+            v0 = v0 < 0 ? 0 : v0;  v1 = v1 > lh ? lh : v1;
+
+            // In a window, missing tiles are scaled in the background; off-screen renderings wait for them
+            mpWindow* win = dynamic_cast<mpWindow*>(&w);
+            std::deque<mpBitmapTileQueue::Job> jobs;
+
+            for (int ty = v0 / mpBITMAP_TILE_SIZE; u0 < u1 && v0 < v1 && ty <= (v1 - 1) / mpBITMAP_TILE_SIZE; ty++)
+            {
+                for (int tx = u0 / mpBITMAP_TILE_SIZE; tx <= (u1 - 1) / mpBITMAP_TILE_SIZE; tx++)
+                {
+                    const wxRect src(tx * mpBITMAP_TILE_SIZE, ty * mpBITMAP_TILE_SIZE,
+                        wxMin(mpBITMAP_TILE_SIZE, lw - tx * mpBITMAP_TILE_SIZE), wxMin(mpBITMAP_TILE_SIZE, lh - ty * mpBITMAP_TILE_SIZE));
+                    // Tile borders are rounded the same way for neighbour tiles, so that they join exactly
+                    const wxCoord sx0 = (wxCoord) floor(X0 + src.GetLeft() * px);
+                    const wxCoord sx1 = (wxCoord) floor(X0 + (src.GetRight() + 1) * px);
+                    const wxCoord sy0 = (wxCoord) floor(Y0 + src.GetTop() * py);
+                    const wxCoord sy1 = (wxCoord) floor(Y0 + (src.GetBottom() + 1) * py);
+                    const wxRect dst(sx0, sy0, sx1 - sx0, sy1 - sy0);
+                    if (dst.width <= 0 || dst.height <= 0)
+                        continue;
+
+                    mpBitmapTile &tile = m_tiles[TileKey((int)levelIndex, tx, ty)];
+                    tile.lastUsed = m_frame;
+
+                    // Magnified pixels: stretching is both the fastest and the expected look
+                    if (magnified)
+                    {
+                        DrawStretched(dc, tile, level, src, dst);
+                        continue;
+                    }
+                    if (!tile.scaled.IsOk() || tile.scaled.GetWidth() != dst.width || tile.scaled.GetHeight() != dst.height)
+                    {
+                        if (win == NULL)
+                        {
+                            tile.scaled = wxBitmap(level.GetSubImage(src).Scale(dst.width, dst.height, wxIMAGE_QUALITY_HIGH));
+                        }
+                        else
+                        {
+                            mpBitmapTileQueue::Job job;
+                            job.generation = m_generation;
+                            job.key = TileKey((int)levelIndex, tx, ty);
+                            job.srcWidth = src.width;
+                            job.srcHeight = src.height;
+                            job.dstWidth = dst.width;
+                            job.dstHeight = dst.height;
+                            const wxImage sub = level.GetSubImage(src);
+                            job.rgb.assign(sub.GetData(), sub.GetData() + (size_t)src.width * src.height * 3);
+                            if (sub.HasAlpha())
+                                job.alpha.assign(sub.GetAlpha(), sub.GetAlpha() + (size_t)src.width * src.height);
+                            jobs.push_back(std::move(job));
+                            DrawStretched(dc, tile, level, src, dst);
+                            continue;
+                        }
+                    }
+                    dc.DrawBitmap(tile.scaled, dst.x, dst.y, true);
+                }
+            }
+
+            // The queue holds the tiles missing in this frame only: tiles scrolled out of view are not scaled anymore
+            if (win != NULL)
+            {
+                m_tileQueue->window = win;
+                bool start = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_tileQueue->mutex);
+                    m_tileQueue->jobs.swap(jobs);
+                    if (!m_tileQueue->jobs.empty() && !m_tileQueue->working)
+                    {
+                        m_tileQueue->working = true;
+                        start = true;
+                    }
+                }
+                if (start)
+                {
+                    // The previous worker has already left its loop (working was false): joining it does not block
+                    if (m_tileQueue->worker.joinable())
+                        m_tileQueue->worker.join();
+                    m_tileQueue->worker = std::thread(mpBitmapTileWorker, m_tileQueue);
+                }
+            }
+        }
+        TrimTiles();
     }
 
     // Draw the name label
@@ -75,9 +75,15 @@
 #include <wx/string.h>
 #include <wx/print.h>
 #include <wx/image.h>
+#include <wx/overlay.h>
+#include <wx/timer.h>
 
 
 #include <deque>
+#include <ctime>
+#include <atomic>
+#include <map>
+#include <memory>
 
 // For memory leak debug
 #ifdef _WINDOWS
@@ -99,6 +105,13 @@
 #define mpX_UTCTIME	0x20
 #define mpX_RAWTIME	mpX_UTCTIME
 
+/** Thread safe replacement of localtime/gmtime, which return a pointer to a buffer shared by all threads.
+    @param when Time to convert
+    @param local Convert to local time if true, to UTC otherwise
+    @param out Broken-down time
+    @return true on success */
+WXDLLIMPEXP_MATHPLOT bool mpConvertTime(time_t when, bool local, struct tm &out);
+
 //-----------------------------------------------------------------------------
 // classes
 //-----------------------------------------------------------------------------
@@ -110,7 +123,9 @@ class WXDLLIMPEXP_MATHPLOT mpFXY;
 class WXDLLIMPEXP_MATHPLOT mpFXYVector;
 class WXDLLIMPEXP_MATHPLOT mpScaleX;
 class WXDLLIMPEXP_MATHPLOT mpScaleY;
+class WXDLLIMPEXP_MATHPLOT mpView;
 class WXDLLIMPEXP_MATHPLOT mpWindow;
+class WXDLLIMPEXP_MATHPLOT mpImageRenderer;
 class WXDLLIMPEXP_MATHPLOT mpText;
 class WXDLLIMPEXP_MATHPLOT mpPrintout;
 
@@ -122,7 +137,8 @@ enum
     mpID_ZOOM_OUT,      //!< Zoom out
     mpID_CENTER,        //!< Center view on click position
     mpID_LOCKASPECT,    //!< Lock x/y scaling aspect
-    mpID_HELP_MOUSE     //!< Shows information about the mouse commands
+    mpID_HELP_MOUSE,    //!< Shows information about the mouse commands
+    mpID_PAN_TIMER      //!< Timer coalescing the repaints while panning
 };
 
 //-----------------------------------------------------------------------------
@@ -193,9 +209,9 @@ public:
 
     /** Plot given view of layer to the given device context.
         An implementation of this function has to transform layer coordinates to
-        wxDC coordinates based on the view parameters retrievable from the mpWindow
-        passed in \a w. 
-	Note that the public methods of mpWindow: x2p,y2p and p2x,p2y are already provided 
+        wxDC coordinates based on the view parameters retrievable from the mpView
+        passed in \a w, which is either a mpWindow or a mpImageRenderer.
+	Note that the public methods of mpView: x2p,y2p and p2x,p2y are already provided 
 	which transform layer coordinates to DC pixel coordinates, and <b>user code should rely 
 	on them</b> for portability and future changes to be applied transparently, instead of
 	implementing the following formulas manually.
@@ -221,18 +237,18 @@ public:
 
         <b> Rules for transformation between mpLayer and wxDC coordinates </b>
         @code
-        dc_X = (layer_X - mpWindow::GetPosX()) * mpWindow::GetScaleX()
-        dc_Y = (mpWindow::GetPosY() - layer_Y) * mpWindow::GetScaleY() // swapping Y-orientation
+        dc_X = (layer_X - mpView::GetPosX()) * mpView::GetScaleX()
+        dc_Y = (mpView::GetPosY() - layer_Y) * mpView::GetScaleY() // swapping Y-orientation
 
-        layer_X = (dc_X / mpWindow::GetScaleX()) + mpWindow::GetPosX() // scale guaranteed to be not 0
-        layer_Y = mpWindow::GetPosY() - (dc_Y / mpWindow::GetScaleY()) // swapping Y-orientation
+        layer_X = (dc_X / mpView::GetScaleX()) + mpView::GetPosX() // scale guaranteed to be not 0
+        layer_Y = mpView::GetPosY() - (dc_Y / mpView::GetScaleY()) // swapping Y-orientation
         @endcode
 
         @param dc Device context to plot to.
         @param w  View to plot. The visible area can be retrieved from this object.
-	@sa mpWindow::p2x,mpWindow::p2y,mpWindow::x2p,mpWindow::y2p
+	@sa mpView::p2x,mpView::p2y,mpView::x2p,mpView::y2p
     */
-    virtual void   Plot(wxDC & dc, mpWindow & w) = 0;
+    virtual void   Plot(wxDC & dc, mpView & w) = 0;
 
     /** Get layer name.
         @return Name
@@ -252,7 +268,7 @@ public:
     /** Set the 'continuity' property of the layer (true:draws a continuous line, false:draws separate points).
       * @sa GetContinuity
       */
-    void SetContinuity(bool continuity) {m_continuous = continuity;}
+    void SetContinuity(bool continuity) {m_continuous = continuity; DataChanged();}
 
     /** Gets the 'continuity' property of the layer.
       * @sa SetContinuity
@@ -261,26 +277,26 @@ public:
 
     /** Shows or hides the text label with the name of the layer (default is visible).
       */
-    void ShowName(bool show) { m_showName = show; };
+    void ShowName(bool show) { m_showName = show; DataChanged(); };
 
     /** Set layer name
         @param name Name, will be copied to internal class member
     */
-    void SetName(wxString name) { m_name = name; }
+    void SetName(wxString name) { m_name = name; DataChanged(); }
 
     /** Set layer font
         @param font Font, will be copied to internal class member
     */
-    void SetFont(wxFont& font)  { m_font = font; }
+    void SetFont(wxFont& font)  { m_font = font; DataChanged(); }
 
     /** Set layer pen
         @param pen Pen, will be copied to internal class member
     */
-    void SetPen(wxPen pen)     { m_pen  = pen;  }
+    void SetPen(wxPen pen)     { m_pen  = pen; DataChanged(); }
 
     /** Set Draw mode: inside or outside margins. Default is outside, which allows the layer to draw up to the mpWindow border.
         @param drawModeOutside The draw mode to be set */
-    void SetDrawOutsideMargins(bool drawModeOutside) { m_drawOutsideMargins = drawModeOutside; };
+    void SetDrawOutsideMargins(bool drawModeOutside) { m_drawOutsideMargins = drawModeOutside; DataChanged(); };
 
     /** Get Draw mode: inside or outside margins.
         @return The draw mode */
@@ -301,7 +317,7 @@ public:
 
     /** Sets layer visibility.
         @param show visibility bool. */
-    void SetVisible(bool show) { m_visible = show; };
+    void SetVisible(bool show) { m_visible = show; DataChanged(); };
 	
 	/** Get brush set for this layer.
 		@return brush. */
@@ -309,7 +325,24 @@ public:
 	
 	/** Set layer brush
 		@param brush brush, will be copied to internal class member	*/
-	void SetBrush(wxBrush brush) { m_brush = brush; };
+	void SetBrush(wxBrush brush) { m_brush = brush; DataChanged(); };
+
+    /** Get the data version of the layer. The version is incremented every time the data or the
+        appearance of the layer changes, so that mpWindow can tell whether cached renderings of the layer are still valid.
+        @return The current version counter
+        @sa DataChanged */
+    unsigned long GetDataVersion() const { return m_dataVersion; };
+
+    /** Notify that the data (or the appearance) of the layer has changed. Setters of mpLayer and of the provided
+        implementations call it automatically; derived classes whose output depends on external state must call it
+        whenever that state changes, otherwise mpWindow will keep showing the cached rendering.
+        @sa GetDataVersion */
+    void DataChanged() { m_dataVersion++; ms_globalDataVersion++; };
+
+    /** Get a counter which is incremented every time any layer calls DataChanged. It allows mpWindow to find out
+        in constant time whether any cached information about its layers may be out of date.
+        @return The global version counter */
+    static unsigned long GetGlobalDataVersion() { return ms_globalDataVersion; };
 
 protected:
     wxFont   m_font;    //!< Layer's font
@@ -321,6 +354,8 @@ protected:
     bool     m_drawOutsideMargins; //!< select if the layer should draw only inside margins or over all DC
     mpLayerType m_type; //!< Define layer type, which is assigned by constructor
 	bool 	m_visible;	//!< Toggles layer visibility
+    unsigned long m_dataVersion; //!< Incremented whenever layer data or appearance changes
+    static std::atomic<unsigned long> ms_globalDataVersion; //!< Incremented whenever any layer data or appearance changes
     DECLARE_DYNAMIC_CLASS(mpLayer)
 };
 
@@ -361,7 +396,7 @@ public:
         @param dc the device content where to plot
         @param w the window to plot
         @sa mpLayer::Plot */
-    virtual void   Plot(wxDC & dc, mpWindow & w);
+    virtual void   Plot(wxDC & dc, mpView & w);
 
     /** Specifies that this is an Info box layer.
         @return always \a TRUE
@@ -426,7 +461,7 @@ public:
         @param dc the device content where to plot
         @param w the window to plot
         @sa mpLayer::Plot */
-    virtual void   Plot(wxDC & dc, mpWindow & w);
+    virtual void   Plot(wxDC & dc, mpView & w);
 		
     /** Set X axis label view mode.
         @param mode mpX_NORMAL for normal labels, mpX_TIME for time axis in hours, minutes, seconds. */
@@ -438,6 +473,43 @@ protected:
 		unsigned int m_timeConv;
 };
 
+/** @class mpInfoNearest
+    @brief Implements an overlay box which shows the plotted point nearest to the mouse.
+    When the mouse moves over the mpWindow, the box reports the name of the layer, the X (formatted according to
+    the label mode, e.g. as a date) and the Y of the nearest point of all the visible mpFXY layers, if it lies within
+    a radius in pixels. Layers are queried with mpFXY::GetNearestPoint, which only scans the points near the mouse
+    for layers with sorted X (mpFXYVector, mpFXYRingBuffer, mpFXYPyramid). */
+class WXDLLIMPEXP_MATHPLOT mpInfoNearest : public mpInfoCoords
+{
+public:
+    /** Default constructor */
+    mpInfoNearest();
+    /** Complete constructor, setting initial rectangle and background brush.
+        @param rect The initial bounding rectangle.
+        @param brush The wxBrush to be used for box background: default is transparent */
+    mpInfoNearest(wxRect rect, const wxBrush* brush = wxTRANSPARENT_BRUSH);
+
+    /** Set the maximum distance, in pixels, between the mouse and the reported point (default 10). */
+    void SetRadius(int radius) { m_radius = radius; }
+
+    /** Finds the point nearest to the mouse.
+        @param w parent mpWindow from which to obtain information
+        @param event The event which called the update. */
+    virtual void UpdateInfo(mpWindow& w, wxEvent& event);
+
+    /** Plot method: draws the box only when a point is near the mouse, one line of text per item.
+        @param dc the device content where to plot
+        @param w the window to plot
+        @sa mpLayer::Plot */
+    virtual void Plot(wxDC & dc, mpView & w);
+
+protected:
+    /** Formats an X value according to the label mode. */
+    wxString FormatX(double xVal);
+
+    int m_radius; //!< Search radius in pixels
+};
+
 /** @class mpInfoLegend
     @brief Implements the legend to be added to the plot
     This layer allows you to add a legend to describe the plots in the window. The legend uses the layer name as a label, and displays only layers of type mpLAYER_PLOT. */
@@ -465,7 +537,7 @@ public:
         @param dc the device content where to plot
         @param w the window to plot
         @sa mpLayer::Plot */
-    virtual void   Plot(wxDC & dc, mpWindow & w);
+    virtual void   Plot(wxDC & dc, mpView & w);
 		
 		/** Swith item mode, which is the element on the left of text representing the plot line.
 		 * @param mode The item draw mode: mpLEGEND_LINE or mpLEGEND_SQUARE. */
@@ -531,6 +603,37 @@ protected:
 /** @name mpLayer implementations - functions
 @{*/
 
+/** Cache of function values evaluated at consecutive pixel positions of a view, used by mpFX, mpFY and mpProfile.
+    The cache is keyed by the view transform along the sampled axis (position and scale), by the sampled pixel range,
+    and by the layer data version: an unchanged view costs no function evaluations.
+*/
+class WXDLLIMPEXP_MATHPLOT mpSampleCache
+{
+public:
+    mpSampleCache() : m_valid(false), m_pos(0), m_scale(0), m_first(0), m_version(0) {}
+
+    /** Checks whether the cache holds the samples for the given key; if not, resizes the buffers and records the key.
+        @param pos View position along the sampled axis
+        @param scale View scale along the sampled axis
+        @param first First sampled pixel
+        @param count Number of sampled pixels
+        @param version Data version of the layer
+        @return true if the caller must fill m_args and evaluate m_values again */
+    bool Prepare(double pos, double scale, wxCoord first, size_t count, unsigned long version);
+
+    /** Forget the cached samples. */
+    void Invalidate() { m_valid = false; }
+
+    std::vector<double> m_args;   //!< Function arguments, one per sampled pixel
+    std::vector<double> m_values; //!< Function values, one per sampled pixel
+
+private:
+    bool          m_valid;
+    double        m_pos, m_scale;
+    wxCoord       m_first;
+    unsigned long m_version;
+};
+
 /** Abstract base class providing plot and labeling functionality for functions F:X->Y.
     Override mpFX::GetY to implement a function.
     Optionally implement a constructor and pass a name (label) and a label alignment
@@ -551,14 +654,25 @@ public:
     */
     virtual double GetY( double x ) = 0;
 
+    /** Evaluate the function for a batch of arguments: out[i] = GetY(in[i]).
+        The default implementation calls GetY for each argument; override it with a vectorized implementation
+        when the function is expensive. Values are cached per view: if the function depends on some state,
+        call mpLayer::DataChanged when that state changes.
+        @param in Arguments
+        @param out Function values
+        @param n Number of arguments
+    */
+    virtual void EvaluateBatch(const double* in, double* out, size_t n);
+
     /** Layer plot handler.
         This implementation will plot the function in the visible area and
         put a label according to the aligment specified.
     */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
 protected:
     int m_flags; //!< Holds label alignment
+    mpSampleCache m_samples; //!< Function values at the pixels plotted last time
 
     DECLARE_DYNAMIC_CLASS(mpFX)
 };
@@ -583,14 +697,23 @@ public:
     */
     virtual double GetX( double y ) = 0;
 
+    /** Evaluate the function for a batch of arguments: out[i] = GetX(in[i]).
+        See mpFX::EvaluateBatch.
+        @param in Arguments
+        @param out Function values
+        @param n Number of arguments
+    */
+    virtual void EvaluateBatch(const double* in, double* out, size_t n);
+
     /** Layer plot handler.
         This implementation will plot the function in the visible area and
         put a label according to the aligment specified.
     */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
 protected:
     int m_flags; //!< Holds label alignment
+    mpSampleCache m_samples; //!< Function values at the pixels plotted last time
 
     DECLARE_DYNAMIC_CLASS(mpFY)
 };
@@ -625,8 +748,18 @@ public:
         This implementation will plot the locus in the visible area and
         put a label according to the alignment specified.
     */
-    virtual void Plot(wxDC & dc, mpWindow & w);
-
+    virtual void Plot(wxDC & dc, mpView & w);
+
+    /** Finds the point of the layer nearest to a window position, within a radius.
+        This implementation scans all the points; layers with sorted X override it with a binary search.
+        @param w The view the layer is plotted in
+        @param pos Window position, in pixels
+        @param radius Maximum distance, in pixels
+        @param x Returns the X of the nearest point
+        @param y Returns the Y of the nearest point
+        @param dist2 Returns the squared distance of the nearest point, in pixels
+        @return false if no point lies within the radius */
+    virtual bool GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2);
 
 protected:
     int m_flags; //!< Holds label alignment
@@ -665,14 +798,23 @@ public:
     */
     virtual double GetY( double x ) = 0;
 
+    /** Evaluate the function for a batch of arguments: out[i] = GetY(in[i]).
+        See mpFX::EvaluateBatch.
+        @param in Arguments
+        @param out Function values
+        @param n Number of arguments
+    */
+    virtual void EvaluateBatch(const double* in, double* out, size_t n);
+
     /** Layer plot handler.
         This implementation will plot the function in the visible area and
         put a label according to the aligment specified.
     */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
 protected:
     int m_flags; //!< Holds label alignment
+    mpSampleCache m_samples; //!< Function values at the pixels plotted last time
 
     DECLARE_DYNAMIC_CLASS(mpProfile)
 };
@@ -686,6 +828,45 @@ protected:
 /** @name mpLayer implementations - furniture (scales, ...)
 @{*/
 
+/** A tick of an axis with its label, as laid out by mpScaleX and mpScaleY. */
+typedef struct {
+    int      pos;           //!< Tick position along the axis, in pixels
+    wxString label;         //!< Formatted label
+    wxCoord  width, height; //!< Label extent
+} mpAxisTick;
+
+/** Layout of the ticks and labels of an axis, cached between paint events.
+    Computing the layout needs a tick step, a formatted string and a text measurement per tick: mpScaleX and mpScaleY
+    keep it until the view, the font, the label format or the layer data version change.
+*/
+class WXDLLIMPEXP_MATHPLOT mpAxisLayoutCache
+{
+public:
+    mpAxisLayoutCache() : m_labelSize(0), m_nameWidth(0), m_nameHeight(0), m_valid(false) {}
+
+    /** Checks whether the cached layout was computed with the given key, font and user label format. */
+    bool Matches(const std::vector<double>& key, const wxFont& font, const wxString& format) const
+        { return m_valid && m_key == key && m_font == font && m_format == format; }
+
+    /** Record the key, font and user label format the layout is being computed with. */
+    void Store(const std::vector<double>& key, const wxFont& font, const wxString& format)
+        { m_key = key; m_font = font; m_format = format; m_valid = true; }
+
+    /** Forget the cached layout. */
+    void Invalidate() { m_valid = false; }
+
+    std::vector<mpAxisTick> m_ticks;  //!< Ticks (or grid lines) in the visible area
+    std::vector<mpAxisTick> m_labels; //!< Labels to be drawn, not overlapping
+    int     m_labelSize;              //!< Max label height (X axis) or width (Y axis)
+    wxCoord m_nameWidth, m_nameHeight; //!< Extent of the axis name
+
+private:
+    std::vector<double> m_key;
+    wxFont   m_font;
+    wxString m_format;
+    bool     m_valid;
+};
+
 /** Plot layer implementing a x-scale ruler.
     The ruler is fixed at Y=0 in the coordinate system. A label is plotted at
     the bottom-right hand of the ruler. The scale numbering automatically
@@ -703,7 +884,7 @@ public:
 
     /** Layer plot handler.
         This implementation will plot the ruler adjusted to the visible area. */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
     /** Check whether this layer has a bounding box.
         This implementation returns \a FALSE thus making the ruler invisible
@@ -712,11 +893,11 @@ public:
 
     /** Set X axis alignment.
         @param align alignment (choose between mpALIGN_BORDER_BOTTOM, mpALIGN_BOTTOM, mpALIGN_CENTER, mpALIGN_TOP, mpALIGN_BORDER_TOP */
-    void SetAlign(int align) { m_flags = align; };
+    void SetAlign(int align) { m_flags = align; DataChanged(); };
 
     /** Set X axis ticks or grid
         @param ticks TRUE to plot axis ticks, FALSE to plot grid. */
-    void SetTicks(bool ticks) { m_ticks = ticks; };
+    void SetTicks(bool ticks) { m_ticks = ticks; DataChanged(); };
 
     /** Get X axis ticks or grid
         @return TRUE if plot is drawing axis ticks, FALSE if the grid is active. */
@@ -728,11 +909,11 @@ public:
 
     /** Set X axis label view mode.
         @param mode mpX_NORMAL for normal labels, mpX_TIME for time axis in hours, minutes, seconds. */
-    void SetLabelMode(unsigned int mode, unsigned int time_conv = mpX_RAWTIME) { m_labelType = mode; m_timeConv = time_conv; };
+    void SetLabelMode(unsigned int mode, unsigned int time_conv = mpX_RAWTIME) { m_labelType = mode; m_timeConv = time_conv; DataChanged(); };
 	
 	/** Set X axis Label format (used for mpX_NORMAL draw mode).
 	    @param format The format string */
-	void SetLabelFormat(const wxString& format) { m_labelFormat = format; };
+	void SetLabelFormat(const wxString& format) { m_labelFormat = format; DataChanged(); };
 
 	/** Get X axis Label format (used for mpX_NORMAL draw mode).
 	@return The format string */
@@ -744,6 +925,10 @@ protected:
     unsigned int m_labelType; //!< Select labels mode: mpX_NORMAL for normal labels, mpX_TIME for time axis in hours, minutes, seconds
     unsigned int m_timeConv;	//!< Selects if time has to be converted to local time or not.
 	wxString m_labelFormat; //!< Format string used to print labels
+    mpAxisLayoutCache m_layout; //!< Ticks and labels computed at last Plot
+
+    /** Format the label of the tick at \a n, according to the label mode. */
+    wxString FormatLabel(double n, const wxString& fmt);
 
     DECLARE_DYNAMIC_CLASS(mpScaleX)
 };
@@ -764,7 +949,7 @@ public:
     /** Layer plot handler.
         This implementation will plot the ruler adjusted to the visible area.
     */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
     /** Check whether this layer has a bounding box.
         This implementation returns \a FALSE thus making the ruler invisible
@@ -774,11 +959,11 @@ public:
 
     /** Set Y axis alignment.
         @param align alignment (choose between mpALIGN_BORDER_LEFT, mpALIGN_LEFT, mpALIGN_CENTER, mpALIGN_RIGHT, mpALIGN_BORDER_RIGHT) */
-    void SetAlign(int align) { m_flags = align; };
+    void SetAlign(int align) { m_flags = align; DataChanged(); };
 
     /** Set Y axis ticks or grid
         @param ticks TRUE to plot axis ticks, FALSE to plot grid. */
-    void SetTicks(bool ticks) { m_ticks = ticks; };
+    void SetTicks(bool ticks) { m_ticks = ticks; DataChanged(); };
 
     /** Get Y axis ticks or grid
         @return TRUE if plot is drawing axis ticks, FALSE if the grid is active. */
@@ -786,7 +971,7 @@ public:
 	
 	/** Set Y axis Label format.
 	@param format The format string */
-	void SetLabelFormat(const wxString& format) { m_labelFormat = format; };
+	void SetLabelFormat(const wxString& format) { m_labelFormat = format; DataChanged(); };
 	
 	/** Get Y axis Label format.
 	@return The format string */
@@ -796,90 +981,32 @@ protected:
     int m_flags; //!< Flag for axis alignment
     bool m_ticks; //!< Flag to toggle between ticks or grid
 	wxString m_labelFormat; //!< Format string used to print labels
+    mpAxisLayoutCache m_layout; //!< Ticks and labels computed at last Plot
 
     DECLARE_DYNAMIC_CLASS(mpScaleY)
 };
 
 //-----------------------------------------------------------------------------
-// mpWindow
+// mpView
 //-----------------------------------------------------------------------------
 
-/** @name Constants defining mouse modes for mpWindow
-@{*/
-
-/** Mouse panning drags the view. Mouse mode for mpWindow. */
-#define mpMOUSEMODE_DRAG    0
-/** Mouse panning creates a zoom box. Mouse mode for mpWindow. */
-#define mpMOUSEMODE_ZOOMBOX 1
-
-/*@}*/
-/** Define the type for the list of layers inside mpWindow */
+/** Define the type for the list of layers inside mpView */
 //WX_DECLARE_HASH_MAP( int, mpLayer*, wxIntegerHash, wxIntegerEqual, wxLayerList );
 typedef std::deque<mpLayer*> wxLayerList;
 
-/** Canvas for plotting mpLayer implementations.
-
-    This class defines a zoomable and moveable 2D plot canvas. Any number
-    of mpLayer implementations (scale rulers, function plots, ...) can be
-    attached using mpWindow::AddLayer.
-
-    The canvas window provides a context menu with actions for navigating the view.
-    The context menu can be retrieved with mpWindow::GetPopupMenu, e.g. for extending it
-    externally.
-
-    Since wxMathPlot version 0.03, the mpWindow incorporates the following features:
-        - DoubleBuffering (Default=disabled): Can be set with EnableDoubleBuffer
-        - Mouse based pan/zoom (Default=enabled): Can be set with EnableMousePanZoom.
-
-    The mouse commands can be visualized by the user through the popup menu, and are:
-        - Mouse Move+CTRL: Pan (Move)
-        - Mouse Wheel: Vertical scroll
-        - Mouse Wheel+SHIFT: Horizontal scroll
-        - Mouse Wheel UP+CTRL: Zoom in
-        - Mouse Wheel DOWN+CTRL: Zoom out
+/** View state shared by all the targets mpLayer implementations can be plotted on.
 
+    mpView holds the list of layers and the view transformation (position, scale, screen size
+    and margins) that layers read in mpLayer::Plot. It has no dependency on wxWindow, so the same
+    layers can be drawn either on screen by mpWindow or off-screen by mpImageRenderer.
+    The view does not own the layers: it is up to the derived class to delete them.
 */
-class WXDLLIMPEXP_MATHPLOT mpWindow : public wxWindow
+class WXDLLIMPEXP_MATHPLOT mpView
 {
 public:
-    mpWindow() {}
-    mpWindow( wxWindow *parent, wxWindowID id,
-                     const wxPoint &pos = wxDefaultPosition,
-                     const wxSize &size = wxDefaultSize,
-                     long flags = 0);
-    ~mpWindow();
-
-    /** Get reference to context menu of the plot canvas.
-        @return Pointer to menu. The menu can be modified.
-    */
-    wxMenu* GetPopupMenu() { return &m_popmenu; }
-
-    /** Add a plot layer to the canvas.
-        @param layer Pointer to layer. The mpLayer object will get under control of mpWindow,
-                     i.e. it will be delete'd on mpWindow destruction
-        @param refreshDisplay States whether to refresh the display (UpdateAll) after adding the layer.
-        @retval TRUE Success
-        @retval FALSE Failure due to out of memory.
-    */
-    bool AddLayer( mpLayer* layer, bool refreshDisplay = true);
-
-    /** Remove a plot layer from the canvas.
-        @param layer Pointer to layer. The mpLayer object will be destructed using delete.
-        @param alsoDeleteObject If set to true, the mpLayer object will be also "deleted", not just removed from the internal list.
-        @param refreshDisplay States whether to refresh the display (UpdateAll) after removing the layer.
-        @return true if layer is deleted correctly
-
-        N.B. Only the layer reference in the mpWindow is deleted, the layer object still exists!
-    */
-    bool DelLayer( mpLayer* layer, bool alsoDeleteObject = false, bool refreshDisplay = true);
+    mpView();
+    virtual ~mpView() {}
 
-    /** Remove all layers from the plot.
-        @param alsoDeleteObject If set to true, the mpLayer objects will be also "deleted", not just removed from the internal list.
-        @param refreshDisplay States whether to refresh the display (UpdateAll) after removing the layers.
-    */
-    void DelAllLayers( bool alsoDeleteObject, bool refreshDisplay = true);
-	
-	
     /*! Get the layer in list position indicated.
         N.B. You <i>must</i> know the index of the layer inside the list!
         @param position position of the layer in the layers list
@@ -893,6 +1020,15 @@ public:
     */
     mpLayer* GetLayerByName( const wxString &name);
 
+    /** Counts the number of plot layers, excluding axes or text: this is to count only the layers which have a bounding box.
+    	\return The number of profiles plotted.
+    */
+    unsigned int CountLayers();
+
+    /** Counts the number of plot layers, whether or not they have a bounding box.
+    	\return The number of layers in the view. */
+    unsigned int CountAllLayers() { return m_layers.size(); };
+
     /** Get current view's X scale.
         See @ref mpLayer::Plot "rules for coordinate transformation"
         @return Scale
@@ -939,32 +1075,6 @@ public:
     int GetScrY(void) const { return m_scrY; }
     int GetYScreen(void) const { return m_scrY; }
 
-    /** Set current view's X scale and refresh display.
-        @param scaleX New scale, must not be 0.
-    */
-    void SetScaleX(double scaleX);
-
-    /** Set current view's Y scale and refresh display.
-        @param scaleY New scale, must not be 0.
-    */
-    void SetScaleY(double scaleY) { if (scaleY!=0) m_scaleY=scaleY; UpdateAll(); }
-
-    /** Set current view's X position and refresh display.
-        @param posX New position that corresponds to the center point of the view.
-    */
-    void SetPosX(double posX) { m_posX=posX; UpdateAll(); }
-
-    /** Set current view's Y position and refresh display.
-        @param posY New position that corresponds to the center point of the view.
-    */
-    void SetPosY(double posY) { m_posY=posY; UpdateAll(); }
-
-    /** Set current view's X and Y position and refresh display.
-        @param posX New position that corresponds to the center point of the view.
-        @param posY New position that corresponds to the center point of the view.
-    */
-    void SetPos( double posX, double posY) { m_posX=posX; m_posY=posY; UpdateAll(); }
-
     /** Set current view's dimensions in device context units.
         Needed by plotting functions. It doesn't refresh display.
         @param scrX New position that corresponds to the center point of the view.
@@ -972,146 +1082,52 @@ public:
     */
     void SetScr( int scrX, int scrY) { m_scrX=scrX; m_scrY=scrY; }
     
-    /** Converts mpWindow (screen) pixel coordinates into graph (floating point) coordinates, using current mpWindow position and scale.
+    /** Converts view (screen) pixel coordinates into graph (floating point) coordinates, using current view position and scale.
       * @sa p2y,x2p,y2p */
 //     double p2x(wxCoord pixelCoordX, bool drawOutside = true ); // { return m_posX + pixelCoordX/m_scaleX; }
     inline double p2x(wxCoord pixelCoordX ) { return m_posX + pixelCoordX/m_scaleX; }
 
-    /** Converts mpWindow (screen) pixel coordinates into graph (floating point) coordinates, using current mpWindow position and scale.
+    /** Converts view (screen) pixel coordinates into graph (floating point) coordinates, using current view position and scale.
       * @sa p2x,x2p,y2p */
 //     double p2y(wxCoord pixelCoordY, bool drawOutside = true ); //{ return m_posY - pixelCoordY/m_scaleY; }
     inline double p2y(wxCoord pixelCoordY ) { return m_posY - pixelCoordY/m_scaleY; }
 
-    /** Converts graph (floating point) coordinates into mpWindow (screen) pixel coordinates, using current mpWindow position and scale.
+    /** Converts graph (floating point) coordinates into view (screen) pixel coordinates, using current view position and scale.
       * @sa p2x,p2y,y2p */
 //     wxCoord x2p(double x, bool drawOutside = true); // { return (wxCoord) ( (x-m_posX) * m_scaleX); }
     inline wxCoord x2p(double x) { return (wxCoord) ( (x-m_posX) * m_scaleX); }
 
-    /** Converts graph (floating point) coordinates into mpWindow (screen) pixel coordinates, using current mpWindow position and scale.
+    /** Converts graph (floating point) coordinates into view (screen) pixel coordinates, using current view position and scale.
       * @sa p2x,p2y,x2p */
 //     wxCoord y2p(double y, bool drawOutside = true); // { return (wxCoord) ( (m_posY-y) * m_scaleY); }
     inline wxCoord y2p(double y) { return (wxCoord) ( (m_posY-y) * m_scaleY); }
 
-
-    /** Enable/disable the double-buffering of the window, eliminating the flicker (default=disabled).
-     */
-    void EnableDoubleBuffer( bool enabled ) { m_enableDoubleBuffer = enabled; }
-
-    /** Enable/disable the feature of pan/zoom with the mouse (default=enabled)
-     */
-    void EnableMousePanZoom( bool enabled ) { m_enableMouseNavigation = enabled; }
-
-    /** Enable or disable X/Y scale aspect locking for the view.
-        @note Explicit calls to mpWindow::SetScaleX and mpWindow::SetScaleY will set
-              an unlocked aspect, but any other action changing the view scale will
-              lock the aspect again.
-    */
-    void LockAspect(bool enable = TRUE);
-
     /** Checks whether the X/Y scale aspect is locked.
         @retval TRUE Locked
         @retval FALSE Unlocked
     */
     inline bool IsAspectLocked() { return m_lockaspect; }
 
-    /** Set view to fit global bounding box of all plot layers and refresh display.
-        Scale and position will be set to show all attached mpLayers.
-        The X/Y scale aspect lock is taken into account.
-    */
-    void Fit();
-
-    /** Set view to fit a given bounding box and refresh display.
-        The X/Y scale aspect lock is taken into account.
-	If provided, the parameters printSizeX and printSizeY are taken as the DC size, and the 
-        pixel scales are computed accordingly. Also, in this case the passed borders are not saved 
-        as the "desired borders", since this use will be invoked only when printing.
-    */
-    void Fit(double xMin, double xMax, double yMin, double yMax,wxCoord *printSizeX=NULL,wxCoord *printSizeY=NULL);
-
-    /** Zoom into current view and refresh display 
-      * @param centerPoint The point (pixel coordinates) that will stay in the same position on the screen after the zoom (by default, the center of the mpWindow).
-      */
-    void ZoomIn( const wxPoint& centerPoint = wxDefaultPosition );
-
-    /** Zoom out current view and refresh display
-      * @param centerPoint The point (pixel coordinates) that will stay in the same position on the screen after the zoom (by default, the center of the mpWindow).
-      */
-    void ZoomOut( const wxPoint& centerPoint = wxDefaultPosition );
-
-    /** Zoom in current view along X and refresh display */
-    void ZoomInX();
-    /** Zoom out current view along X and refresh display */
-    void ZoomOutX();
-    /** Zoom in current view along Y and refresh display */
-    void ZoomInY();
-    /** Zoom out current view along Y and refresh display */
-    void ZoomOutY();
-
-    /** Zoom view fitting given coordinates to the window (p0 and p1 do not need to be in any specific order) */
-    void ZoomRect(wxPoint p0, wxPoint p1);
-
-    /** Refresh display */
-    void UpdateAll();
-
-    // Added methods by Davide Rondini
-
-    /** Counts the number of plot layers, excluding axes or text: this is to count only the layers which have a bounding box.
-    	\return The number of profiles plotted.
-    */
-    unsigned int CountLayers();
-    
-    /** Counts the number of plot layers, whether or not they have a bounding box.
-    	\return The number of layers in the mpWindow. */
-    unsigned int CountAllLayers() { return m_layers.size(); };
-
-    /** Draws the mpWindow on a page for printing
-        \param print the mpPrintout where to print the graph */
-    //void PrintGraph(mpPrintout *print);
-
-
-	/** Returns the left-border layer coordinate that the user wants the mpWindow to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
-	  * @sa Fit
+	/** Returns the left-border layer coordinate that the user wants the view to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
+	  * @sa mpWindow::Fit
    	  */
 	double GetDesiredXmin() {return m_desiredXmin; }
 
-	/** Returns the right-border layer coordinate that the user wants the mpWindow to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
-	  * @sa Fit
+	/** Returns the right-border layer coordinate that the user wants the view to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
+	  * @sa mpWindow::Fit
    	  */
 	double GetDesiredXmax() {return m_desiredXmax; }
 
-	/** Returns the bottom-border layer coordinate that the user wants the mpWindow to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
-	  * @sa Fit
+	/** Returns the bottom-border layer coordinate that the user wants the view to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
+	  * @sa mpWindow::Fit
    	  */
 	double GetDesiredYmin() {return m_desiredYmin; }
 
-	/** Returns the top layer-border coordinate that the user wants the mpWindow to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
-	  * @sa Fit
+	/** Returns the top layer-border coordinate that the user wants the view to show (it may be not exactly the actual shown coordinate in the case of locked aspect ratio).
+	  * @sa mpWindow::Fit
    	  */
 	double GetDesiredYmax() {return m_desiredYmax; }
 
-	/** Returns the bounding box coordinates
-		@param bbox Pointer to a 6-element double array where to store bounding box coordinates. */
-	void GetBoundingBox(double* bbox);
-	
-    /** Enable/disable scrollbars
-      @param status Set to true to show scrollbars */
-    void SetMPScrollbars(bool status);
-
-    /** Get scrollbars status.
-      @return true if scrollbars are visible */
-    bool GetMPScrollbars() {return m_enableScrollBars; };
-
-    /** Draw the window on a wxBitmap, then save it to a file.
-      @param filename File name where to save the screenshot
-      @param type image type to be saved: see wxImage output file types for flags
-	  @param imageSize Set a size for the output image. Default is the same as the screen size
-	  @param fit Decide whether to fit the plot into the size*/
-    bool SaveScreenshot(const wxString& filename, int type = wxBITMAP_TYPE_BMP, wxSize imageSize = wxDefaultSize, bool fit = false);
-
-    /** This value sets the zoom steps whenever the user clicks "Zoom in/out" or performs zoom with the mouse wheel.
-      *  It must be a number above unity. This number is used for zoom in, and its inverse for zoom out. Set to 1.5 by default. */
-    static double zoomIncrementalFactor;
-
     /** Set window margins, creating a blank area where some kinds of layers cannot draw. This is useful for example to draw axes outside the area where the plots are drawn.
         @param top Top border
         @param right Right border
@@ -1137,16 +1153,268 @@ public:
     /** Get the left margin. @param left Left Margin */
     int GetMarginLeft() { return m_marginLeft; };
 
-    /** Sets whether to show coordinate tooltip when mouse passes over the plot. \param value true for enable, false for disable */
-    // void EnableCoordTooltip(bool value = true);
-    /** Gets coordinate tooltip status. \return true for enable, false for disable */
-    // bool GetCoordTooltip() { return m_coordTooltip; };
+protected:
+    /** Compute scale and position so that the given bounding box fits in the current screen size (m_scrX, m_scrY) minus the margins.
+        The bounding box is saved as the "desired borders" and the X/Y scale aspect lock is taken into account.
+        It doesn't refresh anything. */
+    void ComputeFit(double xMin, double xMax, double yMin, double yMax);
 
-    /** Check if a given point is inside the area of a mpInfoLayer and eventually returns its pointer.
-        @param point The position to be checked 
-        @return If an info layer is found, returns its pointer, NULL otherwise */
-    mpInfoLayer* IsInsideInfoLayer(wxPoint& point);
-	
+    /** Compute the union of the bounding boxes of the layers in m_layers.
+        \return false if no layer has a bounding box. */
+    bool ComputeLayersBBox(double &minX, double &maxX, double &minY, double &maxY);
+
+    //wxList m_layers;    //!< List of attached plot layers
+    wxLayerList m_layers; //!< List of attached plot layers
+    bool   m_lockaspect;//!< Scale aspect is locked or not
+    double m_scaleX;    //!< Current view's X scale
+    double m_scaleY;    //!< Current view's Y scale
+    double m_posX;      //!< Current view's X position
+    double m_posY;      //!< Current view's Y position
+    int    m_scrX;      //!< Current view's X dimension
+    int    m_scrY;      //!< Current view's Y dimension
+
+    /** These are updated in Fit() only, and may be different from the real borders (layer coordinates) only if lock aspect ratio is true.
+      */
+    double m_desiredXmin,m_desiredXmax,m_desiredYmin,m_desiredYmax;
+
+    int m_marginTop, m_marginRight, m_marginBottom, m_marginLeft;
+};
+
+//-----------------------------------------------------------------------------
+// mpWindow
+//-----------------------------------------------------------------------------
+
+/** @name Constants defining mouse modes for mpWindow
+@{*/
+
+/** Mouse panning drags the view. Mouse mode for mpWindow. */
+#define mpMOUSEMODE_DRAG    0
+/** Mouse panning creates a zoom box. Mouse mode for mpWindow. */
+#define mpMOUSEMODE_ZOOMBOX 1
+
+/*@}*/
+/** Bounding box of a single layer, as cached by mpWindow together with the layer data version it was read at. */
+typedef struct {
+    unsigned long version;  //!< Layer data version when the box was read
+    bool   hasBBox;         //!< Result of mpLayer::HasBBox
+    double minX, maxX, minY, maxY; //!< Layer bounding box
+} mpLayerBBox;
+
+/** Define the type for the list of cached layer bounding boxes inside mpWindow (one item per layer, in the same order). */
+typedef std::deque<mpLayerBBox> mpLayerBBoxList;
+
+/** Canvas for plotting mpLayer implementations.
+
+    This class defines a zoomable and moveable 2D plot canvas. Any number
+    of mpLayer implementations (scale rulers, function plots, ...) can be
+    attached using mpWindow::AddLayer.
+
+    The canvas window provides a context menu with actions for navigating the view.
+    The context menu can be retrieved with mpWindow::GetPopupMenu, e.g. for extending it
+    externally.
+
+    Since wxMathPlot version 0.03, the mpWindow incorporates the following features:
+        - DoubleBuffering (Default=disabled): Can be set with EnableDoubleBuffer
+        - Mouse based pan/zoom (Default=enabled): Can be set with EnableMousePanZoom.
+
+    The mouse commands can be visualized by the user through the popup menu, and are:
+        - Mouse Move+CTRL: Pan (Move)
+        - Mouse Wheel: Vertical scroll
+        - Mouse Wheel+SHIFT: Horizontal scroll
+        - Mouse Wheel UP+CTRL: Zoom in
+        - Mouse Wheel DOWN+CTRL: Zoom out
+
+*/
+class WXDLLIMPEXP_MATHPLOT mpWindow : public wxWindow, public mpView
+{
+public:
+    mpWindow() {}
+    mpWindow( wxWindow *parent, wxWindowID id,
+                     const wxPoint &pos = wxDefaultPosition,
+                     const wxSize &size = wxDefaultSize,
+                     long flags = 0);
+    ~mpWindow();
+
+    /** Get reference to context menu of the plot canvas.
+        @return Pointer to menu. The menu can be modified.
+    */
+    wxMenu* GetPopupMenu() { return &m_popmenu; }
+
+    /** Add a plot layer to the canvas.
+        @param layer Pointer to layer. The mpLayer object will get under control of mpWindow,
+                     i.e. it will be delete'd on mpWindow destruction
+        @param refreshDisplay States whether to refresh the display (UpdateAll) after adding the layer.
+        @retval TRUE Success
+        @retval FALSE Failure due to out of memory.
+    */
+    bool AddLayer( mpLayer* layer, bool refreshDisplay = true);
+
+    /** Remove a plot layer from the canvas.
+        @param layer Pointer to layer. The mpLayer object will be destructed using delete.
+        @param alsoDeleteObject If set to true, the mpLayer object will be also "deleted", not just removed from the internal list.
+        @param refreshDisplay States whether to refresh the display (UpdateAll) after removing the layer.
+        @return true if layer is deleted correctly
+
+        N.B. Only the layer reference in the mpWindow is deleted, the layer object still exists!
+    */
+    bool DelLayer( mpLayer* layer, bool alsoDeleteObject = false, bool refreshDisplay = true);
+
+    /** Remove all layers from the plot.
+        @param alsoDeleteObject If set to true, the mpLayer objects will be also "deleted", not just removed from the internal list.
+        @param refreshDisplay States whether to refresh the display (UpdateAll) after removing the layers.
+    */
+    void DelAllLayers( bool alsoDeleteObject, bool refreshDisplay = true);
+	
+    /** Set current view's X scale and refresh display.
+        @param scaleX New scale, must not be 0.
+    */
+    void SetScaleX(double scaleX);
+
+    /** Set current view's Y scale and refresh display.
+        @param scaleY New scale, must not be 0.
+    */
+    void SetScaleY(double scaleY) { if (scaleY!=0) m_scaleY=scaleY; UpdateAll(); }
+
+    /** Set current view's X position and refresh display.
+        @param posX New position that corresponds to the center point of the view.
+    */
+    void SetPosX(double posX) { m_posX=posX; UpdateAll(); }
+
+    /** Set current view's Y position and refresh display.
+        @param posY New position that corresponds to the center point of the view.
+    */
+    void SetPosY(double posY) { m_posY=posY; UpdateAll(); }
+
+    /** Set current view's X and Y position and refresh display.
+        @param posX New position that corresponds to the center point of the view.
+        @param posY New position that corresponds to the center point of the view.
+    */
+    void SetPos( double posX, double posY) { m_posX=posX; m_posY=posY; UpdateAll(); }
+
+    /** Enable/disable the double-buffering of the window, eliminating the flicker (default=disabled).
+     */
+    void EnableDoubleBuffer( bool enabled ) { m_enableDoubleBuffer = enabled; }
+
+    /** Enable/disable the cache of static layers (default=enabled).
+        When enabled, axes and plot layers are rendered into a cached bitmap which is reused by OnPaint
+        until the view transform, the window size, the colours or the version of any layer changes.
+        Info layers are always drawn on top of the cached bitmap, so that mouse-driven updates do not
+        re-render the plots.
+        @sa mpLayer::DataChanged, InvalidateLayerCache */
+    void EnableLayerCache( bool enabled ) { m_enableLayerCache = enabled; m_layerCacheValid = false; }
+
+    /** Force the static layers to be rendered again at the next paint event. Only needed when
+        a layer output depends on some state which is not tracked by mpLayer::DataChanged. */
+    void InvalidateLayerCache() { m_layerCacheValid = false; }
+
+    /** Enable/disable the feature of pan/zoom with the mouse (default=enabled)
+     */
+    void EnableMousePanZoom( bool enabled ) { m_enableMouseNavigation = enabled; }
+
+    /** Enable or disable X/Y scale aspect locking for the view.
+        @note Explicit calls to mpWindow::SetScaleX and mpWindow::SetScaleY will set
+              an unlocked aspect, but any other action changing the view scale will
+              lock the aspect again.
+    */
+    void LockAspect(bool enable = TRUE);
+
+    /** Set view to fit global bounding box of all plot layers and refresh display.
+        Scale and position will be set to show all attached mpLayers.
+        The X/Y scale aspect lock is taken into account.
+    */
+    void Fit();
+
+    /** Set view to fit a given bounding box and refresh display.
+        The X/Y scale aspect lock is taken into account.
+	If provided, the parameters printSizeX and printSizeY are taken as the DC size, and the 
+        pixel scales are computed accordingly. Also, in this case the passed borders are not saved 
+        as the "desired borders", since this use will be invoked only when printing.
+    */
+    void Fit(double xMin, double xMax, double yMin, double yMax,wxCoord *printSizeX=NULL,wxCoord *printSizeY=NULL);
+
+    /** Zoom into current view and refresh display 
+      * @param centerPoint The point (pixel coordinates) that will stay in the same position on the screen after the zoom (by default, the center of the mpWindow).
+      */
+    void ZoomIn( const wxPoint& centerPoint = wxDefaultPosition );
+
+    /** Zoom out current view and refresh display
+      * @param centerPoint The point (pixel coordinates) that will stay in the same position on the screen after the zoom (by default, the center of the mpWindow).
+      */
+    void ZoomOut( const wxPoint& centerPoint = wxDefaultPosition );
+
+    /** Zoom in current view along X and refresh display */
+    void ZoomInX();
+    /** Zoom out current view along X and refresh display */
+    void ZoomOutX();
+    /** Zoom in current view along Y and refresh display */
+    void ZoomInY();
+    /** Zoom out current view along Y and refresh display */
+    void ZoomOutY();
+
+    /** Zoom view fitting given coordinates to the window (p0 and p1 do not need to be in any specific order) */
+    void ZoomRect(wxPoint p0, wxPoint p1);
+
+    /** Refresh display. While an update batch is active the refresh is only recorded, and performed once when the batch ends.
+        @sa BeginUpdateBatch */
+    void UpdateAll();
+
+    /** Start a batch of updates: until the matching EndUpdateBatch, calls to UpdateAll (also the implicit ones made by
+        AddLayer, DelLayer, Fit, ...) do not recompute the bounding box nor refresh the display. Batches can be nested.
+        Use mpUpdateBatch to have EndUpdateBatch called automatically at the end of a scope.
+        @sa EndUpdateBatch, mpUpdateBatch */
+    void BeginUpdateBatch() { m_updateBatchLevel++; }
+
+    /** End a batch of updates. When the outermost batch ends, if any update was requested in the meanwhile, the bounding
+        box is recomputed and the display refreshed exactly once.
+        @sa BeginUpdateBatch */
+    void EndUpdateBatch();
+
+    /** Checks whether an update batch is active.
+        @retval TRUE UpdateAll calls are currently deferred */
+    bool IsUpdateBatchActive() const { return m_updateBatchLevel > 0; }
+
+    // Added methods by Davide Rondini
+
+    /** Draws the mpWindow on a page for printing
+        \param print the mpPrintout where to print the graph */
+    //void PrintGraph(mpPrintout *print);
+
+
+	/** Returns the bounding box coordinates
+		@param bbox Pointer to a 6-element double array where to store bounding box coordinates. */
+	void GetBoundingBox(double* bbox);
+	
+    /** Enable/disable scrollbars
+      @param status Set to true to show scrollbars */
+    void SetMPScrollbars(bool status);
+
+    /** Get scrollbars status.
+      @return true if scrollbars are visible */
+    bool GetMPScrollbars() {return m_enableScrollBars; };
+
+    /** Draw the plot on a bitmap, then save it to a file.
+      The plot is drawn by a mpImageRenderer sharing the layers, margins and colours of the window, so that
+      the window view is not changed nor refreshed.
+      @param filename File name where to save the screenshot
+      @param type image type to be saved: see wxImage output file types for flags
+	  @param imageSize Set a size for the output image. Default is the same as the screen size
+	  @param fit Decide whether to fit the plot into the size*/
+    bool SaveScreenshot(const wxString& filename, int type = wxBITMAP_TYPE_BMP, wxSize imageSize = wxDefaultSize, bool fit = false);
+
+    /** This value sets the zoom steps whenever the user clicks "Zoom in/out" or performs zoom with the mouse wheel.
+      *  It must be a number above unity. This number is used for zoom in, and its inverse for zoom out. Set to 1.5 by default. */
+    static double zoomIncrementalFactor;
+
+    /** Sets whether to show coordinate tooltip when mouse passes over the plot. \param value true for enable, false for disable */
+    // void EnableCoordTooltip(bool value = true);
+    /** Gets coordinate tooltip status. \return true for enable, false for disable */
+    // bool GetCoordTooltip() { return m_coordTooltip; };
+
+    /** Check if a given point is inside the area of a mpInfoLayer and eventually returns its pointer.
+        @param point The position to be checked 
+        @return If an info layer is found, returns its pointer, NULL otherwise */
+    mpInfoLayer* IsInsideInfoLayer(wxPoint& point);
+	
 	/** Sets the visibility of a layer by its name.
 		@param name The layer name to set visibility
 		@param viewable the view status to be set */
@@ -1193,6 +1461,7 @@ protected:
     void OnMouseMove     (wxMouseEvent     &event); //!< Mouse handler for mouse motion (for pan)
     void OnMouseLeftDown (wxMouseEvent     &event); //!< Mouse left click (for rect zoom)
     void OnMouseLeftRelease (wxMouseEvent  &event); //!< Mouse left click (for rect zoom)
+    void OnPanTimer      (wxTimerEvent     &event); //!< Renders the pan accumulated since the last frame
     void OnScrollThumbTrack (wxScrollWinEvent &event); //!< Scroll thumb on scroll bar moving
     void OnScrollPageUp     (wxScrollWinEvent &event); //!< Scroll page up 
     void OnScrollPageDown   (wxScrollWinEvent &event); //!< Scroll page down 
@@ -1203,20 +1472,47 @@ protected:
 
     void DoScrollCalc    (const int position, const int orientation);
 
+    /** Lets the visible info layers update their content for a mouse move, and repaints their boxes. */
+    void UpdateInfoLayers(wxMouseEvent &event);
+
     void DoZoomInXCalc   (const int         staticXpixel);
     void DoZoomInYCalc   (const int         staticYpixel);
     void DoZoomOutXCalc  (const int         staticXpixel);
     void DoZoomOutYCalc  (const int         staticYpixel);
 
     /** Recalculate global layer bounding box, and save it in m_minX,...
+      * Bounding boxes of single layers are cached: only layers whose data version has changed are queried again,
+      * and nothing at all is done if no layer called mpLayer::DataChanged since last call.
       * \return true if there is any valid BBox information.
       */
     virtual bool UpdateBBox();
 
-    //wxList m_layers;    //!< List of attached plot layers
-    wxLayerList m_layers; //!< List of attached plot layers
+    /** Read the bounding box of a layer, tagging it with the layer current data version. */
+    static mpLayerBBox ReadLayerBBox(mpLayer* layer);
+
+    /** Recompute the global bounding box m_minX,... as the union of the cached layers bounding boxes. */
+    void MergeBBoxes();
+
+    /** Checks whether the cached rendering of static layers matches the current view and layers data versions.
+        @param checkPosition If false, a cache rendered at another view position (same scale) is accepted too. */
+    bool IsLayerCacheValid(bool checkPosition = true);
+
+    /** Checks whether a layer may draw inside the given update region, so that OnPaint can skip the others.
+        Info layers are tested with their rectangle and mpFXY layers with their bounding box (plus a slack for
+        the pen and the name label); any other layer (axes, functions...) is assumed to cover the whole window. */
+    bool LayerIntersects(mpLayer* layer, const wxRegion& region);
+
+    /** Renders background and all non-info layers in the static layers cache bitmap, and stores the state it was rendered with.
+        @param panning If true, background and plot layers (mpLAYER_PLOT and mpLAYER_BITMAP) are also kept in the pan cache,
+               and the other layers (axes, texts) are drawn on top of them, so that ScrollLayerCache can be used next. */
+    void RenderLayerCache(bool panning = false);
+
+    /** Updates the static layers cache for the current view position by scrolling the pan cache:
+        only the strips exposed by the move are rendered again, then the axes are drawn on top.
+        @return false if the pan cache cannot be scrolled (no pan cache, other scale or layers, move not by whole pixels) */
+    bool ScrollLayerCache();
+
     wxMenu m_popmenu;   //!< Canvas' context menu
-    bool   m_lockaspect;//!< Scale aspect is locked or not
     // bool   m_coordTooltip; //!< Selects whether to show coordinate tooltip
 	wxColour m_bgColour;	//!< Background Colour
 	wxColour m_fgColour;	//!< Foreground Colour
@@ -1226,25 +1522,31 @@ protected:
     double m_maxX;      //!< Global layer bounding box, right border incl.
     double m_minY;      //!< Global layer bounding box, bottom border incl.
     double m_maxY;      //!< Global layer bounding box, top border incl.
-    double m_scaleX;    //!< Current view's X scale
-    double m_scaleY;    //!< Current view's Y scale
-    double m_posX;      //!< Current view's X position
-    double m_posY;      //!< Current view's Y position
-    int    m_scrX;      //!< Current view's X dimension
-    int    m_scrY;      //!< Current view's Y dimension
+    mpLayerBBoxList m_layerBBoxes; //!< Cached bounding boxes of the layers, one per item of m_layers
+    bool   m_bboxValid;   //!< Whether m_minX,... hold a valid bounding box
+    bool   m_bboxDirty;   //!< Whether the global bounding box must be merged again from m_layerBBoxes
+    unsigned long m_bboxGlobalVersion; //!< mpLayer::GetGlobalDataVersion value when bounding boxes were last checked
     int    m_clickedX;  //!< Last mouse click X position, for centering and zooming the view
     int    m_clickedY;  //!< Last mouse click Y position, for centering and zooming the view
 
-    /** These are updated in Fit() only, and may be different from the real borders (layer coordinates) only if lock aspect ratio is true.
-      */
-    double m_desiredXmin,m_desiredXmax,m_desiredYmin,m_desiredYmax;
-
-    int m_marginTop, m_marginRight, m_marginBottom, m_marginLeft;
-
     int         m_last_lx,m_last_ly;   //!< For double buffering
     wxMemoryDC  m_buff_dc;             //!< For double buffering
     wxBitmap    *m_buff_bmp;            //!< For double buffering
     bool        m_enableDoubleBuffer;  //!< For double buffering
+    wxMemoryDC  m_layerCache_dc;       //!< For static layers cache
+    wxBitmap    *m_layerCache_bmp;     //!< For static layers cache
+    bool        m_enableLayerCache;    //!< For static layers cache
+    bool        m_layerCacheValid;     //!< For static layers cache: false forces a new rendering
+    int         m_layerCache_size[2];  //!< For static layers cache: m_scrX, m_scrY at rendering time
+    double      m_layerCache_view[4];  //!< For static layers cache: posX, posY, scaleX, scaleY at rendering time
+    int         m_layerCache_margins[4]; //!< For static layers cache: top, right, bottom, left margins at rendering time
+    wxColour    m_layerCache_bg, m_layerCache_fg; //!< For static layers cache: colours at rendering time
+    std::vector< std::pair<mpLayer*, unsigned long> > m_layerCache_versions; //!< For static layers cache: layers and their versions at rendering time
+    wxMemoryDC  m_panCache_dc;         //!< For panning: background and plot layers only, scrolled while panning
+    wxBitmap    *m_panCache_bmp;       //!< For panning
+    bool        m_panCacheValid;       //!< For panning: the pan cache matches the static layers cache
+    wxTimer     m_panTimer;            //!< For panning: coalesces the repaints to one per display frame
+    wxOverlay   m_zoomOverlay;         //!< For rectangular zoom: the selection box is drawn over the window content
     bool        m_enableMouseNavigation;  //!< For pan/zoom with the mouse.
     bool        m_mouseMovedAfterRightClick;
     long        m_mouseRClick_X,m_mouseRClick_Y; //!< For the right button "drag" feature
@@ -1252,11 +1554,121 @@ protected:
     bool        m_enableScrollBars;
     int         m_scrollX, m_scrollY;
     mpInfoLayer* m_movingInfoLayer;      //!< For moving info layers over the window area
+    int         m_updateBatchLevel;      //!< Nesting level of update batches, UpdateAll is deferred when positive
+    bool        m_updatePending;         //!< An UpdateAll was requested during the current update batch
 
     DECLARE_DYNAMIC_CLASS(mpWindow)
     DECLARE_EVENT_TABLE()
 };
 
+/** Scoped update batch for mpWindow.
+    Calls mpWindow::BeginUpdateBatch on construction and mpWindow::EndUpdateBatch on destruction, so that layers can be
+    added and the view fitted with a single bounding box computation and a single refresh:
+    \code
+    {
+        mpUpdateBatch batch(plot);
+        plot->AddLayer(layer1);
+        plot->AddLayer(layer2);
+        plot->Fit();
+    } // Display refreshed here
+    \endcode
+*/
+class WXDLLIMPEXP_MATHPLOT mpUpdateBatch
+{
+public:
+    /** @param w The mpWindow whose updates must be deferred */
+    mpUpdateBatch(mpWindow* w) : m_window(w) { m_window->BeginUpdateBatch(); }
+    ~mpUpdateBatch() { m_window->EndUpdateBatch(); }
+
+private:
+    mpWindow* m_window;
+
+    mpUpdateBatch(const mpUpdateBatch&);
+    mpUpdateBatch& operator=(const mpUpdateBatch&);
+};
+
+//-----------------------------------------------------------------------------
+// mpImageRenderer
+//-----------------------------------------------------------------------------
+
+/** Off-screen render target for mpLayer implementations.
+
+    mpImageRenderer draws a set of layers with a given view into a wxImage (or a raw RGBA buffer)
+    of any size, without any wxWindow: it can be used to generate chart images from a worker
+    or a batch job, with no display. Each renderer has its own view, so different renderers can be
+    used at the same time, as long as they do not share layers.
+    \code
+    mpImageRenderer renderer(800, 400);
+    renderer.SetMargins(20, 20, 40, 60);
+    renderer.AddLayer(new mpScaleX(wxT("X"), mpALIGN_BOTTOM, true), true);
+    renderer.AddLayer(new mpScaleY(wxT("Y"), mpALIGN_LEFT, true), true);
+    renderer.AddLayer(series, true);
+    renderer.Fit(0.0, 72.0, yMin, yMax);
+    renderer.SaveFile(wxT("chart.png"), wxBITMAP_TYPE_PNG);
+    \endcode
+*/
+class WXDLLIMPEXP_MATHPLOT mpImageRenderer : public mpView
+{
+public:
+    /** @param width Width of the output image, in pixels
+        @param height Height of the output image, in pixels */
+    mpImageRenderer(int width = 640, int height = 480);
+    ~mpImageRenderer();
+
+    /** Add a layer to the renderer.
+        @param layer Pointer to layer
+        @param takeOwnership If true, the layer will be delete'd by the renderer (on DelAllLayers or destruction) */
+    void AddLayer(mpLayer* layer, bool takeOwnership = false);
+
+    /** Remove all layers from the renderer, deleting the ones it owns. The view is not changed. */
+    void DelAllLayers();
+
+    /** Set the output image size. The view is fitted again to the desired borders. */
+    void SetSize(int width, int height);
+
+	/** Set Color theme. As for mpWindow::SetColourTheme, axis and info layers already added get the new pen colours.
+	    @param bgColour Background colour
+		@param drawColour The colour used to draw all elements in foreground, axes excluded
+		@param axesColour The colour used to draw axes (but not their labels) */
+    void SetColourTheme(const wxColour& bgColour, const wxColour& drawColour, const wxColour& axesColour);
+
+    /** Enable or disable X/Y scale aspect locking. It is taken into account by the next Fit. */
+    void LockAspect(bool enable = TRUE) { m_lockaspect = enable; }
+
+    /** Set view to fit the given bounding box in the output image. */
+    void Fit(double xMin, double xMax, double yMin, double yMax) { ComputeFit(xMin, xMax, yMin, yMax); }
+
+    /** Set view to fit the global bounding box of all the layers.
+        @return false if no layer has a bounding box (the view is not changed) */
+    bool Fit();
+
+    /** Render background and all visible layers into an image. The image is (re)created with the current size.
+        @return false if the drawing surface could not be created */
+    bool Render(wxImage& image);
+
+    /** Render into a raw buffer, 4 bytes per pixel (R,G,B,A), rows from top to bottom.
+        @param rgba Output buffer, resized to width*height*4 */
+    bool RenderRGBA(std::vector<unsigned char>& rgba);
+
+    /** Render and save to a file.
+        @param filename File name where to save the image
+        @param type image type to be saved: see wxImage output file types for flags */
+    bool SaveFile(const wxString& filename, wxBitmapType type = wxBITMAP_TYPE_PNG);
+
+protected:
+    /** Draw background and layers on the given DC, which must be m_scrX x m_scrY pixels. */
+    void Draw(wxDC& dc);
+
+    std::vector<mpLayer*> m_ownedLayers; //!< Layers deleted by the renderer
+    wxColour m_bgColour;	//!< Background Colour
+    wxColour m_fgColour;	//!< Foreground Colour
+    wxColour m_axColour;	//!< Axes Colour
+
+private:
+    mpImageRenderer(const mpImageRenderer&);
+    mpImageRenderer& operator=(const mpImageRenderer&);
+};
+
 //-----------------------------------------------------------------------------
 // mpFXYVector - provided by Jose Luis Blanco
 //-----------------------------------------------------------------------------
@@ -1294,16 +1706,36 @@ public:
     */
     void SetData( const std::vector<double> &xs,const std::vector<double> &ys);
 
+    /** Appends points to the end of the internal data, without copying the points already stored.
+        The bounding box is only extended by the new points, so live series can grow cheaply.
+        Both vectors MUST be of the same length. This method DOES NOT refresh the mpWindow; do it manually.
+      * @sa SetData
+    */
+    void AppendData( const std::vector<double> &xs,const std::vector<double> &ys);
+
     /** Clears all the data, leaving the layer empty.
       * @sa SetData
       */
     void Clear();
 
+    /** Finds the nearest point with a binary search on X: directly if the data is sorted by X,
+        otherwise through an index sorted by X, built at the first query after the data changed. */
+    virtual bool GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2);
+
 protected:
     /** The internal copy of the set of data to draw.
       */
     std::vector<double>  m_xs,m_ys;
 
+    /** Whether m_xs is sorted, i.e. can be searched without m_order. */
+    bool m_sortedX;
+
+    /** Indexes of the points sorted by X, used by GetNearestPoint when m_xs is not sorted. */
+    std::vector<size_t> m_order;
+
+    /** Data version m_order was built at. */
+    unsigned long m_orderVersion;
+
     /** The internal counter for the "GetNextXY" interface
       */
     size_t              m_index;
@@ -1345,6 +1777,227 @@ protected:
     DECLARE_DYNAMIC_CLASS(mpFXYVector)
 };
 
+//-----------------------------------------------------------------------------
+// mpFXYRingBuffer
+//-----------------------------------------------------------------------------
+
+/** A 2D plot layer for live data, backed by a fixed-capacity ring buffer.
+     Points are appended at the end in O(1); when the buffer is full the oldest point is evicted.
+     Points can also be evicted by age with EvictBefore, e.g. to keep only the last days of a time series.
+
+     The bounding box is maintained incrementally with monotonic queues (sliding window minimum/maximum),
+     so each append or eviction costs amortized O(1) and a refresh costs O(new points), whatever the capacity.
+     Points are drawn in append order, so for time series append them in increasing X.
+*/
+class WXDLLIMPEXP_MATHPLOT mpFXYRingBuffer : public mpFXY
+{
+public:
+    /** @param name     Label
+        @param capacity Maximum number of points kept in the layer
+        @param flags    Label alignment, pass one of #mpALIGN_NE, #mpALIGN_NW, #mpALIGN_SW, #mpALIGN_SE.
+    */
+    mpFXYRingBuffer(wxString name = wxEmptyString, size_t capacity = 1024, int flags = mpALIGN_NE);
+
+    /** Changes the maximum number of points. The newest points are kept if the buffer shrinks.
+        This method DOES NOT refresh the mpWindow; do it manually. */
+    void SetCapacity(size_t capacity);
+
+    /** Get the maximum number of points. */
+    size_t GetCapacity() const { return m_capacity; }
+
+    /** Get the number of points currently stored. */
+    size_t GetCount() const { return m_count; }
+
+    /** Appends one point, evicting the oldest one if the buffer is full.
+        This method DOES NOT refresh the mpWindow; do it manually. */
+    void Append(double x, double y);
+
+    /** Appends a set of points. Both vectors MUST be of the same length.
+        This method DOES NOT refresh the mpWindow; do it manually.
+      * @sa Append */
+    void AppendData(const std::vector<double> &xs, const std::vector<double> &ys);
+
+    /** Evicts the oldest points while their X is lower than xMin.
+        Eviction stops at the first point not older than xMin, so it expects X increasing in append order.
+        @return The number of evicted points */
+    size_t EvictBefore(double xMin);
+
+    /** Removes all the points, leaving the layer empty. */
+    void Clear();
+
+    /** Get the X of the newest point, or 0 if the layer is empty. */
+    double GetLastX() const { return m_count ? m_xs[Slot(m_count - 1)] : 0; }
+
+    /** Returns the actual minimum X data, padded like mpFXYVector. */
+    double GetMinX() { return m_count ? m_minX.front().value - 0.5 : -1; }
+
+    /** Returns the actual minimum Y data, padded like mpFXYVector. */
+    double GetMinY() { return m_count ? m_minY.front().value - 0.5 : -1; }
+
+    /** Returns the actual maximum X data, padded like mpFXYVector. */
+    double GetMaxX() { return m_count ? m_maxX.front().value + 0.5 : 1; }
+
+    /** Returns the actual maximum Y data, padded like mpFXYVector. */
+    double GetMaxY() { return m_count ? m_maxY.front().value + 0.5 : 1; }
+
+    /** Finds the nearest point with a binary search on X, unless points were appended out of order. */
+    virtual bool GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2);
+
+protected:
+    /** Entry of a monotonic queue: a value and the sequence number of its point. */
+    struct Extreme
+    {
+        unsigned long long seq;
+        double value;
+    };
+
+    /** Index in m_xs/m_ys of the i-th stored point (0 = oldest). */
+    size_t Slot(size_t i) const { return (m_head + i) % m_capacity; }
+
+    /** Adds a point to the back of the buffer and of the monotonic queues, without notifying. */
+    void Push(double x, double y);
+
+    /** Removes the oldest point from the buffer and from the monotonic queues, without notifying. */
+    void PopFront();
+
+    /** Rewind value enumeration with mpFXY::GetNextXY.
+        Overridden in this implementation. */
+    void Rewind();
+
+    /** Get locus value for next N.
+        Overridden in this implementation.
+        @param x Returns X value
+        @param y Returns Y value */
+    bool GetNextXY(double & x, double & y);
+
+    std::vector<double> m_xs, m_ys;     //!< Ring storage, m_capacity points each
+    size_t m_capacity;                  //!< Maximum number of points
+    size_t m_head;                      //!< Slot of the oldest point
+    size_t m_count;                     //!< Number of stored points
+    size_t m_index;                     //!< The internal counter for the "GetNextXY" interface
+    unsigned long long m_seqHead;       //!< Sequence number of the oldest point
+    bool m_sortedX;                     //!< Points were appended in non-decreasing X since the last Clear
+    std::deque<Extreme> m_minX, m_maxX; //!< Monotonic queues: the front holds the extreme of the stored points
+    std::deque<Extreme> m_minY, m_maxY;
+
+    DECLARE_DYNAMIC_CLASS(mpFXYRingBuffer)
+};
+
+//-----------------------------------------------------------------------------
+// mpFXYPyramid
+//-----------------------------------------------------------------------------
+
+/** Summary of the points of a series falling in one bucket of a level of detail. */
+struct mpLodBucket
+{
+    double start;   //!< X of the bucket start (a multiple of the level width)
+    double min;     //!< Minimum Y in the bucket
+    double max;     //!< Maximum Y in the bucket
+    double sum;     //!< Sum of Y in the bucket
+    size_t count;   //!< Number of points in the bucket
+
+    /** Mean Y of the bucket. */
+    double Mean() const { return count ? sum / count : 0; }
+};
+
+/** One level of detail: consecutive buckets of the same width, only non-empty buckets are stored. */
+struct mpLodLevel
+{
+    double width;                       //!< Bucket width in X units
+    std::vector<mpLodBucket> buckets;   //!< Buckets sorted by start
+};
+
+/** A 2D plot layer for long series (e.g. years of hourly measurements), with a level of detail pyramid.
+     Besides the raw points, the layer keeps min/max/mean buckets at several widths (by default 1 hour,
+     6 hours, 1 day and 1 week, for X in seconds). The pyramid is built once by SetData and kept up to date
+     incrementally by AppendData.
+
+     When plotting, the layer picks the coarsest level whose buckets are not wider than one pixel at the
+     current scale and draws the min/max envelope of the visible buckets, so the cost depends on the
+     plot width and not on the length of the series. When zoomed in beyond the finest level, only the
+     visible raw points are drawn.
+
+     X must be non-decreasing; out of order points passed to AppendData make the layer sort the data and
+     rebuild the pyramid.
+*/
+class WXDLLIMPEXP_MATHPLOT mpFXYPyramid : public mpFXY
+{
+public:
+    /** @param name  Label
+        @param flags Label alignment, pass one of #mpALIGN_NE, #mpALIGN_NW, #mpALIGN_SW, #mpALIGN_SE.
+    */
+    mpFXYPyramid(wxString name = wxEmptyString, int flags = mpALIGN_NE);
+
+    /** Changes the bucket widths of the levels (in X units) and rebuilds the pyramid.
+        This method DOES NOT refresh the mpWindow; do it manually. */
+    void SetLevels(const std::vector<double> &widths);
+
+    /** Changes the internal data and rebuilds the pyramid. Both vectors MUST be of the same length.
+        This method DOES NOT refresh the mpWindow; do it manually. */
+    void SetData(const std::vector<double> &xs, const std::vector<double> &ys);
+
+    /** Appends points, updating only the last buckets of each level. Both vectors MUST be of the same length.
+        This method DOES NOT refresh the mpWindow; do it manually. */
+    void AppendData(const std::vector<double> &xs, const std::vector<double> &ys);
+
+    /** Clears all the data, leaving the layer empty. */
+    void Clear();
+
+    /** Draw the min/max envelope of the buckets (default) or only their means. */
+    void ShowEnvelope(bool envelope) { m_envelope = envelope; DataChanged(); }
+
+    /** Get the number of levels. */
+    size_t CountLevels() const { return m_levels.size(); }
+
+    /** Get a level of the pyramid, 0 being the finest one. */
+    const mpLodLevel& GetLevel(size_t level) const { return m_levels[level]; }
+
+    /** Get the number of raw points. */
+    size_t GetCount() const { return m_xs.size(); }
+
+    /** Layer plot handler: selects the level and the visible range, then plots them like mpFXY. */
+    virtual void Plot(wxDC & dc, mpView & w);
+
+    /** Finds the nearest raw point with a binary search on X. */
+    virtual bool GetNearestPoint(mpView & w, const wxPoint & pos, int radius, double & x, double & y, double & dist2);
+
+    /** Bounding box of the raw points, padded like mpFXYVector. */
+    double GetMinX() { return m_minX; }
+    double GetMaxX() { return m_maxX; }
+    double GetMinY() { return m_minY; }
+    double GetMaxY() { return m_maxY; }
+
+protected:
+    /** Adds one point (not older than the last one) to the bounding box and the last buckets of every level.
+        @param first The point is the first one of the layer: it replaces the default bounding box */
+    void AddToLevels(double x, double y, bool first);
+
+    /** Rebuilds the bounding box and all the levels from the raw points. */
+    void Rebuild();
+
+    /** Rewind value enumeration with mpFXY::GetNextXY.
+        Overridden in this implementation. */
+    void Rewind();
+
+    /** Get locus value for next N: raw points or bucket extremes of the level selected by Plot.
+        Overridden in this implementation.
+        @param x Returns X value
+        @param y Returns Y value */
+    bool GetNextXY(double & x, double & y);
+
+    std::vector<double> m_xs, m_ys;     //!< Raw points
+    std::vector<mpLodLevel> m_levels;   //!< Levels sorted from the finest to the coarsest
+    double m_minX, m_maxX, m_minY, m_maxY;
+    bool m_envelope;                    //!< Draw min and max of the buckets rather than their mean
+
+    int m_level;                        //!< Level selected by Plot, -1 for raw points
+    size_t m_first, m_last;             //!< Visible range (of points or buckets) selected by Plot
+    size_t m_index;                     //!< The internal counter for the "GetNextXY" interface
+    bool m_second;                      //!< GetNextXY returns the max of the current bucket next
+
+    DECLARE_DYNAMIC_CLASS(mpFXYPyramid)
+};
+
 //-----------------------------------------------------------------------------
 // mpText - provided by Val Greene
 //-----------------------------------------------------------------------------
@@ -1365,7 +2018,7 @@ public:
 
     /** Text Layer plot handler.
         This implementation will plot text adjusted to the visible area. */
-    virtual void Plot(wxDC & dc, mpWindow & w);
+    virtual void Plot(wxDC & dc, mpView & w);
 
     /** mpText should not be used for scaling decisions. */
     virtual bool HasBBox() { return FALSE; }
@@ -1466,12 +2119,12 @@ public:
     */
     virtual double GetMaxY() { return m_bbox_max_y; }
 
-    virtual void   Plot(wxDC & dc, mpWindow & w);
+    virtual void   Plot(wxDC & dc, mpView & w);
 
     /** Set label axis alignment.
       *  @param align alignment (choose between mpALIGN_NE, mpALIGN_NW, mpALIGN_SW, mpALIGN_SE
       */
-    void SetAlign(int align) { m_flags = align; };
+    void SetAlign(int align) { m_flags = align; DataChanged(); };
 
 protected:
     int m_flags; //!< Holds label alignment
@@ -1556,7 +2209,7 @@ public:
         RecalculateShape();
     }
 
-    void SetSegments( int segments ) { m_segments = segments; }
+    void SetSegments( int segments ) { m_segments = segments; RecalculateShape(); }
     int GetSegments( ) const { return m_segments; }
 
     /** Returns the elements of the current covariance matrix:
@@ -1636,26 +2289,25 @@ public:
   *  be in charge of Bounding Box computation and layer render, assuming that
   *  the object updates its shape in m_shape_xs & m_shape_ys.
   */
+/** Shared state between an mpBitmapLayer and the background thread scaling its tiles (defined in mathplot.cpp). */
+struct mpBitmapTileQueue;
+
 class WXDLLIMPEXP_MATHPLOT mpBitmapLayer : public mpLayer
 {
 public:
     /** Default constructor.
       */
-    mpBitmapLayer( )
-    {
-        m_min_x = m_max_x =
-        m_min_y = m_max_y = 0;
-        m_validImg = false;
-        m_type = mpLAYER_BITMAP;
-    }
+    mpBitmapLayer( );
 
-    virtual ~mpBitmapLayer() {};
+    virtual ~mpBitmapLayer();
 
     /** Returns a copy of the current bitmap assigned to the layer.
       */
     void GetBitmapCopy( wxImage &outBmp ) const;
 
     /** Change the bitmap associated with the layer (to update the screen, refresh the mpWindow).
+      *  A mip-map pyramid (each level half the size of the previous one) is built from the bitmap, so that
+      *  the layer can draw any zoom level from a level no larger than twice the screen resolution.
       *  @param inBmp The bitmap to associate. A copy is made, thus it can be released after calling this.
       *  @param x The left corner X coordinate (in plot units).
       *  @param y The top corner Y coordinate (in plot units).
@@ -1682,21 +2334,54 @@ public:
     */
     virtual double GetMaxY() { return m_max_y; }
 
-    virtual void   Plot(wxDC & dc, mpWindow & w);
+    /** Layer plot handler.
+      *  Only the visible tiles of the pyramid level matching the current zoom are drawn. Tiles are smoothly scaled
+      *  to their size on screen by a background thread; until a tile is ready it is stretched from its unscaled
+      *  pixels, and the window is refreshed when the scaled tiles arrive. When rendering off-screen
+      *  (mpImageRenderer), tiles are scaled synchronously.
+      */
+    virtual void   Plot(wxDC & dc, mpView & w);
 
     /** Set label axis alignment.
       *  @param align alignment (choose between mpALIGN_NE, mpALIGN_NW, mpALIGN_SW, mpALIGN_SE
       */
-    void SetAlign(int align) { m_flags = align; };
+    void SetAlign(int align) { m_flags = align; DataChanged(); };
 
 protected:
     int m_flags; //!< Holds label alignment
 
+    /** A tile of a pyramid level, as bitmaps ready to be drawn. */
+    struct mpBitmapTile
+    {
+        wxBitmap source;        //!< Unscaled tile pixels
+        wxBitmap scaled;        //!< Tile scaled to its size on screen (the bitmap size)
+        unsigned long lastUsed; //!< Last frame the tile was visible in
+    };
+
+    /** Key of a tile in m_tiles, from its level, column and row. */
+    static unsigned long long TileKey(int level, int column, int row)
+    {
+        return ((unsigned long long)level << 48) | ((unsigned long long)row << 24) | (unsigned long long)column;
+    }
+
+    /** Draws the unscaled pixels of a tile stretched to a screen rectangle. */
+    void DrawStretched(wxDC & dc, mpBitmapTile & tile, const wxImage & level, const wxRect & src, const wxRect & dst);
+
+    /** Stores the tiles scaled by the background thread since the last call. */
+    void CollectScaledTiles();
+
+    /** Drops the tiles not visible for the longest time, if the cache holds too many tiles. */
+    void TrimTiles();
+
     /** The internal copy of the Bitmap:
       */
     wxImage      m_bitmap;
-    wxBitmap     m_scaledBitmap;
-    wxCoord      m_scaledBitmap_offset_x,m_scaledBitmap_offset_y;
+
+    std::vector<wxImage> m_levels;                      //!< Mip-map pyramid, m_levels[0] is m_bitmap
+    std::map<unsigned long long, mpBitmapTile> m_tiles; //!< Tiles drawn recently, by TileKey
+    unsigned long m_frame;                              //!< Number of Plot calls, for the tiles LRU
+    unsigned long m_generation;                         //!< Incremented by SetBitmap, to discard tiles of older bitmaps
+    std::shared_ptr<mpBitmapTileQueue> m_tileQueue;     //!< Jobs and results of the tile scaling thread
 
 
     bool            m_validImg;
@@ -0,0 +1,132 @@
+// Testy AnomalyDetector: krocząca mediana i MAD, skoki, stała wartość i przerwy w danych
+#include "AnomalyDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const std::time_t start = 1700000000 - 1700000000 % 3600;
+
+    double NaiveMedian(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+    }
+
+    double NaiveMad(const std::vector<double>& values) {
+        const double median = NaiveMedian(values);
+        std::vector<double> deviations;
+        for (double value : values) {
+            deviations.push_back(std::fabs(value - median));
+        }
+        return NaiveMedian(deviations);
+    }
+
+    // Mediana i MAD okna porównane z sortowaniem całego okna po każdym dodaniu (także z powtórzeniami)
+    void TestRollingMedian() {
+        const size_t windows[] = { 1, 2, 5, 24 };
+        for (size_t window : windows) {
+            RollingMedian median(window);
+            std::vector<double> history;
+            unsigned seed = 12345;
+            for (int i = 0; i < 200; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                const double value = (double)((seed >> 16) % 50);   // wiele powtórzonych wartości
+                median.Add(value);
+                history.push_back(value);
+                const size_t count = std::min(history.size(), window);
+                std::vector<double> current(history.end() - count, history.end());
+                if (median.Count() != count || median.Median() != NaiveMedian(current) || median.Mad() != NaiveMad(current)) {
+                    std::printf("BŁĄD: okno %zu, krok %d: mediana %.2f (oczekiwana %.2f), MAD %.2f (oczekiwane %.2f)\n",
+                        window, i, median.Median(), NaiveMedian(current), median.Mad(), NaiveMad(current));
+                    ++failures;
+                    break;
+                }
+            }
+        }
+        RollingMedian empty;
+        Check(std::isnan(empty.Median()) && std::isnan(empty.Mad()), "mediana pustego okna to NaN");
+    }
+
+    // Wyraźny skok po wypełnieniu okna jest oznaczany, zwykłe wahania nie
+    void TestSpike() {
+        SensorAnomalyDetector detector;
+        const double values[] = { 20, 22, 19, 21, 23, 20, 18, 22, 21, 20 };
+        std::time_t time = start;
+        unsigned flags = ANOMALY_NONE;
+        for (double value : values) {
+            flags |= detector.Add(time, value);
+            time += 3600;
+        }
+        Check(flags == ANOMALY_NONE, "wahania wokół mediany nie są anomalią");
+        Check(detector.Add(time, 250.0) == ANOMALY_SPIKE, "skok daleko od mediany");
+        time += 3600;
+        Check(detector.Add(time, 21.0) == ANOMALY_NONE, "powrót do typowych wartości po skoku");
+
+        // Przed wypełnieniem okna skoki nie są oceniane
+        SensorAnomalyDetector young;
+        young.Add(start, 10.0);
+        Check(young.Add(start + 3600, 500.0) == ANOMALY_NONE, "brak oceny skoków przy krótkiej historii");
+    }
+
+    // Dwanaście identycznych wartości z rzędu to zawieszony czujnik
+    void TestFlatline() {
+        SensorAnomalyDetector detector;
+        std::time_t time = start;
+        for (int i = 1; i <= 11; ++i) {
+            Check((detector.Add(time, 15.0) & ANOMALY_FLATLINE) == 0, "krótka seria stałych wartości");
+            time += 3600;
+        }
+        Check((detector.Add(time, 15.0) & ANOMALY_FLATLINE) != 0, "dwunasta stała wartość z rzędu");
+        time += 3600;
+        Check((detector.Add(time, 16.0) & ANOMALY_FLATLINE) == 0, "zmiana wartości kończy serię");
+    }
+
+    // Przerwa: sześć godzin bez ważnego pomiaru, także gdy w tym czasie przychodziły wartości null
+    void TestGap() {
+        SensorAnomalyDetector detector;
+        detector.Add(start, 10.0);
+        Check(detector.Add(start + 5 * 3600, 11.0) == ANOMALY_NONE, "pięć godzin bez pomiaru to nie przerwa");
+        for (int h = 6; h < 12; ++h) {
+            Check(detector.Add(start + h * 3600, nan) == ANOMALY_NONE, "wartość null nie jest oceniana");
+        }
+        Check(detector.LastTime() == start + 5 * 3600, "wartość null nie przesuwa czasu ostatniego pomiaru");
+        Check(detector.Add(start + 12 * 3600, 12.0) == ANOMALY_GAP, "pierwszy pomiar po serii wartości null");
+        Check(detector.Add(start + 11 * 3600, 12.0) == ANOMALY_NONE, "starszy pomiar jest pomijany");
+    }
+
+    // Godzina opublikowana najpierw jako null jest oceniana, gdy dostanie wartość
+    void TestLateValue() {
+        SensorAnomalyDetector detector;
+        std::vector<Measurement> first = { { start + 3600, nan }, { start, 10.0 } };   // kolejność API
+        DetectAnomalies(detector, first);
+        Check(detector.LastTime() == start, "ostatni ważny pomiar przed uzupełnieniem");
+
+        std::vector<Measurement> second = { { start + 7 * 3600, 10.0 }, { start + 3600, 10.0 }, { start, 10.0 } };
+        std::vector<unsigned> flags = DetectAnomalies(detector, second);
+        Check(detector.LastTime() == start + 7 * 3600, "uzupełniona godzina i nowszy pomiar są ocenione");
+        Check(flags[0] == ANOMALY_GAP && flags[1] == ANOMALY_NONE && flags[2] == ANOMALY_NONE,
+            "flagi w kolejności wejścia");
+    }
+}
+
+int main() {
+    TestRollingMedian();
+    TestSpike();
+    TestFlatline();
+    TestGap();
+    TestLateValue();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// Testy AqiEngine: kategorie indeksu na granicach przedziałów skali GIOŚ
+#include <wx/wx.h>
+#include <wx/init.h>
+#include "AqiEngine.h"
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    // Stężenie (µg/m³) i oczekiwany indeks cząstkowy; wartości na granicy należą do niższej kategorii
+    struct BoundaryCase {
+        AqiPollutant pollutant;
+        float value;
+        int expected;
+    };
+
+    // Progi Polskiego Indeksu Jakości Powietrza dla stężeń 1-godzinnych (GIOŚ)
+    const BoundaryCase boundaryCases[] = {
+        { AQI_PM10, 0.0f, 0 }, { AQI_PM10, 20.0f, 0 }, { AQI_PM10, 20.1f, 1 },
+        { AQI_PM10, 50.0f, 1 }, { AQI_PM10, 50.1f, 2 }, { AQI_PM10, 80.0f, 2 }, { AQI_PM10, 80.1f, 3 },
+        { AQI_PM10, 110.0f, 3 }, { AQI_PM10, 110.1f, 4 }, { AQI_PM10, 150.0f, 4 }, { AQI_PM10, 150.1f, 5 },
+
+        { AQI_PM25, 13.0f, 0 }, { AQI_PM25, 13.1f, 1 }, { AQI_PM25, 35.0f, 1 }, { AQI_PM25, 35.1f, 2 },
+        { AQI_PM25, 55.0f, 2 }, { AQI_PM25, 55.1f, 3 }, { AQI_PM25, 75.0f, 3 }, { AQI_PM25, 75.1f, 4 },
+        { AQI_PM25, 110.0f, 4 }, { AQI_PM25, 110.1f, 5 },
+
+        { AQI_NO2, 40.0f, 0 }, { AQI_NO2, 40.1f, 1 }, { AQI_NO2, 90.0f, 1 }, { AQI_NO2, 90.1f, 2 },
+        { AQI_NO2, 120.0f, 2 }, { AQI_NO2, 120.1f, 3 }, { AQI_NO2, 230.0f, 3 }, { AQI_NO2, 230.1f, 4 },
+        { AQI_NO2, 340.0f, 4 }, { AQI_NO2, 340.1f, 5 },
+
+        { AQI_SO2, 50.0f, 0 }, { AQI_SO2, 50.1f, 1 }, { AQI_SO2, 100.0f, 1 }, { AQI_SO2, 100.1f, 2 },
+        { AQI_SO2, 200.0f, 2 }, { AQI_SO2, 200.1f, 3 }, { AQI_SO2, 350.0f, 3 }, { AQI_SO2, 350.1f, 4 },
+        { AQI_SO2, 500.0f, 4 }, { AQI_SO2, 500.1f, 5 },
+
+        { AQI_O3, 70.0f, 0 }, { AQI_O3, 70.1f, 1 }, { AQI_O3, 120.0f, 1 }, { AQI_O3, 120.1f, 2 },
+        { AQI_O3, 150.0f, 2 }, { AQI_O3, 150.1f, 3 }, { AQI_O3, 180.0f, 3 }, { AQI_O3, 180.1f, 4 },
+        { AQI_O3, 240.0f, 4 }, { AQI_O3, 240.1f, 5 },
+
+        { AQI_C6H6, 6.0f, 0 }, { AQI_C6H6, 6.1f, 1 }, { AQI_C6H6, 11.0f, 1 }, { AQI_C6H6, 11.1f, 2 },
+        { AQI_C6H6, 16.0f, 2 }, { AQI_C6H6, 16.1f, 3 }, { AQI_C6H6, 21.0f, 3 }, { AQI_C6H6, 21.1f, 4 },
+        { AQI_C6H6, 51.0f, 4 }, { AQI_C6H6, 51.1f, 5 }
+    };
+    const size_t boundaryCaseCount = sizeof(boundaryCases) / sizeof(boundaryCases[0]);
+
+    void Report(const BoundaryCase& c, int actual, const char* path) {
+        std::printf("BŁĄD: %s %s = %.1f: indeks %d zamiast %d\n",
+            path, AqiEngine::PollutantName(c.pollutant), c.value, actual, c.expected);
+        ++failures;
+    }
+
+    // Wszystkie przypadki naraz: jedna stacja na przypadek, pełne przeliczenie kolumnami
+    void TestBoundariesCompute() {
+        std::vector<int> ids;
+        for (size_t i = 0; i < boundaryCaseCount; ++i) {
+            ids.push_back((int)i + 1);
+        }
+        AqiEngine engine;
+        engine.SetStations(ids);
+        for (size_t i = 0; i < boundaryCaseCount; ++i) {
+            engine.SetValue(ids[i], boundaryCases[i].pollutant, boundaryCases[i].value);
+        }
+        engine.Compute();
+        for (size_t i = 0; i < boundaryCaseCount; ++i) {
+            const BoundaryCase& c = boundaryCases[i];
+            if (engine.SubIndex(ids[i], c.pollutant) != c.expected) {
+                Report(c, engine.SubIndex(ids[i], c.pollutant), "Compute:");
+            }
+            if (engine.Index(ids[i]) != c.expected) {
+                Report(c, engine.Index(ids[i]), "Compute (indeks ogólny):");
+            }
+        }
+    }
+
+    // Te same przypadki przez przeliczanie pojedynczych zmienionych wierszy
+    void TestBoundariesUpdate() {
+        std::vector<int> ids;
+        for (int i = 1; i <= 10; ++i) {
+            ids.push_back(i);
+        }
+        AqiEngine engine;
+        for (size_t i = 0; i < boundaryCaseCount; ++i) {
+            const BoundaryCase& c = boundaryCases[i];
+            engine.SetStations(ids);
+            engine.SetValue(ids[0], c.pollutant, c.value);
+            Check(engine.Update() == 1, "Update przelicza tylko zmienioną stację");
+            if (engine.SubIndex(ids[0], c.pollutant) != c.expected) {
+                Report(c, engine.SubIndex(ids[0], c.pollutant), "Update:");
+            }
+        }
+    }
+
+    // Indeks ogólny to najgorszy indeks cząstkowy; brak pomiarów to brak indeksu
+    void TestCombined() {
+        AqiEngine engine;
+        engine.SetStations({ 1, 2 });
+        engine.SetValue(1, AQI_PM10, 10.0f);
+        engine.SetValue(1, AQI_NO2, 95.0f);
+        engine.SetValue(1, AQI_O3, std::numeric_limits<float>::quiet_NaN());
+        engine.Compute();
+        Check(engine.Index(1) == 2, "indeks ogólny z najgorszego indeksu cząstkowego");
+        Check(engine.SubIndex(1, AQI_O3) == AQI_NO_INDEX, "brak indeksu cząstkowego bez pomiaru");
+        Check(engine.Index(2) == AQI_NO_INDEX, "brak indeksu stacji bez pomiarów");
+        Check(engine.Index(3) == AQI_NO_INDEX, "brak indeksu nieznanej stacji");
+    }
+}
+
+int main(int argc, char** argv) {
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk()) {
+        std::printf("Nie udało się zainicjować wxWidgets\n");
+        return 1;
+    }
+    TestBoundariesCompute();
+    TestBoundariesUpdate();
+    TestCombined();
+    return failures == 0 ? 0 : 1;
+}
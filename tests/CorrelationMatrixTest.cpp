@@ -0,0 +1,160 @@
+// Testy CorrelationMatrix: korelacje liczone blokami porównane z dwuprzebiegowym wzorem Pearsona dla każdej pary
+#include "CorrelationMatrix.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// main.cpp to cała aplikacja, więc test ma własne RunParallel: zadania z jednego licznika w kilku wątkach
+void RunParallel(size_t count, unsigned maxThreads, const std::function<void(size_t)>& task) {
+    unsigned threads = maxThreads ? maxThreads : 4;
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                task(i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    const std::time_t start = 1700000000 - 1700000000 % 3600;
+
+    // Pearson z godzin ważnych w obu kolumnach: najpierw średnie, potem odchylenia; NaN jak w CorrelationMatrix
+    double NaivePearson(const HourlyGrid& grid, size_t a, size_t b, size_t minOverlap, unsigned& overlap) {
+        double meanA = 0.0, meanB = 0.0;
+        overlap = 0;
+        for (int row = 0; row < grid.Hours(); ++row) {
+            if (grid.IsValid(row, a) && grid.IsValid(row, b)) {
+                meanA += grid.Value(row, a);
+                meanB += grid.Value(row, b);
+                ++overlap;
+            }
+        }
+        if (overlap < std::max<size_t>(minOverlap, 2)) {
+            return std::nan("");
+        }
+        meanA /= overlap;
+        meanB /= overlap;
+        double covariance = 0.0, varianceA = 0.0, varianceB = 0.0;
+        for (int row = 0; row < grid.Hours(); ++row) {
+            if (grid.IsValid(row, a) && grid.IsValid(row, b)) {
+                const double da = grid.Value(row, a) - meanA;
+                const double db = grid.Value(row, b) - meanB;
+                covariance += da * db;
+                varianceA += da * da;
+                varianceB += db * db;
+            }
+        }
+        if (varianceA <= 0.0 || varianceB <= 0.0) {
+            return std::nan("");
+        }
+        return covariance / std::sqrt(varianceA * varianceB);
+    }
+
+    // Serie stacji: wspólny cykl dobowy, własny trend i szum, luki różnej długości i wartości null
+    std::vector<std::vector<Measurement>> MakeSeries(size_t columns, int hours) {
+        std::vector<std::vector<Measurement>> series(columns);
+        unsigned seed = 7;
+        for (size_t c = 0; c < columns; ++c) {
+            for (int h = 0; h < hours; ++h) {
+                seed = seed * 1103515245u + 12345u;
+                const double noise = ((seed >> 16) % 1000) / 100.0;
+                // Luki: co siódma kolumna bez pierwszej doby, pozostałe z przerwami co kilkadziesiąt godzin
+                if ((c % 7 == 3 && h < 24) || (h + (int)c * 5) % 37 < 3) {
+                    continue;
+                }
+                double value = 20.0 + 10.0 * std::sin(h * 0.2618 + c) + 0.05 * h * (c % 3) + noise;
+                if ((h + (int)c) % 53 == 0) {
+                    value = std::nan("");   // null z API
+                }
+                series[c].push_back({ start + (std::time_t)h * 3600, value });
+            }
+        }
+        // Kolumna stała (wariancja 0) i kolumna z kilkoma pomiarami (za mało wspólnych godzin)
+        for (auto& m : series[1]) {
+            m.value = 15.0;
+        }
+        series[2].resize(5);
+        return series;
+    }
+
+    void Compare(const HourlyGrid& grid, size_t minOverlap, unsigned maxThreads) {
+        CorrelationMatrix matrix;
+        matrix.Compute(grid, minOverlap, maxThreads);
+        Check(matrix.Size() == grid.Columns(), "rozmiar macierzy");
+        for (size_t a = 0; a < grid.Columns(); ++a) {
+            for (size_t b = 0; b < grid.Columns(); ++b) {
+                unsigned overlap = 0;
+                const double expected = NaivePearson(grid, a, b, minOverlap, overlap);
+                const float actual = matrix.At(a, b);
+                const bool same = std::isnan(expected) ? std::isnan(actual) : std::fabs(actual - expected) < 1e-5;
+                if (!same || matrix.Overlap(a, b) != overlap) {
+                    std::printf("BŁĄD: para (%zu, %zu), minOverlap %zu: r = %f (oczekiwane %f), wspólne godziny %u (oczekiwane %u)\n",
+                        a, b, minOverlap, actual, expected, matrix.Overlap(a, b), overlap);
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    // Więcej kolumn niż jeden blok (32), więc liczone są też pary różnych bloków i niepełny ostatni blok
+    void TestAgainstNaive() {
+        std::vector<std::vector<Measurement>> series = MakeSeries(45, 24 * 10);
+        HourlyGrid grid;
+        grid.ResetToSpan(series);
+        for (size_t c = 0; c < series.size(); ++c) {
+            grid.SetColumn(c, series[c]);
+        }
+        Compare(grid, 24, 0);
+        Compare(grid, 2, 1);
+        Compare(grid, 200, 3);
+    }
+
+    void TestSmall() {
+        // Serie z lukami: b = 2a + 1 na wspólnych godzinach, c = -a
+        std::vector<std::vector<Measurement>> series(3);
+        for (int h = 0; h < 10; ++h) {
+            if (h != 4) series[0].push_back({ start + h * 3600, (double)h });
+            if (h != 7) series[1].push_back({ start + h * 3600, 2.0 * h + 1.0 });
+            series[2].push_back({ start + h * 3600, -(double)h });
+        }
+        HourlyGrid grid;
+        grid.ResetToSpan(series);
+        for (size_t c = 0; c < series.size(); ++c) {
+            grid.SetColumn(c, series[c]);
+        }
+        CorrelationMatrix matrix;
+        matrix.Compute(grid, 2);
+        Check(std::fabs(matrix.At(0, 1) - 1.0f) < 1e-6f, "korelacja zależności liniowej");
+        Check(std::fabs(matrix.At(0, 2) + 1.0f) < 1e-6f, "korelacja ujemna");
+        Check(matrix.Overlap(0, 1) == 8, "wspólne godziny serii z lukami");
+        Check(matrix.At(1, 0) == matrix.At(0, 1), "macierz symetryczna");
+
+        HourlyGrid empty;
+        matrix.Compute(empty);
+        Check(matrix.Size() == 0, "pusta siatka");
+    }
+}
+
+int main() {
+    TestSmall();
+    TestAgainstNaive();
+    return failures == 0 ? 0 : 1;
+}
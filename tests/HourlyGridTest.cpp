@@ -0,0 +1,114 @@
+// Testy HourlyGrid: brakujące godziny, duplikaty pomiarów i zmiana czasu
+#include "HourlyGrid.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const std::time_t start = 1700000000 - 1700000000 % 3600;   // pełna godzina
+
+    // Brakujące godziny i wartości null: komórki nieważne z NaN, pozostałe bez zmian
+    void TestMissingHours() {
+        std::vector<Measurement> series = {
+            { start, 10.0 }, { start + 3 * 3600, 13.0 }, { start + 4 * 3600, nan }, { start + 5 * 3600, 15.0 }
+        };
+        HourlyGrid grid;
+        grid.ResetToSpan({ series });
+        grid.SetColumn(0, series);
+        Check(grid.Hours() == 6, "siatka obejmuje godziny od pierwszego do ostatniego pomiaru");
+        Check(grid.ValidCount(0) == 3, "liczba ważnych godzin z lukami");
+        Check(grid.IsValid(0, 0) && grid.Value(0, 0) == 10.0, "pierwsza godzina");
+        Check(!grid.IsValid(1, 0) && std::isnan(grid.Value(1, 0)), "brakująca godzina jest nieważna");
+        Check(!grid.IsValid(2, 0), "druga brakująca godzina jest nieważna");
+        Check(!grid.IsValid(4, 0) && std::isnan(grid.Value(4, 0)), "pomiar null jest nieważny");
+        Check(grid.IsValid(5, 0) && grid.Value(5, 0) == 15.0, "ostatnia godzina");
+    }
+
+    // Kilka pomiarów w jednej godzinie (także o tym samym czasie): średnia pomiarów innych niż NaN
+    void TestDuplicates() {
+        std::vector<Measurement> series = {
+            { start, 10.0 }, { start, 20.0 }, { start + 1800, 30.0 }, { start + 3600, nan }, { start + 3600, 5.0 }
+        };
+        HourlyGrid grid;
+        grid.Reset(start, 2, 1);
+        grid.SetColumn(0, series);
+        Check(grid.IsValid(0, 0) && grid.Value(0, 0) == 20.0, "średnia pomiarów z tej samej godziny");
+        Check(grid.IsValid(1, 0) && grid.Value(1, 0) == 5.0, "pomiar null obok ważnego w tej samej godzinie");
+    }
+
+    // Kolejność pomiarów z API (od najnowszego) i dowolna kolejność dają tę samą kolumnę
+    void TestOrder() {
+        std::vector<Measurement> ascending = { { start, 1.0 }, { start + 3600, 2.0 }, { start + 7200, 3.0 } };
+        std::vector<Measurement> descending(ascending.rbegin(), ascending.rend());
+        std::vector<Measurement> shuffled = { ascending[1], ascending[2], ascending[0] };
+        HourlyGrid grid;
+        grid.Reset(start, 3, 3);
+        grid.SetColumn(0, ascending);
+        grid.SetColumn(1, descending);
+        grid.SetColumn(2, shuffled);
+        for (int row = 0; row < 3; ++row) {
+            Check(grid.Value(row, 1) == grid.Value(row, 0), "seria malejąca jak rosnąca");
+            Check(grid.Value(row, 2) == grid.Value(row, 0), "seria nieposortowana jak rosnąca");
+        }
+        Check(grid.ValidCount(0, 1) == 3, "wspólne ważne godziny dwóch kolumn");
+    }
+
+    // Siatka liczy godziny od epoki, więc zmiana czasu w Polsce nie tworzy luk ani duplikatów:
+    // 31.03.2024 po 02:00 CET jest 03:00 CEST, 27.10.2024 godzina 02:00 lokalnie występuje dwa razy
+    void TestDaylightSaving() {
+        const std::time_t springUtcMidnight = 1711843200;   // 2024-03-31 00:00 UTC = 01:00 CET
+        std::vector<Measurement> spring = { { springUtcMidnight, 1.0 }, { springUtcMidnight + 3600, 2.0 } };
+        HourlyGrid grid;
+        grid.ResetToSpan({ spring });
+        grid.SetColumn(0, spring);
+        Check(grid.Hours() == 2, "01:00 CET i 03:00 CEST to sąsiednie godziny siatki");
+        Check(grid.ValidCount(0) == 2, "brak pustej godziny przy przejściu na czas letni");
+
+        const std::time_t autumnUtcMidnight = 1729987200;   // 2024-10-27 00:00 UTC = 02:00 CEST
+        std::vector<Measurement> autumn = {
+            { autumnUtcMidnight, 1.0 }, { autumnUtcMidnight + 3600, 2.0 }, { autumnUtcMidnight + 7200, 3.0 }
+        };
+        grid.ResetToSpan({ autumn });
+        grid.SetColumn(0, autumn);
+        Check(grid.Hours() == 3, "02:00 CEST i 02:00 CET to osobne godziny siatki");
+        Check(grid.Value(0, 0) == 1.0 && grid.Value(1, 0) == 2.0, "powtórzona godzina lokalna nie jest uśredniana");
+        Check(grid.Row(autumnUtcMidnight + 3600 + 1800) == 1, "wiersz w powtórzonej godzinie");
+    }
+
+    // Granice siatki: początek zaokrąglony do pełnej godziny, czasy poza siatką bez wiersza
+    void TestBounds() {
+        HourlyGrid grid;
+        grid.Reset(start + 1234, 4, 1);
+        Check(grid.Start() == start, "początek siatki to pełna godzina");
+        Check(grid.Row(start - 1) == -1, "czas przed siatką");
+        Check(grid.Row(start + 4 * 3600) == -1, "czas po siatce");
+        Check(grid.Row(start + 4 * 3600 - 1) == 3, "ostatnia sekunda siatki");
+
+        std::vector<Measurement> outside = { { start - 3600, 1.0 }, { start + 10 * 3600, 2.0 } };
+        grid.SetColumn(0, outside);
+        Check(grid.ValidCount(0) == 0, "pomiary spoza siatki są pomijane");
+
+        grid.ResetToSpan({ {}, {} });
+        Check(grid.Hours() == 0 && grid.Columns() == 2, "pusta siatka dla serii bez pomiarów");
+    }
+}
+
+int main() {
+    TestMissingHours();
+    TestDuplicates();
+    TestOrder();
+    TestDaylightSaving();
+    TestBounds();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Testy warstwy mpFXYPyramid: obwiednia i poziomy szczegółowości po dopisaniu danych
+#include <wx/wx.h>
+#include <wx/init.h>
+#include "mathplot.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    // Kilka pomiarów godzinowych z czasem w sekundach od epoki
+    void HourlySeries(double start, size_t count, std::vector<double>& xs, std::vector<double>& ys) {
+        xs.clear();
+        ys.clear();
+        for (size_t i = 0; i < count; ++i) {
+            xs.push_back(start + i * 3600.0);
+            ys.push_back(10.0 + i);
+        }
+    }
+
+    // Dopisanie wielu punktów do pustej warstwy: obwiednia z danych, nie domyślne -1..1
+    void TestAppendToEmpty() {
+        std::vector<double> xs, ys;
+        HourlySeries(1700000000.0, 5, xs, ys);
+        mpFXYPyramid layer;
+        layer.AppendData(xs, ys);
+        Check(layer.GetCount() == 5, "liczba punktów po dopisaniu do pustej warstwy");
+        Check(layer.GetMinX() == xs.front() - 0.5, "minimalne X po dopisaniu do pustej warstwy");
+        Check(layer.GetMaxX() == xs.back() + 0.5, "maksymalne X po dopisaniu do pustej warstwy");
+        Check(layer.GetMinY() == ys.front() - 0.5, "minimalne Y po dopisaniu do pustej warstwy");
+        Check(layer.GetMaxY() == ys.back() + 0.5, "maksymalne Y po dopisaniu do pustej warstwy");
+        Check(layer.GetLevel(0).buckets.size() == 5, "kubełki godzinowe po dopisaniu do pustej warstwy");
+    }
+
+    // Dopisanie po wyczyszczeniu i dopisanie do niepustej warstwy
+    void TestAppendAfterClear() {
+        std::vector<double> xs, ys;
+        HourlySeries(1700000000.0, 3, xs, ys);
+        mpFXYPyramid layer;
+        layer.SetData(xs, ys);
+        layer.Clear();
+        HourlySeries(1800000000.0, 4, xs, ys);
+        layer.AppendData(xs, ys);
+        Check(layer.GetMinX() == xs.front() - 0.5, "minimalne X po wyczyszczeniu i dopisaniu");
+        Check(layer.GetMaxX() == xs.back() + 0.5, "maksymalne X po wyczyszczeniu i dopisaniu");
+
+        std::vector<double> more, moreY;
+        HourlySeries(xs.back() + 3600.0, 2, more, moreY);
+        layer.AppendData(more, moreY);
+        Check(layer.GetCount() == 6, "liczba punktów po dopisaniu do niepustej warstwy");
+        Check(layer.GetMinX() == xs.front() - 0.5, "minimalne X po dopisaniu do niepustej warstwy");
+        Check(layer.GetMaxX() == more.back() + 0.5, "maksymalne X po dopisaniu do niepustej warstwy");
+    }
+}
+
+int main(int argc, char** argv) {
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk()) {
+        std::printf("Nie udało się zainicjować wxWidgets\n");
+        return 1;
+    }
+    TestAppendToEmpty();
+    TestAppendAfterClear();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Testy StationIndex: najbliższe stacje i stacje w prostokącie porównane z przeszukaniem wszystkich stacji
+#include "StationIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void Check(bool condition, const char* what) {
+        if (!condition) {
+            std::printf("BŁĄD: %s\n", what);
+            ++failures;
+        }
+    }
+
+    unsigned seed = 2024;
+
+    // Liczba pseudolosowa z [low, high); stałe ziarno, więc test jest powtarzalny
+    double Random(double low, double high) {
+        seed = seed * 1103515245u + 12345u;
+        return low + (high - low) * ((seed >> 8) % 1000000) / 1000000.0;
+    }
+
+    // Stacje rozrzucone po Polsce, co dziesiąta bez współrzędnych, kilka w tym samym miejscu
+    std::vector<Station> MakeStations(size_t count) {
+        std::vector<Station> stations(count);
+        for (size_t i = 0; i < count; ++i) {
+            stations[i].id = (int)i + 1;
+            stations[i].hasLocation = i % 10 != 0;
+            stations[i].latitude = Random(49.0, 54.9);
+            stations[i].longitude = Random(14.1, 24.2);
+        }
+        for (size_t i = 1; i + 1 < count; i += 50) {
+            stations[i + 1].latitude = stations[i].latitude;
+            stations[i + 1].longitude = stations[i].longitude;
+        }
+        return stations;
+    }
+
+    // k najbliższych: te same odległości co po posortowaniu wszystkich stacji (przy remisach pozycje mogą się różnić)
+    void TestNearest() {
+        std::vector<Station> stations = MakeStations(500);
+        StationIndex index;
+        index.Build(stations);
+        Check(index.Size() == 450, "w indeksie tylko stacje ze współrzędnymi");
+
+        const size_t ks[] = { 1, 5, 20, 450, 1000 };
+        for (int query = 0; query < 100; ++query) {
+            // Punkty także poza Polską, żeby sprawdzić odrzucanie poddrzew z dala od danych
+            const double latitude = Random(45.0, 58.0);
+            const double longitude = Random(8.0, 30.0);
+            std::vector<double> expected;
+            for (const auto& station : stations) {
+                if (station.hasLocation) {
+                    expected.push_back(StationIndex::DistanceKm(latitude, longitude, station.latitude, station.longitude));
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+
+            for (size_t k : ks) {
+                std::vector<StationIndex::Hit> hits = index.Nearest(latitude, longitude, k);
+                const size_t count = std::min(k, expected.size());
+                bool ok = hits.size() == count;
+                for (size_t i = 0; ok && i < count; ++i) {
+                    const Station& station = stations[hits[i].station];
+                    ok = station.hasLocation && hits[i].distanceKm == expected[i] &&
+                        hits[i].distanceKm == StationIndex::DistanceKm(latitude, longitude, station.latitude, station.longitude);
+                }
+                if (!ok) {
+                    std::printf("BŁĄD: najbliższe %zu stacji punktu (%.3f, %.3f) inne niż przy przeszukaniu wszystkich\n",
+                        k, latitude, longitude);
+                    ++failures;
+                }
+            }
+        }
+        Check(index.Nearest(52.0, 19.0, 0).empty(), "brak wyników dla k = 0");
+    }
+
+    // Prostokąt współrzędnych: ten sam zbiór stacji co przy sprawdzeniu wszystkich (granice włącznie)
+    void TestInBox() {
+        std::vector<Station> stations = MakeStations(500);
+        StationIndex index;
+        index.Build(stations);
+        for (int query = 0; query < 100; ++query) {
+            double minLatitude = Random(48.0, 56.0), maxLatitude = Random(48.0, 56.0);
+            double minLongitude = Random(13.0, 25.0), maxLongitude = Random(13.0, 25.0);
+            if (minLatitude > maxLatitude) std::swap(minLatitude, maxLatitude);
+            if (minLongitude > maxLongitude) std::swap(minLongitude, maxLongitude);
+            if (query == 0) {
+                // Granica dokładnie na stacji
+                minLatitude = stations[1].latitude;
+                minLongitude = stations[1].longitude;
+            }
+
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < stations.size(); ++i) {
+                const Station& s = stations[i];
+                if (s.hasLocation && s.latitude >= minLatitude && s.latitude <= maxLatitude &&
+                    s.longitude >= minLongitude && s.longitude <= maxLongitude) {
+                    expected.push_back(i);
+                }
+            }
+            std::vector<size_t> found = index.InBox(minLatitude, minLongitude, maxLatitude, maxLongitude);
+            std::sort(found.begin(), found.end());
+            if (found != expected) {
+                std::printf("BŁĄD: prostokąt %d: %zu stacji zamiast %zu\n", query, found.size(), expected.size());
+                ++failures;
+            }
+        }
+    }
+
+    void TestEmpty() {
+        StationIndex index;
+        index.Build({});
+        Check(index.IsEmpty(), "pusty indeks");
+        Check(index.Nearest(52.0, 19.0, 3).empty(), "brak najbliższych w pustym indeksie");
+        Check(index.InBox(49.0, 14.0, 55.0, 25.0).empty(), "brak stacji w prostokącie pustego indeksu");
+    }
+}
+
+int main() {
+    TestNearest();
+    TestInBox();
+    TestEmpty();
+    return failures == 0 ? 0 : 1;
+}